@@ -0,0 +1,180 @@
+/* GStreamer
+ * Copyright (C) 2023 Your Name <your.email@example.com>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+/* Define GST_USE_UNSTABLE_API to avoid warnings about unstable API */
+#define GST_USE_UNSTABLE_API
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "gstspoutallocator.h"
+#include <atomic>
+
+GST_DEBUG_CATEGORY_STATIC (gst_spout_page_allocator_debug);
+#define GST_CAT_DEFAULT gst_spout_page_allocator_debug
+
+/* Shares point into their root's pages and leave them empty */
+struct GstSpoutPageMemory
+{
+  GstMemory mem;
+  
+  GstSpoutPages pages;
+  guint8 *data = nullptr;
+};
+
+struct _GstSpoutPageAllocator
+{
+  GstAllocator parent;
+  
+  gboolean huge_pages;
+  gint numa_node;
+  std::atomic<int> kind;
+};
+
+G_DEFINE_TYPE (GstSpoutPageAllocator, gst_spout_page_allocator,
+    GST_TYPE_ALLOCATOR);
+
+static GstMemory *
+gst_spout_page_allocator_alloc (GstAllocator * allocator, gsize size,
+    GstAllocationParams * params)
+{
+  GstSpoutPageAllocator *self = GST_SPOUT_PAGE_ALLOCATOR (allocator);
+  gsize maxsize = size + params->prefix + params->padding;
+  GstSpoutPageMemory *mem;
+
+  /* Pages are aligned far beyond anything asked for in params->align */
+  mem = new GstSpoutPageMemory ();
+  mem->pages = gst_spout_pages_alloc (maxsize, self->huge_pages,
+      self->numa_node);
+  if (!mem->pages.data) {
+    GST_ERROR_OBJECT (self, "Failed to map %" G_GSIZE_FORMAT " bytes",
+        maxsize);
+    delete mem;
+    return NULL;
+  }
+
+  /* Fresh anonymous pages read as zeroes, ZERO_PREFIXED and ZERO_PADDED
+   * hold without touching them, prefaulting is what costs */
+  gst_spout_pages_prefault (mem->pages);
+  mem->data = (guint8 *) mem->pages.data;
+
+  if (self->kind.exchange (mem->pages.kind) != mem->pages.kind) {
+    GST_INFO_OBJECT (self, "Allocating on %s pages",
+        gst_spout_page_kind_name (mem->pages.kind));
+  }
+
+  gst_memory_init (GST_MEMORY_CAST (mem), (GstMemoryFlags) params->flags,
+      allocator, NULL, maxsize, params->align, params->prefix, size);
+
+  return GST_MEMORY_CAST (mem);
+}
+
+static void
+gst_spout_page_allocator_free (GstAllocator * allocator, GstMemory * memory)
+{
+  GstSpoutPageMemory *mem = (GstSpoutPageMemory *) memory;
+
+  gst_spout_pages_free (mem->pages);
+  delete mem;
+}
+
+static gpointer
+gst_spout_page_memory_map (GstMemory * memory, gsize maxsize,
+    GstMapFlags flags)
+{
+  return ((GstSpoutPageMemory *) memory)->data;
+}
+
+static void
+gst_spout_page_memory_unmap (GstMemory * memory)
+{
+}
+
+static GstMemory *
+gst_spout_page_memory_share (GstMemory * memory, gssize offset, gssize size)
+{
+  GstSpoutPageMemory *mem = (GstSpoutPageMemory *) memory;
+  GstSpoutPageMemory *sub;
+  GstMemory *parent;
+
+  if ((parent = memory->parent) == NULL)
+    parent = memory;
+
+  if (size == -1)
+    size = memory->size - offset;
+
+  sub = new GstSpoutPageMemory ();
+  sub->data = mem->data;
+  gst_memory_init (GST_MEMORY_CAST (sub),
+      (GstMemoryFlags) (GST_MINI_OBJECT_FLAGS (parent) |
+          GST_MINI_OBJECT_FLAG_LOCK_READONLY), memory->allocator, parent,
+      memory->maxsize, memory->align, memory->offset + offset, size);
+
+  return GST_MEMORY_CAST (sub);
+}
+
+static void
+gst_spout_page_allocator_class_init (GstSpoutPageAllocatorClass * klass)
+{
+  GstAllocatorClass *allocator_class = GST_ALLOCATOR_CLASS (klass);
+
+  allocator_class->alloc = GST_DEBUG_FUNCPTR (gst_spout_page_allocator_alloc);
+  allocator_class->free = GST_DEBUG_FUNCPTR (gst_spout_page_allocator_free);
+
+  GST_DEBUG_CATEGORY_INIT (gst_spout_page_allocator_debug,
+      "spoutpageallocator", 0, "Spout Page Allocator");
+}
+
+static void
+gst_spout_page_allocator_init (GstSpoutPageAllocator * self)
+{
+  GstAllocator *allocator = GST_ALLOCATOR_CAST (self);
+
+  allocator->mem_type = GST_SPOUT_PAGE_MEMORY_TYPE;
+  allocator->mem_map = gst_spout_page_memory_map;
+  allocator->mem_unmap = gst_spout_page_memory_unmap;
+  allocator->mem_share = gst_spout_page_memory_share;
+
+  self->kind = -1;
+}
+
+GstAllocator *
+gst_spout_page_allocator_new (gboolean huge_pages, gint numa_node)
+{
+  GstSpoutPageAllocator *self;
+
+  self = (GstSpoutPageAllocator *)
+      g_object_new (GST_TYPE_SPOUT_PAGE_ALLOCATOR, NULL);
+  self->huge_pages = huge_pages;
+  self->numa_node = numa_node;
+
+  /* Allocators start out floating */
+  gst_object_ref_sink (self);
+
+  return GST_ALLOCATOR_CAST (self);
+}
+
+GstSpoutPageKind
+gst_spout_page_allocator_get_kind (GstAllocator * allocator)
+{
+  int kind = GST_SPOUT_PAGE_ALLOCATOR (allocator)->kind.load ();
+
+  return kind < 0 ? GST_SPOUT_PAGES_NORMAL : (GstSpoutPageKind) kind;
+}
@@ -0,0 +1,45 @@
+/* GStreamer
+ * Copyright (C) 2023 Your Name <your.email@example.com>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+/* Define GST_USE_UNSTABLE_API to avoid warnings about unstable API */
+#define GST_USE_UNSTABLE_API
+
+#pragma once
+
+#include <gst/gst.h>
+#include "gstspouthugepages.h"
+
+G_BEGIN_DECLS
+
+#define GST_SPOUT_PAGE_MEMORY_TYPE "SpoutPageMemory"
+
+#define GST_TYPE_SPOUT_PAGE_ALLOCATOR (gst_spout_page_allocator_get_type())
+G_DECLARE_FINAL_TYPE (GstSpoutPageAllocator, gst_spout_page_allocator,
+    GST, SPOUT_PAGE_ALLOCATOR, GstAllocator);
+
+G_END_DECLS
+
+/* System memory on huge pages if @huge_pages and on @numa_node unless it is
+ * negative, see gst_spout_pages_alloc(). Every memory is faulted in as it
+ * is allocated, so pools pay for it when they are activated */
+GstAllocator * gst_spout_page_allocator_new (gboolean huge_pages,
+    gint numa_node);
+
+/* Pages the last memory got, the system may not grant what was asked */
+GstSpoutPageKind gst_spout_page_allocator_get_kind (GstAllocator * allocator);
@@ -0,0 +1,168 @@
+/* GStreamer
+ * Copyright (C) 2023 Your Name <your.email@example.com>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#pragma once
+
+/* Receive backends for spoutsrc.
+ *
+ * spoutDX hands out D3D11 textures and stays wired into the element's GPU
+ * path. Every other backend delivers frames in system memory through a
+ * GstSpoutFrameReceiver, which the element drives without any D3D11 device:
+ * it waits for a frame, wraps the receiver's memory into a buffer without
+ * copying and gives the lease back once downstream lets go of it. Backends
+ * whose frames live in memory shared by file descriptor hand out the fd as
+ * well, for consumers that import frames rather than map them. Free of
+ * GStreamer, D3D11 and Spout. */
+
+#include "gstspoutcapture.h"
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <utility>
+
+typedef enum
+{
+  GST_SPOUT_BACKEND_SPOUT,      /* spoutDX, D3D11 textures */
+  GST_SPOUT_BACKEND_SHM,        /* frame ring in named shared memory */
+  GST_SPOUT_BACKEND_REPLAY,     /* recording file */
+} GstSpoutBackend;
+
+/* Frames as a backend delivers them. format uses DXGI_FORMAT codes like
+ * Spout senders, stride is the distance between rows in bytes */
+struct GstSpoutFrameFormat
+{
+  uint32_t width = 0;
+  uint32_t height = 0;
+  uint32_t format = 0;
+  uint32_t stride = 0;
+  double fps = 0.0;
+
+  bool operator== (const GstSpoutFrameFormat &) const = default;
+};
+
+/* A received frame. The memory stays valid and unchanged until the lease is
+ * released, by release() or by destroying it */
+class GstSpoutFrameLease
+{
+public:
+  GstSpoutFrameLease () = default;
+  ~GstSpoutFrameLease () { release (); }
+
+  GstSpoutFrameLease (GstSpoutFrameLease && other) noexcept
+  {
+    *this = std::move (other);
+  }
+
+  GstSpoutFrameLease & operator= (GstSpoutFrameLease && other) noexcept
+  {
+    if (this != &other) {
+      release ();
+      data = other.data;
+      size = other.size;
+      fd = other.fd;
+      offset = other.offset;
+      frame = other.frame;
+      timestamp = other.timestamp;
+      release_ = std::move (other.release_);
+      other.data = nullptr;
+      other.size = 0;
+      other.fd = -1;
+      other.release_ = nullptr;
+    }
+    return *this;
+  }
+
+  GstSpoutFrameLease (const GstSpoutFrameLease &) = delete;
+  GstSpoutFrameLease & operator= (const GstSpoutFrameLease &) = delete;
+
+  /* Called by the backend that filled in the lease */
+  void hold (const uint8_t * frame_data, size_t frame_size,
+      std::function<void ()> on_release)
+  {
+    release ();
+    data = frame_data;
+    size = frame_size;
+    release_ = std::move (on_release);
+  }
+
+  void release ()
+  {
+    if (release_)
+      std::exchange (release_, nullptr) ();
+    data = nullptr;
+    size = 0;
+    fd = -1;
+    offset = 0;
+  }
+
+  bool held () const { return data != nullptr; }
+
+  const uint8_t *data = nullptr;
+  size_t size = 0;
+  int fd = -1;                /* shared memory data is at offset in, open
+                               * while the lease is held. -1 if none */
+  size_t offset = 0;
+  uint64_t frame = 0;         /* sender frame number, counting from 1 */
+  uint64_t timestamp = 0;     /* sender's monotonic clock in ns, 0 if unknown */
+
+private:
+  std::function<void ()> release_;
+};
+
+/* A source of system memory frames. connect(), disconnect() and receive()
+ * are called by one thread at a time; wake() from any thread */
+class GstSpoutFrameReceiver
+{
+public:
+  using Duration = std::chrono::microseconds;
+
+  virtual ~GstSpoutFrameReceiver () = default;
+
+  /* Whether a sender called @name is there, any sender for an empty name */
+  virtual bool available (const std::string & name) = 0;
+
+  /* Attach to the sender called @name, the newest one for an empty name */
+  virtual bool connect (const std::string & name) = 0;
+
+  /* Leases already handed out stay valid */
+  virtual void disconnect () = 0;
+
+  /* Whether leases carry a file descriptor, also while not connected */
+  virtual bool shares_fd () const { return false; }
+
+  /* Whether no sender will ever be there again, like at the end of a
+   * recording */
+  virtual bool finished () const { return false; }
+
+  /* Name and frame format of the connected sender */
+  virtual std::string sender_name () const = 0;
+  virtual GstSpoutFrameFormat format () const = 0;
+
+  /* Wait up to @timeout for a frame newer than the last one received.
+   * ERROR means the sender went away, connect again */
+  virtual GstSpoutReceiveResult receive (GstSpoutFrameLease & lease,
+      Duration timeout) = 0;
+
+  /* Make a receive() in progress, or else the next one, return NO_FRAME
+   * right away */
+  virtual void wake () = 0;
+};
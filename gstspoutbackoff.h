@@ -0,0 +1,150 @@
+/* GStreamer
+ * Copyright (C) 2023 Your Name <your.email@example.com>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+#pragma once
+
+/* Reconnect scheduling for spoutsrc.
+ *
+ * Jittered exponential backoff with a give-up policy. Time is always passed
+ * in by the caller, so a simulated clock can drive it on any platform. Free
+ * of GStreamer, D3D11 and Spout. */
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+
+typedef enum
+{
+  GST_SPOUT_GIVE_UP_NEVER,      /* keep retrying forever */
+  GST_SPOUT_GIVE_UP_ATTEMPTS,   /* after a number of failed attempts */
+  GST_SPOUT_GIVE_UP_DURATION,   /* once disconnected for a given time */
+} GstSpoutGiveUpPolicy;
+
+class GstSpoutBackoff
+{
+public:
+  using Clock = std::chrono::steady_clock;
+  using Duration = std::chrono::milliseconds;
+  using TimePoint = Clock::time_point;
+
+  struct Config
+  {
+    Duration initial { 50 };
+    Duration max { 5000 };
+    double factor = 2.0;
+    double jitter = 0.25;   /* delays vary by up to +-25% */
+    GstSpoutGiveUpPolicy policy = GST_SPOUT_GIVE_UP_NEVER;
+    uint32_t max_attempts = 5;
+    Duration max_duration { 30000 };
+  };
+
+  void configure (const Config & config) { config_ = config; reset (); }
+
+  /* Seed the jitter, e.g. to get reproducible delays in tests. Seeds close
+   * together, like start times of elements that lost the same sender, are
+   * scrambled (splitmix64) so their delays don't start out alike */
+  void seed (uint64_t seed)
+  {
+    seed += 0x9e3779b97f4a7c15ull;
+    seed = (seed ^ (seed >> 30)) * 0xbf58476d1ce4e5b9ull;
+    seed = (seed ^ (seed >> 27)) * 0x94d049bb133111ebull;
+    seed ^= seed >> 31;
+    rng_ = seed ? seed : 1;
+  }
+
+  /* Connected (again), forget previous failures */
+  void reset ()
+  {
+    attempts_ = 0;
+    delay_ = config_.initial;
+    given_up_ = false;
+    have_first_failure_ = false;
+  }
+
+  /* An attempt failed at @now. Returns FALSE if the policy gives up,
+   * otherwise next_attempt() says when to try again */
+  bool failed (TimePoint now)
+  {
+    if (given_up_)
+      return false;
+
+    if (!have_first_failure_) {
+      first_failure_ = now;
+      have_first_failure_ = true;
+    }
+
+    attempts_++;
+
+    switch (config_.policy) {
+      case GST_SPOUT_GIVE_UP_ATTEMPTS:
+        given_up_ = attempts_ >= config_.max_attempts;
+        break;
+      case GST_SPOUT_GIVE_UP_DURATION:
+        given_up_ = now - first_failure_ >= config_.max_duration;
+        break;
+      case GST_SPOUT_GIVE_UP_NEVER:
+      default:
+        break;
+    }
+
+    if (given_up_)
+      return false;
+
+    next_attempt_ = now + jittered (delay_);
+    delay_ = std::min (Duration ((Duration::rep) (delay_.count () * config_.factor)),
+        config_.max);
+
+    /* Don't oversleep the give-up deadline */
+    if (config_.policy == GST_SPOUT_GIVE_UP_DURATION)
+      next_attempt_ = std::min (next_attempt_, first_failure_ + config_.max_duration);
+
+    return true;
+  }
+
+  /* Retry right away, e.g. when the sender just appeared. Doesn't reset the
+   * attempt count or the give-up deadline */
+  void expedite (TimePoint now) { next_attempt_ = now; }
+
+  bool due (TimePoint now) const { return !given_up_ && now >= next_attempt_; }
+  TimePoint next_attempt () const { return next_attempt_; }
+  uint32_t attempts () const { return attempts_; }
+  bool given_up () const { return given_up_; }
+
+private:
+  Duration jittered (Duration delay)
+  {
+    /* xorshift64, plenty for spreading out retries */
+    rng_ ^= rng_ << 13;
+    rng_ ^= rng_ >> 7;
+    rng_ ^= rng_ << 17;
+
+    double unit = (double) (rng_ >> 11) / (double) (1ull << 53);   /* [0, 1) */
+    double scale = 1.0 + config_.jitter * (2.0 * unit - 1.0);
+
+    return Duration ((Duration::rep) (delay.count () * scale));
+  }
+
+  Config config_;
+  uint32_t attempts_ = 0;
+  Duration delay_ = config_.initial;
+  bool given_up_ = false;
+  bool have_first_failure_ = false;
+  TimePoint first_failure_;
+  TimePoint next_attempt_;
+  uint64_t rng_ = 0x9e3779b97f4a7c15ull;
+};
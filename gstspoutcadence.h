@@ -0,0 +1,166 @@
+/* GStreamer
+ * Copyright (C) 2023 Your Name <your.email@example.com>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+#pragma once
+
+/* Sender cadence prediction for spoutsrc.
+ *
+ * Learns the sender's frame period from when new frames show up and works
+ * out how long the receiving thread may sleep before looking again: right
+ * up to just before the next frame is due, then a few tight polls around
+ * it. A frame that misses that window is polled for at the regular interval
+ * for up to half a period before its slot counts as skipped. Free of
+ * GStreamer and Spout so recorded cadence traces can drive it on any
+ * platform. Not thread-safe, only the thread that receives uses it. Times
+ * are in nanoseconds. */
+
+#include <algorithm>
+#include <cstdint>
+
+class GstSpoutCadencePredictor
+{
+public:
+  /* Frame intervals the period and jitter are estimated from */
+  static constexpr unsigned WINDOW = 32;
+  static constexpr unsigned MIN_SAMPLES = 4;
+
+  void reset ()
+  {
+    count_ = 0;
+    next_ = 0;
+    have_last_ = false;
+    polls_ = 0;
+    period_ = 0;
+    jitter_ = 0;
+  }
+
+  /* @poll_interval: polling pace without a prediction and for late frames,
+   * @budget: polls around each expected frame */
+  void configure (uint64_t poll_interval, unsigned budget)
+  {
+    poll_interval_ = std::max<uint64_t> (poll_interval, 1);
+    budget_ = std::max (budget, 1u);
+  }
+
+  /* The sender's advertised period, used until enough frames were seen */
+  void set_nominal_period (uint64_t period) { nominal_period_ = period; }
+
+  /* A new frame showed up at @time */
+  void frame (uint64_t time)
+  {
+    if (have_last_ && time > last_) {
+      intervals_[next_] = time - last_;
+      next_ = (next_ + 1) % WINDOW;
+      count_ = std::min (count_ + 1, WINDOW);
+      estimate ();
+    }
+
+    last_ = time;
+    have_last_ = true;
+    expected_ = time + period ();
+    polls_ = 0;
+  }
+
+  /* How long to sleep at @now before polling the sender again */
+  uint64_t next_poll (uint64_t now)
+  {
+    uint64_t period = this->period ();
+
+    if (!have_last_ || period == 0)
+      return poll_interval_;
+
+    for (;;) {
+      uint64_t guard = this->guard ();
+      uint64_t wake = expected_ > guard ? expected_ - guard : 0;
+
+      if (now < wake)
+        return wake - now;
+
+      /* Tight polls spread over the window around the expected frame */
+      if (now < expected_ + guard && polls_ < budget_) {
+        polls_++;
+        return std::clamp<uint64_t> (2 * guard / budget_,
+            std::min<uint64_t> (poll_interval_ / 4, guard), poll_interval_);
+      }
+
+      /* Late beyond the jitter seen so far, keep looking at the usual pace
+       * for a while */
+      if (now < expected_ + period / 2)
+        return std::min (poll_interval_, expected_ + period / 2 - now);
+
+      /* The sender skipped a frame, wait for the next one */
+      expected_ += period;
+      polls_ = 0;
+      skipped_++;
+    }
+  }
+
+  /* Estimated frame period, the nominal one until enough frames came in */
+  uint64_t period () const
+  {
+    return count_ >= MIN_SAMPLES ? period_ : nominal_period_;
+  }
+
+  /* How early to wake up before a frame is due */
+  uint64_t guard () const
+  {
+    uint64_t guard = std::max (3 * jitter_, poll_interval_ / 2);
+
+    return std::min (guard, period () / 2);
+  }
+
+  /* Frame slots given up on */
+  uint64_t skipped () const { return skipped_; }
+
+private:
+  /* Median interval and median absolute deviation, robust against the odd
+   * skipped frame or late wakeup */
+  void estimate ()
+  {
+    uint64_t sorted[WINDOW];
+    uint64_t deviations[WINDOW];
+    unsigned mid = count_ / 2;
+
+    std::copy (intervals_, intervals_ + count_, sorted);
+    std::nth_element (sorted, sorted + mid, sorted + count_);
+    period_ = sorted[mid];
+
+    for (unsigned i = 0; i < count_; i++) {
+      deviations[i] = intervals_[i] > period_ ?
+          intervals_[i] - period_ : period_ - intervals_[i];
+    }
+    std::nth_element (deviations, deviations + mid, deviations + count_);
+    jitter_ = deviations[mid];
+  }
+
+  uint64_t poll_interval_ = 1000000;
+  unsigned budget_ = 8;
+  uint64_t nominal_period_ = 0;
+
+  uint64_t intervals_[WINDOW] = { };
+  unsigned count_ = 0;
+  unsigned next_ = 0;
+  uint64_t period_ = 0;
+  uint64_t jitter_ = 0;
+
+  bool have_last_ = false;
+  uint64_t last_ = 0;
+  uint64_t expected_ = 0;
+  unsigned polls_ = 0;
+  uint64_t skipped_ = 0;
+};
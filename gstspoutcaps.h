@@ -0,0 +1,144 @@
+/* GStreamer
+ * Copyright (C) 2023 Your Name <your.email@example.com>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+#pragma once
+
+/* Caps state machine for spoutsrc.
+ *
+ * Keeps the sender format the caps were built from and only asks for
+ * renegotiation when the sender really changed. Free of GStreamer, D3D11
+ * and Spout so a scripted sequence of sender formats can drive it on any
+ * platform. Not thread-safe, the element serializes calls with its lock. */
+
+#include <cmath>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/* Format as advertised by the sender */
+struct GstSpoutSenderFormat
+{
+  uint32_t width = 0;
+  uint32_t height = 0;
+  uint32_t format = 0;      /* DXGI_FORMAT */
+  double fps = 0.0;
+
+  /* Senders report a measured frame rate, so only count deviations above
+   * @fps_tolerance (relative) as a change */
+  bool same_as (const GstSpoutSenderFormat & other,
+      double fps_tolerance = 0.01) const
+  {
+    if (width != other.width || height != other.height ||
+        format != other.format)
+      return false;
+
+    if (fps == other.fps)
+      return true;
+
+    return std::fabs (fps - other.fps) <= fps_tolerance * std::fmax (fps, other.fps);
+  }
+};
+
+/* Every real change bumps generation(). Whoever pushes caps remembers the
+ * generation it negotiated and renegotiates once the two differ, so the
+ * comparison can happen on another thread than the push */
+class GstSpoutCapsState
+{
+public:
+  /* Forget the sender format, the next update() is always a change.
+   * generation() keeps counting */
+  void reset ()
+  {
+    have_format_ = false;
+    current_ = GstSpoutSenderFormat ();
+  }
+
+  /* Compare @format against the current one. Returns TRUE if it differs, in
+   * which case it becomes current() and generation() moves on */
+  bool update (const GstSpoutSenderFormat & format)
+  {
+    if (have_format_ && format.same_as (current_))
+      return false;
+
+    current_ = format;
+    have_format_ = true;
+    generation_++;
+
+    return true;
+  }
+
+  const GstSpoutSenderFormat & current () const { return current_; }
+  bool has_format () const { return have_format_; }
+
+  /* 0 until the first format, then the number of changes seen */
+  uint64_t generation () const { return generation_; }
+
+private:
+  bool have_format_ = false;
+  GstSpoutSenderFormat current_;
+  uint64_t generation_ = 0;
+};
+
+/* How frames reach downstream in the format it negotiated */
+typedef enum
+{
+  GST_SPOUT_OUTPUT_NATIVE,        /* the sender's format, copied as is */
+  GST_SPOUT_OUTPUT_CONVERT,       /* converted on the GPU while copying */
+  GST_SPOUT_OUTPUT_UNSUPPORTED,
+} GstSpoutOutputPath;
+
+/* Formats the GPU converts sender frames to, for hardware encoders */
+static inline const std::vector<std::string> &
+gst_spout_caps_convert_formats (void)
+{
+  static const std::vector<std::string> formats = { "NV12", "P010_10LE" };
+
+  return formats;
+}
+
+/* D3D11 memory formats offered for a sender sharing @native, preferred
+ * first. Native comes first so fixation only converts if downstream
+ * insists */
+static inline std::vector<std::string>
+gst_spout_caps_d3d11_formats (const std::string & native)
+{
+  std::vector<std::string> formats = { native };
+
+  for (const auto & format : gst_spout_caps_convert_formats ()) {
+    if (format != native)
+      formats.push_back (format);
+  }
+
+  return formats;
+}
+
+/* What delivering @chosen takes for a sender sharing @native */
+static inline GstSpoutOutputPath
+gst_spout_caps_output_path (const std::string & native,
+    const std::string & chosen)
+{
+  if (chosen == native)
+    return GST_SPOUT_OUTPUT_NATIVE;
+
+  for (const auto & format : gst_spout_caps_convert_formats ()) {
+    if (format == chosen)
+      return GST_SPOUT_OUTPUT_CONVERT;
+  }
+
+  return GST_SPOUT_OUTPUT_UNSUPPORTED;
+}
@@ -0,0 +1,278 @@
+/* GStreamer
+ * Copyright (C) 2023 Your Name <your.email@example.com>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#pragma once
+
+/* Capture thread and latest-frame handoff for spoutsrc.
+ *
+ * Nothing in here depends on GStreamer, D3D11 or Spout: the element plugs in
+ * a GstSpoutFrameSource that receives into pool buffers, while a synthetic
+ * source can drive the same code on any platform. */
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+#include <utility>
+
+/* Outcome of a single receive attempt */
+enum class GstSpoutReceiveResult
+{
+  FRAME,     /* a new frame was written into the frame */
+  NO_FRAME,  /* the sender has not produced a new frame yet */
+  ERROR,     /* receiving failed, the frame content is undefined */
+};
+
+/* Receiver interface driven by GstSpoutCaptureThread */
+template <typename Frame>
+class GstSpoutFrameSource
+{
+public:
+  using Duration = std::chrono::microseconds;
+
+  virtual ~GstSpoutFrameSource () = default;
+
+  /* Provide an empty frame to receive into, e.g. from a buffer pool.
+   * Must not block for long, the capture thread retries on failure */
+  virtual bool acquire (Frame & frame) = 0;
+
+  /* Receive the sender's current frame into @frame */
+  virtual GstSpoutReceiveResult receive (Frame & frame) = 0;
+
+  /* Give back a frame which will never reach the consumer */
+  virtual void release (Frame & frame) = 0;
+
+  /* How long to wait after NO_FRAME before receiving again */
+  virtual Duration idle (Duration poll_interval) { return poll_interval; }
+};
+
+/* Lock-free single-producer/single-consumer latest-frame ring.
+ *
+ * Three slots rotate between the producer (back), the consumer (front) and
+ * the shared middle slot, whose index and "fresh" bit live in one atomic.
+ * Publishing a frame while the previous one is still fresh replaces it, so
+ * the consumer always gets the newest completed frame and stale ones are
+ * handed back to the producer for reuse instead of queueing up. */
+template <typename Frame>
+class GstSpoutFrameRing
+{
+public:
+  /* Producer: slot to receive the next frame into */
+  Frame & back () { return slots_[back_]; }
+
+  /* Producer: make back() visible to the consumer. Returns TRUE if a frame
+   * the consumer never saw was displaced; it is now in back() and may be
+   * received into again */
+  bool publish ()
+  {
+    uint8_t prev = latest_.exchange (back_ | FRESH, std::memory_order_acq_rel);
+
+    back_ = prev & INDEX_MASK;
+    published_.fetch_add (1, std::memory_order_relaxed);
+
+    if (prev & FRESH) {
+      dropped_.fetch_add (1, std::memory_order_relaxed);
+      return true;
+    }
+
+    return false;
+  }
+
+  /* Consumer: is there a frame newer than the last popped one */
+  bool has_frame () const
+  {
+    return (latest_.load (std::memory_order_acquire) & FRESH) != 0;
+  }
+
+  /* Consumer: take the newest frame, if any */
+  bool pop (Frame & frame)
+  {
+    if (!has_frame ())
+      return false;
+
+    uint8_t prev = latest_.exchange (front_, std::memory_order_acq_rel);
+    front_ = prev & INDEX_MASK;
+
+    frame = std::move (slots_[front_]);
+    slots_[front_] = Frame ();
+    consumed_.fetch_add (1, std::memory_order_relaxed);
+
+    return true;
+  }
+
+  uint64_t published () const { return published_.load (std::memory_order_relaxed); }
+  uint64_t dropped () const { return dropped_.load (std::memory_order_relaxed); }
+  uint64_t consumed () const { return consumed_.load (std::memory_order_relaxed); }
+
+private:
+  static constexpr uint8_t INDEX_MASK = 0x3;
+  static constexpr uint8_t FRESH = 0x4;
+
+  Frame slots_[3] = { };
+  std::atomic<uint8_t> latest_ { 1 };
+  uint8_t back_ = 0;    /* producer only */
+  uint8_t front_ = 2;   /* consumer only */
+
+  std::atomic<uint64_t> published_ { 0 };
+  std::atomic<uint64_t> dropped_ { 0 };
+  std::atomic<uint64_t> consumed_ { 0 };
+};
+
+/* Runs a GstSpoutFrameSource on its own thread and hands the newest frame
+ * to the consumer through a GstSpoutFrameRing */
+template <typename Frame>
+class GstSpoutCaptureThread
+{
+public:
+  using Duration = std::chrono::microseconds;
+
+  ~GstSpoutCaptureThread () { stop (); }
+
+  /* @poll_interval: pause after NO_FRAME, @retry_interval: pause after
+   * acquire or receive failures */
+  void start (GstSpoutFrameSource<Frame> * source, Duration poll_interval,
+      Duration retry_interval)
+  {
+    stop ();
+
+    source_ = source;
+    poll_interval_ = poll_interval;
+    retry_interval_ = retry_interval;
+    stopping_ = false;
+    thread_ = std::thread (&GstSpoutCaptureThread::loop, this);
+  }
+
+  /* Join the thread and release every frame still owned by the ring */
+  void stop ()
+  {
+    if (!thread_.joinable ())
+      return;
+
+    {
+      std::lock_guard<std::mutex> lock (lock_);
+      stopping_ = true;
+    }
+    cond_.notify_all ();
+    thread_.join ();
+
+    Frame frame;
+    while (ring_.pop (frame))
+      source_->release (frame);
+
+    if (have_back_) {
+      source_->release (ring_.back ());
+      have_back_ = false;
+    }
+
+    source_ = nullptr;
+  }
+
+  bool running () const { return thread_.joinable (); }
+
+  /* While flushing, pop_latest() returns immediately without a frame */
+  void set_flushing (bool flushing)
+  {
+    {
+      std::lock_guard<std::mutex> lock (lock_);
+      flushing_ = flushing;
+    }
+    cond_.notify_all ();
+  }
+
+  /* Consumer: wait up to @timeout for a frame newer than the last one */
+  bool pop_latest (Frame & frame, Duration timeout)
+  {
+    if (ring_.pop (frame))
+      return true;
+
+    std::unique_lock<std::mutex> lock (lock_);
+    cond_.wait_for (lock, timeout, [this] {
+      return flushing_ || ring_.has_frame ();
+    });
+
+    if (flushing_)
+      return false;
+
+    return ring_.pop (frame);
+  }
+
+  uint64_t frames_received () const { return ring_.published (); }
+  uint64_t frames_dropped () const { return ring_.dropped (); }
+  uint64_t frames_consumed () const { return ring_.consumed (); }
+
+private:
+  /* Sleep on the condition so stop() does not wait out the interval */
+  void pause (Duration interval)
+  {
+    std::unique_lock<std::mutex> lock (lock_);
+    cond_.wait_for (lock, interval, [this] { return stopping_; });
+  }
+
+  bool stopping ()
+  {
+    std::lock_guard<std::mutex> lock (lock_);
+    return stopping_;
+  }
+
+  void loop ()
+  {
+    while (!stopping ()) {
+      if (!have_back_) {
+        if (!source_->acquire (ring_.back ())) {
+          pause (retry_interval_);
+          continue;
+        }
+        have_back_ = true;
+      }
+
+      switch (source_->receive (ring_.back ())) {
+        case GstSpoutReceiveResult::FRAME:
+          /* A displaced stale frame comes back already acquired */
+          have_back_ = ring_.publish ();
+          {
+            /* Serialize with the predicate check in pop_latest() so the
+             * wakeup cannot be lost */
+            std::lock_guard<std::mutex> lock (lock_);
+          }
+          cond_.notify_all ();
+          break;
+        case GstSpoutReceiveResult::NO_FRAME:
+          pause (source_->idle (poll_interval_));
+          break;
+        case GstSpoutReceiveResult::ERROR:
+          pause (retry_interval_);
+          break;
+      }
+    }
+  }
+
+  GstSpoutFrameSource<Frame> *source_ = nullptr;
+  GstSpoutFrameRing<Frame> ring_;
+  bool have_back_ = false;    /* capture thread only */
+
+  std::thread thread_;
+  std::mutex lock_;
+  std::condition_variable cond_;
+  bool stopping_ = false;
+  bool flushing_ = false;
+  Duration poll_interval_ { 1000 };
+  Duration retry_interval_ { 16000 };
+};
@@ -0,0 +1,583 @@
+/* GStreamer
+ * Copyright (C) 2023 Your Name <your.email@example.com>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#include "gstspoutconvert.h"
+
+#include <algorithm>
+#include <cstring>
+
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86)
+#define GST_SPOUT_CONVERT_X86 1
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+#endif
+
+/* GCC and clang only emit SSE4.1 and AVX2 code in functions asking for it,
+ * MSVC always does */
+#if defined(__GNUC__) || defined(__clang__)
+#define GST_SPOUT_TARGET(t) __attribute__ ((target (t)))
+#else
+#define GST_SPOUT_TARGET(t)
+#endif
+
+/* BT.709 limited range, 8 bit fixed point. Chroma rows sum to zero so grey
+ * stays neutral */
+#define Y_R   47
+#define Y_G  157
+#define Y_B   16
+#define U_R  -26
+#define U_G  -86
+#define U_B  112
+#define V_R  112
+#define V_G -102
+#define V_B  -10
+
+namespace {
+
+/* Everything a kernel needs to know about the formats */
+struct ConvertParams
+{
+  int r, g, b;                  /* source channel byte offsets */
+  int16_t cy[8], cu[8], cv[8];  /* coefficients in source byte order, x2 */
+  uint8_t shuffle[16];          /* packed output: source byte of each byte */
+  uint32_t alpha;               /* packed output: or'ed into each pixel */
+};
+
+struct PlaneRows
+{
+  const uint8_t *src0, *src1;   /* src1 == src0 on a trailing odd row */
+  uint8_t *y0, *y1;             /* y1 is NULL on a trailing odd row */
+  uint8_t *u, *v;               /* I420 */
+  uint8_t *uv;                  /* NV12 */
+};
+
+typedef void (*PackedRowFunc) (const ConvertParams & p, const uint8_t * src,
+    uint8_t * dest, uint32_t width);
+typedef void (*YuvRowsFunc) (const ConvertParams & p, const PlaneRows & rows,
+    uint32_t width);
+
+inline bool
+is_packed (GstSpoutPixelFormat format)
+{
+  return format >= GST_SPOUT_PIXEL_FORMAT_BGRA &&
+      format <= GST_SPOUT_PIXEL_FORMAT_RGBX;
+}
+
+inline bool
+has_alpha (GstSpoutPixelFormat format)
+{
+  return format == GST_SPOUT_PIXEL_FORMAT_BGRA ||
+      format == GST_SPOUT_PIXEL_FORMAT_RGBA;
+}
+
+inline void
+channel_offsets (GstSpoutPixelFormat format, int & r, int & g, int & b)
+{
+  bool bgr = format == GST_SPOUT_PIXEL_FORMAT_BGRA ||
+      format == GST_SPOUT_PIXEL_FORMAT_BGRX;
+
+  r = bgr ? 2 : 0;
+  g = 1;
+  b = bgr ? 0 : 2;
+}
+
+ConvertParams
+make_params (GstSpoutPixelFormat in, GstSpoutPixelFormat out)
+{
+  ConvertParams p = { };
+
+  channel_offsets (in, p.r, p.g, p.b);
+
+  for (int i = 0; i < 8; i += 4) {
+    p.cy[i + p.r] = Y_R; p.cy[i + p.g] = Y_G; p.cy[i + p.b] = Y_B;
+    p.cu[i + p.r] = U_R; p.cu[i + p.g] = U_G; p.cu[i + p.b] = U_B;
+    p.cv[i + p.r] = V_R; p.cv[i + p.g] = V_G; p.cv[i + p.b] = V_B;
+  }
+
+  if (is_packed (out)) {
+    int r, g, b;
+
+    channel_offsets (out, r, g, b);
+    for (int i = 0; i < 16; i += 4) {
+      p.shuffle[i + r] = (uint8_t) (i + p.r);
+      p.shuffle[i + g] = (uint8_t) (i + p.g);
+      p.shuffle[i + b] = (uint8_t) (i + p.b);
+      p.shuffle[i + 3] = (uint8_t) (i + 3);
+    }
+
+    /* Padding bytes become opaque, alpha passes through */
+    if (!has_alpha (in) && has_alpha (out))
+      p.alpha = 0xff000000;
+  }
+
+  return p;
+}
+
+/* Scalar reference */
+
+inline uint8_t
+luma (int r, int g, int b)
+{
+  return (uint8_t) (((Y_R * r + Y_G * g + Y_B * b + 128) >> 8) + 16);
+}
+
+inline uint8_t
+chroma_u (int r, int g, int b)
+{
+  return (uint8_t) (((U_R * r + U_G * g + U_B * b + 128) >> 8) + 128);
+}
+
+inline uint8_t
+chroma_v (int r, int g, int b)
+{
+  return (uint8_t) (((V_R * r + V_G * g + V_B * b + 128) >> 8) + 128);
+}
+
+void
+packed_row_scalar (const ConvertParams & p, const uint8_t * src,
+    uint8_t * dest, uint32_t width)
+{
+  for (uint32_t x = 0; x < width; x++, src += 4, dest += 4) {
+    uint32_t pixel;
+
+    dest[0] = src[p.shuffle[0]];
+    dest[1] = src[p.shuffle[1]];
+    dest[2] = src[p.shuffle[2]];
+    dest[3] = src[p.shuffle[3]];
+
+    memcpy (&pixel, dest, 4);
+    pixel |= p.alpha;
+    memcpy (dest, &pixel, 4);
+  }
+}
+
+/* Pixels [@x, @width) of a row pair, the last column of an odd width is
+ * averaged with itself */
+void
+yuv_rows_tail (const ConvertParams & p, const PlaneRows & rows, uint32_t x,
+    uint32_t width)
+{
+  for (; x < width; x += 2) {
+    uint32_t x1 = std::min (x + 1, width - 1);
+    const uint8_t *a = rows.src0 + x * 4, *b = rows.src0 + x1 * 4;
+    const uint8_t *c = rows.src1 + x * 4, *d = rows.src1 + x1 * 4;
+    int r, g, bl;
+
+    rows.y0[x] = luma (a[p.r], a[p.g], a[p.b]);
+    if (x1 != x)
+      rows.y0[x1] = luma (b[p.r], b[p.g], b[p.b]);
+    if (rows.y1) {
+      rows.y1[x] = luma (c[p.r], c[p.g], c[p.b]);
+      if (x1 != x)
+        rows.y1[x1] = luma (d[p.r], d[p.g], d[p.b]);
+    }
+
+    r = (a[p.r] + b[p.r] + c[p.r] + d[p.r] + 2) >> 2;
+    g = (a[p.g] + b[p.g] + c[p.g] + d[p.g] + 2) >> 2;
+    bl = (a[p.b] + b[p.b] + c[p.b] + d[p.b] + 2) >> 2;
+
+    if (rows.uv) {
+      rows.uv[x] = chroma_u (r, g, bl);
+      rows.uv[x + 1] = chroma_v (r, g, bl);
+    } else {
+      rows.u[x / 2] = chroma_u (r, g, bl);
+      rows.v[x / 2] = chroma_v (r, g, bl);
+    }
+  }
+}
+
+void
+yuv_rows_scalar (const ConvertParams & p, const PlaneRows & rows,
+    uint32_t width)
+{
+  yuv_rows_tail (p, rows, 0, width);
+}
+
+#ifdef GST_SPOUT_CONVERT_X86
+
+/* SSE4.1: 4 pixels per register */
+
+GST_SPOUT_TARGET ("sse4.1") void
+packed_row_sse41 (const ConvertParams & p, const uint8_t * src,
+    uint8_t * dest, uint32_t width)
+{
+  const __m128i shuffle = _mm_loadu_si128 ((const __m128i *) p.shuffle);
+  const __m128i alpha = _mm_set1_epi32 ((int) p.alpha);
+  uint32_t x = 0;
+
+  for (; x + 4 <= width; x += 4) {
+    __m128i px = _mm_loadu_si128 ((const __m128i *) (src + x * 4));
+
+    px = _mm_or_si128 (_mm_shuffle_epi8 (px, shuffle), alpha);
+    _mm_storeu_si128 ((__m128i *) (dest + x * 4), px);
+  }
+
+  packed_row_scalar (p, src + x * 4, dest + x * 4, width - x);
+}
+
+/* Luma of the 4 pixels in @px, as 32 bit lanes */
+GST_SPOUT_TARGET ("sse4.1") inline __m128i
+luma4_sse41 (__m128i px, __m128i cy)
+{
+  const __m128i zero = _mm_setzero_si128 ();
+  __m128i lo = _mm_madd_epi16 (_mm_cvtepu8_epi16 (px), cy);
+  __m128i hi = _mm_madd_epi16 (_mm_unpackhi_epi8 (px, zero), cy);
+  __m128i sum = _mm_hadd_epi32 (lo, hi);
+
+  sum = _mm_srai_epi32 (_mm_add_epi32 (sum, _mm_set1_epi32 (128)), 8);
+  return _mm_add_epi32 (sum, _mm_set1_epi32 (16));
+}
+
+/* Luma of 8 pixels at @src into @dest */
+GST_SPOUT_TARGET ("sse4.1") inline void
+luma8_sse41 (const uint8_t * src, uint8_t * dest, __m128i cy)
+{
+  __m128i a = luma4_sse41 (_mm_loadu_si128 ((const __m128i *) src), cy);
+  __m128i b = luma4_sse41 (_mm_loadu_si128 ((const __m128i *) (src + 16)), cy);
+  __m128i y = _mm_packs_epi32 (a, b);
+
+  _mm_storel_epi64 ((__m128i *) dest, _mm_packus_epi16 (y, y));
+}
+
+/* Rounded channel averages of the two 2x2 blocks in @top and @bottom,
+ * 16 bit lanes in source byte order */
+GST_SPOUT_TARGET ("sse4.1") inline __m128i
+blocks2_sse41 (__m128i top, __m128i bottom)
+{
+  const __m128i zero = _mm_setzero_si128 ();
+  __m128i a = _mm_add_epi16 (_mm_cvtepu8_epi16 (top), _mm_cvtepu8_epi16 (bottom));
+  __m128i b = _mm_add_epi16 (_mm_unpackhi_epi8 (top, zero),
+      _mm_unpackhi_epi8 (bottom, zero));
+  __m128i sum = _mm_add_epi16 (_mm_unpacklo_epi64 (a, b),
+      _mm_unpackhi_epi64 (a, b));
+
+  return _mm_srli_epi16 (_mm_add_epi16 (sum, _mm_set1_epi16 (2)), 2);
+}
+
+/* Chroma of 4 blocks given as two blocks2_sse41() results, 32 bit lanes */
+GST_SPOUT_TARGET ("sse4.1") inline __m128i
+chroma4_sse41 (__m128i a, __m128i b, __m128i c)
+{
+  __m128i sum = _mm_hadd_epi32 (_mm_madd_epi16 (a, c), _mm_madd_epi16 (b, c));
+
+  sum = _mm_srai_epi32 (_mm_add_epi32 (sum, _mm_set1_epi32 (128)), 8);
+  return _mm_add_epi32 (sum, _mm_set1_epi32 (128));
+}
+
+GST_SPOUT_TARGET ("sse4.1") void
+yuv_rows_sse41 (const ConvertParams & p, const PlaneRows & rows,
+    uint32_t width)
+{
+  const __m128i cy = _mm_loadu_si128 ((const __m128i *) p.cy);
+  const __m128i cu = _mm_loadu_si128 ((const __m128i *) p.cu);
+  const __m128i cv = _mm_loadu_si128 ((const __m128i *) p.cv);
+  uint32_t x = 0;
+
+  for (; x + 8 <= width; x += 8) {
+    const uint8_t *s0 = rows.src0 + x * 4, *s1 = rows.src1 + x * 4;
+    __m128i a, b, u, v;
+
+    luma8_sse41 (s0, rows.y0 + x, cy);
+    if (rows.y1)
+      luma8_sse41 (s1, rows.y1 + x, cy);
+
+    a = blocks2_sse41 (_mm_loadu_si128 ((const __m128i *) s0),
+        _mm_loadu_si128 ((const __m128i *) s1));
+    b = blocks2_sse41 (_mm_loadu_si128 ((const __m128i *) (s0 + 16)),
+        _mm_loadu_si128 ((const __m128i *) (s1 + 16)));
+
+    u = chroma4_sse41 (a, b, cu);
+    v = chroma4_sse41 (a, b, cv);
+    u = _mm_packus_epi16 (_mm_packs_epi32 (u, u), u);
+    v = _mm_packus_epi16 (_mm_packs_epi32 (v, v), v);
+
+    if (rows.uv) {
+      _mm_storel_epi64 ((__m128i *) (rows.uv + x), _mm_unpacklo_epi8 (u, v));
+    } else {
+      int32_t u4 = _mm_cvtsi128_si32 (u), v4 = _mm_cvtsi128_si32 (v);
+
+      memcpy (rows.u + x / 2, &u4, 4);
+      memcpy (rows.v + x / 2, &v4, 4);
+    }
+  }
+
+  yuv_rows_tail (p, rows, x, width);
+}
+
+/* AVX2: 8 pixels per register. Lane-crossing is fixed up with permutes */
+
+GST_SPOUT_TARGET ("avx2") void
+packed_row_avx2 (const ConvertParams & p, const uint8_t * src,
+    uint8_t * dest, uint32_t width)
+{
+  const __m256i shuffle = _mm256_broadcastsi128_si256 (
+      _mm_loadu_si128 ((const __m128i *) p.shuffle));
+  const __m256i alpha = _mm256_set1_epi32 ((int) p.alpha);
+  uint32_t x = 0;
+
+  for (; x + 8 <= width; x += 8) {
+    __m256i px = _mm256_loadu_si256 ((const __m256i *) (src + x * 4));
+
+    px = _mm256_or_si256 (_mm256_shuffle_epi8 (px, shuffle), alpha);
+    _mm256_storeu_si256 ((__m256i *) (dest + x * 4), px);
+  }
+
+  packed_row_scalar (p, src + x * 4, dest + x * 4, width - x);
+}
+
+/* Luma of the 8 pixels in @px, as 32 bit lanes in pixel order */
+GST_SPOUT_TARGET ("avx2") inline __m256i
+luma8_avx2 (__m256i px, __m256i cy)
+{
+  __m256i lo = _mm256_madd_epi16 (
+      _mm256_cvtepu8_epi16 (_mm256_castsi256_si128 (px)), cy);
+  __m256i hi = _mm256_madd_epi16 (
+      _mm256_cvtepu8_epi16 (_mm256_extracti128_si256 (px, 1)), cy);
+  __m256i sum = _mm256_hadd_epi32 (lo, hi);
+
+  sum = _mm256_permutevar8x32_epi32 (sum,
+      _mm256_setr_epi32 (0, 1, 4, 5, 2, 3, 6, 7));
+  sum = _mm256_srai_epi32 (_mm256_add_epi32 (sum, _mm256_set1_epi32 (128)), 8);
+  return _mm256_add_epi32 (sum, _mm256_set1_epi32 (16));
+}
+
+/* Luma of 16 pixels at @src into @dest */
+GST_SPOUT_TARGET ("avx2") inline void
+luma16_avx2 (const uint8_t * src, uint8_t * dest, __m256i cy)
+{
+  __m256i a = luma8_avx2 (_mm256_loadu_si256 ((const __m256i *) src), cy);
+  __m256i b = luma8_avx2 (_mm256_loadu_si256 ((const __m256i *) (src + 32)), cy);
+  __m256i y = _mm256_permute4x64_epi64 (_mm256_packs_epi32 (a, b), 0xd8);
+
+  y = _mm256_permute4x64_epi64 (_mm256_packus_epi16 (y, y), 0xd8);
+  _mm_storeu_si128 ((__m128i *) dest, _mm256_castsi256_si128 (y));
+}
+
+/* Rounded channel averages of the four 2x2 blocks in @top and @bottom,
+ * blocks 0 and 2 in the low lane, 1 and 3 in the high one */
+GST_SPOUT_TARGET ("avx2") inline __m256i
+blocks4_avx2 (__m256i top, __m256i bottom)
+{
+  __m256i a = _mm256_add_epi16 (
+      _mm256_cvtepu8_epi16 (_mm256_castsi256_si128 (top)),
+      _mm256_cvtepu8_epi16 (_mm256_castsi256_si128 (bottom)));
+  __m256i b = _mm256_add_epi16 (
+      _mm256_cvtepu8_epi16 (_mm256_extracti128_si256 (top, 1)),
+      _mm256_cvtepu8_epi16 (_mm256_extracti128_si256 (bottom, 1)));
+  __m256i sum = _mm256_add_epi16 (_mm256_unpacklo_epi64 (a, b),
+      _mm256_unpackhi_epi64 (a, b));
+
+  return _mm256_srli_epi16 (_mm256_add_epi16 (sum, _mm256_set1_epi16 (2)), 2);
+}
+
+/* Chroma of 8 blocks given as two blocks4_avx2() results, as 8 bytes */
+GST_SPOUT_TARGET ("avx2") inline __m128i
+chroma8_avx2 (__m256i a, __m256i b, __m256i c)
+{
+  __m256i sum = _mm256_hadd_epi32 (_mm256_madd_epi16 (a, c),
+      _mm256_madd_epi16 (b, c));
+  __m128i packed;
+
+  sum = _mm256_permutevar8x32_epi32 (sum,
+      _mm256_setr_epi32 (0, 4, 1, 5, 2, 6, 3, 7));
+  sum = _mm256_srai_epi32 (_mm256_add_epi32 (sum, _mm256_set1_epi32 (128)), 8);
+  sum = _mm256_add_epi32 (sum, _mm256_set1_epi32 (128));
+  sum = _mm256_permute4x64_epi64 (_mm256_packs_epi32 (sum, sum), 0xd8);
+
+  packed = _mm256_castsi256_si128 (sum);
+  return _mm_packus_epi16 (packed, packed);
+}
+
+GST_SPOUT_TARGET ("avx2") void
+yuv_rows_avx2 (const ConvertParams & p, const PlaneRows & rows,
+    uint32_t width)
+{
+  const __m256i cy = _mm256_broadcastsi128_si256 (
+      _mm_loadu_si128 ((const __m128i *) p.cy));
+  const __m256i cu = _mm256_broadcastsi128_si256 (
+      _mm_loadu_si128 ((const __m128i *) p.cu));
+  const __m256i cv = _mm256_broadcastsi128_si256 (
+      _mm_loadu_si128 ((const __m128i *) p.cv));
+  uint32_t x = 0;
+
+  for (; x + 16 <= width; x += 16) {
+    const uint8_t *s0 = rows.src0 + x * 4, *s1 = rows.src1 + x * 4;
+    __m256i a, b;
+    __m128i u, v;
+
+    luma16_avx2 (s0, rows.y0 + x, cy);
+    if (rows.y1)
+      luma16_avx2 (s1, rows.y1 + x, cy);
+
+    a = blocks4_avx2 (_mm256_loadu_si256 ((const __m256i *) s0),
+        _mm256_loadu_si256 ((const __m256i *) s1));
+    b = blocks4_avx2 (_mm256_loadu_si256 ((const __m256i *) (s0 + 32)),
+        _mm256_loadu_si256 ((const __m256i *) (s1 + 32)));
+
+    u = chroma8_avx2 (a, b, cu);
+    v = chroma8_avx2 (a, b, cv);
+
+    if (rows.uv) {
+      _mm_storeu_si128 ((__m128i *) (rows.uv + x), _mm_unpacklo_epi8 (u, v));
+    } else {
+      _mm_storel_epi64 ((__m128i *) (rows.u + x / 2), u);
+      _mm_storel_epi64 ((__m128i *) (rows.v + x / 2), v);
+    }
+  }
+
+  yuv_rows_tail (p, rows, x, width);
+}
+
+GstSpoutCpuLevel
+detect_cpu_level (void)
+{
+#ifdef _MSC_VER
+  int info[4];
+  bool sse41, avx2 = false;
+
+  __cpuid (info, 1);
+  sse41 = (info[2] & (1 << 19)) != 0;
+
+  /* AVX state must be enabled by the OS too */
+  if ((info[2] & (1 << 27)) && (info[2] & (1 << 28)) &&
+      (_xgetbv (0) & 0x6) == 0x6) {
+    __cpuidex (info, 7, 0);
+    avx2 = (info[1] & (1 << 5)) != 0;
+  }
+#else
+  __builtin_cpu_init ();
+  bool sse41 = __builtin_cpu_supports ("sse4.1");
+  bool avx2 = __builtin_cpu_supports ("avx2");
+#endif
+
+  if (avx2 && sse41)
+    return GST_SPOUT_CPU_AVX2;
+  if (sse41)
+    return GST_SPOUT_CPU_SSE41;
+  return GST_SPOUT_CPU_SCALAR;
+}
+
+#else
+
+GstSpoutCpuLevel
+detect_cpu_level (void)
+{
+  return GST_SPOUT_CPU_SCALAR;
+}
+
+#endif
+
+const PackedRowFunc packed_row_funcs[] = {
+  packed_row_scalar,
+#ifdef GST_SPOUT_CONVERT_X86
+  packed_row_sse41,
+  packed_row_avx2,
+#endif
+};
+
+const YuvRowsFunc yuv_rows_funcs[] = {
+  yuv_rows_scalar,
+#ifdef GST_SPOUT_CONVERT_X86
+  yuv_rows_sse41,
+  yuv_rows_avx2,
+#endif
+};
+
+} /* namespace */
+
+GstSpoutCpuLevel
+gst_spout_cpu_level (void)
+{
+  static const GstSpoutCpuLevel level = detect_cpu_level ();
+
+  return level;
+}
+
+const char *
+gst_spout_cpu_level_name (GstSpoutCpuLevel level)
+{
+  switch (level) {
+    case GST_SPOUT_CPU_SSE41:
+      return "sse4.1";
+    case GST_SPOUT_CPU_AVX2:
+      return "avx2";
+    default:
+      return "scalar";
+  }
+}
+
+bool
+gst_spout_convert_supported (GstSpoutPixelFormat in, GstSpoutPixelFormat out)
+{
+  return is_packed (in) && out != GST_SPOUT_PIXEL_FORMAT_UNKNOWN;
+}
+
+void
+gst_spout_convert (GstSpoutPixelFormat in, const uint8_t * src,
+    size_t src_stride, GstSpoutPixelFormat out, const GstSpoutPlanes & dest,
+    uint32_t width, uint32_t height, uint32_t y_begin, uint32_t y_end,
+    GstSpoutCpuLevel level)
+{
+  ConvertParams p = make_params (in, out);
+
+  level = std::min (level, gst_spout_cpu_level ());
+  y_end = std::min (y_end, height);
+
+  if (in == out) {
+    for (uint32_t y = y_begin; y < y_end; y++) {
+      memcpy (dest.data[0] + y * dest.stride[0], src + y * src_stride,
+          (size_t) width * 4);
+    }
+    return;
+  }
+
+  if (is_packed (out)) {
+    PackedRowFunc row = packed_row_funcs[level];
+
+    for (uint32_t y = y_begin; y < y_end; y++)
+      row (p, src + y * src_stride, dest.data[0] + y * dest.stride[0], width);
+    return;
+  }
+
+  YuvRowsFunc rows_func = yuv_rows_funcs[level];
+  bool nv12 = out == GST_SPOUT_PIXEL_FORMAT_NV12;
+
+  for (uint32_t y = y_begin; y < y_end; y += 2) {
+    PlaneRows rows;
+    bool pair = y + 1 < height;
+
+    rows.src0 = src + y * src_stride;
+    rows.src1 = pair ? rows.src0 + src_stride : rows.src0;
+    rows.y0 = dest.data[0] + y * dest.stride[0];
+    rows.y1 = pair ? rows.y0 + dest.stride[0] : nullptr;
+
+    if (nv12) {
+      rows.uv = dest.data[1] + (y / 2) * dest.stride[1];
+      rows.u = rows.v = nullptr;
+    } else {
+      rows.uv = nullptr;
+      rows.u = dest.data[1] + (y / 2) * dest.stride[1];
+      rows.v = dest.data[2] + (y / 2) * dest.stride[2];
+    }
+
+    rows_func (p, rows, width);
+  }
+}
@@ -0,0 +1,75 @@
+/* GStreamer
+ * Copyright (C) 2023 Your Name <your.email@example.com>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#pragma once
+
+/* Colour conversion and swizzling of read back frames for spoutsrc.
+ *
+ * Converts the packed RGB formats senders share into any of the packed
+ * formats, NV12 or I420 while the frame is copied out of a staging map,
+ * saving downstream a second pass over memory. Kernels are picked at run
+ * time for the CPU: scalar, SSE4.1 or AVX2, all bit-exact against the
+ * scalar one. YUV output is BT.709 limited range. Free of GStreamer. */
+
+#include <cstddef>
+#include <cstdint>
+
+typedef enum
+{
+  GST_SPOUT_PIXEL_FORMAT_UNKNOWN,
+  GST_SPOUT_PIXEL_FORMAT_BGRA,
+  GST_SPOUT_PIXEL_FORMAT_RGBA,
+  GST_SPOUT_PIXEL_FORMAT_BGRX,
+  GST_SPOUT_PIXEL_FORMAT_RGBX,
+  GST_SPOUT_PIXEL_FORMAT_NV12,   /* Y plane, interleaved UV plane */
+  GST_SPOUT_PIXEL_FORMAT_I420,   /* Y, U and V planes */
+} GstSpoutPixelFormat;
+
+typedef enum
+{
+  GST_SPOUT_CPU_SCALAR,
+  GST_SPOUT_CPU_SSE41,
+  GST_SPOUT_CPU_AVX2,
+} GstSpoutCpuLevel;
+
+/* Destination planes, packed formats use the first only */
+struct GstSpoutPlanes
+{
+  uint8_t *data[3] = { };
+  size_t stride[3] = { };
+};
+
+/* Best kernels this CPU runs, detected once */
+GstSpoutCpuLevel gst_spout_cpu_level (void);
+
+const char *gst_spout_cpu_level_name (GstSpoutCpuLevel level);
+
+/* Packed RGB @in to @out, any packed format, NV12 or I420 */
+bool gst_spout_convert_supported (GstSpoutPixelFormat in,
+    GstSpoutPixelFormat out);
+
+/* Convert rows [@y_begin, @y_end) of a @width x @height frame at @src into
+ * @dest, both addressed from the top of the frame. Bands converted
+ * separately give the same result as the whole frame as long as they start
+ * on even rows for NV12 and I420. @level above gst_spout_cpu_level() is
+ * lowered to it */
+void gst_spout_convert (GstSpoutPixelFormat in, const uint8_t * src,
+    size_t src_stride, GstSpoutPixelFormat out, const GstSpoutPlanes & dest,
+    uint32_t width, uint32_t height, uint32_t y_begin, uint32_t y_end,
+    GstSpoutCpuLevel level);
@@ -0,0 +1,107 @@
+/* GStreamer
+ * Copyright (C) 2023 Your Name <your.email@example.com>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#pragma once
+
+/* Duplicate frame detection for spoutsrc's duplicate-policy.
+ *
+ * Free of GStreamer, D3D11 and Spout so a scripted sequence of sender frame
+ * numbers and fingerprints can drive it on any platform. */
+
+#include <cstddef>
+#include <cstdint>
+
+typedef enum
+{
+  GST_SPOUT_DUPLICATE_POLICY_REPEAT,  /* push repeated frames like new ones */
+  GST_SPOUT_DUPLICATE_POLICY_GAP,     /* replace repeated frames by a GAP event */
+  GST_SPOUT_DUPLICATE_POLICY_WAIT,    /* hold back output until a new frame */
+} GstSpoutDuplicatePolicy;
+
+typedef enum
+{
+  GST_SPOUT_FRAME_ACTION_PUSH,        /* new frame, or repeat policy */
+  GST_SPOUT_FRAME_ACTION_GAP,         /* duplicate, push a GAP event instead */
+  GST_SPOUT_FRAME_ACTION_SKIP,        /* duplicate, receive again */
+} GstSpoutFrameAction;
+
+/* 64-bit FNV-1a, cheap enough for the handful of sampled pixels that make up
+ * a content fingerprint */
+static inline uint64_t
+gst_spout_fingerprint_bytes (const uint8_t * data, size_t size,
+    uint64_t hash = 0xcbf29ce484222325ull)
+{
+  for (size_t i = 0; i < size; i++) {
+    hash ^= data[i];
+    hash *= 0x100000001b3ull;
+  }
+
+  return hash;
+}
+
+/* Decides what to do with each received frame. Senders with frame counting
+ * are compared by frame number; for the others the caller supplies a content
+ * fingerprint */
+class GstSpoutDuplicateFilter
+{
+public:
+  void reset ()
+  {
+    have_last_ = false;
+    last_counted_ = false;
+    last_id_ = 0;
+  }
+
+  /* @sender_frame: sender frame number, <= 0 if the sender doesn't count
+   * frames. @fingerprint: only looked at when @sender_frame is <= 0 */
+  GstSpoutFrameAction process (GstSpoutDuplicatePolicy policy,
+      int64_t sender_frame, uint64_t fingerprint)
+  {
+    bool counted = sender_frame > 0;
+    uint64_t id = counted ? (uint64_t) sender_frame : fingerprint;
+    bool duplicate = have_last_ && counted == last_counted_ && id == last_id_;
+
+    have_last_ = true;
+    last_counted_ = counted;
+    last_id_ = id;
+
+    if (!duplicate)
+      return GST_SPOUT_FRAME_ACTION_PUSH;
+
+    duplicates_++;
+
+    switch (policy) {
+      case GST_SPOUT_DUPLICATE_POLICY_GAP:
+        return GST_SPOUT_FRAME_ACTION_GAP;
+      case GST_SPOUT_DUPLICATE_POLICY_WAIT:
+        return GST_SPOUT_FRAME_ACTION_SKIP;
+      case GST_SPOUT_DUPLICATE_POLICY_REPEAT:
+      default:
+        return GST_SPOUT_FRAME_ACTION_PUSH;
+    }
+  }
+
+  uint64_t duplicates () const { return duplicates_; }
+
+private:
+  bool have_last_ = false;
+  bool last_counted_ = false;
+  uint64_t last_id_ = 0;
+  uint64_t duplicates_ = 0;
+};
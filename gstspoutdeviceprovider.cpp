@@ -0,0 +1,345 @@
+/* GStreamer
+ * Copyright (C) 2023 Your Name <your.email@example.com>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+/* Define GST_USE_UNSTABLE_API to avoid warnings about unstable API */
+#define GST_USE_UNSTABLE_API
+
+/**
+ * SECTION:provider-spoutdeviceprovider
+ * @title: spoutdeviceprovider
+ * @short_description: Lists Spout senders as video source devices
+ *
+ * Every Spout sender shows up as a Source/Video device whose
+ * gst_device_create_element() makes a spoutsrc connected to it. Senders
+ * appearing and disappearing are posted as device-added/removed messages.
+ *
+ * ## Example
+ * ```
+ * gst-device-monitor-1.0 Source/Video
+ * ```
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "gstspoutdeviceprovider.h"
+#include "gstspoutsrc.h"
+#include "gstspoutformat.h"
+#include <gst/d3d11/gstd3d11.h>
+#include <mutex>
+#include <string>
+#include <vector>
+
+// SpoutDX.h builds on the D3D11 headers
+#include <d3d11.h>
+
+// Include Spout SDK headers
+#include "SpoutDX.h"
+
+GST_DEBUG_CATEGORY_STATIC (gst_spout_device_provider_debug);
+#define GST_CAT_DEFAULT gst_spout_device_provider_debug
+
+#define SENDER_MONITOR_INTERVAL   100    /* ms between sender registry scans */
+
+/* Sender list straight from Spout's shared memory, no DirectX involved */
+class GstSpoutSharedMemoryRegistry : public GstSpoutSenderRegistry
+{
+public:
+  std::vector<GstSpoutSenderDesc> list () override
+  {
+    std::vector<GstSpoutSenderDesc> senders;
+    int count = spout_.GetSenderCount ();
+
+    for (int i = 0; i < count; i++) {
+      GstSpoutSenderDesc sender;
+      char name[256];
+      unsigned int width = 0;
+      unsigned int height = 0;
+      HANDLE share_handle = NULL;
+      DWORD format = 0;
+
+      if (!spout_.GetSender (i, name, sizeof (name)))
+        continue;
+
+      sender.name = name;
+      if (spout_.GetSenderInfo (name, width, height, share_handle, format)) {
+        sender.width = width;
+        sender.height = height;
+        sender.format = format;
+      }
+
+      senders.push_back (sender);
+    }
+
+    return senders;
+  }
+
+private:
+  spoutDX spout_;
+};
+
+GstSpoutSenderMonitor &
+gst_spout_sender_monitor_get (void)
+{
+  /* Plugins are never unloaded, leak it rather than racing static
+   * destruction at exit */
+  static GstSpoutSenderMonitor *monitor = new GstSpoutSenderMonitor (
+      new GstSpoutSharedMemoryRegistry (),
+      GstSpoutSenderMonitor::Duration (SENDER_MONITOR_INTERVAL));
+
+  return *monitor;
+}
+
+/* GstSpoutDevice */
+
+struct _GstSpoutDevice
+{
+  GstDevice parent;
+  
+  gchar *sender_name;
+};
+
+G_DEFINE_TYPE (GstSpoutDevice, gst_spout_device, GST_TYPE_DEVICE);
+
+static void
+gst_spout_device_finalize (GObject * object)
+{
+  GstSpoutDevice *self = GST_SPOUT_DEVICE (object);
+
+  g_free (self->sender_name);
+
+  G_OBJECT_CLASS (gst_spout_device_parent_class)->finalize (object);
+}
+
+static GstElement *
+gst_spout_device_create_element (GstDevice * device, const gchar * name)
+{
+  GstSpoutDevice *self = GST_SPOUT_DEVICE (device);
+  GstElement *elem;
+
+  elem = gst_element_factory_make ("spoutsrc", name);
+  if (elem)
+    g_object_set (elem, "sender-name", self->sender_name, NULL);
+
+  return elem;
+}
+
+static gboolean
+gst_spout_device_reconfigure_element (GstDevice * device, GstElement * element)
+{
+  GstSpoutDevice *self = GST_SPOUT_DEVICE (device);
+
+  if (!GST_IS_SPOUT_SRC (element))
+    return FALSE;
+
+  g_object_set (element, "sender-name", self->sender_name, NULL);
+
+  return TRUE;
+}
+
+static void
+gst_spout_device_class_init (GstSpoutDeviceClass * klass)
+{
+  GObjectClass *gobject_class = G_OBJECT_CLASS (klass);
+  GstDeviceClass *device_class = GST_DEVICE_CLASS (klass);
+
+  gobject_class->finalize = gst_spout_device_finalize;
+
+  device_class->create_element = gst_spout_device_create_element;
+  device_class->reconfigure_element = gst_spout_device_reconfigure_element;
+}
+
+static void
+gst_spout_device_init (GstSpoutDevice * self)
+{
+}
+
+static GstDevice *
+gst_spout_device_new (const GstSpoutSenderDesc & sender)
+{
+  GstSpoutDevice *device;
+  GstVideoFormat format;
+  GstCaps *caps;
+  GstStructure *props;
+
+  format = gst_spout_format_from_dxgi (sender.format);
+  if (format == GST_VIDEO_FORMAT_UNKNOWN)
+    format = GST_VIDEO_FORMAT_BGRA;
+
+  caps = gst_caps_new_simple ("video/x-raw",
+      "format", G_TYPE_STRING, gst_video_format_to_string (format),
+      "width", G_TYPE_INT, (gint) sender.width,
+      "height", G_TYPE_INT, (gint) sender.height, NULL);
+  gst_caps_set_features (caps, 0,
+      gst_caps_features_new (GST_CAPS_FEATURE_MEMORY_D3D11_MEMORY, NULL));
+
+  props = gst_structure_new ("spout-device-properties",
+      "device.api", G_TYPE_STRING, "spout",
+      "spout.sender-name", G_TYPE_STRING, sender.name.c_str (),
+      "spout.width", G_TYPE_UINT, sender.width,
+      "spout.height", G_TYPE_UINT, sender.height,
+      "spout.dxgi-format", G_TYPE_UINT, sender.format, NULL);
+
+  device = (GstSpoutDevice *) g_object_new (GST_TYPE_SPOUT_DEVICE,
+      "display-name", sender.name.c_str (), "caps", caps,
+      "device-class", "Source/Video", "properties", props, NULL);
+  device->sender_name = g_strdup (sender.name.c_str ());
+
+  gst_caps_unref (caps);
+  gst_structure_free (props);
+
+  return GST_DEVICE (device);
+}
+
+/* GstSpoutDeviceProvider */
+
+struct GstSpoutDeviceProviderPrivate
+{
+  /* Devices we announced, only touched from monitor callbacks */
+  std::vector<GstDevice *> devices;
+  guint64 subscription = 0;
+};
+
+struct _GstSpoutDeviceProvider
+{
+  GstDeviceProvider parent;
+  
+  GstSpoutDeviceProviderPrivate *priv;
+};
+
+G_DEFINE_TYPE (GstSpoutDeviceProvider, gst_spout_device_provider,
+    GST_TYPE_DEVICE_PROVIDER);
+
+static GList *gst_spout_device_provider_probe (GstDeviceProvider * provider);
+static gboolean gst_spout_device_provider_start (GstDeviceProvider * provider);
+static void gst_spout_device_provider_stop (GstDeviceProvider * provider);
+
+static void
+gst_spout_device_provider_finalize (GObject * object)
+{
+  GstSpoutDeviceProvider *self = GST_SPOUT_DEVICE_PROVIDER (object);
+
+  delete self->priv;
+
+  G_OBJECT_CLASS (gst_spout_device_provider_parent_class)->finalize (object);
+}
+
+static void
+gst_spout_device_provider_class_init (GstSpoutDeviceProviderClass * klass)
+{
+  GObjectClass *gobject_class = G_OBJECT_CLASS (klass);
+  GstDeviceProviderClass *provider_class = GST_DEVICE_PROVIDER_CLASS (klass);
+
+  gobject_class->finalize = gst_spout_device_provider_finalize;
+
+  provider_class->probe = GST_DEBUG_FUNCPTR (gst_spout_device_provider_probe);
+  provider_class->start = GST_DEBUG_FUNCPTR (gst_spout_device_provider_start);
+  provider_class->stop = GST_DEBUG_FUNCPTR (gst_spout_device_provider_stop);
+
+  gst_device_provider_class_set_static_metadata (provider_class,
+      "Spout Sender Device Provider", "Source/Video",
+      "Lists Spout senders", "jesus luque <jluque@mediapro.tv>");
+
+  GST_DEBUG_CATEGORY_INIT (gst_spout_device_provider_debug,
+      "spoutdeviceprovider", 0, "Spout Device Provider");
+}
+
+static void
+gst_spout_device_provider_init (GstSpoutDeviceProvider * self)
+{
+  self->priv = new GstSpoutDeviceProviderPrivate;
+}
+
+static GList *
+gst_spout_device_provider_probe (GstDeviceProvider * provider)
+{
+  GstSpoutSenderMonitor & monitor = gst_spout_sender_monitor_get ();
+  std::vector<GstSpoutSenderDesc> senders;
+  GList *devices = NULL;
+  guint64 id;
+
+  /* Subscribing hands out the current list, rescanning if nobody else
+   * keeps it up to date */
+  id = monitor.subscribe ([&senders] (const GstSpoutSenderDiff & diff) {
+    senders.insert (senders.end (), diff.added.begin (), diff.added.end ());
+  });
+  monitor.unsubscribe (id);
+
+  for (const auto & sender : senders)
+    devices = g_list_append (devices, gst_spout_device_new (sender));
+
+  return devices;
+}
+
+static void
+gst_spout_device_provider_senders_changed (GstSpoutDeviceProvider * self,
+    const GstSpoutSenderDiff & diff)
+{
+  GstSpoutDeviceProviderPrivate *priv = self->priv;
+  GstDeviceProvider *provider = GST_DEVICE_PROVIDER (self);
+
+  for (const auto & sender : diff.removed) {
+    for (auto it = priv->devices.begin (); it != priv->devices.end (); ++it) {
+      GstSpoutDevice *device = GST_SPOUT_DEVICE (*it);
+
+      if (sender.name == device->sender_name) {
+        GST_INFO_OBJECT (self, "Spout sender '%s' went away", sender.name.c_str ());
+        gst_device_provider_device_remove (provider, *it);
+        priv->devices.erase (it);
+        break;
+      }
+    }
+  }
+
+  for (const auto & sender : diff.added) {
+    GstDevice *device = gst_spout_device_new (sender);
+
+    GST_INFO_OBJECT (self, "Spout sender '%s' appeared: %ux%u format %u",
+        sender.name.c_str (), sender.width, sender.height, sender.format);
+    priv->devices.push_back (device);
+    gst_device_provider_device_add (provider, device);
+  }
+}
+
+static gboolean
+gst_spout_device_provider_start (GstDeviceProvider * provider)
+{
+  GstSpoutDeviceProvider *self = GST_SPOUT_DEVICE_PROVIDER (provider);
+
+  self->priv->subscription = gst_spout_sender_monitor_get ().subscribe (
+      [self] (const GstSpoutSenderDiff & diff) {
+        gst_spout_device_provider_senders_changed (self, diff);
+      });
+
+  return TRUE;
+}
+
+static void
+gst_spout_device_provider_stop (GstDeviceProvider * provider)
+{
+  GstSpoutDeviceProvider *self = GST_SPOUT_DEVICE_PROVIDER (provider);
+  GstSpoutDeviceProviderPrivate *priv = self->priv;
+
+  gst_spout_sender_monitor_get ().unsubscribe (priv->subscription);
+  priv->subscription = 0;
+
+  /* The base class drops its references to the devices it listed */
+  priv->devices.clear ();
+}
@@ -0,0 +1,42 @@
+/* GStreamer
+ * Copyright (C) 2023 Your Name <your.email@example.com>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+/* Define GST_USE_UNSTABLE_API to avoid warnings about unstable API */
+#define GST_USE_UNSTABLE_API
+
+#pragma once
+
+#include <gst/gst.h>
+#include "gstspoutmonitor.h"
+
+G_BEGIN_DECLS
+
+#define GST_TYPE_SPOUT_DEVICE (gst_spout_device_get_type())
+G_DECLARE_FINAL_TYPE (GstSpoutDevice, gst_spout_device,
+    GST, SPOUT_DEVICE, GstDevice);
+
+#define GST_TYPE_SPOUT_DEVICE_PROVIDER (gst_spout_device_provider_get_type())
+G_DECLARE_FINAL_TYPE (GstSpoutDeviceProvider, gst_spout_device_provider,
+    GST, SPOUT_DEVICE_PROVIDER, GstDeviceProvider);
+
+G_END_DECLS
+
+/* The process-wide sender monitor shared by every spoutsrc and device
+ * provider. Never destroyed, its thread only runs while subscribed */
+GstSpoutSenderMonitor & gst_spout_sender_monitor_get (void);
@@ -0,0 +1,70 @@
+/* GStreamer
+ * Copyright (C) 2023 Your Name <your.email@example.com>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#pragma once
+
+/* Sender formats in GStreamer terms, shared by spoutsrc and the device
+ * provider. Internal, not part of the element's API. Senders describe
+ * their textures with DXGI_FORMAT values; the ones Spout senders use are
+ * spelled out here so this needs no DirectX headers */
+
+#include <gst/video/video.h>
+#include <cstdint>
+
+#define GST_SPOUT_DXGI_FORMAT_UNKNOWN         0
+#define GST_SPOUT_DXGI_FORMAT_R8G8B8A8_UNORM  28
+#define GST_SPOUT_DXGI_FORMAT_B8G8R8A8_UNORM  87
+#define GST_SPOUT_DXGI_FORMAT_B8G8R8X8_UNORM  88
+#define GST_SPOUT_DXGI_FORMAT_R8G8B8X8_UNORM  122   /* not in every DirectX header */
+
+/* A sender's DXGI format, GST_VIDEO_FORMAT_UNKNOWN if unsupported */
+static inline GstVideoFormat
+gst_spout_format_from_dxgi (uint32_t dxgi_format)
+{
+  switch (dxgi_format) {
+    case GST_SPOUT_DXGI_FORMAT_B8G8R8A8_UNORM:
+      return GST_VIDEO_FORMAT_BGRA;
+    case GST_SPOUT_DXGI_FORMAT_R8G8B8A8_UNORM:
+      return GST_VIDEO_FORMAT_RGBA;
+    case GST_SPOUT_DXGI_FORMAT_B8G8R8X8_UNORM:
+      return GST_VIDEO_FORMAT_BGRx;
+    case GST_SPOUT_DXGI_FORMAT_R8G8B8X8_UNORM:
+      return GST_VIDEO_FORMAT_RGBx;
+    default:
+      return GST_VIDEO_FORMAT_UNKNOWN;
+  }
+}
+
+/* Texture format for frames of @format, RGBx has no DXGI equivalent and is
+ * stored as RGBA */
+static inline uint32_t
+gst_spout_format_to_dxgi (GstVideoFormat format)
+{
+  switch (format) {
+    case GST_VIDEO_FORMAT_BGRA:
+      return GST_SPOUT_DXGI_FORMAT_B8G8R8A8_UNORM;
+    case GST_VIDEO_FORMAT_RGBA:
+    case GST_VIDEO_FORMAT_RGBx:
+      return GST_SPOUT_DXGI_FORMAT_R8G8B8A8_UNORM;
+    case GST_VIDEO_FORMAT_BGRx:
+      return GST_SPOUT_DXGI_FORMAT_B8G8R8X8_UNORM;
+    default:
+      return GST_SPOUT_DXGI_FORMAT_UNKNOWN;
+  }
+}
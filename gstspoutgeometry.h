@@ -0,0 +1,145 @@
+/* GStreamer
+ * Copyright (C) 2023 Your Name <your.email@example.com>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+#pragma once
+
+/* Crop and scale geometry for spoutsrc.
+ *
+ * Maps the crop-* and output-* properties onto a sender of a given size.
+ * Free of GStreamer and D3D11 so the maths can be checked on any
+ * platform. */
+
+#include <algorithm>
+#include <cstdint>
+
+/* crop-* and output-* as set on the element, 0 meaning unset */
+struct GstSpoutGeometryRequest
+{
+  uint32_t crop_left = 0;
+  uint32_t crop_right = 0;
+  uint32_t crop_top = 0;
+  uint32_t crop_bottom = 0;
+  uint32_t width = 0;
+  uint32_t height = 0;
+
+  bool is_default () const
+  {
+    return !crop_left && !crop_right && !crop_top && !crop_bottom &&
+        !width && !height;
+  }
+};
+
+struct GstSpoutRect
+{
+  uint32_t x = 0;
+  uint32_t y = 0;
+  uint32_t width = 0;
+  uint32_t height = 0;
+};
+
+/* Which part of a sender's texture ends up in frames of which size */
+struct GstSpoutGeometry
+{
+  uint32_t source_width = 0;
+  uint32_t source_height = 0;
+  GstSpoutRect crop;
+  uint32_t width = 0;
+  uint32_t height = 0;
+
+  bool cropped () const
+  {
+    return crop.x || crop.y || crop.width != source_width ||
+        crop.height != source_height;
+  }
+
+  bool scaled () const
+  {
+    return crop.width != width || crop.height != height;
+  }
+
+  /* Frames are the sender's texture as is */
+  bool identity () const { return !cropped () && !scaled (); }
+};
+
+/* Keep at least one pixel of a @size long side cropped by @before and
+ * @after, the leading crop wins */
+static inline void
+gst_spout_geometry_crop_side (uint32_t size, uint32_t before, uint32_t after,
+    uint32_t * offset, uint32_t * length)
+{
+  if (size == 0) {
+    *offset = *length = 0;
+    return;
+  }
+
+  before = std::min (before, size - 1);
+  after = std::min (after, size - before - 1);
+
+  *offset = before;
+  *length = size - before - after;
+}
+
+/* @length scaled by @num / @den, rounded to nearest and at least 1 */
+static inline uint32_t
+gst_spout_geometry_scale (uint32_t length, uint32_t num, uint32_t den)
+{
+  uint64_t scaled;
+
+  if (den == 0)
+    return length;
+
+  scaled = ((uint64_t) length * num + den / 2) / den;
+
+  return (uint32_t) std::clamp<uint64_t> (scaled, 1, UINT32_MAX);
+}
+
+/* Apply @request to a @source_width x @source_height sender. An unset
+ * output side follows the crop's aspect ratio, both unset keep the crop's
+ * size */
+static inline GstSpoutGeometry
+gst_spout_geometry_compute (uint32_t source_width, uint32_t source_height,
+    const GstSpoutGeometryRequest & request)
+{
+  GstSpoutGeometry geometry;
+
+  geometry.source_width = source_width;
+  geometry.source_height = source_height;
+
+  gst_spout_geometry_crop_side (source_width, request.crop_left,
+      request.crop_right, &geometry.crop.x, &geometry.crop.width);
+  gst_spout_geometry_crop_side (source_height, request.crop_top,
+      request.crop_bottom, &geometry.crop.y, &geometry.crop.height);
+
+  if (request.width && request.height) {
+    geometry.width = request.width;
+    geometry.height = request.height;
+  } else if (request.width) {
+    geometry.width = request.width;
+    geometry.height = gst_spout_geometry_scale (geometry.crop.height,
+        request.width, geometry.crop.width);
+  } else if (request.height) {
+    geometry.width = gst_spout_geometry_scale (geometry.crop.width,
+        request.height, geometry.crop.height);
+    geometry.height = request.height;
+  } else {
+    geometry.width = geometry.crop.width;
+    geometry.height = geometry.crop.height;
+  }
+
+  return geometry;
+}
@@ -0,0 +1,285 @@
+/* GStreamer
+ * Copyright (C) 2023 Your Name <your.email@example.com>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#pragma once
+
+/* Page-level allocation for frame-sized buffers.
+ *
+ * A 4K BGRA frame spans more than 8000 ordinary 4 KiB pages, so every copy
+ * into or out of it walks the TLB as much as the data. gst_spout_pages_alloc()
+ * backs a buffer with the biggest pages the system hands out: explicit huge
+ * pages (hugetlbfs on Linux, large pages on Windows) if some are reserved,
+ * else transparent huge pages on Linux, else ordinary pages. Memory can be
+ * placed on one NUMA node, and gst_spout_pages_prefault() touches all of it
+ * so the first frames don't pay for page faults. Free of GStreamer. */
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <unistd.h>
+#ifdef __linux__
+#include <sys/syscall.h>
+#endif
+#endif
+
+#define GST_SPOUT_PAGE_SIZE        4096
+#define GST_SPOUT_MAX_NUMA_NODES   1024
+
+typedef enum
+{
+  GST_SPOUT_PAGES_NORMAL,
+  GST_SPOUT_PAGES_TRANSPARENT,  /* Linux THP, huge where the kernel managed */
+  GST_SPOUT_PAGES_HUGE,         /* hugetlbfs or Windows large pages */
+} GstSpoutPageKind;
+
+struct GstSpoutPages
+{
+  void *data = nullptr;
+  size_t size = 0;              /* rounded up to the page size used */
+  GstSpoutPageKind kind = GST_SPOUT_PAGES_NORMAL;
+};
+
+static inline const char *
+gst_spout_page_kind_name (GstSpoutPageKind kind)
+{
+  switch (kind) {
+    case GST_SPOUT_PAGES_TRANSPARENT:
+      return "transparent huge";
+    case GST_SPOUT_PAGES_HUGE:
+      return "huge";
+    default:
+      return "normal";
+  }
+}
+
+static inline size_t
+gst_spout_pages_round (size_t size, size_t page)
+{
+  return (size + page - 1) / page * page;
+}
+
+/* Default huge page size, 0 if the system has none */
+static inline size_t
+gst_spout_huge_page_size ()
+{
+  static const size_t page_size = [] () -> size_t {
+#ifdef _WIN32
+    return GetLargePageMinimum ();
+#elif defined (__linux__)
+    size_t kb = 0;
+    char line[128];
+    FILE *meminfo = fopen ("/proc/meminfo", "r");
+
+    if (!meminfo)
+      return 0;
+    while (fgets (line, sizeof (line), meminfo)) {
+      if (sscanf (line, "Hugepagesize: %zu kB", &kb) == 1)
+        break;
+    }
+    fclose (meminfo);
+
+    return kb * 1024;
+#else
+    return 0;
+#endif
+  } ();
+
+  return page_size;
+}
+
+#ifdef _WIN32
+/* Large pages need SeLockMemoryPrivilege granted to the user, and enabled
+ * in the process token before the first allocation */
+static inline bool
+gst_spout_pages_enable_lock_memory ()
+{
+  static const bool enabled = [] {
+    HANDLE token;
+    TOKEN_PRIVILEGES privileges = { };
+    bool ok;
+
+    if (!OpenProcessToken (GetCurrentProcess (),
+            TOKEN_ADJUST_PRIVILEGES | TOKEN_QUERY, &token))
+      return false;
+
+    privileges.PrivilegeCount = 1;
+    privileges.Privileges[0].Attributes = SE_PRIVILEGE_ENABLED;
+    ok = LookupPrivilegeValueA (NULL, "SeLockMemoryPrivilege",
+        &privileges.Privileges[0].Luid) &&
+        AdjustTokenPrivileges (token, FALSE, &privileges, 0, NULL, NULL) &&
+        GetLastError () == ERROR_SUCCESS;   /* not ERROR_NOT_ALL_ASSIGNED */
+    CloseHandle (token);
+
+    return ok;
+  } ();
+
+  return enabled;
+}
+#endif
+
+#ifdef __linux__
+/* Preferred rather than bound: a full node spills over to the others
+ * instead of failing page faults, like VirtualAllocExNuma on Windows */
+static inline bool
+gst_spout_pages_bind (void *data, size_t size, int numa_node)
+{
+  const int mpol_preferred = 1;
+  const size_t bits = 8 * sizeof (unsigned long);
+  unsigned long mask[GST_SPOUT_MAX_NUMA_NODES / (8 * sizeof (unsigned long))] =
+      { };
+
+  if (numa_node < 0 || numa_node >= GST_SPOUT_MAX_NUMA_NODES)
+    return false;
+
+  mask[numa_node / bits] |= 1ul << (numa_node % bits);
+
+  return syscall (SYS_mbind, data, size, mpol_preferred, mask,
+      (unsigned long) GST_SPOUT_MAX_NUMA_NODES, 0u) == 0;
+}
+#endif
+
+/* Maps at least @size bytes, on huge pages if @huge_pages and the system
+ * has any, on @numa_node unless it is negative. Placement is best effort,
+ * only running out of memory altogether leaves data NULL */
+static inline GstSpoutPages
+gst_spout_pages_alloc (size_t size, bool huge_pages, int numa_node)
+{
+  GstSpoutPages pages;
+  size_t huge_size = huge_pages ? gst_spout_huge_page_size () : 0;
+
+  if (size == 0)
+    return pages;
+
+#ifdef _WIN32
+  DWORD node = numa_node >= 0 ? (DWORD) numa_node : NUMA_NO_PREFERRED_NODE;
+
+  if (huge_size && gst_spout_pages_enable_lock_memory ()) {
+    pages.size = gst_spout_pages_round (size, huge_size);
+    pages.data = VirtualAllocExNuma (GetCurrentProcess (), NULL, pages.size,
+        MEM_RESERVE | MEM_COMMIT | MEM_LARGE_PAGES, PAGE_READWRITE, node);
+    if (pages.data) {
+      pages.kind = GST_SPOUT_PAGES_HUGE;
+      return pages;
+    }
+  }
+
+  pages.size = gst_spout_pages_round (size, GST_SPOUT_PAGE_SIZE);
+  pages.data = VirtualAllocExNuma (GetCurrentProcess (), NULL, pages.size,
+      MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE, node);
+  if (!pages.data)
+    pages.size = 0;
+#else
+  void *data;
+
+#ifdef MAP_HUGETLB
+  /* Fails right away unless enough huge pages are reserved, and maps them
+   * all so they can't run out at fault time */
+  if (huge_size) {
+    pages.size = gst_spout_pages_round (size, huge_size);
+    data = mmap (NULL, pages.size, PROT_READ | PROT_WRITE,
+        MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+    if (data != MAP_FAILED) {
+      pages.data = data;
+      pages.kind = GST_SPOUT_PAGES_HUGE;
+    }
+  }
+#endif
+
+#ifdef MADV_HUGEPAGE
+  /* Transparent huge pages only cover huge-page-aligned ranges, so map
+   * one page extra and trim the ends */
+  if (!pages.data && huge_size) {
+    size_t aligned_size = gst_spout_pages_round (size, huge_size);
+
+    data = mmap (NULL, aligned_size + huge_size, PROT_READ | PROT_WRITE,
+        MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (data != MAP_FAILED) {
+      uintptr_t start = (uintptr_t) data;
+      uintptr_t aligned = gst_spout_pages_round (start, huge_size);
+
+      if (aligned > start)
+        munmap (data, aligned - start);
+      if (start + huge_size > aligned)
+        munmap ((void *) (aligned + aligned_size), start + huge_size - aligned);
+
+      pages.data = (void *) aligned;
+      pages.size = aligned_size;
+      if (madvise (pages.data, pages.size, MADV_HUGEPAGE) == 0)
+        pages.kind = GST_SPOUT_PAGES_TRANSPARENT;
+    }
+  }
+#endif
+
+  if (!pages.data) {
+    pages.size = gst_spout_pages_round (size, GST_SPOUT_PAGE_SIZE);
+    data = mmap (NULL, pages.size, PROT_READ | PROT_WRITE,
+        MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (data == MAP_FAILED) {
+      pages.size = 0;
+      return pages;
+    }
+    pages.data = data;
+  }
+
+#ifdef __linux__
+  /* Before anything faults the pages in */
+  if (numa_node >= 0)
+    gst_spout_pages_bind (pages.data, pages.size, numa_node);
+#else
+  (void) numa_node;
+#endif
+#endif
+
+  return pages;
+}
+
+static inline void
+gst_spout_pages_free (GstSpoutPages & pages)
+{
+  if (!pages.data)
+    return;
+
+#ifdef _WIN32
+  VirtualFree (pages.data, 0, MEM_RELEASE);
+#else
+  munmap (pages.data, pages.size);
+#endif
+  pages = GstSpoutPages ();
+}
+
+/* Faults every page in up front. Steps by small pages even over
+ * transparent ones, which the kernel may have had to split */
+static inline void
+gst_spout_pages_prefault (const GstSpoutPages & pages)
+{
+  volatile uint8_t *data = (volatile uint8_t *) pages.data;
+  size_t step = GST_SPOUT_PAGE_SIZE;
+
+  if (pages.kind == GST_SPOUT_PAGES_HUGE)
+    step = gst_spout_huge_page_size ();
+
+  for (size_t offset = 0; offset < pages.size; offset += step)
+    data[offset] = 0;
+}
@@ -0,0 +1,127 @@
+/* GStreamer
+ * Copyright (C) 2023 Your Name <your.email@example.com>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+#pragma once
+
+/* Measured latency for spoutsrc.
+ *
+ * Collects how far behind the clock each frame's timestamp is when it
+ * leaves the element and turns the recent distribution into the latency to
+ * report: the 99th percentile plus a margin. Says when that figure has
+ * drifted far enough from what the pipeline was last told to be worth
+ * announcing again. Free of GStreamer so recorded latencies can drive it on
+ * any platform. Times are in nanoseconds. */
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+
+class GstSpoutLatencyEstimator
+{
+public:
+  /* Latencies the percentile is taken over */
+  static constexpr unsigned WINDOW = 256;
+  /* Latencies needed before there is an estimate */
+  static constexpr unsigned MIN_SAMPLES = 64;
+  /* Latencies between two evaluations of the percentile */
+  static constexpr unsigned EVALUATE_EVERY = 32;
+  static constexpr unsigned PERCENTILE = 99;
+
+  /* Only the recording thread may reset */
+  void reset ()
+  {
+    count_ = 0;
+    next_ = 0;
+    since_evaluate_ = 0;
+    estimate_ = NONE;
+    reported_ = NONE;
+  }
+
+  /* @margin: added to the percentile, @min_drift: smallest change worth
+   * announcing. Changes under an eighth of the reported latency aren't
+   * either */
+  void configure (uint64_t margin, uint64_t min_drift)
+  {
+    margin_ = margin;
+    min_drift_ = min_drift;
+  }
+
+  /* A frame left @latency behind the clock. Returns true if the estimate
+   * drifted away from the reported latency. Only one thread may record */
+  bool record (uint64_t latency)
+  {
+    samples_[next_] = latency;
+    next_ = (next_ + 1) % WINDOW;
+    count_ = std::min (count_ + 1, WINDOW);
+
+    if (count_ < MIN_SAMPLES || ++since_evaluate_ < EVALUATE_EVERY)
+      return false;
+
+    since_evaluate_ = 0;
+    evaluate ();
+
+    return drifted ();
+  }
+
+  /* p99 plus the margin, NONE until enough frames went out */
+  uint64_t estimate () const { return estimate_.load (); }
+
+  /* The pipeline was told about @latency */
+  void set_reported (uint64_t latency) { reported_ = latency; }
+
+  bool drifted () const
+  {
+    uint64_t estimate = estimate_.load ();
+    uint64_t reported = reported_.load ();
+
+    if (estimate == NONE)
+      return false;
+    if (reported == NONE)
+      return true;
+
+    uint64_t drift = estimate > reported ?
+        estimate - reported : reported - estimate;
+
+    return drift > 0 && drift >= std::max (min_drift_, reported / 8);
+  }
+
+  static constexpr uint64_t NONE = UINT64_MAX;
+
+private:
+  void evaluate ()
+  {
+    uint64_t sorted[WINDOW];
+    unsigned rank = (count_ * PERCENTILE + 99) / 100 - 1;
+
+    std::copy (samples_, samples_ + count_, sorted);
+    std::nth_element (sorted, sorted + rank, sorted + count_);
+
+    estimate_ = sorted[rank] + margin_;
+  }
+
+  uint64_t margin_ = 0;
+  uint64_t min_drift_ = 0;
+
+  uint64_t samples_[WINDOW] = { };
+  unsigned count_ = 0;
+  unsigned next_ = 0;
+  unsigned since_evaluate_ = 0;
+
+  std::atomic<uint64_t> estimate_ { NONE };
+  std::atomic<uint64_t> reported_ { NONE };
+};
@@ -0,0 +1,287 @@
+/* GStreamer
+ * Copyright (C) 2023 Your Name <your.email@example.com>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+#pragma once
+
+/* Process-wide Spout sender discovery.
+ *
+ * One GstSpoutSenderMonitor scans the sender registry on its own thread
+ * while anybody is subscribed and tells subscribers what appeared and
+ * disappeared, so the cost of discovery doesn't grow with the number of
+ * spoutsrc elements and device providers in the process. Free of
+ * GStreamer, D3D11 and Spout: the element plugs in a registry backed by
+ * Spout's shared memory, a fake one can drive it on any platform. */
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+/* A sender as listed in the registry */
+struct GstSpoutSenderDesc
+{
+  std::string name;
+  uint32_t width = 0;
+  uint32_t height = 0;
+  uint32_t format = 0;    /* DXGI_FORMAT */
+
+  bool operator== (const GstSpoutSenderDesc & other) const = default;
+};
+
+/* Source of the sender list, e.g. Spout's shared memory sender names */
+class GstSpoutSenderRegistry
+{
+public:
+  virtual ~GstSpoutSenderRegistry () = default;
+
+  virtual std::vector<GstSpoutSenderDesc> list () = 0;
+};
+
+/* Difference between two sender lists. A sender that changed size or format
+ * is reported as removed and added again, so whoever built something from
+ * the old description can rebuild it */
+struct GstSpoutSenderDiff
+{
+  std::vector<GstSpoutSenderDesc> added;
+  std::vector<GstSpoutSenderDesc> removed;
+
+  bool empty () const { return added.empty () && removed.empty (); }
+};
+
+static inline GstSpoutSenderDiff
+gst_spout_diff_senders (const std::vector<GstSpoutSenderDesc> & before,
+    const std::vector<GstSpoutSenderDesc> & after)
+{
+  GstSpoutSenderDiff diff;
+
+  /* Sender lists are short (Spout caps them at a few dozen), no need for
+   * anything smarter than a nested scan */
+  for (const auto & sender : before) {
+    bool kept = false;
+    for (const auto & other : after) {
+      if (other == sender) {
+        kept = true;
+        break;
+      }
+    }
+    if (!kept)
+      diff.removed.push_back (sender);
+  }
+
+  for (const auto & sender : after) {
+    bool known = false;
+    for (const auto & other : before) {
+      if (other == sender) {
+        known = true;
+        break;
+      }
+    }
+    if (!known)
+      diff.added.push_back (sender);
+  }
+
+  return diff;
+}
+
+class GstSpoutSenderMonitor
+{
+public:
+  using Duration = std::chrono::milliseconds;
+
+  /* Called from the monitor thread, or from subscribe() for the initial
+   * list. Must not subscribe or unsubscribe */
+  using Callback = std::function<void (const GstSpoutSenderDiff & diff)>;
+
+  /* With a zero @interval no thread is started and the owner calls poll() */
+  GstSpoutSenderMonitor (GstSpoutSenderRegistry * registry, Duration interval)
+    : registry_ (registry), interval_ (interval) {}
+
+  ~GstSpoutSenderMonitor () { stop (); }
+
+  /* Start delivering changes to @callback. It first receives every known
+   * sender as added. Returns an id for unsubscribe() */
+  uint64_t subscribe (Callback callback)
+  {
+    std::lock_guard<std::mutex> control (control_lock_);
+    GstSpoutSenderDiff initial;
+    uint64_t id;
+
+    {
+      std::lock_guard<std::mutex> dispatch (dispatch_lock_);
+
+      /* Nobody kept the list up to date while there were no subscribers */
+      if (!thread_.joinable ())
+        scan ();
+
+      {
+        std::lock_guard<std::mutex> lock (lock_);
+        id = ++next_id_;
+        subscribers_.emplace_back (id, callback);
+        initial.added = senders_;
+      }
+
+      if (!initial.empty ())
+        callback (initial);
+    }
+
+    if (!thread_.joinable () && interval_.count () > 0) {
+      stopping_ = false;
+      thread_ = std::thread (&GstSpoutSenderMonitor::loop, this);
+    }
+
+    return id;
+  }
+
+  /* Once this returns @id's callback is not running and won't be called
+   * again. The thread stops with the last subscriber */
+  void unsubscribe (uint64_t id)
+  {
+    std::lock_guard<std::mutex> control (control_lock_);
+    bool last;
+
+    {
+      std::lock_guard<std::mutex> dispatch (dispatch_lock_);
+      std::lock_guard<std::mutex> lock (lock_);
+
+      for (auto it = subscribers_.begin (); it != subscribers_.end (); ++it) {
+        if (it->first == id) {
+          subscribers_.erase (it);
+          break;
+        }
+      }
+      last = subscribers_.empty ();
+    }
+
+    if (last)
+      stop ();
+  }
+
+  /* Scan the registry once and notify subscribers of any change. Returns
+   * TRUE if something changed */
+  bool poll ()
+  {
+    std::lock_guard<std::mutex> dispatch (dispatch_lock_);
+    std::vector<std::pair<uint64_t, Callback>> subscribers;
+    GstSpoutSenderDiff diff = scan ();
+
+    if (diff.empty ())
+      return false;
+
+    {
+      std::lock_guard<std::mutex> lock (lock_);
+      subscribers = subscribers_;
+    }
+
+    for (auto & subscriber : subscribers)
+      subscriber.second (diff);
+
+    return true;
+  }
+
+  /* Last known sender list */
+  std::vector<GstSpoutSenderDesc> senders () const
+  {
+    std::lock_guard<std::mutex> lock (lock_);
+    return senders_;
+  }
+
+  /* Is @name in the last known list. An empty @name matches any sender */
+  bool has_sender (const std::string & name) const
+  {
+    std::lock_guard<std::mutex> lock (lock_);
+
+    if (name.empty ())
+      return !senders_.empty ();
+
+    for (const auto & sender : senders_) {
+      if (sender.name == name)
+        return true;
+    }
+
+    return false;
+  }
+
+  /* Number of registry scans so far */
+  uint64_t scans () const
+  {
+    std::lock_guard<std::mutex> lock (lock_);
+    return scans_;
+  }
+
+private:
+  /* Call with dispatch_lock_ held */
+  GstSpoutSenderDiff scan ()
+  {
+    std::vector<GstSpoutSenderDesc> current = registry_->list ();
+    std::lock_guard<std::mutex> lock (lock_);
+    GstSpoutSenderDiff diff = gst_spout_diff_senders (senders_, current);
+
+    senders_ = std::move (current);
+    scans_++;
+
+    return diff;
+  }
+
+  /* Call with control_lock_ held */
+  void stop ()
+  {
+    if (!thread_.joinable ())
+      return;
+
+    {
+      std::lock_guard<std::mutex> lock (lock_);
+      stopping_ = true;
+    }
+    cond_.notify_all ();
+    thread_.join ();
+  }
+
+  void loop ()
+  {
+    for (;;) {
+      {
+        std::unique_lock<std::mutex> lock (lock_);
+        if (cond_.wait_for (lock, interval_, [this] { return stopping_; }))
+          return;
+      }
+
+      poll ();
+    }
+  }
+
+  GstSpoutSenderRegistry *registry_;
+  Duration interval_;
+
+  /* Lock order: control_lock_, dispatch_lock_, lock_ */
+  std::mutex control_lock_;         /* thread start/stop */
+  std::mutex dispatch_lock_;        /* scans and callbacks */
+  mutable std::mutex lock_;         /* everything below */
+  std::condition_variable cond_;
+
+  std::thread thread_;
+  bool stopping_ = false;
+  std::vector<GstSpoutSenderDesc> senders_;
+  std::vector<std::pair<uint64_t, Callback>> subscribers_;
+  uint64_t next_id_ = 0;
+  uint64_t scans_ = 0;
+};
@@ -0,0 +1,183 @@
+/* GStreamer
+ * Copyright (C) 2023 Your Name <your.email@example.com>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+#pragma once
+
+/* Constant frame rate pacing for spoutsrc.
+ *
+ * Lays exact ticks at the negotiated frame rate and keeps count of what went
+ * out on them: a new sender frame, a repeat of the previous one, sender
+ * frames that were replaced before a tick came, and ticks we were too late
+ * for. Tick times come from integer math on the rate fraction, so they never
+ * drift and a test clock reproduces them exactly. Free of GStreamer so it can
+ * be driven on any platform. Not thread-safe, only the streaming thread
+ * paces. Times are in nanoseconds. */
+
+#include <cstdint>
+
+class GstSpoutCfrPacer
+{
+public:
+  static constexpr uint64_t SECOND = 1000000000;
+
+  /* Forget the ticks and counters, the next tick starts a new grid */
+  void reset ()
+  {
+    started_ = false;
+    index_ = 0;
+    ticks_ = 0;
+    have_frame_ = false;
+    last_sender_frame_ = 0;
+    emitted_ = 0;
+    repeated_ = 0;
+    dropped_ = 0;
+    missed_ = 0;
+  }
+
+  /* Tick at @num/@den frames per second. A new rate continues from the
+   * next tick of the old one */
+  void set_rate (int num, int den)
+  {
+    if (num <= 0 || den <= 0 || (num == num_ && den == den_))
+      return;
+
+    if (started_) {
+      origin_ = tick_time (index_ + 1);
+      index_ = (uint64_t) -1;
+    }
+
+    num_ = num;
+    den_ = den;
+  }
+
+  bool configured () const { return num_ > 0; }
+
+  /* Time of the next tick for a caller at @now. The first call starts the
+   * grid at @now. Ticks that are over by the time we get to them are
+   * skipped and counted as missed */
+  uint64_t next_tick (uint64_t now)
+  {
+    if (!started_) {
+      started_ = true;
+      origin_ = now;
+      index_ = 0;
+      return origin_;
+    }
+
+    index_++;
+    ticks_++;
+
+    if (now >= tick_time (index_ + 1)) {
+      uint64_t current = tick_index (now);
+
+      missed_ += current - index_;
+      ticks_ += current - index_;
+      index_ = current;
+    }
+
+    return tick_time (index_);
+  }
+
+  /* Length of the current tick, exact to the nanosecond */
+  uint64_t duration () const
+  {
+    return tick_time (index_ + 1) - tick_time (index_);
+  }
+
+  /* Ticks since the grid started, including missed ones */
+  uint64_t ticks () const { return ticks_; }
+
+  /* A new sender frame goes out on this tick. @sender_frame is the sender's
+   * frame number, <= 0 if it doesn't count frames, @stale the frames our
+   * receive path replaced with newer ones since the last tick */
+  void emit (int64_t sender_frame, uint64_t stale)
+  {
+    if (sender_frame > 0 && last_sender_frame_ > 0 &&
+        sender_frame > last_sender_frame_)
+      dropped_ += (uint64_t) (sender_frame - last_sender_frame_ - 1);
+    else
+      dropped_ += stale;
+
+    last_sender_frame_ = sender_frame;
+    have_frame_ = true;
+    emitted_++;
+  }
+
+  /* The previous frame goes out again on this tick */
+  void repeat () { repeated_++; }
+
+  /* Nothing to repeat yet, or the sender is gone */
+  void forget_frame ()
+  {
+    have_frame_ = false;
+    last_sender_frame_ = 0;
+  }
+
+  bool have_frame () const { return have_frame_; }
+
+  /* Whether @sender_frame is the frame that went out last */
+  bool repeats (int64_t sender_frame) const
+  {
+    return have_frame_ && sender_frame > 0 && sender_frame == last_sender_frame_;
+  }
+
+  /* Ticks that got a frame */
+  uint64_t output () const { return started_ ? ticks_ + 1 - missed_ : 0; }
+
+  uint64_t emitted () const { return emitted_; }
+  uint64_t repeated () const { return repeated_; }
+  uint64_t dropped () const { return dropped_; }
+  uint64_t missed () const { return missed_; }
+
+private:
+  /* origin + i * den / num seconds, split so it can't overflow */
+  uint64_t tick_time (uint64_t i) const
+  {
+    uint64_t period = SECOND * (uint64_t) den_;
+
+    return origin_ + (i / num_) * period + (i % num_) * period / num_;
+  }
+
+  /* Last tick starting at or before @time */
+  uint64_t tick_index (uint64_t time) const
+  {
+    uint64_t period = SECOND * (uint64_t) den_;
+    uint64_t elapsed = time - origin_;
+
+    uint64_t i = (elapsed / period) * num_ + (elapsed % period) * num_ / period;
+
+    /* Ticks start on whole nanoseconds, rounding down */
+    while (tick_time (i + 1) <= time)
+      i++;
+
+    return i;
+  }
+
+  int num_ = 0;
+  int den_ = 1;
+  bool started_ = false;
+  uint64_t origin_ = 0;
+  uint64_t index_ = 0;
+  uint64_t ticks_ = 0;
+  bool have_frame_ = false;
+  int64_t last_sender_frame_ = 0;
+  uint64_t emitted_ = 0;
+  uint64_t repeated_ = 0;
+  uint64_t dropped_ = 0;
+  uint64_t missed_ = 0;
+};
@@ -0,0 +1,170 @@
+/* GStreamer
+ * Copyright (C) 2023 Your Name <your.email@example.com>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+#pragma once
+
+/* Adaptive buffer pool depth for spoutsrc.
+ *
+ * Fed with how long downstream holds each buffer and whether acquiring one
+ * had to wait, it works out how many buffers are in flight at the frame
+ * rate and grows the pool quickly on starvation, shrinking it slowly once
+ * buffers sit idle. Free of GStreamer and D3D11 so scripted hold times can
+ * drive it on any platform. Not thread-safe, the element serializes calls
+ * with its lock. Durations are in nanoseconds. */
+
+#include <algorithm>
+#include <cstdint>
+
+class GstSpoutPoolSizer
+{
+public:
+  /* Acquires per window, holds are summarized per window */
+  static constexpr unsigned WINDOW = 30;
+  /* Waits within a window that make the pool grow right away */
+  static constexpr unsigned GROW_WAITS = 2;
+  /* Calm windows in a row before giving back one buffer */
+  static constexpr unsigned SHRINK_WINDOWS = 4;
+
+  /* Keep between @min and @max buffers, @reserve of them are never with
+   * downstream (being received into, queued for push). @held pushed frames
+   * are kept until the next one replaces them, for repeating them. Starts
+   * out with one buffer for downstream on top of all those */
+  void configure (unsigned min, unsigned max, unsigned reserve,
+      unsigned held, uint64_t frame_duration)
+  {
+    min_ = std::max (min, 1u);
+    max_ = std::max (max, min_);
+    reserve_ = reserve;
+    held_ = held;
+    frame_duration_ = frame_duration;
+    target_ = std::clamp (reserve_ + held_ + 1, min_, max_);
+    required_ = target_;
+    calm_windows_ = 0;
+    start_window ();
+  }
+
+  /* Downstream gave back a buffer it held for @duration */
+  void record_hold (uint64_t duration)
+  {
+    window_max_hold_ = std::max (window_max_hold_, duration);
+    window_holds_++;
+    max_hold_ = std::max (max_hold_, duration);
+  }
+
+  /* An acquire completed, @waited if no buffer was free at first */
+  void record_acquire (bool waited)
+  {
+    window_acquires_++;
+    acquires_++;
+    if (waited) {
+      window_waits_++;
+      waits_++;
+    }
+  }
+
+  /* Decide on the pool depth after recording. Returns TRUE if target()
+   * changed and the pool should be resized */
+  bool update ()
+  {
+    unsigned target = target_;
+
+    if (window_waits_ >= GROW_WAITS) {
+      /* Starving, grow at least by one without waiting for the window */
+      target = std::max (target_ + 1, needed ());
+      calm_windows_ = 0;
+      start_window ();
+    } else if (window_acquires_ >= WINDOW) {
+      required_ = needed ();
+
+      if (window_waits_ > 0 || required_ > target_) {
+        target = std::max (target_, required_);
+        calm_windows_ = 0;
+      } else if (required_ < target_ && ++calm_windows_ >= SHRINK_WINDOWS) {
+        target = target_ - 1;
+        calm_windows_ = 0;
+      }
+
+      start_window ();
+    }
+
+    target = std::clamp (target, min_, max_);
+    if (target == target_)
+      return false;
+
+    target_ = target;
+    resizes_++;
+
+    return true;
+  }
+
+  /* Current pool depth */
+  unsigned target () const { return target_; }
+  /* Depth the last window's hold times asked for */
+  unsigned required () const { return required_; }
+  unsigned max () const { return max_; }
+
+  uint64_t acquires () const { return acquires_; }
+  uint64_t waits () const { return waits_; }
+  uint64_t resizes () const { return resizes_; }
+  uint64_t max_hold () const { return max_hold_; }
+
+private:
+  /* Buffers downstream keeps at the frame rate (Little's law), plus ours.
+   * Hold times run until the buffer is back, so they include the time we
+   * held it too, but never go below what we hold. Without holds in the
+   * window nothing came back, keep what we have */
+  unsigned needed () const
+  {
+    uint64_t in_flight;
+
+    if (window_holds_ == 0 || frame_duration_ == 0)
+      return target_;
+
+    in_flight = (window_max_hold_ + frame_duration_ - 1) / frame_duration_;
+    in_flight = std::max<uint64_t> (in_flight, held_);
+
+    return (unsigned) std::min<uint64_t> (in_flight + reserve_, max_);
+  }
+
+  void start_window ()
+  {
+    window_acquires_ = 0;
+    window_waits_ = 0;
+    window_holds_ = 0;
+    window_max_hold_ = 0;
+  }
+
+  unsigned min_ = 1;
+  unsigned max_ = 1;
+  unsigned reserve_ = 1;
+  unsigned held_ = 0;
+  uint64_t frame_duration_ = 0;
+  unsigned target_ = 1;
+  unsigned required_ = 1;
+  unsigned calm_windows_ = 0;
+
+  unsigned window_acquires_ = 0;
+  unsigned window_waits_ = 0;
+  unsigned window_holds_ = 0;
+  uint64_t window_max_hold_ = 0;
+
+  uint64_t acquires_ = 0;
+  uint64_t waits_ = 0;
+  uint64_t resizes_ = 0;
+  uint64_t max_hold_ = 0;
+};
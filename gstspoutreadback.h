@@ -0,0 +1,203 @@
+/* GStreamer
+ * Copyright (C) 2023 Your Name <your.email@example.com>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#pragma once
+
+/* Pipelined GPU to system memory readback for spoutsrc.
+ *
+ * Frames are copied into a ring of staging slots and only read back once
+ * @latency newer copies were issued after them, by which time the GPU is
+ * normally done and mapping does not stall. Free of GStreamer, D3D11 and
+ * Spout: the element plugs in a D3D11 copy engine, a mock engine with
+ * simulated completion drives the same scheduler on any platform. */
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+/* Outcome of mapping a staging slot */
+enum class GstSpoutMapResult
+{
+  DONE,          /* the slot is mapped */
+  WOULD_BLOCK,   /* the copy is still in flight, only without waiting */
+  ERROR,         /* mapping failed, the slot content is lost */
+};
+
+/* CPU view of a mapped staging slot */
+struct GstSpoutMapping
+{
+  const uint8_t *data = nullptr;
+  size_t stride = 0;
+};
+
+/* Outcome of GstSpoutReadbackRing::collect() */
+enum class GstSpoutReadbackResult
+{
+  READY,     /* the oldest frame was handed to the sink */
+  PENDING,   /* frames are in flight but none is due yet */
+  EMPTY,     /* nothing in flight */
+  ERROR,     /* mapping or the sink failed, the oldest frame was dropped */
+};
+
+/* Engine requirements:
+ *   Source     what frames are copied from, e.g. GstBuffer *
+ *   bool copy (unsigned int slot, const Source &)
+ *              issue an asynchronous copy into @slot
+ *   GstSpoutMapResult map (unsigned int slot, bool wait, GstSpoutMapping &)
+ *              map @slot for reading, without waiting for the copy unless @wait
+ *   void unmap (unsigned int slot)
+ *
+ * Slots are only copied into after they were read back or reset(), an engine
+ * may (re)create slot storage in copy() */
+template <typename Engine, typename Tag>
+class GstSpoutReadbackRing
+{
+public:
+  using Source = typename Engine::Source;
+
+  GstSpoutReadbackRing () { configure (2); }
+
+  /* Frames of latency before a frame is read back. One slot more than that
+   * is kept so a late copy costs a frame of latency instead of a stall.
+   * Forgets the frames in flight */
+  void configure (unsigned int latency)
+  {
+    latency_ = latency;
+    slots_.assign (latency + 2, Tag ());
+    head_ = 0;
+    count_ = 0;
+  }
+
+  unsigned int latency () const { return latency_; }
+  unsigned int slots () const { return (unsigned int) slots_.size (); }
+  unsigned int in_flight () const { return count_; }
+  bool full () const { return count_ == slots_.size (); }
+
+  /* Issue the copy of @source, carrying @tag to the sink. Fails if the ring
+   * is full, collect() first */
+  bool submit (const Source & source, const Tag & tag)
+  {
+    if (full ())
+      return false;
+
+    unsigned int slot = (head_ + count_) % slots ();
+
+    if (!engine_.copy (slot, source)) {
+      errors_++;
+      return false;
+    }
+
+    slots_[slot] = tag;
+    count_++;
+    submitted_++;
+
+    return true;
+  }
+
+  /* Read back the oldest frame once it is due, that is once more than
+   * latency() frames are in flight or when @drain. @sink is called as
+   * bool (const GstSpoutMapping &, const Tag &) while the slot is mapped.
+   * Only waits for the GPU if the ring is full, or always with a latency
+   * of 0 */
+  template <typename Sink>
+  GstSpoutReadbackResult collect (Sink && sink, bool drain = false)
+  {
+    if (count_ == 0)
+      return GstSpoutReadbackResult::EMPTY;
+
+    if (!drain && count_ <= latency_)
+      return GstSpoutReadbackResult::PENDING;
+
+    unsigned int slot = head_;
+    GstSpoutMapping mapping;
+    GstSpoutMapResult result = engine_.map (slot, false, mapping);
+
+    if (result == GstSpoutMapResult::WOULD_BLOCK) {
+      late_++;
+      if (!drain && !full () && latency_ > 0)
+        return GstSpoutReadbackResult::PENDING;
+
+      stalls_++;
+      result = engine_.map (slot, true, mapping);
+    }
+
+    bool ok = false;
+    if (result == GstSpoutMapResult::DONE) {
+      ok = sink (mapping, slots_[slot]);
+      engine_.unmap (slot);
+    }
+
+    slots_[slot] = Tag ();
+    head_ = (head_ + 1) % slots ();
+    count_--;
+
+    if (!ok) {
+      errors_++;
+      return GstSpoutReadbackResult::ERROR;
+    }
+
+    collected_++;
+    return GstSpoutReadbackResult::READY;
+  }
+
+  /* Forget the frames in flight, e.g. on flush or format change */
+  void reset ()
+  {
+    for (auto & tag : slots_)
+      tag = Tag ();
+    head_ = 0;
+    count_ = 0;
+  }
+
+  Engine & engine () { return engine_; }
+
+  uint64_t submitted () const { return submitted_; }
+  uint64_t collected () const { return collected_; }
+  uint64_t late () const { return late_; }        /* not done when due */
+  uint64_t stalls () const { return stalls_; }    /* had to wait for the GPU */
+  uint64_t errors () const { return errors_; }
+
+private:
+  Engine engine_;
+  std::vector<Tag> slots_;
+  unsigned int latency_ = 0;
+  unsigned int head_ = 0;     /* oldest frame in flight */
+  unsigned int count_ = 0;
+
+  uint64_t submitted_ = 0;
+  uint64_t collected_ = 0;
+  uint64_t late_ = 0;
+  uint64_t stalls_ = 0;
+  uint64_t errors_ = 0;
+};
+
+/* Copy @rows rows of @row_size bytes between buffers of different strides */
+static inline void
+gst_spout_copy_rows (uint8_t * dest, size_t dest_stride, const uint8_t * src,
+    size_t src_stride, size_t row_size, size_t rows)
+{
+  if (dest_stride == src_stride && dest_stride == row_size) {
+    memcpy (dest, src, row_size * rows);
+    return;
+  }
+
+  for (size_t row = 0; row < rows; row++)
+    memcpy (dest + row * dest_stride, src + row * src_stride, row_size);
+}
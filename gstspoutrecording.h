@@ -0,0 +1,854 @@
+/* GStreamer
+ * Copyright (C) 2023 Your Name <your.email@example.com>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#pragma once
+
+/* Recordings of what spoutsrc receives, and the "replay" backend that plays
+ * them back.
+ *
+ * A recording is a file of records: connects with the sender's name, frame
+ * formats, frames and disconnects, each stamped with the monotonic time it
+ * happened. Frames carry the sender's frame number and timestamp, plus their
+ * content or a fingerprint of it where they were in system memory. Both
+ * ends map the file: GstSpoutRecorder appends records without a write() per
+ * frame, and GstSpoutReplayReceiver hands out frame content straight from
+ * the mapping like a sender's shared memory. Replays keep the original
+ * timing, down to the frames a busy receiver misses, or run as fast as
+ * frames are taken. Free of GStreamer, D3D11 and Spout. */
+
+#include "gstspoutbackend.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#define GST_SPOUT_RECORDING_MAGIC    0x52505347u   /* "GSPR" */
+#define GST_SPOUT_RECORDING_VERSION  1u
+#define GST_SPOUT_RECORDING_ALIGN    4096          /* frame content starts on a page */
+#define GST_SPOUT_RECORDING_GROWTH   ((size_t) 64 << 20)  /* bytes at least */
+
+typedef enum
+{
+  GST_SPOUT_REPLAY_TIMING_ORIGINAL,   /* as far apart as they were recorded */
+  GST_SPOUT_REPLAY_TIMING_FAST,       /* every frame, as soon as asked for */
+} GstSpoutReplayTiming;
+
+typedef enum
+{
+  GST_SPOUT_RECORD_CONNECT,           /* the sender name follows */
+  GST_SPOUT_RECORD_FORMAT,
+  GST_SPOUT_RECORD_FRAME,             /* the content follows, if any */
+  GST_SPOUT_RECORD_DISCONNECT,
+} GstSpoutRecordType;
+
+/* Start of a recording file. Records follow up to length, which only ever
+ * covers complete ones: a recording cut short by a crash still plays */
+struct GstSpoutRecordingHeader
+{
+  uint32_t magic;
+  uint32_t version;
+  std::atomic<uint64_t> length;       /* from the start of the file */
+  uint64_t reserved[6];
+};
+
+struct GstSpoutRecord
+{
+  uint32_t type;
+  uint32_t name_size;                 /* connect */
+  uint64_t size;                      /* of the whole record, 8-byte aligned */
+  uint64_t time;                      /* monotonic ns */
+  union {
+    struct {
+      uint32_t width;
+      uint32_t height;
+      uint32_t format;                /* DXGI_FORMAT */
+      uint32_t stride;
+      double fps;
+    } format;
+    struct {
+      uint64_t number;                /* of the sender, 0 if it doesn't count */
+      uint64_t timestamp;             /* of the sender, 0 if unknown */
+      uint64_t fingerprint;           /* 0 if unknown */
+      uint64_t content_offset;        /* from the start of the file, 0 if none */
+      uint64_t content_size;
+    } frame;
+  };
+};
+
+static inline size_t
+gst_spout_recording_align (size_t size, size_t alignment)
+{
+  return (size + alignment - 1) / alignment * alignment;
+}
+
+/* A whole file mapped into memory: created and grown for writing, or opened
+ * to read */
+class GstSpoutFileMapping
+{
+public:
+  GstSpoutFileMapping () = default;
+  ~GstSpoutFileMapping () { close (); }
+
+  GstSpoutFileMapping (const GstSpoutFileMapping &) = delete;
+  GstSpoutFileMapping & operator= (const GstSpoutFileMapping &) = delete;
+
+  /* A new file of @size bytes, replacing any file at @path. Its blocks are
+   * allocated up front where the system can, so running out of disk space
+   * fails here rather than on a write through the mapping */
+  bool create (const std::string & path, size_t size)
+  {
+    close ();
+    writable_ = true;
+#ifdef _WIN32
+    file_ = CreateFileA (path.c_str (), GENERIC_READ | GENERIC_WRITE,
+        FILE_SHARE_READ, NULL, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (file_ == INVALID_HANDLE_VALUE)
+      return false;
+#else
+    fd_ = ::open (path.c_str (), O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (fd_ < 0)
+      return false;
+#endif
+    if (!map (size)) {
+      close ();
+      return false;
+    }
+    return true;
+  }
+
+  /* An existing file, read only */
+  bool open (const std::string & path)
+  {
+    close ();
+    writable_ = false;
+#ifdef _WIN32
+    LARGE_INTEGER size;
+
+    file_ = CreateFileA (path.c_str (), GENERIC_READ,
+        FILE_SHARE_READ | FILE_SHARE_WRITE, NULL, OPEN_EXISTING,
+        FILE_ATTRIBUTE_NORMAL, NULL);
+    if (file_ == INVALID_HANDLE_VALUE || !GetFileSizeEx (file_, &size) ||
+        size.QuadPart <= 0 || !map ((size_t) size.QuadPart)) {
+      close ();
+      return false;
+    }
+#else
+    struct stat st;
+
+    fd_ = ::open (path.c_str (), O_RDONLY | O_CLOEXEC);
+    if (fd_ < 0 || fstat (fd_, &st) != 0 || st.st_size <= 0 ||
+        !map ((size_t) st.st_size)) {
+      close ();
+      return false;
+    }
+#endif
+    return true;
+  }
+
+  /* Grows a created file to @size bytes, data() moves */
+  bool resize (size_t size)
+  {
+    unmap ();
+    return map (size);
+  }
+
+  /* Cuts a created file down to @length bytes first */
+  void close (size_t length = SIZE_MAX)
+  {
+    unmap ();
+#ifdef _WIN32
+    if (file_ != INVALID_HANDLE_VALUE) {
+      if (writable_ && length != SIZE_MAX) {
+        LARGE_INTEGER end;
+
+        end.QuadPart = (LONGLONG) length;
+        if (SetFilePointerEx (file_, end, NULL, FILE_BEGIN))
+          SetEndOfFile (file_);
+      }
+      CloseHandle (file_);
+      file_ = INVALID_HANDLE_VALUE;
+    }
+#else
+    if (fd_ >= 0) {
+      if (writable_ && length != SIZE_MAX && ftruncate (fd_, (off_t) length)) {
+        /* Nothing to do about it, readers go by the header's length */
+      }
+      ::close (fd_);
+      fd_ = -1;
+    }
+#endif
+  }
+
+  uint8_t *data () const { return (uint8_t *) data_; }
+  size_t size () const { return size_; }
+
+  static void remove (const std::string & path)
+  {
+#ifdef _WIN32
+    DeleteFileA (path.c_str ());
+#else
+    ::unlink (path.c_str ());
+#endif
+  }
+
+private:
+  bool map (size_t size)
+  {
+#ifdef _WIN32
+    mapping_ = CreateFileMappingA (file_, NULL,
+        writable_ ? PAGE_READWRITE : PAGE_READONLY,
+        (DWORD) ((uint64_t) size >> 32), (DWORD) size, NULL);
+    if (!mapping_)
+      return false;
+
+    data_ = MapViewOfFile (mapping_, writable_ ? FILE_MAP_WRITE : FILE_MAP_READ,
+        0, 0, size);
+    if (!data_) {
+      CloseHandle (mapping_);
+      mapping_ = NULL;
+      return false;
+    }
+#else
+    if (writable_) {
+#ifdef __linux__
+      if (posix_fallocate (fd_, 0, (off_t) size) != 0)
+        return false;
+#else
+      if (ftruncate (fd_, (off_t) size) != 0)
+        return false;
+#endif
+    }
+
+    data_ = mmap (NULL, size, PROT_READ | (writable_ ? PROT_WRITE : 0),
+        MAP_SHARED, fd_, 0);
+    if (data_ == MAP_FAILED) {
+      data_ = nullptr;
+      return false;
+    }
+#endif
+    size_ = size;
+    return true;
+  }
+
+  void unmap ()
+  {
+    if (!data_)
+      return;
+#ifdef _WIN32
+    UnmapViewOfFile (data_);
+    CloseHandle (mapping_);
+    mapping_ = NULL;
+#else
+    munmap (data_, size_);
+#endif
+    data_ = nullptr;
+    size_ = 0;
+  }
+
+#ifdef _WIN32
+  HANDLE file_ = INVALID_HANDLE_VALUE;
+  HANDLE mapping_ = NULL;
+#else
+  int fd_ = -1;
+#endif
+  void *data_ = nullptr;
+  size_t size_ = 0;
+  bool writable_ = false;
+};
+
+/* Appends records to a recording file. Thread-safe, connection state and
+ * frames may come from different threads */
+class GstSpoutRecorder
+{
+public:
+  ~GstSpoutRecorder () { close (); }
+
+  bool open (const std::string & path)
+  {
+    std::lock_guard<std::mutex> lock (lock_);
+    GstSpoutRecordingHeader *header;
+
+    close_locked ();
+    if (!file_.create (path, GST_SPOUT_RECORDING_GROWTH))
+      return false;
+    path_ = path;
+
+    header = this->header ();
+    header->magic = GST_SPOUT_RECORDING_MAGIC;
+    header->version = GST_SPOUT_RECORDING_VERSION;
+    length_ = sizeof (GstSpoutRecordingHeader);
+    header->length.store (length_, std::memory_order_release);
+
+    connected_ = false;
+    name_.clear ();
+    format_ = GstSpoutFrameFormat ();
+    frames_ = 0;
+    lost_ = false;
+    open_ = true;
+    return true;
+  }
+
+  void close ()
+  {
+    std::lock_guard<std::mutex> lock (lock_);
+
+    close_locked ();
+  }
+
+  /* Closes the recording and deletes its file, for a recording that
+   * shouldn't exist after all. Nothing to do when it isn't open */
+  void discard ()
+  {
+    std::lock_guard<std::mutex> lock (lock_);
+
+    if (!open_)
+      return;
+    close_locked ();
+    GstSpoutFileMapping::remove (path_);
+  }
+
+  /* Lock-free, for skipping the work of recording when nobody records */
+  bool is_open () const { return open_.load (std::memory_order_relaxed); }
+
+  /* Whether recording stopped on a write error since the last call */
+  bool lost () { return lost_.exchange (false); }
+
+  uint64_t frames () const { return frames_.load (); }
+
+  /* Records what changed since the last state: a connect, a new format or
+   * a disconnect. A new sender name counts as a connect */
+  void state (uint64_t time, bool connected, const std::string & name,
+      const GstSpoutFrameFormat & format)
+  {
+    std::lock_guard<std::mutex> lock (lock_);
+    GstSpoutRecord *record;
+
+    if (!open_)
+      return;
+
+    if (!connected) {
+      if (connected_ && (record = append (GST_SPOUT_RECORD_DISCONNECT, time,
+                  sizeof (GstSpoutRecord)))) {
+        commit (record);
+      }
+      connected_ = false;
+      return;
+    }
+
+    if (!connected_ || name != name_) {
+      record = append (GST_SPOUT_RECORD_CONNECT, time,
+          sizeof (GstSpoutRecord) + name.size ());
+      if (!record)
+        return;
+
+      record->name_size = (uint32_t) name.size ();
+      memcpy (record + 1, name.data (), name.size ());
+      commit (record);
+
+      connected_ = true;
+      name_ = name;
+      format_ = GstSpoutFrameFormat ();
+    }
+
+    if (format != format_) {
+      record = append (GST_SPOUT_RECORD_FORMAT, time, sizeof (GstSpoutRecord));
+      if (!record)
+        return;
+
+      record->format.width = format.width;
+      record->format.height = format.height;
+      record->format.format = format.format;
+      record->format.stride = format.stride;
+      record->format.fps = format.fps;
+      commit (record);
+
+      format_ = format;
+    }
+  }
+
+  /* @content may be NULL, to record the frame without it */
+  void frame (uint64_t time, uint64_t number, uint64_t timestamp,
+      uint64_t fingerprint, const uint8_t * content, size_t size)
+  {
+    std::lock_guard<std::mutex> lock (lock_);
+    GstSpoutRecord *record;
+    size_t offset = 0;
+    size_t record_size = sizeof (GstSpoutRecord);
+
+    if (!open_)
+      return;
+
+    if (content) {
+      offset = gst_spout_recording_align (length_ + sizeof (GstSpoutRecord),
+          GST_SPOUT_RECORDING_ALIGN);
+      record_size = offset + size - length_;
+    }
+
+    record = append (GST_SPOUT_RECORD_FRAME, time, record_size);
+    if (!record)
+      return;
+
+    record->frame.number = number;
+    record->frame.timestamp = timestamp;
+    record->frame.fingerprint = fingerprint;
+    if (content) {
+      record->frame.content_offset = offset;
+      record->frame.content_size = size;
+      memcpy (file_.data () + offset, content, size);
+    }
+    commit (record);
+
+    frames_++;
+  }
+
+private:
+  GstSpoutRecordingHeader *header () const
+  {
+    return (GstSpoutRecordingHeader *) file_.data ();
+  }
+
+  /* A zeroed record of @size bytes at the end, growing the file for it.
+   * NULL if it can't grow, which ends the recording. Call with the lock
+   * held */
+  GstSpoutRecord *append (GstSpoutRecordType type, uint64_t time, size_t size)
+  {
+    GstSpoutRecord *record;
+
+    size = gst_spout_recording_align (size, 8);
+    if (length_ + size > file_.size ()) {
+      size_t grow = std::max ({ size, GST_SPOUT_RECORDING_GROWTH,
+          file_.size () / 4 });
+
+      if (!file_.resize (file_.size () + grow)) {
+        close_locked ();
+        lost_ = true;
+        return nullptr;
+      }
+    }
+
+    record = (GstSpoutRecord *) (file_.data () + length_);
+    memset (record, 0, sizeof (GstSpoutRecord));
+    record->type = type;
+    record->size = size;
+    record->time = time;
+
+    return record;
+  }
+
+  /* Call with the lock held */
+  void commit (GstSpoutRecord * record)
+  {
+    length_ += record->size;
+    header ()->length.store (length_, std::memory_order_release);
+  }
+
+  /* Call with the lock held */
+  void close_locked ()
+  {
+    if (open_)
+      file_.close (length_);
+    open_ = false;
+  }
+
+  std::mutex lock_;
+  GstSpoutFileMapping file_;
+  std::string path_;
+  size_t length_ = 0;
+  bool connected_ = false;
+  std::string name_;
+  GstSpoutFrameFormat format_;
+  std::atomic<bool> open_ { false };
+  std::atomic<bool> lost_ { false };
+  std::atomic<uint64_t> frames_ { 0 };
+};
+
+/* A recording file to read records from */
+class GstSpoutRecording
+{
+public:
+  bool open (const std::string & path)
+  {
+    const GstSpoutRecordingHeader *header;
+
+    if (!file_.open (path) || file_.size () < sizeof (GstSpoutRecordingHeader))
+      return false;
+
+    header = (const GstSpoutRecordingHeader *) file_.data ();
+    if (header->magic != GST_SPOUT_RECORDING_MAGIC ||
+        header->version != GST_SPOUT_RECORDING_VERSION)
+      return false;
+
+    length_ = std::min<uint64_t> (header->length.load (std::memory_order_acquire),
+        file_.size ());
+    return length_ >= sizeof (GstSpoutRecordingHeader);
+  }
+
+  size_t begin () const { return sizeof (GstSpoutRecordingHeader); }
+
+  /* The record at @offset, the next one is at offset + size. NULL at the
+   * end, or where the record doesn't fit in the file */
+  const GstSpoutRecord *at (size_t offset) const
+  {
+    const GstSpoutRecord *record;
+
+    if (offset % 8 || offset > length_ ||
+        length_ - offset < sizeof (GstSpoutRecord))
+      return nullptr;
+
+    record = (const GstSpoutRecord *) (file_.data () + offset);
+    if (record->size < sizeof (GstSpoutRecord) || record->size % 8 ||
+        record->size > length_ - offset)
+      return nullptr;
+
+    if (record->type == GST_SPOUT_RECORD_CONNECT &&
+        record->name_size > record->size - sizeof (GstSpoutRecord))
+      return nullptr;
+
+    if (record->type == GST_SPOUT_RECORD_FRAME &&
+        record->frame.content_offset &&
+        (record->frame.content_offset < offset + sizeof (GstSpoutRecord) ||
+            record->frame.content_offset > offset + record->size ||
+            record->frame.content_size >
+                offset + record->size - record->frame.content_offset))
+      return nullptr;
+
+    return record;
+  }
+
+  std::string name (const GstSpoutRecord * record) const
+  {
+    return std::string ((const char *) (record + 1), record->name_size);
+  }
+
+  /* NULL for frames recorded without content */
+  const uint8_t *content (const GstSpoutRecord * record) const
+  {
+    if (!record->frame.content_offset)
+      return nullptr;
+
+    return file_.data () + record->frame.content_offset;
+  }
+
+private:
+  GstSpoutFileMapping file_;
+  size_t length_ = 0;
+};
+
+/* Plays a recording back as a sender. Connects, disconnects and format
+ * changes happen where they were recorded; the recording ending is the
+ * sender going away for good, see finished() */
+class GstSpoutReplayReceiver : public GstSpoutFrameReceiver
+{
+public:
+  using Clock = std::chrono::steady_clock;
+
+  bool open (const std::string & path, GstSpoutReplayTiming timing)
+  {
+    auto recording = std::make_shared<GstSpoutRecording> ();
+    std::lock_guard<std::mutex> lock (lock_);
+
+    if (!recording->open (path))
+      return false;
+
+    recording_ = std::move (recording);
+    timing_ = timing;
+    cursor_ = recording_->begin ();
+    started_ = false;
+    connected_ = false;
+    finished_ = false;
+    return true;
+  }
+
+  bool available (const std::string & name) override
+  {
+    std::lock_guard<std::mutex> lock (lock_);
+
+    if (connected_)
+      return name.empty () || name == name_;
+
+    return next_connect (name) != nullptr;
+  }
+
+  bool connect (const std::string & name) override
+  {
+    std::lock_guard<std::mutex> lock (lock_);
+    const GstSpoutRecord *record = next_connect (name);
+    const GstSpoutRecord *format;
+
+    if (!record)
+      return false;
+
+    /* The recorder puts a connect's format right after it */
+    format = recording_->at (cursor_ + record->size);
+    if (!format || format->type != GST_SPOUT_RECORD_FORMAT) {
+      cursor_ += record->size;
+      return false;
+    }
+
+    /* Reconnecting took longer than it did when recording, the rest of the
+     * replay moves along instead of bursting to catch up */
+    if (timing_ == GST_SPOUT_REPLAY_TIMING_ORIGINAL) {
+      Clock::time_point due = this->due (record->time);
+      Clock::duration late = Clock::now () - due;
+
+      if (late > Clock::duration::zero ())
+        origin_ += late;
+    }
+
+    name_ = recording_->name (record);
+    apply_format (format);
+    cursor_ += record->size + format->size;
+    connected_ = true;
+    return true;
+  }
+
+  void disconnect () override
+  {
+    std::lock_guard<std::mutex> lock (lock_);
+
+    connected_ = false;
+    name_.clear ();
+    format_ = GstSpoutFrameFormat ();
+  }
+
+  bool finished () const override
+  {
+    std::lock_guard<std::mutex> lock (lock_);
+
+    return finished_;
+  }
+
+  std::string sender_name () const override
+  {
+    std::lock_guard<std::mutex> lock (lock_);
+
+    return name_;
+  }
+
+  GstSpoutFrameFormat format () const override
+  {
+    std::lock_guard<std::mutex> lock (lock_);
+
+    return format_;
+  }
+
+  GstSpoutReceiveResult receive (GstSpoutFrameLease & lease,
+      Duration timeout) override
+  {
+    std::unique_lock<std::mutex> lock (lock_);
+    auto deadline = Clock::now () + timeout;
+
+    for (;;) {
+      const GstSpoutRecord *record;
+      Clock::time_point now, due;
+
+      if (!connected_)
+        return GstSpoutReceiveResult::ERROR;
+
+      record = recording_->at (cursor_);
+      if (!record) {
+        connected_ = false;
+        finished_ = true;
+        return GstSpoutReceiveResult::ERROR;
+      }
+
+      /* A new sender without a disconnect first, connect again */
+      if (record->type == GST_SPOUT_RECORD_CONNECT) {
+        connected_ = false;
+        return GstSpoutReceiveResult::ERROR;
+      }
+
+      /* Applies to the frames after it, whenever they are due */
+      if (record->type == GST_SPOUT_RECORD_FORMAT) {
+        apply_format (record);
+        cursor_ += record->size;
+        continue;
+      }
+
+      now = Clock::now ();
+      due = this->due (record->time);
+      if (due > now) {
+        if (woken_) {
+          woken_ = false;
+          return GstSpoutReceiveResult::NO_FRAME;
+        }
+        if (now >= deadline)
+          return GstSpoutReceiveResult::NO_FRAME;
+
+        wake_.wait_until (lock, std::min (due, deadline));
+        continue;
+      }
+
+      cursor_ += record->size;
+      if (record->type == GST_SPOUT_RECORD_DISCONNECT) {
+        connected_ = false;
+        finished_ = !recording_->at (cursor_);
+        return GstSpoutReceiveResult::ERROR;
+      }
+      if (record->type != GST_SPOUT_RECORD_FRAME)
+        continue;
+
+      /* A live sender doesn't wait for a busy receiver, frames that were
+       * replaced by the time we got to them are never seen */
+      if (timing_ == GST_SPOUT_REPLAY_TIMING_ORIGINAL && next_frame_due ())
+        continue;
+
+      lease_frame (record, lease);
+      return GstSpoutReceiveResult::FRAME;
+    }
+  }
+
+  void wake () override
+  {
+    std::lock_guard<std::mutex> lock (lock_);
+
+    woken_ = true;
+    wake_.notify_all ();
+  }
+
+private:
+  /* When the record made at @time plays. The first record anybody looks at
+   * plays right away. Call with the lock held */
+  Clock::time_point due (uint64_t time)
+  {
+    if (timing_ == GST_SPOUT_REPLAY_TIMING_FAST)
+      return Clock::time_point::min ();
+
+    if (!started_) {
+      started_ = true;
+      origin_ = Clock::now ();
+      base_ = time;
+    }
+
+    return origin_ + std::chrono::nanoseconds (time > base_ ? time - base_ : 0);
+  }
+
+  /* The next connect to @name that is due, skipping whatever is left of the
+   * last connection. Call with the lock held */
+  const GstSpoutRecord *next_connect (const std::string & name)
+  {
+    const GstSpoutRecord *record;
+
+    if (!recording_)
+      return nullptr;
+
+    while ((record = recording_->at (cursor_))) {
+      if (record->type == GST_SPOUT_RECORD_CONNECT &&
+          (name.empty () || recording_->name (record) == name)) {
+        Clock::time_point due = this->due (record->time);
+
+        return due <= Clock::now () ? record : nullptr;
+      }
+
+      cursor_ += record->size;
+    }
+
+    finished_ = true;
+    return nullptr;
+  }
+
+  /* Call with the lock held */
+  bool next_frame_due ()
+  {
+    const GstSpoutRecord *next = recording_->at (cursor_);
+    Clock::time_point due;
+
+    if (!next || next->type != GST_SPOUT_RECORD_FRAME)
+      return false;
+
+    due = this->due (next->time);
+    return due <= Clock::now ();
+  }
+
+  /* Call with the lock held */
+  void apply_format (const GstSpoutRecord * record)
+  {
+    format_.width = record->format.width;
+    format_.height = record->format.height;
+    format_.format = record->format.format;
+    format_.stride = record->format.stride;
+    format_.fps = record->format.fps;
+  }
+
+  /* Frames recorded without content play as a blank frame of the current
+   * format. Call with the lock held */
+  void lease_frame (const GstSpoutRecord * record, GstSpoutFrameLease & lease)
+  {
+    const uint8_t *content = recording_->content (record);
+    size_t size = (size_t) format_.stride * format_.height;
+
+    if (content && record->frame.content_size >= size) {
+      auto recording = recording_;
+
+      /* The lease keeps the file mapped */
+      lease.hold (content, (size_t) record->frame.content_size,
+          [recording] () { });
+    } else {
+      if (!blank_ || blank_->size () != size)
+        blank_ = std::make_shared<std::vector<uint8_t>> (size);
+
+      auto blank = blank_;
+      lease.hold (blank->data (), blank->size (), [blank] () { });
+    }
+
+    lease.frame = record->frame.number;
+    lease.timestamp = 0;
+
+    /* Sender timestamps move along with the replay, on our monotonic clock */
+    if (timing_ == GST_SPOUT_REPLAY_TIMING_ORIGINAL &&
+        record->frame.timestamp >= base_) {
+      std::chrono::nanoseconds origin = origin_.time_since_epoch ();
+
+      lease.timestamp = (uint64_t) origin.count () + record->frame.timestamp -
+          base_;
+    }
+  }
+
+  mutable std::mutex lock_;
+  std::condition_variable wake_;
+  std::shared_ptr<GstSpoutRecording> recording_;
+  GstSpoutReplayTiming timing_ = GST_SPOUT_REPLAY_TIMING_ORIGINAL;
+  size_t cursor_ = 0;
+  bool started_ = false;
+  Clock::time_point origin_;
+  uint64_t base_ = 0;
+  bool connected_ = false;
+  bool finished_ = false;
+  bool woken_ = false;
+  std::string name_;
+  GstSpoutFrameFormat format_;
+  std::shared_ptr<std::vector<uint8_t>> blank_;
+};
@@ -0,0 +1,921 @@
+/* GStreamer
+ * Copyright (C) 2023 Your Name <your.email@example.com>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#pragma once
+
+/* Frame ring in named shared memory, the "shm" receive backend.
+ *
+ * A sender process publishes frames into a ring of slots in a shared memory
+ * object and lists itself in a registry, another shared memory object with
+ * a fixed table of senders. Receivers look the sender up by name, map its
+ * ring and lease the newest slot: they read it in place, so frames reach
+ * the pipeline without a single copy; leases also carry the ring's fd and
+ * the slot's offset in it, for consumers that import frames by fd. Slots
+ * carry a reader count the
+ * sender checks before writing, it never overwrites a leased frame and
+ * never waits for receivers either, it drops the frame when every slot is
+ * taken. New frames are signalled through a futex on Linux and a named
+ * event on Windows.
+ *
+ * The same header is all a sender needs, see GstSpoutShmSender. Free of
+ * GStreamer, D3D11 and Spout. */
+
+#include "gstspoutbackend.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <vector>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <cerrno>
+#include <climits>
+#include <ctime>
+#include <fcntl.h>
+#include <signal.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#ifdef __linux__
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#endif
+#endif
+
+#define GST_SPOUT_SHM_MAGIC        0x53505347u   /* "GSPS" */
+#define GST_SPOUT_SHM_VERSION      1u
+#define GST_SPOUT_SHM_REGISTRY     "gstspout-registry"
+#define GST_SPOUT_SHM_MAX_SENDERS  64
+#define GST_SPOUT_SHM_NAME_SIZE    256           /* like Spout sender names */
+#define GST_SPOUT_SHM_MIN_SLOTS    3             /* latest, leased, written */
+#define GST_SPOUT_SHM_MAX_SLOTS    8
+#define GST_SPOUT_SHM_ALIGN        4096          /* frames start on a page */
+
+/* Slot readers count with this bit set while the sender writes the slot */
+#define GST_SPOUT_SHM_WRITER       0x80000000u
+
+static_assert (std::atomic<uint32_t>::is_always_lock_free &&
+    std::atomic<uint64_t>::is_always_lock_free,
+    "shared memory atomics must be lock-free to work across processes");
+
+struct GstSpoutShmSlot
+{
+  std::atomic<uint32_t> readers;
+  uint32_t reserved;
+  std::atomic<uint64_t> frame;
+  std::atomic<uint64_t> timestamp;
+};
+
+/* Start of a frame ring, the slots' frames follow at data_offset. Everything
+ * up to fps is written once before magic */
+struct GstSpoutShmHeader
+{
+  std::atomic<uint32_t> magic;
+  uint32_t version;
+  uint32_t pid;                 /* of the sender */
+  uint32_t width;
+  uint32_t height;
+  uint32_t format;              /* DXGI_FORMAT */
+  uint32_t stride;
+  uint32_t slot_count;
+  uint64_t frame_size;
+  uint64_t slot_stride;
+  uint64_t data_offset;
+  double fps;
+  std::atomic<uint64_t> latest;       /* frame << 8 | slot, 0 before the first */
+  std::atomic<uint32_t> signal;       /* bumped on every publish, the futex */
+  std::atomic<uint32_t> closed;
+  std::atomic<uint64_t> dropped;      /* frames with every slot leased */
+  GstSpoutShmSlot slots[GST_SPOUT_SHM_MAX_SLOTS];
+};
+
+enum
+{
+  GST_SPOUT_SHM_ENTRY_FREE,
+  GST_SPOUT_SHM_ENTRY_CLAIMED,        /* being filled in or emptied */
+  GST_SPOUT_SHM_ENTRY_ACTIVE,
+};
+
+struct GstSpoutShmEntry
+{
+  std::atomic<uint32_t> state;
+  uint32_t pid;
+  std::atomic<uint64_t> serial;       /* bumped on every claim */
+  char name[GST_SPOUT_SHM_NAME_SIZE];
+  char ring[64];
+};
+
+struct GstSpoutShmRegistryTable
+{
+  std::atomic<uint32_t> magic;
+  uint32_t version;
+  std::atomic<uint64_t> serial;
+  GstSpoutShmEntry entries[GST_SPOUT_SHM_MAX_SENDERS];
+};
+
+static inline size_t
+gst_spout_shm_align (size_t size)
+{
+  return (size + GST_SPOUT_SHM_ALIGN - 1) & ~(size_t) (GST_SPOUT_SHM_ALIGN - 1);
+}
+
+static inline uint32_t
+gst_spout_shm_current_pid ()
+{
+#ifdef _WIN32
+  return (uint32_t) GetCurrentProcessId ();
+#else
+  return (uint32_t) getpid ();
+#endif
+}
+
+/* Whether the process that registered a sender is still around, senders
+ * that crashed leave their entries behind */
+static inline bool
+gst_spout_shm_process_alive (uint32_t pid)
+{
+#ifdef _WIN32
+  HANDLE process = OpenProcess (SYNCHRONIZE, FALSE, (DWORD) pid);
+  bool alive;
+
+  if (!process)
+    return GetLastError () == ERROR_ACCESS_DENIED;
+
+  alive = WaitForSingleObject (process, 0) == WAIT_TIMEOUT;
+  CloseHandle (process);
+  return alive;
+#else
+  return kill ((pid_t) pid, 0) == 0 || errno == EPERM;
+#endif
+}
+
+/* A named shared memory object mapped read-write. Named POSIX shared memory
+ * rather than a memfd, receivers find it without an fd being passed over */
+class GstSpoutShmMapping
+{
+public:
+  GstSpoutShmMapping () = default;
+  ~GstSpoutShmMapping () { close (); }
+
+  GstSpoutShmMapping (const GstSpoutShmMapping &) = delete;
+  GstSpoutShmMapping & operator= (const GstSpoutShmMapping &) = delete;
+
+  /* Create @name with @size zeroed bytes. Unless @exclusive, an existing
+   * object is opened instead and grown to @size if smaller */
+  bool create (const std::string & name, size_t size, bool exclusive)
+  {
+    close ();
+    name_ = name;
+#ifdef _WIN32
+    std::string path = "Local\\" + name;
+
+    handle_ = CreateFileMappingA (INVALID_HANDLE_VALUE, NULL, PAGE_READWRITE,
+        (DWORD) ((uint64_t) size >> 32), (DWORD) size, path.c_str ());
+    if (!handle_ || (exclusive && GetLastError () == ERROR_ALREADY_EXISTS)) {
+      close ();
+      return false;
+    }
+    return map (size);
+#else
+    std::string path = "/" + name;
+    int flags = O_RDWR | O_CREAT | (exclusive ? O_EXCL : 0);
+    struct stat st;
+
+    fd_ = shm_open (path.c_str (), flags, 0600);
+    if (fd_ < 0)
+      return false;
+    owner_ = exclusive;
+    if (fstat (fd_, &st) < 0 ||
+        ((size_t) st.st_size < size && ftruncate (fd_, (off_t) size) < 0) ||
+        !map (size)) {
+      unlink ();
+      close ();
+      return false;
+    }
+    return true;
+#endif
+  }
+
+  /* Map the existing object @name in full */
+  bool open (const std::string & name)
+  {
+    close ();
+    name_ = name;
+#ifdef _WIN32
+    std::string path = "Local\\" + name;
+    MEMORY_BASIC_INFORMATION info;
+
+    handle_ = OpenFileMappingA (FILE_MAP_ALL_ACCESS, FALSE, path.c_str ());
+    if (!handle_ || !map (0) ||
+        !VirtualQuery (data_, &info, sizeof (info))) {
+      close ();
+      return false;
+    }
+    size_ = info.RegionSize;
+    return true;
+#else
+    std::string path = "/" + name;
+    struct stat st;
+
+    fd_ = shm_open (path.c_str (), O_RDWR, 0);
+    if (fd_ < 0 || fstat (fd_, &st) < 0 || !map ((size_t) st.st_size)) {
+      close ();
+      return false;
+    }
+    return true;
+#endif
+  }
+
+  /* Take the name away from new receivers, mappings stay valid. Windows
+   * drops the object with its last handle by itself */
+  void unlink ()
+  {
+    if (owner_)
+      remove (name_);
+    owner_ = false;
+  }
+
+  static void remove (const std::string & name)
+  {
+#ifdef _WIN32
+    (void) name;
+#else
+    shm_unlink (("/" + name).c_str ());
+#endif
+  }
+
+  void close ()
+  {
+#ifdef _WIN32
+    if (data_)
+      UnmapViewOfFile (data_);
+    if (handle_)
+      CloseHandle (handle_);
+    handle_ = NULL;
+#else
+    if (data_)
+      munmap (data_, size_);
+    if (fd_ >= 0)
+      ::close (fd_);
+    fd_ = -1;
+#endif
+    data_ = nullptr;
+    size_ = 0;
+  }
+
+  uint8_t *data () const { return (uint8_t *) data_; }
+  size_t size () const { return size_; }
+
+  /* Of the open object, -1 on Windows where it's a section handle */
+  int fd () const
+  {
+#ifdef _WIN32
+    return -1;
+#else
+    return fd_;
+#endif
+  }
+  const std::string & name () const { return name_; }
+
+private:
+  bool map (size_t size)
+  {
+#ifdef _WIN32
+    data_ = MapViewOfFile (handle_, FILE_MAP_ALL_ACCESS, 0, 0, size);
+#else
+    data_ = size ? mmap (nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED,
+        fd_, 0) : MAP_FAILED;
+    if (data_ == MAP_FAILED)
+      data_ = nullptr;
+#endif
+    size_ = data_ ? size : 0;
+    return data_ != nullptr;
+  }
+
+  std::string name_;
+  void *data_ = nullptr;
+  size_t size_ = 0;
+  bool owner_ = false;
+#ifdef _WIN32
+  HANDLE handle_ = NULL;
+#else
+  int fd_ = -1;
+#endif
+};
+
+/* New-frame signalling on a ring's signal word. On Linux a futex on the word
+ * itself. Windows has no futex across processes, there the sender sets a
+ * named auto-reset event: with several receivers on one sender only one is
+ * woken per frame, the others see it when their wait times out */
+class GstSpoutShmSignal
+{
+public:
+  GstSpoutShmSignal () = default;
+  ~GstSpoutShmSignal () { close (); }
+
+  GstSpoutShmSignal (const GstSpoutShmSignal &) = delete;
+  GstSpoutShmSignal & operator= (const GstSpoutShmSignal &) = delete;
+
+  bool open (const std::string & ring)
+  {
+    close ();
+#ifdef _WIN32
+    std::string path = "Local\\" + ring + "-frame";
+
+    event_ = CreateEventA (NULL, FALSE, FALSE, path.c_str ());
+    interrupt_ = CreateEventA (NULL, FALSE, FALSE, NULL);
+    if (!event_ || !interrupt_) {
+      close ();
+      return false;
+    }
+#else
+    (void) ring;
+#endif
+    return true;
+  }
+
+  void close ()
+  {
+#ifdef _WIN32
+    if (event_)
+      CloseHandle (event_);
+    if (interrupt_)
+      CloseHandle (interrupt_);
+    event_ = interrupt_ = NULL;
+#endif
+  }
+
+  /* Sender: @word was bumped for a new frame */
+  void notify (std::atomic<uint32_t> & word)
+  {
+#ifdef _WIN32
+    (void) word;
+    if (event_)
+      SetEvent (event_);
+#else
+    futex (word, FUTEX_WAKE, INT_MAX, nullptr);
+#endif
+  }
+
+  /* Receiver: sleep until @word moves on from @seen, interrupt() or
+   * @timeout, whichever comes first. May return early */
+  void wait (std::atomic<uint32_t> & word, uint32_t seen,
+      std::chrono::nanoseconds timeout)
+  {
+    if (timeout.count () <= 0)
+      return;
+#ifdef _WIN32
+    HANDLE handles[] = { event_, interrupt_ };
+    DWORD ms = (DWORD) std::chrono::ceil<std::chrono::milliseconds> (timeout).count ();
+
+    if (word.load (std::memory_order_acquire) == seen)
+      WaitForMultipleObjects (2, handles, FALSE, ms);
+#else
+    struct timespec ts;
+
+    ts.tv_sec = (time_t) (timeout.count () / 1000000000);
+    ts.tv_nsec = (long) (timeout.count () % 1000000000);
+    futex (word, FUTEX_WAIT, seen, &ts);
+#endif
+  }
+
+  /* Any thread: end a wait() in progress */
+  void interrupt (std::atomic<uint32_t> & word)
+  {
+#ifdef _WIN32
+    (void) word;
+    if (interrupt_)
+      SetEvent (interrupt_);
+#else
+    /* Moving the word on also catches a receiver just about to sleep, other
+     * receivers of the sender wake up for nothing and sleep again */
+    word.fetch_add (1, std::memory_order_release);
+    futex (word, FUTEX_WAKE, INT_MAX, nullptr);
+#endif
+  }
+
+private:
+#ifdef _WIN32
+  HANDLE event_ = NULL;
+  HANDLE interrupt_ = NULL;
+#else
+  static void futex (std::atomic<uint32_t> & word, int op, uint32_t value,
+      const struct timespec * timeout)
+  {
+#ifdef __linux__
+    /* Not FUTEX_PRIVATE_FLAG, the word is shared with other processes */
+    syscall (SYS_futex, (uint32_t *) &word, op, value, timeout, nullptr, 0);
+#else
+    /* No futex, poll every millisecond instead */
+    if (op == FUTEX_WAIT) {
+      struct timespec ms = { 0, 1000000 };
+      if (timeout && timeout->tv_sec == 0 && timeout->tv_nsec < ms.tv_nsec)
+        ms = *timeout;
+      if (word.load (std::memory_order_acquire) == value)
+        nanosleep (&ms, nullptr);
+    }
+#endif
+  }
+#endif
+};
+
+/* The process-shared table of senders */
+class GstSpoutShmRegistry
+{
+public:
+  struct Sender
+  {
+    std::string name;
+    std::string ring;
+    uint32_t pid = 0;
+    uint64_t serial = 0;
+  };
+
+  bool open ()
+  {
+    if (table ())
+      return true;
+    if (!mapping_.create (GST_SPOUT_SHM_REGISTRY,
+            sizeof (GstSpoutShmRegistryTable), false))
+      return false;
+
+    /* Whoever maps it first stamps it, the rest is zero which is FREE */
+    GstSpoutShmRegistryTable *t = raw ();
+    uint32_t magic = 0;
+
+    if (!t->magic.compare_exchange_strong (magic, GST_SPOUT_SHM_MAGIC) &&
+        magic != GST_SPOUT_SHM_MAGIC) {
+      mapping_.close ();
+      return false;
+    }
+    return true;
+  }
+
+  /* Live senders, newest first */
+  std::vector<Sender> list ()
+  {
+    std::vector<Sender> senders;
+    GstSpoutShmRegistryTable *t = table ();
+
+    if (!t)
+      return senders;
+
+    for (auto & entry : t->entries) {
+      Sender sender;
+
+      if (read (entry, sender) && gst_spout_shm_process_alive (sender.pid))
+        senders.push_back (std::move (sender));
+    }
+
+    std::sort (senders.begin (), senders.end (),
+        [] (const Sender & a, const Sender & b) { return a.serial > b.serial; });
+    return senders;
+  }
+
+  /* The sender called @name, the newest one for an empty name */
+  bool find (const std::string & name, Sender & sender)
+  {
+    for (auto & candidate : list ()) {
+      if (name.empty () || candidate.name == name) {
+        sender = std::move (candidate);
+        return true;
+      }
+    }
+    return false;
+  }
+
+  /* List @name with its @ring, -1 if the name is taken or the table full.
+   * Entries of senders that died are taken over */
+  int add (const std::string & name, const std::string & ring)
+  {
+    GstSpoutShmRegistryTable *t = table ();
+    Sender existing;
+
+    if (!t || name.empty () || name.size () >= GST_SPOUT_SHM_NAME_SIZE ||
+        ring.size () >= sizeof (t->entries[0].ring) || find (name, existing))
+      return -1;
+
+    for (int i = 0; i < GST_SPOUT_SHM_MAX_SENDERS; i++) {
+      GstSpoutShmEntry & entry = t->entries[i];
+      uint32_t state = GST_SPOUT_SHM_ENTRY_FREE;
+
+      if (!entry.state.compare_exchange_strong (state,
+              GST_SPOUT_SHM_ENTRY_CLAIMED)) {
+        if (state != GST_SPOUT_SHM_ENTRY_ACTIVE ||
+            gst_spout_shm_process_alive (entry.pid) ||
+            !entry.state.compare_exchange_strong (state,
+                GST_SPOUT_SHM_ENTRY_CLAIMED))
+          continue;
+
+        /* Nobody else unlinks the ring of a sender that crashed */
+        GstSpoutShmMapping::remove (std::string (entry.ring,
+                strnlen (entry.ring, sizeof (entry.ring))));
+      }
+
+      entry.serial.store (t->serial.fetch_add (1) + 1,
+          std::memory_order_relaxed);
+      entry.pid = gst_spout_shm_current_pid ();
+      memset (entry.name, 0, sizeof (entry.name));
+      memset (entry.ring, 0, sizeof (entry.ring));
+      memcpy (entry.name, name.data (), name.size ());
+      memcpy (entry.ring, ring.data (), ring.size ());
+      entry.state.store (GST_SPOUT_SHM_ENTRY_ACTIVE, std::memory_order_release);
+      return i;
+    }
+    return -1;
+  }
+
+  void remove (int index)
+  {
+    GstSpoutShmRegistryTable *t = table ();
+
+    if (t && index >= 0 && index < GST_SPOUT_SHM_MAX_SENDERS)
+      t->entries[index].state.store (GST_SPOUT_SHM_ENTRY_FREE,
+          std::memory_order_release);
+  }
+
+private:
+  GstSpoutShmRegistryTable *raw () const
+  {
+    return (GstSpoutShmRegistryTable *) mapping_.data ();
+  }
+
+  GstSpoutShmRegistryTable *table () const
+  {
+    return mapping_.size () >= sizeof (GstSpoutShmRegistryTable) ? raw () : nullptr;
+  }
+
+  /* Copy out an active entry, checking it wasn't taken over meanwhile */
+  static bool read (GstSpoutShmEntry & entry, Sender & sender)
+  {
+    uint64_t serial = entry.serial.load (std::memory_order_acquire);
+
+    if (entry.state.load (std::memory_order_acquire) != GST_SPOUT_SHM_ENTRY_ACTIVE)
+      return false;
+
+    sender.name.assign (entry.name, strnlen (entry.name, sizeof (entry.name)));
+    sender.ring.assign (entry.ring, strnlen (entry.ring, sizeof (entry.ring)));
+    sender.pid = entry.pid;
+    sender.serial = serial;
+
+    std::atomic_thread_fence (std::memory_order_acquire);
+    return entry.state.load (std::memory_order_relaxed) ==
+        GST_SPOUT_SHM_ENTRY_ACTIVE &&
+        entry.serial.load (std::memory_order_relaxed) == serial;
+  }
+
+  GstSpoutShmMapping mapping_;
+};
+
+/* Publishes frames of one format, create a new sender for another one */
+class GstSpoutShmSender
+{
+public:
+  GstSpoutShmSender () = default;
+  ~GstSpoutShmSender () { close (); }
+
+  GstSpoutShmSender (const GstSpoutShmSender &) = delete;
+  GstSpoutShmSender & operator= (const GstSpoutShmSender &) = delete;
+
+  /* A stride of 0 packs rows of 4 byte pixels, the only kind of format
+   * Spout senders have */
+  bool create (const std::string & name, const GstSpoutFrameFormat & format,
+      unsigned int slots = GST_SPOUT_SHM_MIN_SLOTS)
+  {
+    static std::atomic<uint32_t> rings { 0 };
+    GstSpoutShmHeader *header;
+    uint32_t stride = format.stride ? format.stride : format.width * 4;
+    uint64_t frame_size = (uint64_t) stride * format.height;
+    std::string ring;
+
+    close ();
+    if (!format.width || !format.height || stride < format.width)
+      return false;
+
+    slots = std::clamp (slots, (unsigned int) GST_SPOUT_SHM_MIN_SLOTS,
+        (unsigned int) GST_SPOUT_SHM_MAX_SLOTS);
+    ring = "gstspout-" + std::to_string (gst_spout_shm_current_pid ()) + "-" +
+        std::to_string (rings.fetch_add (1));
+
+    size_t data_offset = gst_spout_shm_align (sizeof (GstSpoutShmHeader));
+    size_t slot_stride = gst_spout_shm_align ((size_t) frame_size);
+
+    if (!mapping_.create (ring, data_offset + slots * slot_stride, true))
+      return false;
+
+    header = this->header ();
+    header->version = GST_SPOUT_SHM_VERSION;
+    header->pid = gst_spout_shm_current_pid ();
+    header->width = format.width;
+    header->height = format.height;
+    header->format = format.format;
+    header->stride = stride;
+    header->slot_count = slots;
+    header->frame_size = frame_size;
+    header->slot_stride = slot_stride;
+    header->data_offset = data_offset;
+    header->fps = format.fps;
+    header->magic.store (GST_SPOUT_SHM_MAGIC, std::memory_order_release);
+
+    if (!signal_.open (ring) || !registry_.open () ||
+        (entry_ = registry_.add (name, ring)) < 0) {
+      close ();
+      return false;
+    }
+    return true;
+  }
+
+  /* Where to write the next frame, nullptr if receivers hold every slot
+   * the frame could go to and it has to be dropped */
+  uint8_t *begin ()
+  {
+    GstSpoutShmHeader *header = this->header ();
+    uint32_t latest;
+
+    if (!header || writing_ >= 0)
+      return nullptr;
+
+    latest = (uint32_t) (header->latest.load (std::memory_order_relaxed) & 0xff);
+    for (uint32_t i = 1; i <= header->slot_count; i++) {
+      uint32_t slot = (latest + i) % header->slot_count;
+      uint32_t readers = 0;
+
+      if (slot == latest && header->latest.load (std::memory_order_relaxed))
+        continue;
+
+      if (header->slots[slot].readers.compare_exchange_strong (readers,
+              GST_SPOUT_SHM_WRITER, std::memory_order_acq_rel)) {
+        writing_ = (int) slot;
+        return mapping_.data () + header->data_offset +
+            slot * header->slot_stride;
+      }
+    }
+
+    header->dropped.fetch_add (1, std::memory_order_relaxed);
+    return nullptr;
+  }
+
+  /* Hand the frame from begin() to receivers. @timestamp is the steady
+   * clock in ns when the frame was made, 0 for now */
+  void publish (uint64_t timestamp = 0)
+  {
+    GstSpoutShmHeader *header = this->header ();
+    GstSpoutShmSlot *slot;
+
+    if (!header || writing_ < 0)
+      return;
+
+    if (!timestamp)
+      timestamp = (uint64_t) std::chrono::duration_cast<std::chrono::nanoseconds> (
+          std::chrono::steady_clock::now ().time_since_epoch ()).count ();
+
+    slot = &header->slots[writing_];
+    slot->frame.store (++frame_, std::memory_order_relaxed);
+    slot->timestamp.store (timestamp, std::memory_order_relaxed);
+    slot->readers.fetch_sub (GST_SPOUT_SHM_WRITER, std::memory_order_release);
+
+    header->latest.store (frame_ << 8 | (uint64_t) writing_,
+        std::memory_order_release);
+    header->signal.fetch_add (1, std::memory_order_release);
+    signal_.notify (header->signal);
+    writing_ = -1;
+  }
+
+  /* Receivers get ERROR on their next receive, frames they hold stay
+   * valid */
+  void close ()
+  {
+    GstSpoutShmHeader *header = this->header ();
+
+    registry_.remove (entry_);
+    entry_ = -1;
+
+    if (header) {
+      header->closed.store (1, std::memory_order_release);
+      header->signal.fetch_add (1, std::memory_order_release);
+      signal_.notify (header->signal);
+    }
+
+    signal_.close ();
+    mapping_.unlink ();
+    mapping_.close ();
+    writing_ = -1;
+    frame_ = 0;
+  }
+
+  uint64_t frames () const { return frame_; }
+
+  uint64_t dropped () const
+  {
+    GstSpoutShmHeader *header = this->header ();
+
+    return header ? header->dropped.load (std::memory_order_relaxed) : 0;
+  }
+
+private:
+  GstSpoutShmHeader *header () const
+  {
+    return mapping_.size () >= sizeof (GstSpoutShmHeader) ?
+        (GstSpoutShmHeader *) mapping_.data () : nullptr;
+  }
+
+  GstSpoutShmMapping mapping_;
+  GstSpoutShmSignal signal_;
+  GstSpoutShmRegistry registry_;
+  int entry_ = -1;
+  int writing_ = -1;
+  uint64_t frame_ = 0;
+};
+
+/* Receives from a GstSpoutShmSender in another process (or this one) */
+class GstSpoutShmReceiver : public GstSpoutFrameReceiver
+{
+public:
+  bool available (const std::string & name) override
+  {
+    GstSpoutShmRegistry::Sender sender;
+
+    return registry_.open () && registry_.find (name, sender);
+  }
+
+  bool connect (const std::string & name) override
+  {
+    GstSpoutShmRegistry::Sender sender;
+    auto ring = std::make_shared<GstSpoutShmMapping> ();
+    GstSpoutShmHeader *header;
+
+    disconnect ();
+    if (!registry_.open () || !registry_.find (name, sender) ||
+        !ring->open (sender.ring) || ring->size () < sizeof (GstSpoutShmHeader))
+      return false;
+
+    /* Frames must fit in what we mapped, whatever the header claims */
+    header = (GstSpoutShmHeader *) ring->data ();
+    if (header->magic.load (std::memory_order_acquire) != GST_SPOUT_SHM_MAGIC ||
+        header->version != GST_SPOUT_SHM_VERSION ||
+        header->slot_count < GST_SPOUT_SHM_MIN_SLOTS ||
+        header->slot_count > GST_SPOUT_SHM_MAX_SLOTS ||
+        header->frame_size < (uint64_t) header->stride * header->height ||
+        header->slot_stride < header->frame_size ||
+        header->data_offset < sizeof (GstSpoutShmHeader) ||
+        header->data_offset + header->slot_count * header->slot_stride >
+            ring->size () ||
+        !signal_.open (sender.ring))
+      return false;
+
+    format_.width = header->width;
+    format_.height = header->height;
+    format_.format = header->format;
+    format_.stride = header->stride;
+    format_.fps = header->fps;
+    name_ = sender.name;
+    ring_ = std::move (ring);
+    last_frame_ = 0;
+    return true;
+  }
+
+  void disconnect () override
+  {
+    ring_.reset ();
+    signal_.close ();
+    name_.clear ();
+    format_ = GstSpoutFrameFormat ();
+  }
+
+  bool shares_fd () const override
+  {
+#ifdef _WIN32
+    return false;
+#else
+    return true;
+#endif
+  }
+
+  std::string sender_name () const override { return name_; }
+  GstSpoutFrameFormat format () const override { return format_; }
+
+  GstSpoutReceiveResult receive (GstSpoutFrameLease & lease,
+      Duration timeout) override
+  {
+    auto deadline = std::chrono::steady_clock::now () + timeout;
+    GstSpoutShmHeader *header = this->header ();
+
+    if (!header)
+      return GstSpoutReceiveResult::ERROR;
+
+    for (;;) {
+      uint32_t seen = header->signal.load (std::memory_order_acquire);
+      auto now = std::chrono::steady_clock::now ();
+
+      if (header->closed.load (std::memory_order_acquire))
+        return GstSpoutReceiveResult::ERROR;
+      if (lease_latest (lease))
+        return GstSpoutReceiveResult::FRAME;
+      if (woken_.exchange (false))
+        return GstSpoutReceiveResult::NO_FRAME;
+
+      if (now >= deadline) {
+        /* A sender that crashed never closes its ring */
+        return gst_spout_shm_process_alive (header->pid) ?
+            GstSpoutReceiveResult::NO_FRAME : GstSpoutReceiveResult::ERROR;
+      }
+
+      signal_.wait (header->signal, seen, deadline - now);
+    }
+  }
+
+  void wake () override
+  {
+    GstSpoutShmHeader *header = this->header ();
+
+    woken_ = true;
+    if (header)
+      signal_.interrupt (header->signal);
+  }
+
+private:
+  GstSpoutShmHeader *header () const
+  {
+    return ring_ ? (GstSpoutShmHeader *) ring_->data () : nullptr;
+  }
+
+  /* Take a reader reference on the newest slot if it has a frame we haven't
+   * seen. The sender may recycle the slot between reading latest and taking
+   * the reference, it holds the writer bit while it does so and we retry;
+   * afterwards the slot may even hold a newer frame than latest said */
+  bool lease_latest (GstSpoutFrameLease & lease)
+  {
+    GstSpoutShmHeader *header = this->header ();
+
+    for (int attempt = 0; attempt < 16; attempt++) {
+      uint64_t latest = header->latest.load (std::memory_order_acquire);
+      uint32_t index = (uint32_t) (latest & 0xff);
+      GstSpoutShmSlot *slot;
+      uint64_t frame;
+
+      if (!latest || (latest >> 8) <= last_frame_ ||
+          index >= header->slot_count)
+        return false;
+
+      slot = &header->slots[index];
+      if (slot->readers.fetch_add (1, std::memory_order_acquire) &
+          GST_SPOUT_SHM_WRITER) {
+        slot->readers.fetch_sub (1, std::memory_order_release);
+        continue;
+      }
+
+      frame = slot->frame.load (std::memory_order_relaxed);
+      if (frame <= last_frame_) {
+        slot->readers.fetch_sub (1, std::memory_order_release);
+        return false;
+      }
+
+      /* The lease keeps the mapping and with it the fd */
+      auto ring = ring_;
+      size_t offset = header->data_offset + index * header->slot_stride;
+
+      lease.hold (ring->data () + offset, (size_t) header->frame_size,
+          [ring, slot] {
+            slot->readers.fetch_sub (1, std::memory_order_release);
+          });
+      lease.fd = ring->fd ();
+      lease.offset = offset;
+      lease.frame = frame;
+      lease.timestamp = slot->timestamp.load (std::memory_order_relaxed);
+      last_frame_ = frame;
+      return true;
+    }
+    return false;
+  }
+
+  GstSpoutShmRegistry registry_;
+  std::shared_ptr<GstSpoutShmMapping> ring_;
+  GstSpoutShmSignal signal_;
+  std::string name_;
+  GstSpoutFrameFormat format_;
+  uint64_t last_frame_ = 0;
+  std::atomic<bool> woken_ { false };
+};
@@ -0,0 +1,108 @@
+/* GStreamer
+ * Copyright (C) 2023 Your Name <your.email@example.com>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+#pragma once
+
+/* Publication of immutable state for spoutsrc.
+ *
+ * Writers build a complete new state and swap it in, readers take a
+ * reference to whatever is current and keep using it even if a newer one is
+ * published meanwhile. The swap goes through std::atomic<std::shared_ptr>,
+ * which is not lock-free: standard libraries guard it with a short internal
+ * lock and every load() costs a reference count increment and decrement.
+ *
+ * Per-frame readers therefore hold a View, load it once and refresh() it
+ * where the state may have changed. Refreshing an unchanged View is a single
+ * lock-free load of the publication counter. Free of GStreamer, D3D11 and
+ * Spout so it can be exercised on any platform. */
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <utility>
+
+template <typename State>
+class GstSpoutSnapshot
+{
+public:
+  using Ptr = std::shared_ptr<const State>;
+
+  /* A reader's reference to the state, with the publication it is from */
+  struct View
+  {
+    Ptr state;
+    uint64_t version = 0;
+
+    const State * operator-> () const { return state.get (); }
+    const State & operator* () const { return *state; }
+  };
+
+  GstSpoutSnapshot () : state_ (std::make_shared<const State> ()) {}
+
+  /* Reader: the current state, never NULL */
+  Ptr load () const { return state_.load (std::memory_order_acquire); }
+
+  /* Reader: the current state to hold on to and refresh() later */
+  View view () const
+  {
+    View view;
+
+    /* Versions never get ahead of the state they were read with, a
+     * publication in between only costs a needless reload later */
+    view.version = version_.load (std::memory_order_acquire);
+    view.state = load ();
+
+    return view;
+  }
+
+  /* Reader: catch @view up with the latest publication. Returns whether it
+   * changed, without touching the shared pointer if it didn't */
+  bool refresh (View & view) const
+  {
+    uint64_t version = version_.load (std::memory_order_acquire);
+
+    if (version == view.version && view.state)
+      return false;
+
+    view.version = version;
+    view.state = load ();
+
+    return true;
+  }
+
+  /* Reader: whether anything was published since @view was loaded. For
+   * waiting on a change to the state a decision was made on, a change
+   * that lands before the wait still ends it */
+  bool changed (const View & view) const
+  {
+    return !view.state ||
+        version_.load (std::memory_order_acquire) != view.version;
+  }
+
+  /* Writer: replace the current state. Concurrent writers must be
+   * serialized by the caller, otherwise the last one wins */
+  void publish (Ptr state)
+  {
+    state_.store (std::move (state), std::memory_order_release);
+    version_.fetch_add (1, std::memory_order_release);
+  }
+
+private:
+  std::atomic<Ptr> state_;
+  std::atomic<uint64_t> version_ { 0 };
+};
@@ -37,6 +37,46 @@
  * ```
  * gst-launch-1.0 spoutsrc sender-name=SenderName ! queue ! d3d11videosink
  * ```
+ *
+ * Downstream elements working on system memory are served directly, frames
+ * are read back through a ring of staging textures
+ * ```
+ * gst-launch-1.0 spoutsrc ! video/x-raw,format=BGRA ! videoconvert ! x264enc ! fakesink
+ * ```
+ *
+ * backend=shm receives from a GstSpoutShmSender frame ring in shared memory
+ * instead, without spoutDX or a GPU. Frames are pushed in place, zero-copy:
+ * the sender can't reuse a slot while downstream holds its buffer
+ * ```
+ * gst-launch-1.0 spoutsrc backend=shm sender-name=SenderName ! videoconvert ! autovideosink
+ * ```
+ *
+ * Built without GStreamer's D3D11 library and the Spout SDK, as on Linux,
+ * spoutsrc has only backend=shm, the default there, and backend=replay
+ *
+ * Where the frame ring is shared by fd, memory:FdMemory caps make buffers
+ * GstFdMemory at the slot's offset in the sender's fd, for downstream that
+ * imports frames by fd or passes them on to other processes
+ * ```
+ * gst-launch-1.0 spoutsrc backend=shm ! "video/x-raw(memory:FdMemory)" ! unixfdsink socket-path=/tmp/frames
+ * ```
+ *
+ * With huge-pages, system memory buffers from our own pool sit on huge pages
+ * and numa-node places them on one NUMA node, both faulted in when the pool
+ * starts. Downstream that provides its own pool keeps it
+ * ```
+ * gst-launch-1.0 spoutsrc huge-pages=true numa-node=0 ! video/x-raw,format=BGRA,width=3840,height=2160 ! x264enc ! fakesink
+ * ```
+ *
+ * record-location records what spoutsrc receives: connects, disconnects,
+ * format changes and frames with their arrival times, plus their content
+ * where it is in system memory. backend=replay plays a recording back with
+ * the original timing, or as fast as downstream takes frames with
+ * replay-timing=fast, and ends with EOS
+ * ```
+ * gst-launch-1.0 spoutsrc sender-name=SenderName record-location=session.gspr ! d3d11videosink
+ * gst-launch-1.0 spoutsrc backend=replay replay-location=session.gspr replay-timing=fast ! fakesink
+ * ```
  */
 
 #ifdef HAVE_CONFIG_H
@@ -44,12 +84,49 @@
 #endif
 
 #include "gstspoutsrc.h"
+#include "gstspoutallocator.h"
+#include "gstspoutdeviceprovider.h"
+#include "gstspoutbackend.h"
+#include "gstspoutbackoff.h"
+#include "gstspoutcadence.h"
+#include "gstspoutcaps.h"
+#include "gstspoutcapture.h"
+#include "gstspoutconvert.h"
+#include "gstspoutdedup.h"
+#include "gstspoutformat.h"
+#include "gstspoutgeometry.h"
+#include "gstspoutlatency.h"
+#include "gstspoutpacer.h"
+#include "gstspoutpoolsizer.h"
+#include "gstspoutreadback.h"
+#include "gstspoutrecording.h"
+#include "gstspoutshm.h"
+#include "gstspoutsnapshot.h"
+#include "gstspoutstandby.h"
+#include "gstspoutstats.h"
+#include "gstspouttexturecache.h"
+#include "gstspouttimestamp.h"
+#include "gstspouttrace.h"
+#include "gstspoutworkers.h"
+#include <gst/allocators/allocators.h>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+/* backend=spout needs GStreamer's D3D11 library and the Spout SDK. Without
+ * them, as on Linux, only the system memory backends are built */
+#ifdef HAVE_SPOUT
 #include <gst/d3d11/gstd3d11memory.h>
 #include <gst/d3d11/gstd3d11device.h>
 #include <gst/d3d11/gstd3d11utils.h>
 #include <gst/d3d11/gstd3d11format.h>
-#include <mutex>
-#include <string>
+#include <gst/d3d11/gstd3d11converter.h>
 
 // DirectX headers needed for DXGI format definitions
 #include <d3d11.h>
@@ -58,14 +135,28 @@
 
 // Include Spout SDK headers
 #include "SpoutDX.h"
+#endif
 
 GST_DEBUG_CATEGORY_STATIC (gst_spout_src_debug);
 #define GST_CAT_DEFAULT gst_spout_src_debug
 
-/* Memory:D3D11Memory caps feature indicates the buffer contains D3D11 GPU memory */
+/* Memory:D3D11Memory caps feature indicates the buffer contains D3D11 GPU
+ * memory, system memory output is read back from the GPU. memory:FdMemory
+ * is for system memory backends sharing frames by fd */
+#ifdef HAVE_SPOUT
 static GstStaticCaps pad_template_caps =
   GST_STATIC_CAPS (GST_VIDEO_CAPS_MAKE_WITH_FEATURES
-    (GST_CAPS_FEATURE_MEMORY_D3D11_MEMORY, GST_SPOUT_SRC_FORMATS));
+    (GST_CAPS_FEATURE_MEMORY_D3D11_MEMORY, GST_SPOUT_SRC_D3D11_FORMATS) "; "
+    GST_VIDEO_CAPS_MAKE (GST_SPOUT_SRC_SYSMEM_FORMATS) "; "
+    GST_VIDEO_CAPS_MAKE_WITH_FEATURES
+    (GST_SPOUT_SRC_CAPS_FEATURE_MEMORY_FD, GST_SPOUT_SRC_FORMATS));
+#else
+/* Without D3D11 frames go out in the format the backend received them in */
+static GstStaticCaps pad_template_caps =
+  GST_STATIC_CAPS (GST_VIDEO_CAPS_MAKE (GST_SPOUT_SRC_FORMATS) "; "
+    GST_VIDEO_CAPS_MAKE_WITH_FEATURES
+    (GST_SPOUT_SRC_CAPS_FEATURE_MEMORY_FD, GST_SPOUT_SRC_FORMATS));
+#endif
 
 enum
 {
@@ -75,40 +166,269 @@ enum
   PROP_ADAPTER,
   PROP_PROCESSING_DEADLINE,
   PROP_FORCE_RECONNECT,
+  PROP_CAPTURE_THREAD,
+  PROP_DUPLICATE_POLICY,
+  PROP_ZERO_COPY,
+  PROP_RECONNECT_GIVE_UP,
+  PROP_RECONNECT_MAX_ATTEMPTS,
+  PROP_RECONNECT_TIMEOUT,
+  PROP_STANDBY_MODE,
+  PROP_STANDBY_COLOR,
+  PROP_READBACK_LATENCY,
+  PROP_N_THREADS,
+  PROP_THREAD_AFFINITY,
+  PROP_CROP_LEFT,
+  PROP_CROP_RIGHT,
+  PROP_CROP_TOP,
+  PROP_CROP_BOTTOM,
+  PROP_OUTPUT_WIDTH,
+  PROP_OUTPUT_HEIGHT,
+  PROP_POOL_BUDGET,
+  PROP_POOL_SIZE,
+  PROP_TIMESTAMP_MODE,
+  PROP_CFR,
+  PROP_STATS,
+  PROP_STATS_INTERVAL,
+  PROP_BACKEND,
+  PROP_HUGE_PAGES,
+  PROP_NUMA_NODE,
+  PROP_RECORD_LOCATION,
+  PROP_RECORD_PAYLOADS,
+  PROP_REPLAY_LOCATION,
+  PROP_REPLAY_TIMING,
 };
 
 #define DEFAULT_SENDER_NAME        ""
 #define DEFAULT_WAIT_TIMEOUT       16    /* ms */
 #define DEFAULT_ADAPTER           -1     /* Default adapter */
 #define DEFAULT_PROCESSING_DEADLINE (20 * GST_MSECOND)
+#define LATENCY_MARGIN            (2 * GST_MSECOND)   /* on top of the measured p99 */
+#define LATENCY_MIN_DRIFT         (2 * GST_MSECOND)   /* before announcing a new latency */
 #define DEFAULT_FORCE_RECONNECT   FALSE
 #define DEFAULT_FRAMERATE         30.0   /* Default framerate if sender doesn't provide one */
+#define DEFAULT_CAPTURE_THREAD    FALSE
+#define NEW_FRAME_POLL_INTERVAL   1      /* ms between polls while the sender has no new frame */
+#define CADENCE_POLL_BUDGET       8      /* polls around each expected frame */
+#define SENDER_PARK_TIMEOUT       1000   /* ms parked without a sender, connecting wakes us earlier */
+#define DEFAULT_DUPLICATE_POLICY  GST_SPOUT_DUPLICATE_POLICY_REPEAT
+#define FINGERPRINT_GRID          16     /* sampled pixels per row and column */
+#define DEFAULT_ZERO_COPY         FALSE
+#define DEFAULT_RECONNECT_GIVE_UP GST_SPOUT_GIVE_UP_NEVER
+#define DEFAULT_RECONNECT_MAX_ATTEMPTS 5
+#define DEFAULT_RECONNECT_TIMEOUT 30000  /* ms */
+#define RECONNECT_BACKOFF_MIN     50     /* ms before the first retry */
+#define RECONNECT_BACKOFF_MAX     5000   /* ms between retries at most */
+#define DEFAULT_STANDBY_MODE      GST_SPOUT_STANDBY_BLACK
+#define DEFAULT_STANDBY_COLOR     0xff000000     /* ARGB */
+#define DEFAULT_READBACK_LATENCY  2      /* frames */
+#define MAX_READBACK_LATENCY      8
+#define DEFAULT_N_THREADS         0      /* one per CPU */
+#define DEFAULT_THREAD_AFFINITY   0      /* any CPU */
+#define MIN_BAND_ROWS             64     /* smaller bands aren't worth a handoff */
+#define DEFAULT_POOL_BUDGET       0      /* bytes, 0 for MAX_POOL_BUFFERS */
+#define MIN_POOL_BUFFERS          2
+#define MAX_POOL_BUFFERS          32
+#define DEFAULT_TIMESTAMP_MODE    GST_SPOUT_TIMESTAMP_ARRIVAL
+#define DEFAULT_CFR               FALSE
+#define DEFAULT_STATS_INTERVAL    0      /* ms, 0 for no stats messages */
+#define TRACE_ENV                 "GST_SPOUT_TRACE"
+#ifdef HAVE_SPOUT
+#define DEFAULT_BACKEND           GST_SPOUT_BACKEND_SPOUT
+#else
+#define DEFAULT_BACKEND           GST_SPOUT_BACKEND_SHM
+#endif
+#define DEFAULT_HUGE_PAGES        FALSE
+#define DEFAULT_NUMA_NODE         -1     /* wherever the system puts it */
+#define DEFAULT_RECORD_PAYLOADS   TRUE
+#define DEFAULT_REPLAY_TIMING     GST_SPOUT_REPLAY_TIMING_ORIGINAL
+
+/* Receiving found the sender holding the shared texture's keyed mutex. It
+ * is still there, just busy: no new frame this time */
+#define GST_SPOUT_SRC_FLOW_BUSY   GST_FLOW_CUSTOM_SUCCESS
+
+#ifdef HAVE_SPOUT
+class GstSpoutD3D11FrameSource;
+
+/* Opens sender textures on our device for GstSpoutTextureCache */
+struct GstSpoutD3D11TextureBackend
+{
+  using Handle = HANDLE;
+  using Texture = ID3D11Texture2D *;
+  
+  ID3D11Device *device = nullptr;
+  
+  Texture open (Handle handle)
+  {
+    ID3D11Texture2D *texture = nullptr;
+    
+    if (!device || FAILED (device->OpenSharedResource (handle,
+                IID_PPV_ARGS (&texture))))
+      return nullptr;
+    
+    return texture;
+  }
+  
+  void ref (Texture texture) { texture->AddRef (); }
+  void unref (Texture texture) { texture->Release (); }
+};
+#endif
+
+/* Connection state as seen by the streaming thread. Immutable once
+ * published, writers build a new one from the private fields */
+struct GstSpoutConnectionState
+{
+  gboolean connected = FALSE;
+  std::string sender_name;
+  GstVideoInfo video_info;
+  double fps = DEFAULT_FRAMERATE;
+  GstCaps *caps = nullptr;
+  guint64 caps_generation = 0;
+  GstSpoutGeometry geometry;      /* caps are at the geometry's output size */
+  gboolean reshape = FALSE;       /* crop-* or output-* are set */
+  
+  GstSpoutConnectionState () { gst_video_info_init (&video_info); }
+  ~GstSpoutConnectionState () { gst_clear_caps (&caps); }
+  
+  GstSpoutConnectionState (const GstSpoutConnectionState &) = delete;
+  GstSpoutConnectionState & operator= (const GstSpoutConnectionState &) = delete;
+};
+
+/* The connection state create() loaded for the frame at hand. It is handed
+ * down the per-frame path and refreshed where a receive or a wait may have
+ * published a newer one, see GstSpoutSnapshot */
+typedef GstSpoutSnapshot<GstSpoutConnectionState>::View GstSpoutStateView;
+
+#ifdef HAVE_SPOUT
+/* Renders standby frames into textures of our own for GstSpoutStandby */
+struct GstSpoutD3D11StandbyBackend
+{
+  using Frame = GstBuffer *;
+  
+  GstD3D11Device *device = nullptr;
+  
+  Frame render (const GstSpoutSenderFormat & format, GstSpoutStandbyMode mode,
+      uint32_t argb);
+  Frame copy (Frame frame, const GstSpoutSenderFormat & format);
+  void ref (Frame frame) { gst_buffer_ref (frame); }
+  void unref (Frame frame) { gst_buffer_unref (frame); }
+};
+
+/* Copies frames into staging textures for GstSpoutReadbackRing */
+struct GstSpoutD3D11ReadbackEngine
+{
+  using Source = GstBuffer *;
+  
+  GstD3D11Device *device = nullptr;
+  std::vector<ID3D11Texture2D *> staging;
+  
+  bool copy (unsigned int slot, GstBuffer * const & source);
+  GstSpoutMapResult map (unsigned int slot, bool wait, GstSpoutMapping & mapping);
+  void unmap (unsigned int slot);
+  void clear ();
+};
+#endif
+
+/* What a frame in the readback ring carries over to its output buffer */
+struct GstSpoutReadbackTag
+{
+  GstClockTime pts = GST_CLOCK_TIME_NONE;
+  GstClockTime duration = GST_CLOCK_TIME_NONE;
+  guint64 offset = GST_BUFFER_OFFSET_NONE;
+  GstVideoFormat format = GST_VIDEO_FORMAT_UNKNOWN;
+  guint width = 0;
+  guint height = 0;
+};
+
+/* Sizes our own buffer pool, shared with the buffers downstream holds so
+ * they can report back after the element is gone */
+struct GstSpoutPoolTracker
+{
+  std::mutex lock;
+  GstSpoutPoolSizer sizer;
+};
 
 /* Private data structure */
 struct GstSpoutSrcPrivate
 {
+#ifdef HAVE_SPOUT
   /* GStreamer D3D11 Device */
   GstD3D11Device *device = nullptr;
   
   /* Spout SDK object */
   spoutDX *spout = nullptr;
+#endif
+  
+  /* Set instead of device and spout for backend != spout, between start()
+   * and stop(). Connected and woken up under lock, received from by the
+   * streaming thread */
+  std::unique_ptr<GstSpoutFrameReceiver> receiver;
+  
+  /* Format of the receiver's frames we last set up for, streaming thread
+   * and connecting under lock */
+  GstSpoutFrameFormat received_format;
+  
+  /* Open between start() and stop() with record-location set */
+  GstSpoutRecorder recorder;
+  
+  /* Set while the receiver shares frames by fd. fd_output is set by
+   * negotiation when downstream picked memory:FdMemory */
+  GstAllocator *fd_allocator = nullptr;
+  gboolean fd_output = FALSE;
   
   /* Texture information */
-  ID3D11Texture2D *shared_texture = nullptr;
-  ID3D11ShaderResourceView *texture_srv = nullptr;
+#ifdef HAVE_SPOUT
+  GstSpoutTextureCache<GstSpoutD3D11TextureBackend> shared_textures;
   HANDLE shared_handle = nullptr;
-  DXGI_FORMAT format = DXGI_FORMAT_UNKNOWN;
+#endif
+  uint32_t format = GST_SPOUT_DXGI_FORMAT_UNKNOWN;   /* DXGI_FORMAT */
   GstVideoInfo video_info;
   
-  /* Caps negotiation */
+  /* Caps negotiation, video_info and caps follow caps_state.current().
+   * video_info is the sender's, caps are cropped and scaled by geometry */
   GstCaps *caps = nullptr;
+  GstSpoutCapsState caps_state;
+  GstSpoutGeometry geometry;
   
   /* Buffer pool for texture reuse */
   GstBufferPool *pool = nullptr;
   
+  /* Set while pool is our own and resized by how long downstream holds
+   * buffers. Written by the streaming thread, read under lock elsewhere */
+  std::shared_ptr<GstSpoutPoolTracker> pool_tracker;
+  std::atomic<guint> pool_size { 0 };
+  
+  /* Converts the sender's texture into pool buffers when downstream picked
+   * NV12 or P010, guarded by lock. convert_info is the format assumed for
+   * the sender */
+#ifdef HAVE_SPOUT
+  GstD3D11Converter *converter = nullptr;
+#endif
+  GstVideoInfo convert_info;
+  std::atomic<bool> converting { false };
+  
+  /* System memory output, negotiation and streaming thread only. Frames
+   * are received into pool and read back into output_pool buffers */
+  gboolean sysmem_output = FALSE;
+  GstBufferPool *output_pool = nullptr;
+  GstVideoInfo output_info;
+#ifdef HAVE_SPOUT
+  GstSpoutReadbackRing<GstSpoutD3D11ReadbackEngine, GstSpoutReadbackTag> readback;
+#endif
+  guint readback_threads = 1;     /* including the streaming thread */
+  
   /* Thread safety */
   std::mutex lock;
-  gboolean flushing = FALSE;
+  std::condition_variable cond;   /* signalled with lock held, e.g. by unlock() */
+  std::atomic<bool> flushing { false };   /* written with lock held */
+  
+  /* Sender monitor subscription, bumps senders_generation on changes */
+  guint64 monitor_subscription = 0;
+  guint64 senders_generation = 0;
+  
+  /* Connection state published for the per-frame path, which reads it
+   * without taking lock */
+  GstSpoutSnapshot<GstSpoutConnectionState> state;
+  guint64 pushed_caps_generation = 0;     /* streaming thread only */
   
   /* Properties */
   std::string sender_name = DEFAULT_SENDER_NAME;
@@ -116,18 +436,80 @@ struct GstSpoutSrcPrivate
   gint adapter = DEFAULT_ADAPTER;
   GstClockTime processing_deadline = DEFAULT_PROCESSING_DEADLINE;
   gboolean force_reconnect = DEFAULT_FORCE_RECONNECT;
+  gboolean capture_thread = DEFAULT_CAPTURE_THREAD;
+  std::atomic<GstSpoutDuplicatePolicy> duplicate_policy { DEFAULT_DUPLICATE_POLICY };
+  gboolean zero_copy = DEFAULT_ZERO_COPY;
+  GstSpoutGiveUpPolicy reconnect_give_up = DEFAULT_RECONNECT_GIVE_UP;
+  guint reconnect_max_attempts = DEFAULT_RECONNECT_MAX_ATTEMPTS;
+  guint reconnect_timeout = DEFAULT_RECONNECT_TIMEOUT;
+  std::atomic<GstSpoutStandbyMode> standby_mode { DEFAULT_STANDBY_MODE };
+  std::atomic<guint> standby_color { DEFAULT_STANDBY_COLOR };
+  guint readback_latency = DEFAULT_READBACK_LATENCY;
+  guint n_threads = DEFAULT_N_THREADS;
+  guint64 thread_affinity = DEFAULT_THREAD_AFFINITY;
+  GstSpoutGeometryRequest geometry_request;
+  guint64 pool_budget = DEFAULT_POOL_BUDGET;
+  GstSpoutTimestampMode timestamp_mode = DEFAULT_TIMESTAMP_MODE;
+  gboolean cfr = DEFAULT_CFR;
+  std::atomic<guint> stats_interval { DEFAULT_STATS_INTERVAL };
+  GstSpoutBackend backend = DEFAULT_BACKEND;
+  gboolean huge_pages = DEFAULT_HUGE_PAGES;
+  gint numa_node = DEFAULT_NUMA_NODE;
+  std::string record_location;
+  gboolean record_payloads = DEFAULT_RECORD_PAYLOADS;
+  std::string replay_location;
+  GstSpoutReplayTiming replay_timing = DEFAULT_REPLAY_TIMING;
+  
+#ifdef HAVE_SPOUT
+  /* Frames pushed while no sender is connected, streaming thread only */
+  GstSpoutStandby<GstSpoutD3D11StandbyBackend> standby;
+  GstSpoutStandbyTimer standby_timer;
+#endif
+  
+  /* Duplicate frame detection */
+  GstSpoutDuplicateFilter dedup;
+#ifdef HAVE_SPOUT
+  ID3D11Texture2D *fingerprint_staging = nullptr;
+#endif
+  GstClockTime gap_end = GST_CLOCK_TIME_NONE;
+  
+  /* Background receive, used when capture-thread is enabled */
+  GstSpoutCaptureThread<GstBuffer *> capture;
+#ifdef HAVE_SPOUT
+  GstSpoutD3D11FrameSource *capture_source = nullptr;
+#endif
+  guint64 capture_dropped = 0;
   
   /* Connection state */
   gboolean connected = FALSE;
   gboolean first_frame = TRUE;
-  guint reconnect_attempts = 0;
   std::string connected_sender_name; // Track the name of the connected sender
   
+  /* Reconnects happen on their own thread, guarded by lock */
+  std::thread reconnect_thread;
+  gboolean reconnect_stopping = FALSE;
+  GstSpoutBackoff backoff;
+  std::atomic<bool> reconnect_given_up { false };
+  
   /* Timing */
   GstClockTime prev_pts = GST_CLOCK_TIME_NONE;
   guint64 frame_number = 0;
+  GstSpoutTimestamper timestamper;      /* streaming thread only */
+  
+  /* cfr=true, streaming thread only except for the clock id, which unlock()
+   * unschedules under lock */
+  GstSpoutCfrPacer pacer;
+  GstBuffer *cfr_last = nullptr;        /* repeated while no new frame comes */
+  GstClockID cfr_clock_id = nullptr;
+  guint64 cfr_lost = 0;                 /* last reported to QoS */
   double current_fps = DEFAULT_FRAMERATE;
-  GstClockTime last_receive_time = GST_CLOCK_TIME_NONE;
+  std::atomic<GstClockTime> last_receive_time { GST_CLOCK_TIME_NONE };
+  GstSpoutCadencePredictor cadence;     /* receiving thread only */
+  GstSpoutLatencyEstimator latency;     /* recorded by the streaming thread */
+  
+  /* Always on, readable from any thread */
+  GstSpoutStats stats;
+  GstClockTime stats_posted = GST_CLOCK_TIME_NONE;  /* streaming thread only */
 };
 
 struct _GstSpoutSrc
@@ -144,7 +526,9 @@ static void gst_spout_src_get_property (GObject * object,
 static void gst_spout_src_finalize (GObject * object);
 
 static GstClock *gst_spout_src_provide_clock (GstElement * elem);
+#ifdef HAVE_SPOUT
 static void gst_spout_src_set_context (GstElement * elem, GstContext * context);
+#endif
 
 static gboolean gst_spout_src_start (GstBaseSrc * src);
 static gboolean gst_spout_src_stop (GstBaseSrc * src);
@@ -160,8 +544,277 @@ static GstFlowReturn gst_spout_src_create (GstBaseSrc * src, guint64 offset,
 /* Helper functions */
 static gboolean gst_spout_src_connect (GstSpoutSrc * self);
 static void gst_spout_src_disconnect (GstSpoutSrc * self);
-static GstVideoFormat gst_spout_src_dxgi_format_to_gst (DXGI_FORMAT dxgi_format);
-static GstFlowReturn gst_spout_src_copy_texture_to_buffer (GstSpoutSrc * self, GstBuffer * buffer);
+static GstStructure *gst_spout_src_stats (GstSpoutSrc * self);
+static void gst_spout_src_name_trace_thread (GstSpoutSrc * self,
+    const gchar * role);
+static gboolean gst_spout_src_dump_trace (GstSpoutSrc * self,
+    const gchar * filename);
+static GstFlowReturn gst_spout_src_create_received (GstSpoutSrc * self,
+    GstSpoutStateView & state, GstBuffer ** buf);
+static void gst_spout_src_stamp_frame (GstSpoutSrc * self,
+    const GstSpoutStateView & state, GstBuffer * buffer);
+static gboolean gst_spout_src_sender_available (GstSpoutSrc * self);
+static gboolean gst_spout_src_wait (GstSpoutSrc * self,
+    const GstSpoutStateView & state, guint timeout_ms);
+static void gst_spout_src_start_reconnect (GstSpoutSrc * self);
+static void gst_spout_src_stop_reconnect (GstSpoutSrc * self);
+
+/* D3D11 and spoutDX */
+#ifdef HAVE_SPOUT
+static gboolean gst_spout_src_decide_sysmem_allocation (GstSpoutSrc * self,
+    GstQuery * query, GstCaps * caps, GstVideoInfo * info);
+static GstCaps *gst_spout_src_sysmem_caps (GstCaps * caps);
+static GstCaps *gst_spout_src_d3d11_caps (GstCaps * caps);
+static GstFlowReturn gst_spout_src_copy_texture_to_buffer (GstSpoutSrc * self,
+    GstSpoutStateView & state, GstBuffer * buffer);
+static GstFlowReturn gst_spout_src_wrap_shared_texture (GstSpoutSrc * self,
+    const GstSpoutStateView & state, GstBuffer ** buffer);
+static GstFlowReturn gst_spout_src_convert_shared_texture (GstSpoutSrc * self,
+    const GstSpoutStateView & state, GstBuffer * buffer,
+    GstD3D11Converter * converter);
+static GstFlowReturn gst_spout_src_crop_shared_texture (GstSpoutSrc * self,
+    GstSpoutStateView & state, GstBuffer * buffer);
+static gboolean gst_spout_src_use_zero_copy (GstSpoutSrc * self,
+    const GstSpoutStateView & state);
+static gboolean gst_spout_src_setup_converter (GstSpoutSrc * self,
+    const GstVideoInfo * info);
+static void gst_spout_src_setup_pool_sizer (GstSpoutSrc * self,
+    const GstVideoInfo * info, guint size, guint * min, guint * max);
+static void gst_spout_src_track_buffer (
+    const std::shared_ptr<GstSpoutPoolTracker> & tracker, GstBuffer * buffer,
+    gboolean waited);
+static void gst_spout_src_start_capture (GstSpoutSrc * self);
+static void gst_spout_src_stop_capture (GstSpoutSrc * self);
+static GstFlowReturn gst_spout_src_create_standby (GstSpoutSrc * self,
+    const GstSpoutStateView & state, GstBuffer ** buf);
+static GstFlowReturn gst_spout_src_create_frame (GstSpoutSrc * self,
+    GstSpoutStateView & state, GstBuffer ** buf);
+static GstFlowReturn gst_spout_src_create_readback (GstSpoutSrc * self,
+    GstSpoutStateView & state, GstBuffer ** buf);
+static GstFlowReturn gst_spout_src_create_cfr (GstSpoutSrc * self,
+    GstSpoutStateView & state, GstBuffer ** buf);
+static gboolean gst_spout_src_decide_texture_allocation (GstSpoutSrc * self,
+    GstQuery * query, GstCaps * caps);
+static void gst_spout_src_senders_changed (GstSpoutSrc * self,
+    const GstSpoutSenderDiff & diff);
+#endif
+
+#define GST_TYPE_SPOUT_SRC_DUPLICATE_POLICY (gst_spout_src_duplicate_policy_get_type ())
+static GType
+gst_spout_src_duplicate_policy_get_type (void)
+{
+  static gsize type = 0;
+  static const GEnumValue values[] = {
+    {GST_SPOUT_DUPLICATE_POLICY_REPEAT,
+        "Push repeated frames like new ones", "repeat"},
+    {GST_SPOUT_DUPLICATE_POLICY_GAP,
+        "Push a GAP event instead of a repeated frame", "gap"},
+    {GST_SPOUT_DUPLICATE_POLICY_WAIT,
+        "Hold back output until the sender produces a new frame", "wait"},
+    {0, NULL, NULL}
+  };
+
+  if (g_once_init_enter (&type)) {
+    GType tmp = g_enum_register_static ("GstSpoutSrcDuplicatePolicy", values);
+    g_once_init_leave (&type, tmp);
+  }
+
+  return (GType) type;
+}
+
+#define GST_TYPE_SPOUT_SRC_STANDBY_MODE (gst_spout_src_standby_mode_get_type ())
+static GType
+gst_spout_src_standby_mode_get_type (void)
+{
+  static gsize type = 0;
+  static const GEnumValue values[] = {
+    {GST_SPOUT_STANDBY_BLACK, "Black frames", "black"},
+    {GST_SPOUT_STANDBY_LAST_FRAME,
+        "Hold the last received frame, black if there is none", "last-frame"},
+    {GST_SPOUT_STANDBY_COLOR, "Frames filled with standby-color", "color"},
+    {GST_SPOUT_STANDBY_PATTERN, "Colour bars", "pattern"},
+    {0, NULL, NULL}
+  };
+
+  if (g_once_init_enter (&type)) {
+    GType tmp = g_enum_register_static ("GstSpoutSrcStandbyMode", values);
+    g_once_init_leave (&type, tmp);
+  }
+
+  return (GType) type;
+}
+
+#define GST_TYPE_SPOUT_SRC_TIMESTAMP_MODE (gst_spout_src_timestamp_mode_get_type ())
+static GType
+gst_spout_src_timestamp_mode_get_type (void)
+{
+  static gsize type = 0;
+  static const GEnumValue values[] = {
+    {GST_SPOUT_TIMESTAMP_ARRIVAL,
+        "Time the frame was received", "arrival"},
+    {GST_SPOUT_TIMESTAMP_SMOOTHED,
+        "Receive times fitted to the sender's cadence", "smoothed"},
+    {GST_SPOUT_TIMESTAMP_SENDER_FRAME,
+        "Sender frame number at the frame rate, smoothed if the sender "
+        "doesn't count frames", "sender-frame"},
+    {0, NULL, NULL}
+  };
+
+  if (g_once_init_enter (&type)) {
+    GType tmp = g_enum_register_static ("GstSpoutSrcTimestampMode", values);
+    g_once_init_leave (&type, tmp);
+  }
+
+  return (GType) type;
+}
+
+#define GST_TYPE_SPOUT_SRC_GIVE_UP_POLICY (gst_spout_src_give_up_policy_get_type ())
+static GType
+gst_spout_src_give_up_policy_get_type (void)
+{
+  static gsize type = 0;
+  static const GEnumValue values[] = {
+    {GST_SPOUT_GIVE_UP_NEVER,
+        "Keep trying to reconnect forever", "never"},
+    {GST_SPOUT_GIVE_UP_ATTEMPTS,
+        "Give up after reconnect-max-attempts failed attempts", "attempts"},
+    {GST_SPOUT_GIVE_UP_DURATION,
+        "Give up once disconnected for reconnect-timeout", "duration"},
+    {0, NULL, NULL}
+  };
+
+  if (g_once_init_enter (&type)) {
+    GType tmp = g_enum_register_static ("GstSpoutSrcGiveUpPolicy", values);
+    g_once_init_leave (&type, tmp);
+  }
+
+  return (GType) type;
+}
+
+#define GST_TYPE_SPOUT_SRC_BACKEND (gst_spout_src_backend_get_type ())
+static GType
+gst_spout_src_backend_get_type (void)
+{
+  static gsize type = 0;
+  static const GEnumValue values[] = {
+    {GST_SPOUT_BACKEND_SPOUT, "Spout senders through spoutDX", "spout"},
+    {GST_SPOUT_BACKEND_SHM,
+        "Frame ring of a GstSpoutShmSender in shared memory", "shm"},
+    {GST_SPOUT_BACKEND_REPLAY,
+        "Recording made with record-location", "replay"},
+    {0, NULL, NULL}
+  };
+
+  if (g_once_init_enter (&type)) {
+    GType tmp = g_enum_register_static ("GstSpoutSrcBackend", values);
+    g_once_init_leave (&type, tmp);
+  }
+
+  return (GType) type;
+}
+
+#define GST_TYPE_SPOUT_SRC_REPLAY_TIMING (gst_spout_src_replay_timing_get_type ())
+static GType
+gst_spout_src_replay_timing_get_type (void)
+{
+  static gsize type = 0;
+  static const GEnumValue values[] = {
+    {GST_SPOUT_REPLAY_TIMING_ORIGINAL,
+        "Frames as far apart as they were recorded", "original"},
+    {GST_SPOUT_REPLAY_TIMING_FAST,
+        "Every frame, as fast as downstream takes them", "fast"},
+    {0, NULL, NULL}
+  };
+
+  if (g_once_init_enter (&type)) {
+    GType tmp = g_enum_register_static ("GstSpoutSrcReplayTiming", values);
+    g_once_init_leave (&type, tmp);
+  }
+
+  return (GType) type;
+}
+
+/* Worker threads shared by every spoutsrc in the process */
+static GstSpoutWorkerPool &
+gst_spout_src_worker_pool (void)
+{
+  /* Plugins are never unloaded, leak it rather than joining threads
+   * during static destruction at exit */
+  static GstSpoutWorkerPool *pool = new GstSpoutWorkerPool ();
+  
+  return *pool;
+}
+
+/* Marks buffers of our own pool with the time they were pushed. The pool
+ * drops the meta when the buffer comes back, which records the hold time */
+typedef struct
+{
+  GstMeta meta;
+  
+  std::shared_ptr<GstSpoutPoolTracker> *tracker;
+  GstClockTime pushed;
+} GstSpoutHoldMeta;
+
+static GType
+gst_spout_hold_meta_api_get_type (void)
+{
+  static gsize type = 0;
+  static const gchar *tags[] = { NULL };
+  
+  if (g_once_init_enter (&type)) {
+    GType tmp = gst_meta_api_type_register ("GstSpoutHoldMetaAPI", tags);
+    g_once_init_leave (&type, tmp);
+  }
+  
+  return (GType) type;
+}
+
+static gboolean
+gst_spout_hold_meta_init (GstMeta * meta, gpointer params, GstBuffer * buffer)
+{
+  GstSpoutHoldMeta *hold = (GstSpoutHoldMeta *) meta;
+  
+  hold->tracker = nullptr;
+  hold->pushed = GST_CLOCK_TIME_NONE;
+  
+  return TRUE;
+}
+
+static void
+gst_spout_hold_meta_free (GstMeta * meta, GstBuffer * buffer)
+{
+  GstSpoutHoldMeta *hold = (GstSpoutHoldMeta *) meta;
+  
+  if (!hold->tracker)
+    return;
+  
+  /* Buffers dropped as duplicates never reached downstream */
+  if (GST_CLOCK_TIME_IS_VALID (hold->pushed)) {
+    GstClockTime now = gst_util_get_timestamp ();
+    GstSpoutPoolTracker *tracker = hold->tracker->get ();
+    std::lock_guard<std::mutex> lock(tracker->lock);
+    
+    tracker->sizer.record_hold (now > hold->pushed ? now - hold->pushed : 0);
+  }
+  
+  delete hold->tracker;
+  hold->tracker = nullptr;
+}
+
+static const GstMetaInfo *
+gst_spout_hold_meta_get_info (void)
+{
+  static const GstMetaInfo *info = NULL;
+  
+  if (g_once_init_enter ((GstMetaInfo **) & info)) {
+    const GstMetaInfo *tmp = gst_meta_register (gst_spout_hold_meta_api_get_type (),
+        "GstSpoutHoldMeta", sizeof (GstSpoutHoldMeta), gst_spout_hold_meta_init,
+        gst_spout_hold_meta_free, NULL);
+    g_once_init_leave ((GstMetaInfo **) & info, (GstMetaInfo *) tmp);
+  }
+  
+  return info;
+}
 
 #define gst_spout_src_parent_class parent_class
 G_DEFINE_TYPE (GstSpoutSrc, gst_spout_src, GST_TYPE_BASE_SRC);
@@ -178,6 +831,18 @@ gst_spout_src_class_init (GstSpoutSrcClass * klass)
   gobject_class->get_property = gst_spout_src_get_property;
   gobject_class->finalize = gst_spout_src_finalize;
 
+  /* GST_SPOUT_TRACE=<file> traces every element's stages and writes them
+   * to <file> whenever one of them stops */
+  if (g_getenv (TRACE_ENV))
+    gst_spout_tracer_get ().set_enabled (true);
+
+  /* Write the stage traces of every spoutsrc in the process as Chrome
+   * trace JSON, returns FALSE if the file couldn't be written */
+  g_signal_new_class_handler ("dump-trace", G_TYPE_FROM_CLASS (klass),
+      (GSignalFlags) (G_SIGNAL_RUN_LAST | G_SIGNAL_ACTION),
+      G_CALLBACK (gst_spout_src_dump_trace), NULL, NULL, NULL,
+      G_TYPE_BOOLEAN, 1, G_TYPE_STRING);
+
   /* Install properties */
   g_object_class_install_property (gobject_class, PROP_SENDER_NAME,
       g_param_spec_string ("sender-name", "Sender Name",
@@ -200,7 +865,8 @@ gst_spout_src_class_init (GstSpoutSrcClass * klass)
           
   g_object_class_install_property (gobject_class, PROP_PROCESSING_DEADLINE,
       g_param_spec_uint64 ("processing-deadline", "Processing deadline",
-          "Maximum processing time for a buffer in nanoseconds", 
+          "Latency to report in nanoseconds until enough frames went out to "
+          "measure it", 
           0, G_MAXUINT64, DEFAULT_PROCESSING_DEADLINE,
           (GParamFlags) (G_PARAM_READWRITE | 
           G_PARAM_STATIC_STRINGS | GST_PARAM_MUTABLE_PLAYING)));
@@ -211,13 +877,247 @@ gst_spout_src_class_init (GstSpoutSrcClass * klass)
           DEFAULT_FORCE_RECONNECT,
           (GParamFlags) (G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS)));
 
+  g_object_class_install_property (gobject_class, PROP_CAPTURE_THREAD,
+      g_param_spec_boolean ("capture-thread", "Capture Thread",
+          "Receive frames on a background thread and always output the newest one, "
+          "dropping frames downstream did not consume in time",
+          DEFAULT_CAPTURE_THREAD,
+          (GParamFlags) (G_PARAM_READWRITE | 
+          G_PARAM_STATIC_STRINGS | GST_PARAM_MUTABLE_READY)));
+
+  g_object_class_install_property (gobject_class, PROP_DUPLICATE_POLICY,
+      g_param_spec_enum ("duplicate-policy", "Duplicate Policy",
+          "What to output when the sender has not produced a new frame. Uses "
+          "the sender frame count, or a sparse content fingerprint for senders "
+          "without frame counting",
+          GST_TYPE_SPOUT_SRC_DUPLICATE_POLICY, DEFAULT_DUPLICATE_POLICY,
+          (GParamFlags) (G_PARAM_READWRITE | 
+          G_PARAM_STATIC_STRINGS | GST_PARAM_MUTABLE_PLAYING)));
+
+  g_object_class_install_property (gobject_class, PROP_ZERO_COPY,
+      g_param_spec_boolean ("zero-copy", "Zero Copy",
+          "Output the sender's shared texture itself instead of a copy. Senders "
+          "sharing with a keyed mutex are locked out until downstream releases "
+          "the buffer, with others downstream may observe the next frame",
+          DEFAULT_ZERO_COPY,
+          (GParamFlags) (G_PARAM_READWRITE | 
+          G_PARAM_STATIC_STRINGS | GST_PARAM_MUTABLE_READY)));
+
+  g_object_class_install_property (gobject_class, PROP_RECONNECT_GIVE_UP,
+      g_param_spec_enum ("reconnect-give-up", "Reconnect Give Up",
+          "When to stop trying to reconnect to a lost sender and fail. Standby "
+          "frames are pushed until then",
+          GST_TYPE_SPOUT_SRC_GIVE_UP_POLICY, DEFAULT_RECONNECT_GIVE_UP,
+          (GParamFlags) (G_PARAM_READWRITE | 
+          G_PARAM_STATIC_STRINGS | GST_PARAM_MUTABLE_READY)));
+
+  g_object_class_install_property (gobject_class, PROP_RECONNECT_MAX_ATTEMPTS,
+      g_param_spec_uint ("reconnect-max-attempts", "Reconnect Max Attempts",
+          "Failed reconnect attempts before giving up with reconnect-give-up=attempts",
+          1, G_MAXUINT, DEFAULT_RECONNECT_MAX_ATTEMPTS,
+          (GParamFlags) (G_PARAM_READWRITE | 
+          G_PARAM_STATIC_STRINGS | GST_PARAM_MUTABLE_READY)));
+
+  g_object_class_install_property (gobject_class, PROP_RECONNECT_TIMEOUT,
+      g_param_spec_uint ("reconnect-timeout", "Reconnect Timeout",
+          "Milliseconds without a sender before giving up with reconnect-give-up=duration",
+          0, G_MAXUINT, DEFAULT_RECONNECT_TIMEOUT,
+          (GParamFlags) (G_PARAM_READWRITE | 
+          G_PARAM_STATIC_STRINGS | GST_PARAM_MUTABLE_READY)));
+
+  g_object_class_install_property (gobject_class, PROP_STANDBY_MODE,
+      g_param_spec_enum ("standby-mode", "Standby Mode",
+          "What to output while no sender is connected",
+          GST_TYPE_SPOUT_SRC_STANDBY_MODE, DEFAULT_STANDBY_MODE,
+          (GParamFlags) (G_PARAM_READWRITE | 
+          G_PARAM_STATIC_STRINGS | GST_PARAM_MUTABLE_PLAYING)));
+
+  g_object_class_install_property (gobject_class, PROP_READBACK_LATENCY,
+      g_param_spec_uint ("readback-latency", "Readback Latency",
+          "Frames a GPU copy gets to complete before it is read back for system "
+          "memory output. 0 waits for every copy, higher values trade latency "
+          "for not stalling on the GPU",
+          0, MAX_READBACK_LATENCY, DEFAULT_READBACK_LATENCY,
+          (GParamFlags) (G_PARAM_READWRITE | 
+          G_PARAM_STATIC_STRINGS | GST_PARAM_MUTABLE_READY)));
+
+  g_object_class_install_property (gobject_class, PROP_N_THREADS,
+      g_param_spec_uint ("n-threads", "Threads",
+          "Threads reading back and converting system memory output, 0 for "
+          "one per CPU. Worker threads are shared by all spoutsrc elements",
+          0, GST_SPOUT_MAX_WORKERS + 1, DEFAULT_N_THREADS,
+          (GParamFlags) (G_PARAM_READWRITE | 
+          G_PARAM_STATIC_STRINGS | GST_PARAM_MUTABLE_READY)));
+
+  g_object_class_install_property (gobject_class, PROP_THREAD_AFFINITY,
+      g_param_spec_uint64 ("thread-affinity", "Thread Affinity",
+          "Process-wide: mask of the CPUs the worker threads shared by every "
+          "spoutsrc in the process may run on, 0 for any. The element that "
+          "set it last wins",
+          0, G_MAXUINT64, DEFAULT_THREAD_AFFINITY,
+          (GParamFlags) (G_PARAM_READWRITE | 
+          G_PARAM_STATIC_STRINGS | GST_PARAM_MUTABLE_PLAYING)));
+
+  g_object_class_install_property (gobject_class, PROP_STANDBY_COLOR,
+      g_param_spec_uint ("standby-color", "Standby Color",
+          "Colour of standby frames with standby-mode=color, big-endian ARGB",
+          0, G_MAXUINT32, DEFAULT_STANDBY_COLOR,
+          (GParamFlags) (G_PARAM_READWRITE | 
+          G_PARAM_STATIC_STRINGS | GST_PARAM_MUTABLE_PLAYING)));
+
+  g_object_class_install_property (gobject_class, PROP_CROP_LEFT,
+      g_param_spec_uint ("crop-left", "Crop Left",
+          "Pixels to crop from the left of the sender's frames",
+          0, G_MAXINT, 0,
+          (GParamFlags) (G_PARAM_READWRITE | 
+          G_PARAM_STATIC_STRINGS | GST_PARAM_MUTABLE_READY)));
+
+  g_object_class_install_property (gobject_class, PROP_CROP_RIGHT,
+      g_param_spec_uint ("crop-right", "Crop Right",
+          "Pixels to crop from the right of the sender's frames",
+          0, G_MAXINT, 0,
+          (GParamFlags) (G_PARAM_READWRITE | 
+          G_PARAM_STATIC_STRINGS | GST_PARAM_MUTABLE_READY)));
+
+  g_object_class_install_property (gobject_class, PROP_CROP_TOP,
+      g_param_spec_uint ("crop-top", "Crop Top",
+          "Pixels to crop from the top of the sender's frames",
+          0, G_MAXINT, 0,
+          (GParamFlags) (G_PARAM_READWRITE | 
+          G_PARAM_STATIC_STRINGS | GST_PARAM_MUTABLE_READY)));
+
+  g_object_class_install_property (gobject_class, PROP_CROP_BOTTOM,
+      g_param_spec_uint ("crop-bottom", "Crop Bottom",
+          "Pixels to crop from the bottom of the sender's frames",
+          0, G_MAXINT, 0,
+          (GParamFlags) (G_PARAM_READWRITE | 
+          G_PARAM_STATIC_STRINGS | GST_PARAM_MUTABLE_READY)));
+
+  g_object_class_install_property (gobject_class, PROP_OUTPUT_WIDTH,
+      g_param_spec_uint ("output-width", "Output Width",
+          "Scale the cropped frames to this width on the GPU, 0 keeps the "
+          "cropped width or follows output-height's aspect ratio",
+          0, G_MAXINT, 0,
+          (GParamFlags) (G_PARAM_READWRITE | 
+          G_PARAM_STATIC_STRINGS | GST_PARAM_MUTABLE_READY)));
+
+  g_object_class_install_property (gobject_class, PROP_OUTPUT_HEIGHT,
+      g_param_spec_uint ("output-height", "Output Height",
+          "Scale the cropped frames to this height on the GPU, 0 keeps the "
+          "cropped height or follows output-width's aspect ratio",
+          0, G_MAXINT, 0,
+          (GParamFlags) (G_PARAM_READWRITE | 
+          G_PARAM_STATIC_STRINGS | GST_PARAM_MUTABLE_READY)));
+
+  g_object_class_install_property (gobject_class, PROP_TIMESTAMP_MODE,
+      g_param_spec_enum ("timestamp-mode", "Timestamp Mode",
+          "How frames are timestamped",
+          GST_TYPE_SPOUT_SRC_TIMESTAMP_MODE, DEFAULT_TIMESTAMP_MODE,
+          (GParamFlags) (G_PARAM_READWRITE | 
+          G_PARAM_STATIC_STRINGS | GST_PARAM_MUTABLE_READY)));
+
+  g_object_class_install_property (gobject_class, PROP_CFR,
+      g_param_spec_boolean ("cfr", "Constant Frame Rate",
+          "Push a frame on every tick of the negotiated frame rate, repeating "
+          "the last frame while the sender has no new one and dropping frames "
+          "it replaces between ticks. Posts QoS messages for dropped frames",
+          DEFAULT_CFR,
+          (GParamFlags) (G_PARAM_READWRITE | 
+          G_PARAM_STATIC_STRINGS | GST_PARAM_MUTABLE_READY)));
+
+  g_object_class_install_property (gobject_class, PROP_STATS,
+      g_param_spec_boxed ("stats", "Statistics",
+          "Frame counters and receive, copy and buffer acquire time "
+          "histograms since the element started",
+          GST_TYPE_STRUCTURE,
+          (GParamFlags) (G_PARAM_READABLE | G_PARAM_STATIC_STRINGS)));
+
+  g_object_class_install_property (gobject_class, PROP_STATS_INTERVAL,
+      g_param_spec_uint ("stats-interval", "Statistics Interval",
+          "Post the stats as an element message this often in milliseconds, "
+          "0 to never post them",
+          0, G_MAXUINT, DEFAULT_STATS_INTERVAL,
+          (GParamFlags) (G_PARAM_READWRITE | 
+          G_PARAM_STATIC_STRINGS | GST_PARAM_MUTABLE_PLAYING)));
+
+  g_object_class_install_property (gobject_class, PROP_BACKEND,
+      g_param_spec_enum ("backend", "Backend",
+          "Where frames come from. Backends other than spout output system "
+          "memory frames as the sender made them, without a GPU: no cfr, "
+          "standby frames, cropping or scaling",
+          GST_TYPE_SPOUT_SRC_BACKEND, DEFAULT_BACKEND,
+          (GParamFlags) (G_PARAM_READWRITE | 
+          G_PARAM_STATIC_STRINGS | GST_PARAM_MUTABLE_READY)));
+
+  g_object_class_install_property (gobject_class, PROP_POOL_BUDGET,
+      g_param_spec_uint64 ("pool-budget", "Pool Budget",
+          "Bytes of video memory our own buffer pool may grow to while adapting "
+          "to how long downstream holds buffers, 0 for up to 32 buffers",
+          0, G_MAXUINT64, DEFAULT_POOL_BUDGET,
+          (GParamFlags) (G_PARAM_READWRITE | 
+          G_PARAM_STATIC_STRINGS | GST_PARAM_MUTABLE_READY)));
+
+  g_object_class_install_property (gobject_class, PROP_HUGE_PAGES,
+      g_param_spec_boolean ("huge-pages", "Huge Pages",
+          "Put system memory buffers from our own pool on huge pages where "
+          "the system has them, ordinary pages otherwise",
+          DEFAULT_HUGE_PAGES,
+          (GParamFlags) (G_PARAM_READWRITE | 
+          G_PARAM_STATIC_STRINGS | GST_PARAM_MUTABLE_READY)));
+
+  g_object_class_install_property (gobject_class, PROP_NUMA_NODE,
+      g_param_spec_int ("numa-node", "NUMA Node",
+          "NUMA node to prefer for system memory buffers from our own pool, "
+          "-1 for any",
+          -1, GST_SPOUT_MAX_NUMA_NODES - 1, DEFAULT_NUMA_NODE,
+          (GParamFlags) (G_PARAM_READWRITE | 
+          G_PARAM_STATIC_STRINGS | GST_PARAM_MUTABLE_READY)));
+
+  g_object_class_install_property (gobject_class, PROP_RECORD_LOCATION,
+      g_param_spec_string ("record-location", "Record Location",
+          "File to record connects, format changes and frames with their "
+          "arrival times to, for backend=replay. Empty to not record",
+          NULL,
+          (GParamFlags) (G_PARAM_READWRITE | 
+          G_PARAM_STATIC_STRINGS | GST_PARAM_MUTABLE_READY)));
+
+  g_object_class_install_property (gobject_class, PROP_RECORD_PAYLOADS,
+      g_param_spec_boolean ("record-payloads", "Record Payloads",
+          "Record the content of frames received in system memory, otherwise "
+          "a fingerprint of it. D3D11 frames are always recorded without",
+          DEFAULT_RECORD_PAYLOADS,
+          (GParamFlags) (G_PARAM_READWRITE | 
+          G_PARAM_STATIC_STRINGS | GST_PARAM_MUTABLE_READY)));
+
+  g_object_class_install_property (gobject_class, PROP_REPLAY_LOCATION,
+      g_param_spec_string ("replay-location", "Replay Location",
+          "Recording backend=replay plays back",
+          NULL,
+          (GParamFlags) (G_PARAM_READWRITE | 
+          G_PARAM_STATIC_STRINGS | GST_PARAM_MUTABLE_READY)));
+
+  g_object_class_install_property (gobject_class, PROP_REPLAY_TIMING,
+      g_param_spec_enum ("replay-timing", "Replay Timing",
+          "When backend=replay delivers frames",
+          GST_TYPE_SPOUT_SRC_REPLAY_TIMING, DEFAULT_REPLAY_TIMING,
+          (GParamFlags) (G_PARAM_READWRITE | 
+          G_PARAM_STATIC_STRINGS | GST_PARAM_MUTABLE_READY)));
+
+  g_object_class_install_property (gobject_class, PROP_POOL_SIZE,
+      g_param_spec_uint ("pool-size", "Pool Size",
+          "Buffers in the pool frames are received into, 0 before negotiation",
+          0, G_MAXUINT, 0,
+          (GParamFlags) (G_PARAM_READABLE | G_PARAM_STATIC_STRINGS)));
+
   /* Set element metadata */
   gst_element_class_set_static_metadata (element_class,
       "Spout Source", "Source/Video",
-      "Receives DirectX textures from Spout senders",
+      "Receives video from Spout senders, shared memory rings or recordings "
+      "as D3D11 textures, system memory or fd memory",
       "jesus luque <jluque@mediapro.tv>");
 
-  /* Add pad template with memory:D3D11Memory caps */
+  /* Add pad template with memory:D3D11Memory, system memory and
+   * memory:FdMemory caps */
   caps = gst_static_caps_get (&pad_template_caps);
   gst_element_class_add_pad_template (element_class,
       gst_pad_template_new ("src", GST_PAD_SRC, GST_PAD_ALWAYS, caps));
@@ -225,7 +1125,9 @@ gst_spout_src_class_init (GstSpoutSrcClass * klass)
 
   /* Set element functions */
   element_class->provide_clock = GST_DEBUG_FUNCPTR (gst_spout_src_provide_clock);
+#ifdef HAVE_SPOUT
   element_class->set_context = GST_DEBUG_FUNCPTR (gst_spout_src_set_context);
+#endif
 
   /* Set source functions */
   basesrc_class->start = GST_DEBUG_FUNCPTR (gst_spout_src_start);
@@ -316,11 +1218,111 @@ gst_spout_src_set_property (GObject * object, guint prop_id,
       GST_DEBUG_OBJECT (self, "Set force reconnect to %s", 
                        priv->force_reconnect ? "TRUE" : "FALSE");
       break;
-    default:
-      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+    case PROP_CAPTURE_THREAD:
+      priv->capture_thread = g_value_get_boolean (value);
+      GST_DEBUG_OBJECT (self, "Set capture thread to %s",
+                       priv->capture_thread ? "TRUE" : "FALSE");
       break;
-  }
-}
+    case PROP_DUPLICATE_POLICY:
+      priv->duplicate_policy = (GstSpoutDuplicatePolicy) g_value_get_enum (value);
+      GST_DEBUG_OBJECT (self, "Set duplicate policy to %d", priv->duplicate_policy.load ());
+      break;
+    case PROP_ZERO_COPY:
+      priv->zero_copy = g_value_get_boolean (value);
+      GST_DEBUG_OBJECT (self, "Set zero copy to %s",
+                       priv->zero_copy ? "TRUE" : "FALSE");
+      break;
+    case PROP_RECONNECT_GIVE_UP:
+      priv->reconnect_give_up = (GstSpoutGiveUpPolicy) g_value_get_enum (value);
+      break;
+    case PROP_RECONNECT_MAX_ATTEMPTS:
+      priv->reconnect_max_attempts = g_value_get_uint (value);
+      break;
+    case PROP_RECONNECT_TIMEOUT:
+      priv->reconnect_timeout = g_value_get_uint (value);
+      break;
+    case PROP_STANDBY_MODE:
+      priv->standby_mode = (GstSpoutStandbyMode) g_value_get_enum (value);
+      break;
+    case PROP_STANDBY_COLOR:
+      priv->standby_color = g_value_get_uint (value);
+      break;
+    case PROP_READBACK_LATENCY:
+      priv->readback_latency = g_value_get_uint (value);
+      break;
+    case PROP_N_THREADS:
+      priv->n_threads = g_value_get_uint (value);
+      break;
+    case PROP_THREAD_AFFINITY: {
+      guint64 affinity = g_value_get_uint64 (value);
+      
+      priv->thread_affinity = affinity;
+      
+      /* The pool is shared by every spoutsrc, not ours to hold the lock for */
+      lock.unlock();
+      gst_spout_src_worker_pool ().set_affinity (affinity);
+      break;
+    }
+    case PROP_CROP_LEFT:
+      priv->geometry_request.crop_left = g_value_get_uint (value);
+      break;
+    case PROP_CROP_RIGHT:
+      priv->geometry_request.crop_right = g_value_get_uint (value);
+      break;
+    case PROP_CROP_TOP:
+      priv->geometry_request.crop_top = g_value_get_uint (value);
+      break;
+    case PROP_CROP_BOTTOM:
+      priv->geometry_request.crop_bottom = g_value_get_uint (value);
+      break;
+    case PROP_OUTPUT_WIDTH:
+      priv->geometry_request.width = g_value_get_uint (value);
+      break;
+    case PROP_OUTPUT_HEIGHT:
+      priv->geometry_request.height = g_value_get_uint (value);
+      break;
+    case PROP_POOL_BUDGET:
+      priv->pool_budget = g_value_get_uint64 (value);
+      break;
+    case PROP_TIMESTAMP_MODE:
+      priv->timestamp_mode = (GstSpoutTimestampMode) g_value_get_enum (value);
+      break;
+    case PROP_CFR:
+      priv->cfr = g_value_get_boolean (value);
+      break;
+    case PROP_STATS_INTERVAL:
+      priv->stats_interval = g_value_get_uint (value);
+      break;
+    case PROP_BACKEND:
+      priv->backend = (GstSpoutBackend) g_value_get_enum (value);
+      break;
+    case PROP_HUGE_PAGES:
+      priv->huge_pages = g_value_get_boolean (value);
+      break;
+    case PROP_NUMA_NODE:
+      priv->numa_node = g_value_get_int (value);
+      break;
+    case PROP_RECORD_LOCATION: {
+      const gchar *location = g_value_get_string (value);
+      priv->record_location = location ? location : "";
+      break;
+    }
+    case PROP_RECORD_PAYLOADS:
+      priv->record_payloads = g_value_get_boolean (value);
+      break;
+    case PROP_REPLAY_LOCATION: {
+      const gchar *location = g_value_get_string (value);
+      priv->replay_location = location ? location : "";
+      break;
+    }
+    case PROP_REPLAY_TIMING:
+      priv->replay_timing = (GstSpoutReplayTiming) g_value_get_enum (value);
+      break;
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+      break;
+  }
+}
 
 static void
 gst_spout_src_get_property (GObject * object, guint prop_id,
@@ -346,6 +1348,96 @@ gst_spout_src_get_property (GObject * object, guint prop_id,
     case PROP_FORCE_RECONNECT:
       g_value_set_boolean (value, priv->force_reconnect);
       break;
+    case PROP_CAPTURE_THREAD:
+      g_value_set_boolean (value, priv->capture_thread);
+      break;
+    case PROP_DUPLICATE_POLICY:
+      g_value_set_enum (value, priv->duplicate_policy.load ());
+      break;
+    case PROP_ZERO_COPY:
+      g_value_set_boolean (value, priv->zero_copy);
+      break;
+    case PROP_RECONNECT_GIVE_UP:
+      g_value_set_enum (value, priv->reconnect_give_up);
+      break;
+    case PROP_RECONNECT_MAX_ATTEMPTS:
+      g_value_set_uint (value, priv->reconnect_max_attempts);
+      break;
+    case PROP_RECONNECT_TIMEOUT:
+      g_value_set_uint (value, priv->reconnect_timeout);
+      break;
+    case PROP_STANDBY_MODE:
+      g_value_set_enum (value, priv->standby_mode.load ());
+      break;
+    case PROP_STANDBY_COLOR:
+      g_value_set_uint (value, priv->standby_color.load ());
+      break;
+    case PROP_READBACK_LATENCY:
+      g_value_set_uint (value, priv->readback_latency);
+      break;
+    case PROP_N_THREADS:
+      g_value_set_uint (value, priv->n_threads);
+      break;
+    case PROP_THREAD_AFFINITY:
+      g_value_set_uint64 (value, priv->thread_affinity);
+      break;
+    case PROP_CROP_LEFT:
+      g_value_set_uint (value, priv->geometry_request.crop_left);
+      break;
+    case PROP_CROP_RIGHT:
+      g_value_set_uint (value, priv->geometry_request.crop_right);
+      break;
+    case PROP_CROP_TOP:
+      g_value_set_uint (value, priv->geometry_request.crop_top);
+      break;
+    case PROP_CROP_BOTTOM:
+      g_value_set_uint (value, priv->geometry_request.crop_bottom);
+      break;
+    case PROP_OUTPUT_WIDTH:
+      g_value_set_uint (value, priv->geometry_request.width);
+      break;
+    case PROP_OUTPUT_HEIGHT:
+      g_value_set_uint (value, priv->geometry_request.height);
+      break;
+    case PROP_POOL_BUDGET:
+      g_value_set_uint64 (value, priv->pool_budget);
+      break;
+    case PROP_POOL_SIZE:
+      g_value_set_uint (value, priv->pool_size.load ());
+      break;
+    case PROP_TIMESTAMP_MODE:
+      g_value_set_enum (value, priv->timestamp_mode);
+      break;
+    case PROP_CFR:
+      g_value_set_boolean (value, priv->cfr);
+      break;
+    case PROP_STATS:
+      g_value_take_boxed (value, gst_spout_src_stats (self));
+      break;
+    case PROP_STATS_INTERVAL:
+      g_value_set_uint (value, priv->stats_interval.load ());
+      break;
+    case PROP_BACKEND:
+      g_value_set_enum (value, priv->backend);
+      break;
+    case PROP_HUGE_PAGES:
+      g_value_set_boolean (value, priv->huge_pages);
+      break;
+    case PROP_NUMA_NODE:
+      g_value_set_int (value, priv->numa_node);
+      break;
+    case PROP_RECORD_LOCATION:
+      g_value_set_string (value, priv->record_location.c_str());
+      break;
+    case PROP_RECORD_PAYLOADS:
+      g_value_set_boolean (value, priv->record_payloads);
+      break;
+    case PROP_REPLAY_LOCATION:
+      g_value_set_string (value, priv->replay_location.c_str());
+      break;
+    case PROP_REPLAY_TIMING:
+      g_value_set_enum (value, priv->replay_timing);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -359,6 +1451,7 @@ gst_spout_src_provide_clock (GstElement * elem)
   return gst_system_clock_obtain ();
 }
 
+#ifdef HAVE_SPOUT
 static void
 gst_spout_src_set_context (GstElement * elem, GstContext * context)
 {
@@ -370,25 +1463,115 @@ gst_spout_src_set_context (GstElement * elem, GstContext * context)
 
   GST_ELEMENT_CLASS (parent_class)->set_context (elem, context);
 }
+#endif
 
-/* Helper function to convert DXGI_FORMAT to GstVideoFormat */
-static GstVideoFormat
-gst_spout_src_dxgi_format_to_gst (DXGI_FORMAT dxgi_format)
-{
-  switch (dxgi_format) {
-    case DXGI_FORMAT_B8G8R8A8_UNORM:
-      return GST_VIDEO_FORMAT_BGRA;
-    case DXGI_FORMAT_R8G8B8A8_UNORM:
-      return GST_VIDEO_FORMAT_RGBA;
-    case DXGI_FORMAT_B8G8R8X8_UNORM:
-      return GST_VIDEO_FORMAT_BGRx;
-    /* DXGI_FORMAT_R8G8B8X8_UNORM is not defined in all DirectX headers
-     * Use a numeric constant instead (122) */
-    case 122: /* DXGI_FORMAT_R8G8B8X8_UNORM */
-      return GST_VIDEO_FORMAT_RGBx;
-    default:
-      return GST_VIDEO_FORMAT_UNKNOWN;
+static void
+gst_spout_src_publish_state (GstSpoutSrc * self)
+{
+  GstSpoutSrcPrivate *priv = self->priv;
+  auto state = std::make_shared<GstSpoutConnectionState> ();
+  
+#ifdef HAVE_SPOUT
+  state->connected = priv->connected && (priv->spout || priv->receiver);
+#else
+  state->connected = priv->connected && priv->receiver;
+#endif
+  state->sender_name = priv->connected_sender_name;
+  state->video_info = priv->video_info;
+  state->fps = priv->current_fps > 0 ? priv->current_fps : DEFAULT_FRAMERATE;
+  state->caps = priv->caps ? gst_caps_ref (priv->caps) : nullptr;
+  state->caps_generation = priv->caps_state.generation ();
+  state->geometry = priv->geometry;
+  state->reshape = !priv->receiver && !priv->geometry_request.is_default ();
+  
+  /* Every connect, disconnect and format change comes by here */
+  if (priv->recorder.is_open ()) {
+    GstSpoutFrameFormat format;
+    
+    format.width = GST_VIDEO_INFO_WIDTH (&priv->video_info);
+    format.height = GST_VIDEO_INFO_HEIGHT (&priv->video_info);
+    format.format = priv->format;
+    format.stride = GST_VIDEO_INFO_PLANE_STRIDE (&priv->video_info, 0);
+    format.fps = state->fps;
+    priv->recorder.state (gst_util_get_timestamp (), state->connected,
+        state->sender_name, format);
+  }
+  
+  priv->state.publish (std::move (state));
+}
+
+/* Compare the sender format against the one our caps were built from and
+ * rebuild video_info and caps only if it changed. Call with the lock held */
+static gboolean
+gst_spout_src_update_format (GstSpoutSrc * self, unsigned int width,
+    unsigned int height, uint32_t format, double fps)
+{
+  GstSpoutSrcPrivate *priv = self->priv;
+  GstSpoutSenderFormat sender_format;
+  
+  /* If the sender doesn't provide a valid framerate, use our default */
+  if (fps <= 0.0 || fps > 1000.0)
+    fps = DEFAULT_FRAMERATE;
+  
+  sender_format.width = width;
+  sender_format.height = height;
+  sender_format.format = format;
+  sender_format.fps = fps;
+  
+  if (!priv->caps_state.update (sender_format))
+    return FALSE;
+  
+  GST_DEBUG_OBJECT (self, "Sender format changed: %ux%u format=%u %.2f fps",
+                    width, height, format, fps);
+  
+  priv->format = format;
+  priv->current_fps = fps;
+  
+  GstVideoFormat video_format = gst_spout_format_from_dxgi (format);
+  if (video_format == GST_VIDEO_FORMAT_UNKNOWN) {
+    GST_WARNING_OBJECT (self, "Unsupported DXGI format %u, falling back to BGRA", format);
+    video_format = GST_VIDEO_FORMAT_BGRA;
+  }
+  
+  /* Set up the video info with the framerate, as the standard rate the
+   * sender most likely runs at */
+  gst_video_info_set_format(&priv->video_info, video_format, width, height);
+  gst_spout_snap_framerate (fps, &priv->video_info.fps_n, &priv->video_info.fps_d);
+  
+  /* Downstream gets the cropped and scaled size, system memory backends
+   * push frames as they are */
+  priv->geometry = gst_spout_geometry_compute (width, height,
+      priv->receiver ? GstSpoutGeometryRequest () : priv->geometry_request);
+  if (!priv->geometry.identity ()) {
+    GST_DEBUG_OBJECT (self, "Cropping %ux%u+%u+%u, scaling to %ux%u",
+        priv->geometry.crop.width, priv->geometry.crop.height,
+        priv->geometry.crop.x, priv->geometry.crop.y,
+        priv->geometry.width, priv->geometry.height);
+  }
+  
+  GstVideoInfo output_info = priv->video_info;
+  GST_VIDEO_INFO_WIDTH (&output_info) = priv->geometry.width;
+  GST_VIDEO_INFO_HEIGHT (&output_info) = priv->geometry.height;
+  
+  /* Create caps from video info and make them writable */
+  GstCaps *new_caps = gst_video_info_to_caps(&output_info);
+  new_caps = gst_caps_make_writable(new_caps);
+  
+#ifdef HAVE_SPOUT
+  /* Add D3D11 memory feature to the writable caps */
+  if (!priv->receiver) {
+    GstCapsFeatures *features = gst_caps_features_new(GST_CAPS_FEATURE_MEMORY_D3D11_MEMORY, NULL);
+    gst_caps_set_features(new_caps, 0, features);
   }
+#endif
+  
+  /* Replace the existing caps with the new one, create() pushes them */
+  gst_caps_replace(&priv->caps, new_caps);
+  gst_caps_unref(new_caps);
+  
+  GST_DEBUG_OBJECT (self, "Created caps %" GST_PTR_FORMAT, priv->caps);
+  
+  return TRUE;
 }
 
 /* Safely disconnect from Spout and clean up resources */
@@ -401,25 +1584,73 @@ gst_spout_src_disconnect (GstSpoutSrc * self)
   GST_DEBUG_OBJECT (self, "Disconnecting from Spout (current state: connected=%d, sender=%s)",
                     priv->connected, priv->connected_sender_name.c_str());
   
-  /* Release texture resources */
-  if (priv->texture_srv) {
-    priv->texture_srv->Release();
-    priv->texture_srv = nullptr;
+  if (priv->connected) {
+    GST_WARNING_OBJECT (self, "Lost connection to Spout sender '%s'",
+                        priv->connected_sender_name.c_str());
   }
   
-  if (priv->shared_texture) {
-    priv->shared_texture->Release();
-    priv->shared_texture = nullptr;
-  }
+#ifdef HAVE_SPOUT
+  /* Release texture resources, buffers downstream keep their own references */
+  priv->shared_textures.clear();
+  priv->shared_handle = nullptr;
   
   /* Release Spout receiver */
   if (priv->spout) {
     priv->spout->ReleaseReceiver();
   }
+#endif
+  if (priv->receiver)
+    priv->receiver->disconnect ();
   
   priv->connected = FALSE;
   priv->first_frame = TRUE;
   priv->connected_sender_name.clear();
+  gst_spout_src_publish_state (self);
+}
+
+/* Set up for the receiver's frames in @format. Call with the lock held */
+static void
+gst_spout_src_apply_received_format (GstSpoutSrc * self,
+    const GstSpoutFrameFormat & format)
+{
+  GstSpoutSrcPrivate *priv = self->priv;
+  
+  priv->received_format = format;
+  gst_spout_src_update_format (self, format.width, format.height,
+                               format.format, format.fps);
+  
+  /* Frames are pushed in place, rows are as far apart as the sender put them */
+  GST_VIDEO_INFO_PLANE_STRIDE (&priv->video_info, 0) = format.stride;
+  GST_VIDEO_INFO_SIZE (&priv->video_info) =
+      (gsize) format.stride * format.height;
+}
+
+/* Connect through a system memory backend. Call with the lock held */
+static gboolean
+gst_spout_src_connect_receiver (GstSpoutSrc * self)
+{
+  GstSpoutSrcPrivate *priv = self->priv;
+  GstSpoutFrameFormat format;
+  
+  if (!priv->receiver->connect (priv->sender_name)) {
+    GST_WARNING_OBJECT (self, "Failed to connect to sender '%s'",
+                        priv->sender_name.c_str());
+    return FALSE;
+  }
+  
+  format = priv->receiver->format ();
+  GST_INFO_OBJECT (self, "Connected to sender '%s': %ux%u, format %u, "
+      "stride %u", priv->receiver->sender_name ().c_str(), format.width,
+      format.height, format.format, format.stride);
+  
+  priv->connected_sender_name = priv->receiver->sender_name ();
+  gst_spout_src_apply_received_format (self, format);
+  
+  priv->connected = TRUE;
+  priv->last_receive_time = gst_util_get_timestamp();
+  gst_spout_src_publish_state (self);
+  
+  return TRUE;
 }
 
 /* Connect to a Spout sender and setup texture sharing */
@@ -429,6 +1660,10 @@ gst_spout_src_connect (GstSpoutSrc * self)
   GstSpoutSrcPrivate *priv = self->priv;
   std::lock_guard<std::mutex> lock(priv->lock);
   
+  if (priv->receiver)
+    return gst_spout_src_connect_receiver (self);
+  
+#ifdef HAVE_SPOUT
   if (!priv->spout) {
     GST_DEBUG_OBJECT (self, "Creating new spoutDX instance");
     priv->spout = new spoutDX();
@@ -451,19 +1686,9 @@ gst_spout_src_connect (GstSpoutSrc * self)
     return FALSE;
   }
   
-  /* Get sender list for debugging */
-  int senderCount = priv->spout->GetSenderCount();
-  GST_INFO_OBJECT (self, "Found %d Spout senders", senderCount);
-  
-  for (int i = 0; i < senderCount; i++) {
-    char senderName[256];
-    if (priv->spout->GetSender(i, senderName, 256)) {
-      GST_INFO_OBJECT (self, "Spout Sender %d: '%s'", i, senderName);
-    }
-  }
-  
-  if (senderCount == 0) {
-    GST_DEBUG_OBJECT (self, "No Spout senders found, will wait for one to appear");
+  /* The process-wide sender monitor keeps the list, no need to enumerate */
+  if (!gst_spout_sender_monitor_get ().has_sender (priv->sender_name)) {
+    GST_DEBUG_OBJECT (self, "No matching Spout sender found, will wait for one to appear");
     return TRUE; // Not an error, just wait for sender to appear
   }
   
@@ -495,44 +1720,9 @@ gst_spout_src_connect (GstSpoutSrc * self)
         GST_INFO_OBJECT (self, "Successfully connected to sender '%s'", senderName);
         
         /* Now set up our local info based on the connection */
-        priv->format = (DXGI_FORMAT)format;
         priv->connected_sender_name = senderName;
-        
-        /* Get or create caps based on sender info */
-        GstVideoFormat video_format = gst_spout_src_dxgi_format_to_gst((DXGI_FORMAT)format);
-        if (video_format == GST_VIDEO_FORMAT_UNKNOWN) {
-          GST_WARNING_OBJECT (self, "Unsupported DXGI format %d, falling back to BGRA", format);
-          video_format = GST_VIDEO_FORMAT_BGRA;
-        }
-        
-        /* Get the sender frame rate if available */
-        double fps = priv->spout->GetSenderFps();
-        if (fps <= 0.0 || fps > 1000.0) {
-          /* If the sender doesn't provide a valid framerate, use our default */
-          fps = DEFAULT_FRAMERATE;
-        }
-        priv->current_fps = fps;
-        
-        GST_DEBUG_OBJECT (self, "Using sender framerate: %.2f fps", fps);
-        
-        /* Set up the video info with the framerate */
-        gst_video_info_set_format(&priv->video_info, video_format, width, height);
-        priv->video_info.fps_n = (int)(fps * 1000);
-        priv->video_info.fps_d = 1000; /* Using 1000 as denominator for better precision */
-        
-        /* Create caps from video info and make them writable */
-        GstCaps *new_caps = gst_video_info_to_caps(&priv->video_info);
-        new_caps = gst_caps_make_writable(new_caps);
-        
-        /* Add D3D11 memory feature to the writable caps */
-        GstCapsFeatures *features = gst_caps_features_new(GST_CAPS_FEATURE_MEMORY_D3D11_MEMORY, NULL);
-        gst_caps_set_features(new_caps, 0, features);
-        
-        /* Replace the existing caps with the new one */
-        gst_caps_replace(&priv->caps, new_caps);
-        gst_caps_unref(new_caps);
-        
-        GST_DEBUG_OBJECT (self, "Created caps %" GST_PTR_FORMAT, priv->caps);
+        gst_spout_src_update_format (self, width, height, (uint32_t) format,
+                                     priv->spout->GetSenderFps());
         
         /* Clean up the texture we just received */
         if (texture) {
@@ -541,8 +1731,8 @@ gst_spout_src_connect (GstSpoutSrc * self)
         
         /* Mark as connected and update last receive time */
         priv->connected = TRUE;
-        priv->reconnect_attempts = 0;
         priv->last_receive_time = gst_util_get_timestamp();
+        gst_spout_src_publish_state (self);
         
         return TRUE;
       } else {
@@ -567,49 +1757,11 @@ gst_spout_src_connect (GstSpoutSrc * self)
       /* Store the connected sender name */
       priv->connected_sender_name = sender_name ? sender_name : "";
       
-      /* Get the sender width and height */
-      unsigned int width = priv->spout->GetSenderWidth();
-      unsigned int height = priv->spout->GetSenderHeight();
-      DXGI_FORMAT format = priv->spout->GetSenderFormat();
-      
-      /* Store the format */
-      priv->format = format;
-      
-      /* Get or create caps based on sender info */
-      GstVideoFormat video_format = gst_spout_src_dxgi_format_to_gst(format);
-      if (video_format == GST_VIDEO_FORMAT_UNKNOWN) {
-        GST_WARNING_OBJECT (self, "Unsupported DXGI format %d, falling back to BGRA", format);
-        video_format = GST_VIDEO_FORMAT_BGRA;
-      }
-      
-      /* Get the sender frame rate if available */
-      double fps = priv->spout->GetSenderFps();
-      if (fps <= 0.0 || fps > 1000.0) {
-        /* If the sender doesn't provide a valid framerate, use our default */
-        fps = DEFAULT_FRAMERATE;
-      }
-      priv->current_fps = fps;
-      
-      GST_DEBUG_OBJECT (self, "Using sender framerate: %.2f fps", fps);
-      
-      /* Set up the video info with the framerate */
-      gst_video_info_set_format(&priv->video_info, video_format, width, height);
-      priv->video_info.fps_n = (int)(fps * 1000);
-      priv->video_info.fps_d = 1000; /* Using 1000 as denominator for better precision */
-      
-      /* Create caps from video info and make them writable */
-      GstCaps *new_caps = gst_video_info_to_caps(&priv->video_info);
-      new_caps = gst_caps_make_writable(new_caps);
-      
-      /* Add D3D11 memory feature to the writable caps */
-      GstCapsFeatures *features = gst_caps_features_new(GST_CAPS_FEATURE_MEMORY_D3D11_MEMORY, NULL);
-      gst_caps_set_features(new_caps, 0, features);
-      
-      /* Replace the existing caps with the new one */
-      gst_caps_replace(&priv->caps, new_caps);
-      gst_caps_unref(new_caps);
-      
-      GST_DEBUG_OBJECT (self, "Created caps %" GST_PTR_FORMAT, priv->caps);
+      /* Set up our local info from the sender */
+      gst_spout_src_update_format (self, priv->spout->GetSenderWidth(),
+                                   priv->spout->GetSenderHeight(),
+                                   priv->spout->GetSenderFormat(),
+                                   priv->spout->GetSenderFps());
       
       /* Clean up the texture we just received */
       if (texture) {
@@ -618,26 +1770,88 @@ gst_spout_src_connect (GstSpoutSrc * self)
       
       /* Mark as connected and update last receive time */
       priv->connected = TRUE;
-      priv->reconnect_attempts = 0;
       priv->last_receive_time = gst_util_get_timestamp();
+      gst_spout_src_publish_state (self);
       
       return TRUE;
     } else {
       GST_WARNING_OBJECT (self, "Failed to connect to active sender");
     }
   }
+#endif
+  
+  /* If we're here, connection failed, the reconnect thread backs off */
+  GST_WARNING_OBJECT (self, "Failed to connect to any Spout sender");
+  
+  return FALSE;
+}
+
+/* Receiver for backend != spout, nullptr after posting an error if it
+ * can't be set up */
+static std::unique_ptr<GstSpoutFrameReceiver>
+gst_spout_src_new_receiver (GstSpoutSrc * self)
+{
+  GstSpoutSrcPrivate *priv = self->priv;
   
-  /* If we're here, connection failed */
-  GST_WARNING_OBJECT (self, "Failed to connect to any Spout sender (%d attempts)", 
-                     ++priv->reconnect_attempts);
+  switch (priv->backend) {
+    case GST_SPOUT_BACKEND_SHM:
+      return std::make_unique<GstSpoutShmReceiver> ();
+    case GST_SPOUT_BACKEND_REPLAY: {
+      auto replay = std::make_unique<GstSpoutReplayReceiver> ();
+      
+      if (!replay->open (priv->replay_location, priv->replay_timing)) {
+        GST_ELEMENT_ERROR (self, RESOURCE, OPEN_READ,
+            ("Failed to open recording '%s'", priv->replay_location.c_str()),
+            ("Not a recording, or replay-location isn't set"));
+        return nullptr;
+      }
+      
+      return replay;
+    }
+    default:
+      return nullptr;
+  }
+}
+
+#ifdef HAVE_SPOUT
+/* Set up the D3D11 device and sender discovery for the spout backend */
+static gboolean
+gst_spout_src_open_device (GstSpoutSrc * self)
+{
+  GstSpoutSrcPrivate *priv = self->priv;
   
-  /* If this is our first few attempts, not a critical error */
-  if (priv->reconnect_attempts < 5) {
-    return TRUE;
+  /* Ensure we have a D3D11 device */
+  if (!gst_d3d11_ensure_element_data (GST_ELEMENT_CAST (self),
+          priv->adapter, &priv->device)) {
+    GST_ERROR_OBJECT (self, "Failed to get D3D11 device");
+    return FALSE;
   }
   
+  priv->shared_textures.backend().device =
+      gst_d3d11_device_get_device_handle (priv->device);
+  priv->standby.backend().device = priv->device;
+  priv->readback.engine().device = priv->device;
+  
+  /* Follow the sender list through the process-wide monitor */
+  priv->monitor_subscription = gst_spout_sender_monitor_get ().subscribe (
+      [self] (const GstSpoutSenderDiff & diff) {
+        gst_spout_src_senders_changed (self, diff);
+      });
+  
+  return TRUE;
+}
+#else
+/* Built without D3D11 and the Spout SDK */
+static gboolean
+gst_spout_src_open_device (GstSpoutSrc * self)
+{
+  GST_ELEMENT_ERROR (self, CORE, NOT_IMPLEMENTED,
+      ("backend=spout isn't available on this platform"),
+      ("Built without GStreamer's D3D11 library and the Spout SDK, "
+       "use backend=shm or backend=replay"));
   return FALSE;
 }
+#endif
 
 static gboolean
 gst_spout_src_start (GstBaseSrc * src)
@@ -647,25 +1861,73 @@ gst_spout_src_start (GstBaseSrc * src)
 
   GST_DEBUG_OBJECT (self, "start");
 
-  /* Ensure we have a D3D11 device */
-  if (!gst_d3d11_ensure_element_data (GST_ELEMENT_CAST (self),
-          priv->adapter, &priv->device)) {
-    GST_ERROR_OBJECT (self, "Failed to get D3D11 device");
+  if (!priv->record_location.empty () &&
+      !priv->recorder.open (priv->record_location)) {
+    GST_ELEMENT_ERROR (self, RESOURCE, OPEN_WRITE,
+        ("Failed to create recording '%s'", priv->record_location.c_str()),
+        (NULL));
+    return FALSE;
+  }
+
+  /* Other backends receive into system memory, no GPU needed. From here
+   * on a failed start takes the new recording away again rather than
+   * leaving an empty one behind */
+  if (priv->backend != GST_SPOUT_BACKEND_SPOUT) {
+    /* Set up outside the lock, failing posts an error message */
+    auto receiver = gst_spout_src_new_receiver (self);
+    
+    if (!receiver) {
+      priv->recorder.discard ();
+      return FALSE;
+    }
+    if (receiver->shares_fd ())
+      priv->fd_allocator = gst_fd_allocator_new ();
+    if (priv->cfr || priv->capture_thread ||
+        !priv->geometry_request.is_default ()) {
+      GST_WARNING_OBJECT (self, "cfr, capture-thread, crop-* and output-* "
+          "only apply to the spout backend");
+    }
+    
+    std::lock_guard<std::mutex> lock(priv->lock);
+    priv->receiver = std::move (receiver);
+  } else if (!gst_spout_src_open_device (self)) {
+    priv->recorder.discard ();
     return FALSE;
   }
 
-  /* Connect to Spout */
+  priv->stats.reset ();
+  priv->stats_posted = GST_CLOCK_TIME_NONE;
+  
+  /* Connect to Spout. Without a sender yet this succeeds unconnected and
+   * the reconnect thread counts the connect once it comes */
   if (!gst_spout_src_connect (self)) {
-    GST_ERROR_OBJECT (self, "Failed to connect to Spout");
-    /* Do not fail here - we'll retry in the create function */
+    GST_WARNING_OBJECT (self, "Failed to connect to Spout");
+    /* Do not fail here - the reconnect thread retries */
+  } else if (priv->connected) {
+    priv->stats.connects.add ();
   }
 
   /* Reset frame count and timing */
+  priv->dedup.reset ();
+  priv->gap_end = GST_CLOCK_TIME_NONE;
   priv->frame_number = 0;
   priv->prev_pts = GST_CLOCK_TIME_NONE;
+  priv->timestamper.reset ();
+  priv->pacer.reset ();
+#ifdef HAVE_SPOUT
+  priv->standby_timer.reset ();
+#endif
+  priv->cfr_lost = 0;
   priv->first_frame = TRUE;
-  priv->reconnect_attempts = 0;
   priv->last_receive_time = GST_CLOCK_TIME_NONE;
+  priv->cadence.reset ();
+  priv->latency.reset ();
+  priv->latency.configure (LATENCY_MARGIN, LATENCY_MIN_DRIFT);
+  priv->cadence.configure (NEW_FRAME_POLL_INTERVAL * GST_MSECOND,
+      CADENCE_POLL_BUDGET);
+  priv->pushed_caps_generation = 0;
+  
+  gst_spout_src_start_reconnect (self);
 
   return TRUE;
 }
@@ -678,15 +1940,48 @@ gst_spout_src_stop (GstBaseSrc * src)
   
   GST_DEBUG_OBJECT (self, "stop");
   
-  /* Clean up texture resources */
-  if (priv->texture_srv) {
-    priv->texture_srv->Release();
-    priv->texture_srv = nullptr;
+  if (const gchar *trace = g_getenv (TRACE_ENV))
+    gst_spout_src_dump_trace (self, trace);
+  
+  /* The reconnect and capture threads use the receiver, stop them first */
+  gst_spout_src_stop_reconnect (self);
+#ifdef HAVE_SPOUT
+  gst_spout_src_stop_capture (self);
+#endif
+  
+  /* Buffers downstream still hold leases, which keep what they need */
+  {
+    std::lock_guard<std::mutex> lock(priv->lock);
+    priv->receiver.reset ();
+  }
+  gst_clear_object (&priv->fd_allocator);
+  priv->fd_output = FALSE;
+  
+  /* May hold a pool buffer, let it go before the pool */
+  gst_clear_buffer (&priv->cfr_last);
+  
+#ifdef HAVE_SPOUT
+  if (priv->monitor_subscription) {
+    gst_spout_sender_monitor_get ().unsubscribe (priv->monitor_subscription);
+    priv->monitor_subscription = 0;
   }
   
-  if (priv->shared_texture) {
-    priv->shared_texture->Release();
-    priv->shared_texture = nullptr;
+  /* Clean up texture resources */
+  priv->shared_textures.clear();
+  priv->shared_textures.backend().device = nullptr;
+  priv->shared_handle = nullptr;
+  
+  /* Holds pool buffers too */
+  priv->standby.clear();
+  priv->standby.backend().device = nullptr;
+  
+  priv->readback.reset();
+  priv->readback.engine().clear();
+  priv->readback.engine().device = nullptr;
+  
+  if (priv->fingerprint_staging) {
+    priv->fingerprint_staging->Release();
+    priv->fingerprint_staging = nullptr;
   }
 
   /* Release Spout resources */
@@ -699,6 +1994,7 @@ gst_spout_src_stop (GstBaseSrc * src)
   
   /* Release D3D11 device */
   gst_clear_object(&priv->device);
+#endif
   
   /* Release buffer pool */
   if (priv->pool) {
@@ -706,15 +2002,36 @@ gst_spout_src_stop (GstBaseSrc * src)
     gst_object_unref(priv->pool);
     priv->pool = nullptr;
   }
+  priv->pool_tracker.reset ();
+  priv->pool_size = 0;
+  
+  if (priv->output_pool) {
+    gst_buffer_pool_set_active(priv->output_pool, FALSE);
+    gst_object_unref(priv->output_pool);
+    priv->output_pool = nullptr;
+  }
+  priv->sysmem_output = FALSE;
+  
+#ifdef HAVE_SPOUT
+  gst_clear_object(&priv->converter);
+#endif
+  priv->converting = FALSE;
   
   /* Clear caps */
   gst_clear_caps(&priv->caps);
+  priv->caps_state.reset ();
   
   /* Reset connection state */
   priv->connected = FALSE;
   priv->first_frame = TRUE;
-  priv->reconnect_attempts = 0;
   priv->connected_sender_name.clear();
+  gst_spout_src_publish_state (self);
+  
+  if (priv->recorder.is_open ()) {
+    GST_INFO_OBJECT (self, "Recorded %" G_GUINT64_FORMAT " frames to '%s'",
+        priv->recorder.frames (), priv->record_location.c_str());
+    priv->recorder.close ();
+  }
 
   return TRUE;
 }
@@ -728,6 +2045,12 @@ gst_spout_src_unlock (GstBaseSrc * src)
 
   GST_DEBUG_OBJECT (self, "unlock");
   priv->flushing = TRUE;
+  priv->capture.set_flushing (true);
+  priv->cond.notify_all ();
+  if (priv->cfr_clock_id)
+    gst_clock_id_unschedule (priv->cfr_clock_id);
+  if (priv->receiver)
+    priv->receiver->wake ();
 
   return TRUE;
 }
@@ -741,10 +2064,58 @@ gst_spout_src_unlock_stop (GstBaseSrc * src)
 
   GST_DEBUG_OBJECT (self, "unlock_stop");
   priv->flushing = FALSE;
+  priv->capture.set_flushing (false);
 
   return TRUE;
 }
 
+/* The negotiated frame rate, else the sender's snapped to a standard one,
+ * else the default */
+static void
+gst_spout_src_frame_rate (const GstSpoutConnectionState & state, gint * fps_n,
+    gint * fps_d)
+{
+  if (GST_VIDEO_INFO_FPS_N (&state.video_info) > 0) {
+    *fps_n = GST_VIDEO_INFO_FPS_N (&state.video_info);
+    *fps_d = GST_VIDEO_INFO_FPS_D (&state.video_info);
+  } else {
+    gst_spout_snap_framerate (state.fps, fps_n, fps_d);
+  }
+  
+  if (*fps_n <= 0)
+    gst_spout_snap_framerate (DEFAULT_FRAMERATE, fps_n, fps_d);
+}
+
+/* One frame at gst_spout_src_frame_rate(), exact for 59.94 and rates
+ * below 1 fps alike */
+static GstClockTime
+gst_spout_src_frame_duration (const GstSpoutConnectionState & state)
+{
+  gint fps_n, fps_d;
+  
+  gst_spout_src_frame_rate (state, &fps_n, &fps_d);
+  
+  return gst_spout_frame_duration (fps_n, fps_d);
+}
+
+/* The element clock's running time, GST_CLOCK_TIME_NONE without a clock */
+static GstClockTime
+gst_spout_src_running_time (GstSpoutSrc * self)
+{
+  GstClockTime base_time, now;
+  GstClock *clock;
+  
+  clock = gst_element_get_clock (GST_ELEMENT_CAST (self));
+  if (!clock)
+    return GST_CLOCK_TIME_NONE;
+  
+  now = gst_clock_get_time (clock);
+  base_time = GST_ELEMENT_CAST (self)->base_time;
+  gst_object_unref (clock);
+  
+  return now > base_time ? now - base_time : 0;
+}
+
 static gboolean
 gst_spout_src_query (GstBaseSrc * src, GstQuery * query)
 {
@@ -756,17 +2127,43 @@ gst_spout_src_query (GstBaseSrc * src, GstQuery * query)
     case GST_QUERY_LATENCY: {
       std::lock_guard<std::mutex> lock(priv->lock);
       
-      /* Report latency based on processing deadline */
-      if (GST_CLOCK_TIME_IS_VALID (priv->processing_deadline)) {
-        gst_query_set_latency (query, TRUE, priv->processing_deadline,
-            GST_CLOCK_TIME_NONE);
+      /* Frames read back to system memory come out readback-latency
+       * frames late */
+      GstClockTime readback = 0;
+#ifdef HAVE_SPOUT
+      if (priv->sysmem_output) {
+        readback = priv->readback.latency () *
+            gst_spout_src_frame_duration (*priv->state.load ());
+      }
+#endif
+      
+      /* Once enough frames went out, report how far behind the clock they
+       * actually were. Read back frames keep the PTS they were received
+       * with and leave create() readback-latency frames later, so that
+       * already includes the readback. The processing deadline is only a
+       * guess to start with */
+      GstClockTime min, max = GST_CLOCK_TIME_NONE;
+      GstClockTime measured = priv->latency.estimate ();
+      if (measured != GstSpoutLatencyEstimator::NONE) {
+        GST_DEBUG_OBJECT (self, "Reporting measured latency %" GST_TIME_FORMAT,
+            GST_TIME_ARGS (measured));
+        priv->latency.set_reported (measured);
+        min = measured;
+      } else if (GST_CLOCK_TIME_IS_VALID (priv->processing_deadline)) {
+        min = priv->processing_deadline + readback;
       } else {
-        gst_query_set_latency (query, TRUE, 0, 0);
+        min = max = readback;
       }
       
+      /* We never buffer less than we add */
+      if (GST_CLOCK_TIME_IS_VALID (max) && max < min)
+        max = min;
+      gst_query_set_latency (query, TRUE, min, max);
+      
       ret = TRUE;
       break;
     }
+#ifdef HAVE_SPOUT
     case GST_QUERY_CONTEXT:
       /* Handle D3D11 context query */
       ret = gst_d3d11_handle_context_query (GST_ELEMENT (self), query,
@@ -775,6 +2172,7 @@ gst_spout_src_query (GstBaseSrc * src, GstQuery * query)
         break;
       
       /* Fall through for other context types */
+#endif
     default:
       ret = GST_BASE_SRC_CLASS (parent_class)->query (src, query);
       break;
@@ -783,20 +2181,166 @@ gst_spout_src_query (GstBaseSrc * src, GstQuery * query)
   return ret;
 }
 
-static GstCaps *
-gst_spout_src_get_caps (GstBaseSrc * src, GstCaps * filter)
+#ifdef HAVE_SPOUT
+/* Kernel format for @format, UNKNOWN if the readback can't convert it */
+static GstSpoutPixelFormat
+gst_spout_src_pixel_format (GstVideoFormat format)
 {
-  GstSpoutSrc *self = GST_SPOUT_SRC (src);
-  GstSpoutSrcPrivate *priv = self->priv;
-  GstCaps *caps = NULL;
-
-  GST_DEBUG_OBJECT (self, "get_caps");
+  switch (format) {
+    case GST_VIDEO_FORMAT_BGRA:
+      return GST_SPOUT_PIXEL_FORMAT_BGRA;
+    case GST_VIDEO_FORMAT_RGBA:
+      return GST_SPOUT_PIXEL_FORMAT_RGBA;
+    case GST_VIDEO_FORMAT_BGRx:
+      return GST_SPOUT_PIXEL_FORMAT_BGRX;
+    case GST_VIDEO_FORMAT_RGBx:
+      return GST_SPOUT_PIXEL_FORMAT_RGBX;
+    case GST_VIDEO_FORMAT_NV12:
+      return GST_SPOUT_PIXEL_FORMAT_NV12;
+    case GST_VIDEO_FORMAT_I420:
+      return GST_SPOUT_PIXEL_FORMAT_I420;
+    default:
+      return GST_SPOUT_PIXEL_FORMAT_UNKNOWN;
+  }
+}
 
-  std::unique_lock<std::mutex> lock(priv->lock);
+/* @caps in D3D11 memory, followed by the formats the GPU converts to */
+static GstCaps *
+gst_spout_src_d3d11_caps (GstCaps * caps)
+{
+  GstCaps *d3d11 = gst_caps_new_empty ();
+  
+  for (guint i = 0; i < gst_caps_get_size (caps); i++) {
+    GstStructure *s = gst_caps_get_structure (caps, i);
+    const gchar *native = gst_structure_get_string (s, "format");
+    GstStructure *yuv;
+    GValue formats = G_VALUE_INIT, value = G_VALUE_INIT;
+    
+    gst_caps_append_structure_full (d3d11, gst_structure_copy (s),
+        gst_caps_features_new (GST_CAPS_FEATURE_MEMORY_D3D11_MEMORY, NULL));
+    
+    if (!native)
+      continue;
+    
+    auto converted = gst_spout_caps_d3d11_formats (native);
+    
+    gst_value_list_init (&formats, converted.size ());
+    g_value_init (&value, G_TYPE_STRING);
+    for (size_t j = 1; j < converted.size (); j++) {
+      g_value_set_string (&value, converted[j].c_str ());
+      gst_value_list_append_value (&formats, &value);
+    }
+    g_value_unset (&value);
+    
+    yuv = gst_structure_copy (s);
+    gst_structure_take_value (yuv, "format", &formats);
+    gst_structure_set (yuv, "colorimetry", G_TYPE_STRING, "bt709", NULL);
+    
+    gst_caps_append_structure_full (d3d11, yuv,
+        gst_caps_features_new (GST_CAPS_FEATURE_MEMORY_D3D11_MEMORY, NULL));
+  }
+  
+  return d3d11;
+}
+
+/* @caps in system memory, in their own format first and then in every
+ * other format the readback converts to. YUV output is BT.709 */
+static GstCaps *
+gst_spout_src_sysmem_caps (GstCaps * caps)
+{
+  static const gchar *packed_formats[] = { "BGRA", "RGBA", "RGBx", "BGRx" };
+  GstCaps *sysmem = gst_caps_new_empty ();
+  
+  for (guint i = 0; i < gst_caps_get_size (caps); i++) {
+    GstStructure *s = gst_caps_get_structure (caps, i);
+    const gchar *native = gst_structure_get_string (s, "format");
+    GstStructure *packed = gst_structure_copy (s);
+    GstStructure *yuv = gst_structure_copy (s);
+    GValue formats = G_VALUE_INIT, value = G_VALUE_INIT;
+    
+    if (native) {
+      gst_value_list_init (&formats, G_N_ELEMENTS (packed_formats));
+      g_value_init (&value, G_TYPE_STRING);
+      
+      g_value_set_string (&value, native);
+      gst_value_list_append_value (&formats, &value);
+      for (guint j = 0; j < G_N_ELEMENTS (packed_formats); j++) {
+        if (g_strcmp0 (packed_formats[j], native) == 0)
+          continue;
+        g_value_set_string (&value, packed_formats[j]);
+        gst_value_list_append_value (&formats, &value);
+      }
+      
+      gst_structure_take_value (packed, "format", &formats);
+      g_value_unset (&value);
+    }
+    
+    gst_caps_append_structure_full (sysmem, packed,
+        gst_caps_features_copy (GST_CAPS_FEATURES_MEMORY_SYSTEM_MEMORY));
+    
+    gst_structure_remove_field (yuv, "format");
+    gst_structure_set (yuv, "colorimetry", G_TYPE_STRING, "bt709", NULL);
+    gst_value_list_init (&formats, 2);
+    g_value_init (&value, G_TYPE_STRING);
+    g_value_set_string (&value, "NV12");
+    gst_value_list_append_value (&formats, &value);
+    g_value_set_string (&value, "I420");
+    gst_value_list_append_value (&formats, &value);
+    g_value_unset (&value);
+    gst_structure_take_value (yuv, "format", &formats);
+    
+    gst_caps_append_structure_full (sysmem, yuv,
+        gst_caps_features_copy (GST_CAPS_FEATURES_MEMORY_SYSTEM_MEMORY));
+  }
+  
+  return sysmem;
+}
+
+#endif
+
+/* @caps of a system memory backend, taking ownership. Offered as
+ * memory:FdMemory first when frames come with their fd, downstream that
+ * takes any memory gets those too: they map like any other */
+static GstCaps *
+gst_spout_src_received_caps (GstSpoutSrc * self, GstCaps * caps)
+{
+  GstCaps *received = gst_caps_new_empty ();
+  
+  if (self->priv->receiver->shares_fd ()) {
+    for (guint i = 0; i < gst_caps_get_size (caps); i++) {
+      gst_caps_append_structure_full (received,
+          gst_structure_copy (gst_caps_get_structure (caps, i)),
+          gst_caps_features_new (GST_SPOUT_SRC_CAPS_FEATURE_MEMORY_FD, NULL));
+    }
+  }
+  
+  gst_caps_append (received, caps);
+  return received;
+}
+
+static GstCaps *
+gst_spout_src_get_caps (GstBaseSrc * src, GstCaps * filter)
+{
+  GstSpoutSrc *self = GST_SPOUT_SRC (src);
+  GstSpoutSrcPrivate *priv = self->priv;
+  GstCaps *caps = NULL;
+
+  GST_DEBUG_OBJECT (self, "get_caps");
+
+  std::unique_lock<std::mutex> lock(priv->lock);
   
-  /* If we're connected to a sender, return its caps */
-  if (priv->caps) {
-    caps = gst_caps_ref (priv->caps);
+  /* System memory backends push frames as the sender made them */
+  if (priv->receiver) {
+    caps = gst_spout_src_received_caps (self, priv->caps ?
+        gst_caps_ref (priv->caps) :
+        gst_caps_from_string (GST_VIDEO_CAPS_MAKE (GST_SPOUT_SRC_FORMATS)));
+#ifdef HAVE_SPOUT
+  } else if (priv->caps) {
+    /* If we're connected to a sender, return its caps, in D3D11 memory
+     * preferably or read back to system memory */
+    caps = gst_spout_src_d3d11_caps (priv->caps);
+    gst_caps_append (caps, gst_spout_src_sysmem_caps (priv->caps));
+#endif
   } else {
     /* Otherwise return template caps */
     caps = gst_pad_get_pad_template_caps (GST_BASE_SRC_PAD (src));
@@ -831,19 +2375,17 @@ gst_spout_src_fixate (GstBaseSrc * src, GstCaps * caps)
 
   /* If we already know dimensions from a connected Spout stream, use those */
   std::lock_guard<std::mutex> lock(priv->lock);
-  if (priv->connected && priv->spout) {
-    width = priv->spout->GetSenderWidth();
-    height = priv->spout->GetSenderHeight();
-    
-    if (width <= 0 || height <= 0) {
-      /* Try to get width/height from video info */
-      width = GST_VIDEO_INFO_WIDTH(&priv->video_info);
-      height = GST_VIDEO_INFO_HEIGHT(&priv->video_info);
-    }
+  if (priv->caps_state.has_format ()) {
+    width = priv->geometry.width;
+    height = priv->geometry.height;
   } else {
-    /* Default size if not connected yet */
-    width = 640;
-    height = 480;
+    /* Default size if not connected yet, as if a sender of that size
+     * was cropped and scaled */
+    GstSpoutGeometry geometry = gst_spout_geometry_compute (640, 480,
+        priv->geometry_request);
+    
+    width = geometry.width;
+    height = geometry.height;
   }
   
   /* Make sure we have valid dimensions */
@@ -854,9 +2396,11 @@ gst_spout_src_fixate (GstBaseSrc * src, GstCaps * caps)
 
   /* Get framerate from connected sender or use default */
   double fps = priv->current_fps;
+  gint fps_n, fps_d;
   if (fps <= 0.0 || fps > 1000.0) {
     fps = DEFAULT_FRAMERATE;
   }
+  gst_spout_snap_framerate (fps, &fps_n, &fps_d);
 
   /* For each structure in caps, fixate dimensions and framerate */
   for (guint i = 0; i < gst_caps_get_size (caps); i++) {
@@ -869,10 +2413,10 @@ gst_spout_src_fixate (GstBaseSrc * src, GstCaps * caps)
     /* Fixate framerate using the sender's fps or default */
     if (gst_structure_has_field (s, "framerate")) {
       gst_structure_fixate_field_nearest_fraction (s, "framerate", 
-                                                 (int)(fps + 0.5), 1);
+                                                 fps_n, fps_d);
     } else {
       /* Add framerate if not present */
-      gst_structure_set (s, "framerate", GST_TYPE_FRACTION, (int)(fps + 0.5), 1, NULL);
+      gst_structure_set (s, "framerate", GST_TYPE_FRACTION, fps_n, fps_d, NULL);
     }
   }
 
@@ -880,17 +2424,390 @@ gst_spout_src_fixate (GstBaseSrc * src, GstCaps * caps)
   return gst_caps_fixate (caps);
 }
 
+#ifdef HAVE_SPOUT
+/* Start our own pool with room for what we hold plus one buffer for
+ * downstream, and let it grow within pool-budget. The pool stays at the
+ * sizer's target, min and max alike, so acquiring waits once downstream
+ * holds all of it and the sizer learns about it */
+static void
+gst_spout_src_setup_pool_sizer (GstSpoutSrc * self, const GstVideoInfo * info,
+    guint size, guint * min, guint * max)
+{
+  GstSpoutSrcPrivate *priv = self->priv;
+  auto tracker = std::make_shared<GstSpoutPoolTracker> ();
+  GstClockTime frame_duration;
+  guint64 budget;
+  guint limit = MAX_POOL_BUFFERS, reserve, held;
+  
+  {
+    std::lock_guard<std::mutex> lock(priv->lock);
+    budget = priv->pool_budget;
+    /* The capture thread keeps up to two more frames in its ring */
+    reserve = priv->capture_thread ? 3 : 1;
+    /* cfr repeats its last frame and standby-mode=last-frame keeps it for
+     * outages unless converted, both the newest pushed one */
+    held = priv->cfr || (priv->standby_mode == GST_SPOUT_STANDBY_LAST_FRAME &&
+        !priv->converting) ? 1 : 0;
+  }
+  
+  if (budget > 0 && size > 0)
+    limit = (guint) MIN (budget / size, (guint64) MAX_POOL_BUFFERS);
+  
+  if (GST_VIDEO_INFO_FPS_N (info) > 0)
+    frame_duration = gst_util_uint64_scale_int (GST_SECOND,
+        GST_VIDEO_INFO_FPS_D (info), GST_VIDEO_INFO_FPS_N (info));
+  else
+    frame_duration = (GstClockTime) (GST_SECOND / DEFAULT_FRAMERATE);
+  
+  tracker->sizer.configure (MAX (*min, MIN_POOL_BUFFERS), limit, reserve,
+      held, frame_duration);
+  *min = *max = tracker->sizer.target ();
+  
+  GST_DEBUG_OBJECT (self, "Pool starts at %u buffers, up to %u", *min,
+      tracker->sizer.max ());
+  
+  std::lock_guard<std::mutex> lock(priv->lock);
+  priv->pool_tracker = std::move (tracker);
+}
+
+/* Replace our own pool by one of @target buffers. Buffers of the old one
+ * are freed once downstream gives them back */
+static void
+gst_spout_src_resize_pool (GstSpoutSrc * self, guint target)
+{
+  GstSpoutSrcPrivate *priv = self->priv;
+  GstBufferPool *pool, *old_pool;
+  GstStructure *config;
+  GstCaps *caps = NULL;
+  guint size;
+  
+  config = gst_buffer_pool_get_config (priv->pool);
+  if (!gst_buffer_pool_config_get_params (config, &caps, &size, NULL, NULL)) {
+    gst_structure_free (config);
+    return;
+  }
+  
+  gst_caps_ref (caps);
+  gst_buffer_pool_config_set_params (config, caps, size, target, target);
+  gst_caps_unref (caps);
+  
+  pool = gst_d3d11_buffer_pool_new (priv->device);
+  if (!pool || !gst_buffer_pool_set_config (pool, config) ||
+      !gst_buffer_pool_set_active (pool, TRUE)) {
+    GST_WARNING_OBJECT (self, "Failed to resize pool to %u buffers", target);
+    gst_clear_object (&pool);
+    return;
+  }
+  
+  {
+    std::lock_guard<std::mutex> lock(priv->lock);
+    old_pool = priv->pool;
+    priv->pool = pool;
+  }
+  priv->pool_size = target;
+  
+  gst_buffer_pool_set_active (old_pool, FALSE);
+  gst_object_unref (old_pool);
+  
+  GST_DEBUG_OBJECT (self, "Resized pool to %u buffers", target);
+}
+
+/* Count an acquire from our own pool and mark @buffer for measuring how
+ * long downstream holds it */
+static void
+gst_spout_src_track_buffer (const std::shared_ptr<GstSpoutPoolTracker> & tracker,
+    GstBuffer * buffer, gboolean waited)
+{
+  GstSpoutHoldMeta *meta;
+  
+  if (!tracker)
+    return;
+  
+  {
+    std::lock_guard<std::mutex> lock(tracker->lock);
+    tracker->sizer.record_acquire (waited);
+  }
+  
+  if (!gst_buffer_is_writable (buffer))
+    return;
+  
+  meta = (GstSpoutHoldMeta *) gst_buffer_add_meta (buffer,
+      gst_spout_hold_meta_get_info (), NULL);
+  if (meta)
+    meta->tracker = new std::shared_ptr<GstSpoutPoolTracker> (tracker);
+}
+
+/* Apply what the tracker learnt about downstream, streaming thread only */
+static void
+gst_spout_src_adapt_pool (GstSpoutSrc * self)
+{
+  GstSpoutSrcPrivate *priv = self->priv;
+  GstSpoutPoolTracker *tracker = priv->pool_tracker.get ();
+  gboolean changed;
+  guint target;
+  
+  if (!tracker)
+    return;
+  
+  {
+    std::lock_guard<std::mutex> lock(tracker->lock);
+    changed = tracker->sizer.update ();
+    target = tracker->sizer.target ();
+  }
+  
+  if (changed)
+    gst_spout_src_resize_pool (self, target);
+}
+
+/* Convert on the GPU if downstream picked NV12 or P010 over the sender's
+ * own format, or if the sender's frames are scaled. Before we know the
+ * sender we assume it shares BGRA at the output size */
+static gboolean
+gst_spout_src_setup_converter (GstSpoutSrc * self, const GstVideoInfo * info)
+{
+  GstSpoutSrcPrivate *priv = self->priv;
+  auto state = priv->state.load ();
+  GstVideoFormat chosen = GST_VIDEO_INFO_FORMAT (info);
+  GstVideoFormat native = chosen;
+  GstD3D11Converter *converter = NULL;
+  GstVideoInfo native_info;
+  GstSpoutGeometry geometry;
+  
+  if (state->caps) {
+    native = GST_VIDEO_INFO_FORMAT (&state->video_info);
+    geometry = state->geometry;
+  } else {
+    if (gst_spout_format_to_dxgi (chosen) == GST_SPOUT_DXGI_FORMAT_UNKNOWN)
+      native = GST_VIDEO_FORMAT_BGRA;
+    geometry = gst_spout_geometry_compute (GST_VIDEO_INFO_WIDTH (info),
+        GST_VIDEO_INFO_HEIGHT (info), GstSpoutGeometryRequest ());
+  }
+  
+  if (gst_spout_caps_output_path (gst_video_format_to_string (native),
+          gst_video_format_to_string (chosen)) == GST_SPOUT_OUTPUT_CONVERT ||
+      geometry.scaled ()) {
+    gst_video_info_set_format (&native_info, native,
+        geometry.source_width, geometry.source_height);
+    GST_VIDEO_INFO_FPS_N (&native_info) = GST_VIDEO_INFO_FPS_N (info);
+    GST_VIDEO_INFO_FPS_D (&native_info) = GST_VIDEO_INFO_FPS_D (info);
+    
+    converter = gst_d3d11_converter_new (priv->device, &native_info, info, NULL);
+    if (!converter) {
+      GST_ERROR_OBJECT (self, "Can't convert %s to %s",
+          gst_video_format_to_string (native), gst_video_format_to_string (chosen));
+      return FALSE;
+    }
+    
+    /* Only sample the cropped region */
+    g_object_set (converter, "src-x", (gint) geometry.crop.x,
+        "src-y", (gint) geometry.crop.y, "src-width", (gint) geometry.crop.width,
+        "src-height", (gint) geometry.crop.height, NULL);
+    
+    GST_INFO_OBJECT (self, "Converting %s %ux%u to %s %dx%d on the GPU",
+        gst_video_format_to_string (native), geometry.crop.width,
+        geometry.crop.height, gst_video_format_to_string (chosen),
+        GST_VIDEO_INFO_WIDTH (info), GST_VIDEO_INFO_HEIGHT (info));
+  }
+  
+  std::lock_guard<std::mutex> lock(priv->lock);
+  gst_clear_object (&priv->converter);
+  priv->converter = converter;
+  if (converter)
+    priv->convert_info = native_info;
+  priv->converting = converter != NULL;
+  
+  return TRUE;
+}
+
+/* Receive into a pool of our own and read back into buffers from
+ * downstream's pool, or a video buffer pool if downstream has none */
+static gboolean
+gst_spout_src_decide_sysmem_allocation (GstSpoutSrc * self, GstQuery * query,
+    GstCaps * caps, GstVideoInfo * info)
+{
+  GstSpoutSrcPrivate *priv = self->priv;
+  GstBufferPool *pool = NULL, *gpu_pool;
+  GstAllocator *allocator = NULL;
+  GstVideoInfo gpu_info;
+  GstCaps *gpu_caps;
+  GstStructure *config;
+  guint size, min, max, gpu_min = 2, gpu_max = 0;
+  gboolean update_pool = FALSE;
+  
+  size = GST_VIDEO_INFO_SIZE (info);
+  
+  if (gst_query_get_n_allocation_pools (query) > 0) {
+    gst_query_parse_nth_allocation_pool (query, 0, &pool, &size, &min, &max);
+    update_pool = TRUE;
+  } else {
+    min = 2;
+    max = 0;
+  }
+  
+  if (!pool) {
+    GST_DEBUG_OBJECT (self, "Creating new video buffer pool");
+    pool = gst_video_buffer_pool_new ();
+    
+    /* The readback writes every byte of every frame, huge pages spare it
+     * most TLB misses. The pool allocates its min buffers, faulting them
+     * in, when it is activated */
+    if (priv->huge_pages || priv->numa_node >= 0)
+      allocator = gst_spout_page_allocator_new (priv->huge_pages,
+          priv->numa_node);
+  } else if (priv->huge_pages || priv->numa_node >= 0) {
+    GST_INFO_OBJECT (self, "Downstream provides the buffer pool, "
+        "huge-pages and numa-node don't apply");
+  }
+  
+  config = gst_buffer_pool_get_config (pool);
+  gst_buffer_pool_config_set_params (config, caps, size, min, max);
+  
+  /* The readback honours whatever strides downstream's buffers come with */
+  if (gst_query_find_allocation_meta (query, GST_VIDEO_META_API_TYPE, NULL))
+    gst_buffer_pool_config_add_option (config, GST_BUFFER_POOL_OPTION_VIDEO_META);
+  
+  if (allocator) {
+    GstAllocationParams params;
+    
+    gst_allocation_params_init (&params);
+    gst_buffer_pool_config_set_allocator (config, allocator, &params);
+  }
+  
+  if (!gst_buffer_pool_set_config (pool, config)) {
+    GST_ERROR_OBJECT (self, "Failed to set output buffer pool config");
+    gst_clear_object (&allocator);
+    gst_object_unref (pool);
+    return FALSE;
+  }
+  
+  if (update_pool)
+    gst_query_set_nth_allocation_pool (query, 0, pool, size, min, max);
+  else
+    gst_query_add_allocation_pool (query, pool, size, min, max);
+  
+  if (priv->output_pool) {
+    gst_buffer_pool_set_active (priv->output_pool, FALSE);
+    gst_object_unref (priv->output_pool);
+  }
+  priv->output_pool = pool;
+  priv->output_info = *info;
+  
+  if (!gst_buffer_pool_set_active (priv->output_pool, TRUE)) {
+    GST_ERROR_OBJECT (self, "Failed to activate output buffer pool");
+    gst_clear_object (&allocator);
+    return FALSE;
+  }
+  
+  /* The pool's config holds on to the allocator */
+  if (allocator) {
+    GST_INFO_OBJECT (self, "Output buffers on %s pages",
+        gst_spout_page_kind_name (gst_spout_page_allocator_get_kind (allocator)));
+    gst_object_unref (allocator);
+  }
+  
+  /* The GPU side receives as it does for D3D11 output */
+  gpu_pool = gst_d3d11_buffer_pool_new (priv->device);
+  if (!gpu_pool) {
+    GST_ERROR_OBJECT (self, "Failed to create D3D11 buffer pool");
+    return FALSE;
+  }
+  
+  /* Textures are in the sender's format, whatever the readback converts to.
+   * Before we know the sender, packed output is received as is */
+  {
+    auto state = priv->state.load ();
+    GstVideoFormat gpu_format = GST_VIDEO_FORMAT_BGRA;
+    
+    if (state->caps)
+      gpu_format = GST_VIDEO_INFO_FORMAT (&state->video_info);
+    else if (gst_spout_format_to_dxgi (GST_VIDEO_INFO_FORMAT (info)) !=
+        GST_SPOUT_DXGI_FORMAT_UNKNOWN)
+      gpu_format = GST_VIDEO_INFO_FORMAT (info);
+    
+    gst_video_info_set_format (&gpu_info, gpu_format,
+        GST_VIDEO_INFO_WIDTH (info), GST_VIDEO_INFO_HEIGHT (info));
+    GST_VIDEO_INFO_FPS_N (&gpu_info) = GST_VIDEO_INFO_FPS_N (info);
+    GST_VIDEO_INFO_FPS_D (&gpu_info) = GST_VIDEO_INFO_FPS_D (info);
+  }
+  
+  /* Scaling happens on the GPU before the readback */
+  if (!gst_spout_src_setup_converter (self, &gpu_info)) {
+    gst_object_unref (gpu_pool);
+    return FALSE;
+  }
+  
+  gpu_caps = gst_video_info_to_caps (&gpu_info);
+  gst_caps_set_features (gpu_caps, 0,
+      gst_caps_features_new (GST_CAPS_FEATURE_MEMORY_D3D11_MEMORY, NULL));
+  
+  /* Textures only go as far as the readback, but the capture thread's ring
+   * and the readback latency can still starve a fixed pool. Sized like the
+   * D3D11 output pool, it grows when receiving waits for a texture */
+  gst_spout_src_setup_pool_sizer (self, &gpu_info,
+      GST_VIDEO_INFO_SIZE (&gpu_info), &gpu_min, &gpu_max);
+  priv->pool_size = gpu_min;
+  
+  config = gst_buffer_pool_get_config (gpu_pool);
+  gst_buffer_pool_config_set_params (config, gpu_caps,
+      GST_VIDEO_INFO_SIZE (&gpu_info), gpu_min, gpu_max);
+  gst_buffer_pool_config_add_option (config, GST_BUFFER_POOL_OPTION_VIDEO_META);
+  gst_caps_unref (gpu_caps);
+  
+  if (priv->converting) {
+    GstD3D11AllocationParams *params = gst_d3d11_allocation_params_new (
+        priv->device, &gpu_info, GST_D3D11_ALLOCATION_FLAG_DEFAULT,
+        D3D11_BIND_RENDER_TARGET | D3D11_BIND_SHADER_RESOURCE, 0);
+    
+    gst_buffer_pool_config_set_d3d11_allocation_params (config, params);
+    gst_d3d11_allocation_params_free (params);
+  }
+  
+  if (!gst_buffer_pool_set_config (gpu_pool, config)) {
+    GST_ERROR_OBJECT (self, "Failed to set buffer pool config");
+    gst_object_unref (gpu_pool);
+    return FALSE;
+  }
+  
+  if (priv->pool) {
+    gst_buffer_pool_set_active (priv->pool, FALSE);
+    gst_object_unref (priv->pool);
+  }
+  priv->pool = gpu_pool;
+  
+  if (!gst_buffer_pool_set_active (priv->pool, TRUE)) {
+    GST_ERROR_OBJECT (self, "Failed to activate buffer pool");
+    return FALSE;
+  }
+  
+  priv->readback.configure (priv->readback_latency);
+  priv->sysmem_output = TRUE;
+  
+  /* The streaming thread works along, the pool provides the rest */
+  {
+    std::lock_guard<std::mutex> lock(priv->lock);
+    priv->readback_threads = priv->n_threads;
+  }
+  if (priv->readback_threads == 0)
+    priv->readback_threads = MAX (std::thread::hardware_concurrency (), 1u);
+  gst_spout_src_worker_pool ().ensure (priv->readback_threads - 1);
+  
+  GST_INFO_OBJECT (self, "System memory output in %s, %u frames readback "
+      "latency, %s kernels on %u threads",
+      gst_video_format_to_string (GST_VIDEO_INFO_FORMAT (info)),
+      priv->readback.latency (), gst_spout_cpu_level_name (gst_spout_cpu_level ()),
+      priv->readback_threads);
+  
+  return TRUE;
+}
+
+#endif
+
 static gboolean
 gst_spout_src_decide_allocation (GstBaseSrc * src, GstQuery * query)
 {
   GstSpoutSrc *self = GST_SPOUT_SRC (src);
   GstSpoutSrcPrivate *priv = self->priv;
-  GstBufferPool *pool = NULL;
   GstCaps *caps;
-  GstVideoInfo info;
-  guint size, min, max;
-  gboolean update_pool = FALSE;
-  GstStructure *config;
 
   /* Get negotiated caps from the query */
   gst_query_parse_allocation (query, &caps, NULL);
@@ -898,11 +2815,60 @@ gst_spout_src_decide_allocation (GstBaseSrc * src, GstQuery * query)
     GST_ERROR_OBJECT (self, "No caps in allocation query");
     return FALSE;
   }
+  
+  /* Frames are wrapped, not received into buffers of a pool */
+  if (priv->receiver) {
+    priv->fd_output = gst_caps_features_contains (
+        gst_caps_get_features (caps, 0), GST_SPOUT_SRC_CAPS_FEATURE_MEMORY_FD);
+    return GST_BASE_SRC_CLASS (parent_class)->decide_allocation (src, query);
+  }
+
+#ifdef HAVE_SPOUT
+  return gst_spout_src_decide_texture_allocation (self, query, caps);
+#else
+  return FALSE;
+#endif
+}
+
+#ifdef HAVE_SPOUT
+/* Frames are received into textures of a pool, ours unless downstream
+ * offers one */
+static gboolean
+gst_spout_src_decide_texture_allocation (GstSpoutSrc * self, GstQuery * query,
+    GstCaps * caps)
+{
+  GstSpoutSrcPrivate *priv = self->priv;
+  GstBufferPool *pool = NULL;
+  GstVideoInfo info;
+  guint size, min, max;
+  gboolean update_pool = FALSE;
+  GstStructure *config;
 
   if (!gst_video_info_from_caps (&info, caps)) {
     GST_ERROR_OBJECT (self, "Failed to parse caps into video info");
     return FALSE;
   }
+  
+  /* Frames in flight were read back for the old caps */
+  priv->readback.reset ();
+  
+  {
+    std::lock_guard<std::mutex> lock(priv->lock);
+    priv->pool_tracker.reset ();
+  }
+  
+  if (!gst_caps_features_contains (gst_caps_get_features (caps, 0),
+          GST_CAPS_FEATURE_MEMORY_D3D11_MEMORY))
+    return gst_spout_src_decide_sysmem_allocation (self, query, caps, &info);
+  
+  priv->sysmem_output = FALSE;
+  if (priv->output_pool) {
+    gst_buffer_pool_set_active (priv->output_pool, FALSE);
+    gst_clear_object (&priv->output_pool);
+  }
+  
+  if (!gst_spout_src_setup_converter (self, &info))
+    return FALSE;
 
   /* Calculate buffer size from video dimensions */
   size = GST_VIDEO_INFO_SIZE (&info);
@@ -926,7 +2892,11 @@ gst_spout_src_decide_allocation (GstBaseSrc * src, GstQuery * query)
       GST_ERROR_OBJECT (self, "Failed to create D3D11 buffer pool");
       return FALSE;
     }
+    
+    /* Our own pool follows how long downstream holds buffers */
+    gst_spout_src_setup_pool_sizer (self, &info, size, &min, &max);
   }
+  priv->pool_size = min;
 
   /* Configure the pool */
   config = gst_buffer_pool_get_config (pool);
@@ -935,6 +2905,16 @@ gst_spout_src_decide_allocation (GstBaseSrc * src, GstQuery * query)
   /* Enable video meta for stride information */
   gst_buffer_pool_config_add_option (config, GST_BUFFER_POOL_OPTION_VIDEO_META);
   
+  /* The converter renders into our textures */
+  if (priv->converting) {
+    GstD3D11AllocationParams *params = gst_d3d11_allocation_params_new (
+        priv->device, &info, GST_D3D11_ALLOCATION_FLAG_DEFAULT,
+        D3D11_BIND_RENDER_TARGET | D3D11_BIND_SHADER_RESOURCE, 0);
+    
+    gst_buffer_pool_config_set_d3d11_allocation_params (config, params);
+    gst_d3d11_allocation_params_free (params);
+  }
+  
   /* Apply configuration */
   if (!gst_buffer_pool_set_config (pool, config)) {
     GST_ERROR_OBJECT (self, "Failed to set buffer pool config");
@@ -963,36 +2943,207 @@ gst_spout_src_decide_allocation (GstBaseSrc * src, GstQuery * query)
   return TRUE;
 }
 
-/* Helper function to copy DX texture to GStreamer buffer */
+/* Make sure we have a receiver before receiving a frame */
 static GstFlowReturn
-gst_spout_src_copy_texture_to_buffer (GstSpoutSrc * self, GstBuffer * buffer)
+gst_spout_src_prepare_receive (GstSpoutSrc * self,
+    const GstSpoutStateView & state)
 {
   GstSpoutSrcPrivate *priv = self->priv;
-  GstMemory *mem;
-  GstD3D11Memory *dmem;
-  ID3D11Texture2D *texture = NULL;
-  ID3D11DeviceContext *context = NULL;
-  gboolean was_connected = FALSE;
-  const char* sender_name = NULL;
   
-  /* Check connection state before starting */
-  {
-    std::lock_guard<std::mutex> lock(priv->lock);
-    was_connected = priv->connected && priv->spout;
-    sender_name = priv->connected_sender_name.c_str();
-    
-    GST_LOG_OBJECT (self, "Connection state: connected=%d, sender=%s, spout=%p", 
-                    priv->connected, sender_name, priv->spout);
+  GST_LOG_OBJECT (self, "Connection state: connected=%d, sender=%s", 
+                  state->connected, state->sender_name.c_str());
+  
+  /* Connecting is up to the reconnect thread */
+  if (!state->connected) {
+    GST_LOG_OBJECT (self, "Not connected, nothing to receive");
+    return GST_FLOW_ERROR;
   }
   
-  if (!was_connected) {
-    GST_INFO_OBJECT (self, "Not connected before copy attempt, trying to connect");
-    if (!gst_spout_src_connect (self)) {
-      GST_WARNING_OBJECT (self, "Failed to connect before texture copy");
-      return GST_FLOW_ERROR;
+  /* If we're forcing reconnection on each frame, do it now */
+  if (priv->force_reconnect) {
+    if (!priv->sender_name.empty()) {
+      priv->spout->SetReceiverName(priv->sender_name.c_str());
+    } else {
+      priv->spout->ReleaseReceiver();
+    }
+  }
+  
+  return GST_FLOW_OK;
+}
+
+#endif
+
+/* Receiving from the sender failed, assume it went away */
+static void
+gst_spout_src_receive_failed (GstSpoutSrc * self)
+{
+  GstSpoutSrcPrivate *priv = self->priv;
+  
+  GST_WARNING_OBJECT (self, "Failed to receive texture from Spout");
+  
+  gst_spout_src_disconnect(self);
+  
+  /* Hand over to the reconnect thread */
+  {
+    std::lock_guard<std::mutex> lock(priv->lock);
+    priv->cond.notify_all ();
+  }
+}
+
+/* gst_spout_src_fingerprint() of a frame in system memory, from the same
+ * sample points */
+static guint64
+gst_spout_src_fingerprint_memory (const guint8 * data, const GstVideoInfo * info)
+{
+  guint width = GST_VIDEO_INFO_WIDTH (info);
+  guint height = GST_VIDEO_INFO_HEIGHT (info);
+  gint stride = GST_VIDEO_INFO_PLANE_STRIDE (info, 0);
+  gint pixel = GST_VIDEO_INFO_COMP_PSTRIDE (info, 0);
+  guint64 hash = gst_spout_fingerprint_bytes (NULL, 0);
+  
+  for (guint y = 0; y < FINGERPRINT_GRID; y++) {
+    for (guint x = 0; x < FINGERPRINT_GRID; x++) {
+      guint left = (2 * x + 1) * width / (2 * FINGERPRINT_GRID);
+      guint top = (2 * y + 1) * height / (2 * FINGERPRINT_GRID);
+      
+      hash = gst_spout_fingerprint_bytes (data + (gsize) top * stride +
+          (gsize) left * pixel, pixel, hash);
+    }
+  }
+  
+  return hash;
+}
+
+/* Add a received frame to the recording, if any. @data is the frame in
+ * system memory as @info describes it, NULL for textures */
+static void
+gst_spout_src_record_frame (GstSpoutSrc * self, GstClockTime received,
+    guint64 frame, guint64 timestamp, const guint8 * data,
+    const GstVideoInfo * info)
+{
+  GstSpoutSrcPrivate *priv = self->priv;
+  guint64 fingerprint = 0;
+  
+  if (!priv->recorder.is_open ())
+    return;
+  
+  if (data && !priv->record_payloads) {
+    fingerprint = gst_spout_src_fingerprint_memory (data, info);
+    data = NULL;
+  }
+  
+  priv->recorder.frame (received, frame, timestamp, fingerprint, data,
+      data ? GST_VIDEO_INFO_SIZE (info) : 0);
+  
+  if (priv->recorder.lost ()) {
+    GST_ELEMENT_WARNING (self, RESOURCE, WRITE,
+        ("Recording to '%s' stopped, the file can't grow",
+            priv->record_location.c_str()), (NULL));
+  }
+}
+
+#ifdef HAVE_SPOUT
+/* Bookkeeping after a frame was received into @buffer */
+static void
+gst_spout_src_receive_done (GstSpoutSrc * self,
+    const GstSpoutStateView & state, GstBuffer * buffer)
+{
+  GstSpoutSrcPrivate *priv = self->priv;
+  const char* sender_name = NULL;
+  
+  /* Update last receive time */
+  GstClockTime now = gst_util_get_timestamp();
+  priv->last_receive_time = now;
+  priv->stats.received.add ();
+  
+  GST_LOG_OBJECT (self, "Successfully received texture from Spout");
+  
+  /* Carry the sender frame number (0 without frame counting) with the
+   * buffer for duplicate detection, create() replaces it by our own count.
+   * The PTS carries the receive time until create() timestamps it */
+  GST_BUFFER_OFFSET (buffer) = MAX (priv->spout->GetSenderFrame (), 0);
+  GST_BUFFER_PTS (buffer) = now;
+  
+  /* Learn when the sender's next frame is due */
+  if (priv->spout->IsFrameNew ()) {
+    priv->cadence.set_nominal_period (gst_spout_src_frame_duration (*state));
+    priv->cadence.frame (now);
+  }
+  
+  /* Follow sender updates. This may run on the capture thread, so only
+   * record format changes and leave pushing the caps to create() */
+  if (priv->spout->IsUpdated() || priv->first_frame) {
+    std::lock_guard<std::mutex> lock(priv->lock);
+    
+    /* Update connected sender name */
+    sender_name = priv->spout->GetSenderName();
+    if (sender_name) {
+      priv->connected_sender_name = sender_name;
     }
+    
+    gst_spout_src_update_format (self, priv->spout->GetSenderWidth(),
+                                 priv->spout->GetSenderHeight(),
+                                 priv->spout->GetSenderFormat(),
+                                 priv->spout->GetSenderFps());
+    
+    priv->first_frame = FALSE;
+    priv->connected = TRUE;
+    gst_spout_src_publish_state (self);
+  }
+  
+  /* Textures are recorded without content, a readback per frame would
+   * change the very timing we record */
+  gst_spout_src_record_frame (self, now, GST_BUFFER_OFFSET (buffer), 0,
+      NULL, NULL);
+}
+
+/* Frames can be the sender's texture itself, nothing reshapes them */
+static gboolean
+gst_spout_src_use_zero_copy (GstSpoutSrc * self,
+    const GstSpoutStateView & state)
+{
+  GstSpoutSrcPrivate *priv = self->priv;
+  
+  /* cfr repeats frames, which must not hold on to the sender's texture */
+  return priv->zero_copy && !priv->converting && !priv->cfr &&
+      !state->reshape;
+}
+
+/* Helper function to copy DX texture to GStreamer buffer */
+static GstFlowReturn
+gst_spout_src_copy_texture_to_buffer (GstSpoutSrc * self,
+    GstSpoutStateView & state, GstBuffer * buffer)
+{
+  GstSpoutSrcPrivate *priv = self->priv;
+  GstMemory *mem;
+  GstD3D11Memory *dmem;
+  ID3D11Texture2D *texture = NULL;
+  GstD3D11Converter *converter = NULL;
+  GstFlowReturn ret;
+  
+  GST_SPOUT_TRACE ("receive-texture");
+  
+  if (priv->converting) {
+    std::lock_guard<std::mutex> lock(priv->lock);
+    if (priv->converter)
+      converter = (GstD3D11Converter *) gst_object_ref (priv->converter);
   }
   
+  if (converter) {
+    ret = gst_spout_src_convert_shared_texture (self, state, buffer,
+        converter);
+    gst_object_unref (converter);
+    return ret;
+  }
+  
+  /* Spout copies whole textures, cropping takes the shared one */
+  if (state->reshape)
+    return gst_spout_src_crop_shared_texture (self, state, buffer);
+  
+  ret = gst_spout_src_prepare_receive (self, state);
+  if (ret != GST_FLOW_OK)
+    return ret;
+  
   /* Get D3D11 memory from the buffer */
   mem = gst_buffer_peek_memory (buffer, 0);
   if (!gst_is_d3d11_memory (mem)) {
@@ -1007,284 +3158,1967 @@ gst_spout_src_copy_texture_to_buffer (GstSpoutSrc * self, GstBuffer * buffer)
     return GST_FLOW_ERROR;
   }
   
-  /* Get the device context */
-  ID3D11Device *device = gst_d3d11_device_get_device_handle (priv->device);
-  if (!device) {
-    GST_ERROR_OBJECT (self, "Failed to get D3D11 device handle");
+  GST_LOG_OBJECT (self, "Attempting to receive texture from Spout to texture %p", texture);
+  
+  /* Use Spout to receive texture directly to our buffer's texture */
+  if (!priv->spout->ReceiveTexture(&texture)) {
+    gst_spout_src_receive_failed (self);
     return GST_FLOW_ERROR;
   }
-  device->GetImmediateContext(&context);
   
-  GST_LOG_OBJECT (self, "Attempting to receive texture from Spout to texture %p", texture);
+  gst_spout_src_receive_done (self, state, buffer);
   
-  /* If we're forcing reconnection on each frame, do it now */
-  if (priv->force_reconnect) {
-    if (!priv->sender_name.empty()) {
-      priv->spout->SetReceiverName(priv->sender_name.c_str());
-    } else {
-      priv->spout->ReleaseReceiver();
+  return GST_FLOW_OK;
+}
+
+/* Sample the sender's texture straight into @buffer in the negotiated
+ * format, the conversion is the only copy */
+static GstFlowReturn
+gst_spout_src_convert_shared_texture (GstSpoutSrc * self,
+    const GstSpoutStateView & state, GstBuffer * buffer,
+    GstD3D11Converter * converter)
+{
+  GstBuffer *shared = NULL;
+  GstFlowReturn ret;
+  
+  ret = gst_spout_src_wrap_shared_texture (self, state, &shared);
+  if (ret != GST_FLOW_OK)
+    return ret;
+  
+  if (!gst_d3d11_converter_convert_buffer (converter, shared, buffer)) {
+    GST_WARNING_OBJECT (self, "Failed to convert shared texture");
+    ret = GST_FLOW_ERROR;
+  }
+  
+  GST_BUFFER_OFFSET (buffer) = GST_BUFFER_OFFSET (shared);
+  GST_BUFFER_PTS (buffer) = GST_BUFFER_PTS (shared);
+  
+  /* The conversion is queued, let the sender write again */
+  gst_buffer_unref (shared);
+  
+  return ret;
+}
+
+/* Copy the cropped region of the sender's texture into @buffer */
+static GstFlowReturn
+gst_spout_src_crop_shared_texture (GstSpoutSrc * self,
+    GstSpoutStateView & state, GstBuffer * buffer)
+{
+  GstSpoutSrcPrivate *priv = self->priv;
+  ID3D11DeviceContext *context;
+  ID3D11Texture2D *src_texture, *texture;
+  D3D11_TEXTURE2D_DESC src_desc, desc;
+  GstMemory *src_mem, *mem;
+  GstBuffer *shared = NULL;
+  D3D11_BOX box;
+  GstFlowReturn ret;
+  
+  mem = gst_buffer_peek_memory (buffer, 0);
+  if (!gst_is_d3d11_memory (mem)) {
+    GST_ERROR_OBJECT (self, "Not a D3D11 memory");
+    return GST_FLOW_ERROR;
+  }
+  
+  ret = gst_spout_src_wrap_shared_texture (self, state, &shared);
+  if (ret != GST_FLOW_OK)
+    return ret;
+  
+  /* Receiving may just have picked up a new sender size */
+  priv->state.refresh (state);
+  const GstSpoutGeometry & geometry = state->geometry;
+  
+  src_mem = gst_buffer_peek_memory (shared, 0);
+  src_texture = (ID3D11Texture2D *) gst_d3d11_memory_get_resource_handle (
+      GST_D3D11_MEMORY_CAST (src_mem));
+  texture = (ID3D11Texture2D *) gst_d3d11_memory_get_resource_handle (
+      GST_D3D11_MEMORY_CAST (mem));
+  src_texture->GetDesc (&src_desc);
+  texture->GetDesc (&desc);
+  
+  /* Frames received before renegotiating may not fit */
+  box.left = MIN (geometry.crop.x, src_desc.Width);
+  box.top = MIN (geometry.crop.y, src_desc.Height);
+  box.right = MIN (box.left + MIN (geometry.crop.width, desc.Width), src_desc.Width);
+  box.bottom = MIN (box.top + MIN (geometry.crop.height, desc.Height), src_desc.Height);
+  box.front = 0;
+  box.back = 1;
+  
+  context = gst_d3d11_device_get_device_context_handle (priv->device);
+  gst_d3d11_device_lock (priv->device);
+  context->CopySubresourceRegion (texture,
+      gst_d3d11_memory_get_subresource_index (GST_D3D11_MEMORY_CAST (mem)),
+      0, 0, 0, src_texture, 0, &box);
+  gst_d3d11_device_unlock (priv->device);
+  
+  GST_BUFFER_OFFSET (buffer) = GST_BUFFER_OFFSET (shared);
+  GST_BUFFER_PTS (buffer) = GST_BUFFER_PTS (shared);
+  
+  /* The copy is queued, let the sender write again */
+  gst_buffer_unref (shared);
+  
+  return GST_FLOW_OK;
+}
+
+/* Destroy notify of zero-copy memory, lets the sender write again */
+static void
+gst_spout_src_release_keyed_mutex (gpointer user_data)
+{
+  IDXGIKeyedMutex *keyed_mutex = (IDXGIKeyedMutex *) user_data;
+  
+  keyed_mutex->ReleaseSync (0);
+  keyed_mutex->Release ();
+}
+
+/* Wrap the sender's shared texture in a buffer instead of copying it */
+static GstFlowReturn
+gst_spout_src_wrap_shared_texture (GstSpoutSrc * self,
+    const GstSpoutStateView & state, GstBuffer ** buffer)
+{
+  GstSpoutSrcPrivate *priv = self->priv;
+  GstAllocator *allocator;
+  GstMemory *mem;
+  ID3D11Texture2D *texture;
+  IDXGIKeyedMutex *keyed_mutex = nullptr;
+  D3D11_TEXTURE2D_DESC desc;
+  HANDLE handle;
+  GstFlowReturn ret;
+  
+  GST_SPOUT_TRACE ("wrap-texture");
+  
+  ret = gst_spout_src_prepare_receive (self, state);
+  if (ret != GST_FLOW_OK)
+    return ret;
+  
+  /* Without a destination this only checks the sender for updates */
+  if (!priv->spout->ReceiveTexture()) {
+    gst_spout_src_receive_failed (self);
+    return GST_FLOW_ERROR;
+  }
+  
+  handle = priv->spout->GetSenderHandle();
+  {
+    std::lock_guard<std::mutex> lock(priv->lock);
+    
+    if (handle != priv->shared_handle) {
+      GST_DEBUG_OBJECT (self, "Sender shares texture handle %p", handle);
+      priv->shared_handle = handle;
     }
+    
+    texture = handle ? priv->shared_textures.acquire (handle) : nullptr;
   }
   
-  /* Use Spout to receive texture directly to our buffer's texture */
-  bool spout_result = priv->spout->ReceiveTexture(&texture);
+  if (!texture) {
+    GST_WARNING_OBJECT (self, "Failed to open shared texture %p", handle);
+    return GST_FLOW_ERROR;
+  }
   
-  if (!spout_result) {
-    GST_WARNING_OBJECT (self, "Failed to receive texture from Spout");
-    if (context) context->Release();
+  /* Hold the sender off while downstream reads the texture, if it shares
+   * with a keyed mutex. Plain shared textures offer no such protection */
+  if (SUCCEEDED (texture->QueryInterface (IID_PPV_ARGS (&keyed_mutex)))) {
+    HRESULT hr = keyed_mutex->AcquireSync (0, priv->wait_timeout);
     
-    /* Try to reconnect if connection was lost */
-    {
-      std::lock_guard<std::mutex> lock(priv->lock);
+    if (hr != S_OK) {
+      keyed_mutex->Release ();
+      texture->Release ();
+      
+      if (hr == WAIT_TIMEOUT) {
+        GST_LOG_OBJECT (self, "Sender is holding the shared texture");
+        return GST_SPOUT_SRC_FLOW_BUSY;
+      }
       
-      GST_WARNING_OBJECT (self, "Lost connection to Spout sender '%s', attempting to reconnect",
-                          priv->connected_sender_name.c_str());
-      priv->connected = FALSE;
+      GST_WARNING_OBJECT (self, "Failed to acquire the shared texture: 0x%x",
+          (guint) hr);
+      return GST_FLOW_ERROR;
+    }
+  }
+  
+  /* All supported formats are 4 bytes per pixel */
+  texture->GetDesc (&desc);
+  
+  allocator = gst_allocator_find (GST_D3D11_MEMORY_NAME);
+  mem = gst_d3d11_allocator_alloc_wrapped (GST_D3D11_ALLOCATOR (allocator),
+      priv->device, texture, (gsize) desc.Width * desc.Height * 4,
+      keyed_mutex, keyed_mutex ? gst_spout_src_release_keyed_mutex : NULL);
+  gst_clear_object (&allocator);
+  
+  /* The memory holds its own reference */
+  texture->Release ();
+  
+  if (!mem) {
+    GST_ERROR_OBJECT (self, "Failed to wrap shared texture");
+    if (keyed_mutex)
+      gst_spout_src_release_keyed_mutex (keyed_mutex);
+    return GST_FLOW_ERROR;
+  }
+  
+  *buffer = gst_buffer_new ();
+  gst_buffer_append_memory (*buffer, mem);
+  
+  gst_spout_src_receive_done (self, state, *buffer);
+  
+  return GST_FLOW_OK;
+}
+
+#endif
+
+/* Ask the sender monitor whether a full connect is worth attempting, so
+ * idle sources don't open the receiver on each wakeup */
+static gboolean
+gst_spout_src_sender_available (GstSpoutSrc * self)
+{
+  GstSpoutSrcPrivate *priv = self->priv;
+  std::string sender_name;
+  
+  {
+    std::lock_guard<std::mutex> lock(priv->lock);
+    sender_name = priv->sender_name;
+    
+    if (priv->receiver)
+      return priv->receiver->available (sender_name);
+  }
+  
+#ifdef HAVE_SPOUT
+  return gst_spout_sender_monitor_get ().has_sender (sender_name);
+#else
+  return FALSE;
+#endif
+}
+
+#ifdef HAVE_SPOUT
+/* Sender monitor callback, wakes the reconnect thread */
+static void
+gst_spout_src_senders_changed (GstSpoutSrc * self, const GstSpoutSenderDiff & diff)
+{
+  GstSpoutSrcPrivate *priv = self->priv;
+  std::lock_guard<std::mutex> lock(priv->lock);
+  
+  GST_LOG_OBJECT (self, "Senders changed: %" G_GSIZE_FORMAT " added, %"
+      G_GSIZE_FORMAT " removed", diff.added.size (), diff.removed.size ());
+  
+  priv->senders_generation++;
+  priv->cond.notify_all ();
+}
+#endif
+
+/* Park the streaming thread for up to @timeout. unlock() and the reconnect
+ * thread (dis)connecting wake it up immediately, as does a state published
+ * since @state, the one the caller decided to wait on, even if that was
+ * before we got here; returns FALSE if we are flushing */
+static gboolean
+gst_spout_src_wait_for (GstSpoutSrc * self, const GstSpoutStateView & state,
+    std::chrono::microseconds timeout)
+{
+  GstSpoutSrcPrivate *priv = self->priv;
+  std::unique_lock<std::mutex> lock(priv->lock);
+  
+  priv->cond.wait_for (lock, timeout,
+      [priv, &state] {
+        return priv->flushing || priv->state.changed (state);
+      });
+  
+  return !priv->flushing;
+}
+
+static gboolean
+gst_spout_src_wait (GstSpoutSrc * self, const GstSpoutStateView & state,
+    guint timeout_ms)
+{
+  return gst_spout_src_wait_for (self, state,
+      std::chrono::milliseconds (timeout_ms));
+}
+
+/* Park the streaming thread until the sender's next frame is due */
+static gboolean
+gst_spout_src_wait_for_frame (GstSpoutSrc * self,
+    const GstSpoutStateView & state)
+{
+  GstClockTime delay =
+      self->priv->cadence.next_poll (gst_util_get_timestamp ());
+  
+  return gst_spout_src_wait_for (self, state,
+      std::chrono::microseconds (GST_TIME_AS_USECONDS (delay)));
+}
+
+/* Keeps (re)connecting while we are disconnected, backing off between
+ * failed attempts, so the streaming thread never blocks on a connect */
+static void
+gst_spout_src_reconnect_loop (GstSpoutSrc * self)
+{
+  GstSpoutSrcPrivate *priv = self->priv;
+  std::unique_lock<std::mutex> lock(priv->lock);
+  guint64 generation = priv->senders_generation;
+  
+  while (!priv->reconnect_stopping) {
+    if (priv->connected || priv->backoff.given_up ()) {
+      priv->cond.wait (lock, [priv] {
+        return priv->reconnect_stopping || !priv->connected;
+      });
+      continue;
     }
     
-    gst_spout_src_disconnect(self);
-    gst_spout_src_connect(self);
+    /* A sender appeared or went away, worth trying right now */
+    if (generation != priv->senders_generation) {
+      generation = priv->senders_generation;
+      priv->backoff.expedite (GstSpoutBackoff::Clock::now ());
+    }
     
-    return GST_FLOW_ERROR;
+    if (!priv->backoff.due (GstSpoutBackoff::Clock::now ())) {
+      priv->cond.wait_until (lock, priv->backoff.next_attempt (),
+          [priv, generation] {
+            return priv->reconnect_stopping || priv->connected ||
+                priv->senders_generation != generation;
+          });
+      continue;
+    }
+    
+    lock.unlock();
+    
+    if (gst_spout_src_sender_available (self)) {
+#ifdef HAVE_SPOUT
+      /* Connecting receives a texture, which needs the device context */
+      if (priv->device)
+        gst_d3d11_device_lock (priv->device);
+      gst_spout_src_connect (self);
+      if (priv->device)
+        gst_d3d11_device_unlock (priv->device);
+#else
+      gst_spout_src_connect (self);
+#endif
+    }
+    
+    lock.lock();
+    
+    if (priv->connected) {
+      GST_INFO_OBJECT (self, "Connected to '%s' after %u failed attempts",
+                       priv->connected_sender_name.c_str(), priv->backoff.attempts ());
+      priv->stats.connects.add ();
+      priv->backoff.reset ();
+      priv->cond.notify_all ();
+    } else if (!priv->backoff.failed (GstSpoutBackoff::Clock::now ())) {
+      GST_WARNING_OBJECT (self, "Giving up reconnecting after %u attempts",
+                          priv->backoff.attempts ());
+      priv->reconnect_given_up = true;
+      priv->cond.notify_all ();
+    }
   }
+}
+
+static void
+gst_spout_src_start_reconnect (GstSpoutSrc * self)
+{
+  GstSpoutSrcPrivate *priv = self->priv;
+  GstSpoutBackoff::Config config;
+  
+  config.initial = GstSpoutBackoff::Duration (RECONNECT_BACKOFF_MIN);
+  config.max = GstSpoutBackoff::Duration (RECONNECT_BACKOFF_MAX);
+  config.policy = priv->reconnect_give_up;
+  config.max_attempts = priv->reconnect_max_attempts;
+  config.max_duration = GstSpoutBackoff::Duration (priv->reconnect_timeout);
+  
+  /* Spread retries of sources started together */
+  priv->backoff.configure (config);
+  priv->backoff.seed ((guint64) g_get_monotonic_time () ^ GPOINTER_TO_SIZE (self));
+  priv->reconnect_given_up = false;
+  priv->reconnect_stopping = FALSE;
+  
+  priv->reconnect_thread = std::thread (gst_spout_src_reconnect_loop, self);
+}
+
+static void
+gst_spout_src_stop_reconnect (GstSpoutSrc * self)
+{
+  GstSpoutSrcPrivate *priv = self->priv;
+  
+  if (!priv->reconnect_thread.joinable ())
+    return;
+  
+  {
+    std::lock_guard<std::mutex> lock(priv->lock);
+    priv->reconnect_stopping = TRUE;
+    priv->cond.notify_all ();
+  }
+  
+  priv->reconnect_thread.join ();
+}
+
+#ifdef HAVE_SPOUT
+/* A buffer around a new render target texture for frames of @format */
+static GstBuffer *
+gst_spout_src_new_target_buffer (GstD3D11Device * device,
+    const GstSpoutSenderFormat & format, ID3D11Texture2D ** texture)
+{
+  ID3D11Device *device_handle = gst_d3d11_device_get_device_handle (device);
+  D3D11_TEXTURE2D_DESC desc = { };
+  GstAllocator *allocator;
+  GstMemory *mem;
+  GstBuffer *buffer;
+  HRESULT hr;
+  
+  desc.Width = format.width;
+  desc.Height = format.height;
+  desc.MipLevels = 1;
+  desc.ArraySize = 1;
+  desc.Format = (DXGI_FORMAT) format.format;
+  desc.SampleDesc.Count = 1;
+  desc.Usage = D3D11_USAGE_DEFAULT;
+  desc.BindFlags = D3D11_BIND_RENDER_TARGET | D3D11_BIND_SHADER_RESOURCE;
+  
+  hr = device_handle->CreateTexture2D (&desc, nullptr, texture);
+  if (FAILED (hr)) {
+    GST_WARNING_OBJECT (device, "Failed to create %ux%u texture, hr 0x%x",
+        format.width, format.height, (guint) hr);
+    return NULL;
+  }
+  
+  /* All supported formats are 4 bytes per pixel */
+  allocator = gst_allocator_find (GST_D3D11_MEMORY_NAME);
+  mem = gst_d3d11_allocator_alloc_wrapped (GST_D3D11_ALLOCATOR (allocator),
+      device, *texture, (gsize) format.width * format.height * 4, NULL, NULL);
+  gst_clear_object (&allocator);
+  
+  if (!mem) {
+    (*texture)->Release ();
+    *texture = nullptr;
+    return NULL;
+  }
+  
+  /* The memory holds its own reference, ours stays valid as long as it */
+  (*texture)->Release ();
+  
+  buffer = gst_buffer_new ();
+  gst_buffer_append_memory (buffer, mem);
+  
+  return buffer;
+}
+
+GstBuffer *
+GstSpoutD3D11StandbyBackend::render (const GstSpoutSenderFormat & format,
+    GstSpoutStandbyMode mode, uint32_t argb)
+{
+  ID3D11Device *device_handle = gst_d3d11_device_get_device_handle (device);
+  ID3D11DeviceContext *context = gst_d3d11_device_get_device_context_handle (device);
+  ID3D11DeviceContext1 *context1 = nullptr;
+  ID3D11RenderTargetView *rtv = nullptr;
+  ID3D11Texture2D *texture = nullptr;
+  GstBuffer *buffer;
+  HRESULT hr;
+  
+  buffer = gst_spout_src_new_target_buffer (device, format, &texture);
+  if (!buffer)
+    return NULL;
+  
+  hr = device_handle->CreateRenderTargetView (texture, nullptr, &rtv);
+  if (FAILED (hr)) {
+    GST_WARNING_OBJECT (device, "Failed to create render target view, hr 0x%x",
+        (guint) hr);
+    gst_buffer_unref (buffer);
+    return NULL;
+  }
+  
+  if (mode == GST_SPOUT_STANDBY_BLACK)
+    argb = 0xff000000;
+  
+  gst_d3d11_device_lock (device);
+  
+  /* Bars need rectangle clears from D3D11.1, otherwise fall back to black */
+  if (mode == GST_SPOUT_STANDBY_PATTERN &&
+      SUCCEEDED (context->QueryInterface (IID_PPV_ARGS (&context1)))) {
+    for (guint bar = 0; bar < GST_SPOUT_STANDBY_BARS; bar++) {
+      guint32 color = gst_spout_standby_bar_color (bar);
+      FLOAT rgba[4] = {
+        ((color >> 16) & 0xff) / 255.0f, ((color >> 8) & 0xff) / 255.0f,
+        (color & 0xff) / 255.0f, ((color >> 24) & 0xff) / 255.0f,
+      };
+      uint32_t left, right;
+      D3D11_RECT rect;
+      
+      gst_spout_standby_bar_bounds (format.width, bar, &left, &right);
+      rect.left = left;
+      rect.right = right;
+      rect.top = 0;
+      rect.bottom = format.height;
+      
+      context1->ClearView (rtv, rgba, &rect, 1);
+    }
+    context1->Release ();
+  } else {
+    if (mode == GST_SPOUT_STANDBY_PATTERN)
+      argb = 0xff000000;
+    
+    FLOAT rgba[4] = {
+      ((argb >> 16) & 0xff) / 255.0f, ((argb >> 8) & 0xff) / 255.0f,
+      (argb & 0xff) / 255.0f, ((argb >> 24) & 0xff) / 255.0f,
+    };
+    
+    context->ClearRenderTargetView (rtv, rgba);
+  }
+  
+  gst_d3d11_device_unlock (device);
+  rtv->Release ();
+  
+  return buffer;
+}
+
+GstBuffer *
+GstSpoutD3D11StandbyBackend::copy (GstBuffer * frame,
+    const GstSpoutSenderFormat & format)
+{
+  ID3D11DeviceContext *context = gst_d3d11_device_get_device_context_handle (device);
+  GstMemory *mem = gst_buffer_peek_memory (frame, 0);
+  ID3D11Texture2D *src_texture, *texture = nullptr;
+  D3D11_TEXTURE2D_DESC desc;
+  GstD3D11Memory *dmem;
+  GstBuffer *buffer;
+  
+  if (!gst_is_d3d11_memory (mem))
+    return NULL;
+  
+  dmem = GST_D3D11_MEMORY_CAST (mem);
+  src_texture = (ID3D11Texture2D *) gst_d3d11_memory_get_resource_handle (dmem);
+  src_texture->GetDesc (&desc);
+  
+  if (desc.Width != format.width || desc.Height != format.height ||
+      desc.Format != (DXGI_FORMAT) format.format)
+    return NULL;
+  
+  buffer = gst_spout_src_new_target_buffer (device, format, &texture);
+  if (!buffer)
+    return NULL;
+  
+  gst_d3d11_device_lock (device);
+  context->CopySubresourceRegion (texture, 0, 0, 0, 0, src_texture,
+      gst_d3d11_memory_get_subresource_index (dmem), nullptr);
+  gst_d3d11_device_unlock (device);
+  
+  return buffer;
+}
+
+/* Format of the frames going into our pool or converter: the last
+ * sender's at the output size, or what the pool was configured with if we
+ * never had a sender */
+static gboolean
+gst_spout_src_output_format (GstSpoutSrc * self,
+    const GstSpoutStateView & state, GstSpoutSenderFormat * format)
+{
+  GstSpoutSrcPrivate *priv = self->priv;
+  GstVideoInfo info;
+  
+  if (priv->converting) {
+    std::lock_guard<std::mutex> lock(priv->lock);
+    info = priv->convert_info;
+  } else if (state->caps) {
+    info = state->video_info;
+    GST_VIDEO_INFO_WIDTH (&info) = state->geometry.width;
+    GST_VIDEO_INFO_HEIGHT (&info) = state->geometry.height;
+  } else {
+    GstStructure *config = gst_buffer_pool_get_config (priv->pool);
+    GstCaps *caps = NULL;
+    gboolean ret;
+    
+    ret = gst_buffer_pool_config_get_params (config, &caps, NULL, NULL, NULL) &&
+        caps && gst_video_info_from_caps (&info, caps);
+    gst_structure_free (config);
+    
+    if (!ret)
+      return FALSE;
+  }
+  
+  format->width = GST_VIDEO_INFO_WIDTH (&info);
+  format->height = GST_VIDEO_INFO_HEIGHT (&info);
+  format->format = gst_spout_format_to_dxgi (GST_VIDEO_INFO_FORMAT (&info));
+  format->fps = state->fps;
+  
+  return format->format != GST_SPOUT_DXGI_FORMAT_UNKNOWN && format->width && format->height;
+}
+
+/* Provide a standby frame while no sender is available. It is rendered on
+ * the GPU once and then pushed again as a shallow copy, never mapped */
+static GstFlowReturn
+gst_spout_src_create_standby (GstSpoutSrc * self,
+    const GstSpoutStateView & state, GstBuffer ** buf)
+{
+  GstSpoutSrcPrivate *priv = self->priv;
+  GstSpoutSenderFormat format;
+  GstClock *clock;
+  GstClockTime base_time, clock_time, timestamp;
+  GstBuffer *frame, *buffer;
+
+  GST_SPOUT_TRACE ("standby");
+
+  if (!priv->pool) {
+    GST_DEBUG_OBJECT (self, "No buffer pool available yet, deferring");
+    return GST_FLOW_OK;  // Try again next time
+  }
+  
+  if (!gst_spout_src_output_format (self, state, &format)) {
+    GST_WARNING_OBJECT (self, "Don't know the output format yet, deferring");
+    return GST_FLOW_OK;  // Try again next time
+  }
+  
+  priv->standby.configure (priv->standby_mode, priv->standby_color);
+  frame = priv->standby.get (format);
+  if (!frame) {
+    GST_WARNING_OBJECT (self, "Failed to render standby frame");
+    return GST_FLOW_OK;  // Try again next time
+  }
+  
+  /* Shares the texture, only the metadata is our own */
+  buffer = gst_buffer_copy (frame);
+  gst_buffer_unref (frame);
+  
+  /* Standby frames are rendered in the sender's format */
+  if (priv->converting) {
+    GstD3D11Converter *converter = NULL;
+    GstBuffer *converted = NULL;
+    
+    {
+      std::lock_guard<std::mutex> lock(priv->lock);
+      if (priv->converter)
+        converter = (GstD3D11Converter *) gst_object_ref (priv->converter);
+    }
+    
+    if (converter &&
+        gst_buffer_pool_acquire_buffer (priv->pool, &converted, NULL) == GST_FLOW_OK &&
+        !gst_d3d11_converter_convert_buffer (converter, buffer, converted))
+      gst_clear_buffer (&converted);
+    
+    gst_clear_object (&converter);
+    gst_buffer_unref (buffer);
+    
+    if (!converted) {
+      GST_WARNING_OBJECT (self, "Failed to convert standby frame");
+      return GST_FLOW_OK;  // Try again next time
+    }
+    buffer = converted;
+  }
+  
+  /* Set timestamps for the dummy buffer */
+  clock = gst_element_get_clock(GST_ELEMENT_CAST(self));
+  if (clock) {
+    clock_time = gst_clock_get_time(clock);
+    base_time = GST_ELEMENT_CAST(self)->base_time;
+    gst_object_unref(clock);
+    
+    if (clock_time > base_time)
+      timestamp = clock_time - base_time;
+    else
+      timestamp = 0;
+      
+    GST_BUFFER_TIMESTAMP(buffer) = timestamp;
+    
+    /* One frame at the negotiated rate */
+    GST_BUFFER_DURATION(buffer) = gst_spout_src_frame_duration (*state);
+  }
+  
+  priv->stats.standby.add ();
+  
+  *buf = buffer;
+  return GST_FLOW_OK;
+}
+
+/* Receives sender frames into pool buffers on the capture thread. While the
+ * thread runs it is the only user of the Spout receiver */
+class GstSpoutD3D11FrameSource : public GstSpoutFrameSource<GstBuffer *>
+{
+public:
+  explicit GstSpoutD3D11FrameSource (GstSpoutSrc * self) : self_ (self) {}
+
+  bool acquire (GstBuffer *& buffer) override
+  {
+    GstSpoutSrcPrivate *priv = self_->priv;
+    
+    gst_spout_src_name_trace_thread (self_, "capture");
+    GstBufferPool *pool = NULL;
+    GstBufferPoolAcquireParams params = { };
+    std::shared_ptr<GstSpoutPoolTracker> tracker;
+    GstFlowReturn ret;
+
+    {
+      std::lock_guard<std::mutex> lock(priv->lock);
+      if (priv->pool)
+        pool = (GstBufferPool *) gst_object_ref (priv->pool);
+      tracker = priv->pool_tracker;
+    }
+
+    if (!pool)
+      return false;
+
+    /* Zero-copy buffers are created by receive() */
+    priv->state.refresh (state_);
+    if (gst_spout_src_use_zero_copy (self_, state_)) {
+      buffer = NULL;
+      gst_object_unref (pool);
+      return true;
+    }
+
+    /* Never block here, downstream may be holding every buffer. Count
+     * that as a wait once, not on every retry */
+    params.flags = GST_BUFFER_POOL_ACQUIRE_FLAG_DONTWAIT;
+    GstClockTime start = gst_util_get_timestamp ();
+    GST_SPOUT_TRACE ("pool-acquire");
+    ret = gst_buffer_pool_acquire_buffer (pool, &buffer, &params);
+    priv->stats.acquire_time.record (gst_util_get_timestamp () - start);
+    gst_object_unref (pool);
+
+    if (ret != GST_FLOW_OK) {
+      starved_ = true;
+      return false;
+    }
+
+    gst_spout_src_track_buffer (tracker, buffer, starved_);
+    starved_ = false;
+
+    return true;
+  }
+
+  GstSpoutReceiveResult receive (GstBuffer *& buffer) override
+  {
+    GstSpoutSrcPrivate *priv = self_->priv;
+    GstFlowReturn ret;
+    bool is_new = true;
+    bool frame_counted = false;
+
+    /* Senders without frame counting report every receive as a new frame,
+     * so pace those to their advertised rate instead of copying flat out */
+    if (next_receive_ > std::chrono::steady_clock::now ())
+      std::this_thread::sleep_until (next_receive_);
+
+    GstClockTime start = gst_util_get_timestamp ();
+    priv->state.refresh (state_);
+    gst_d3d11_device_lock (priv->device);
+    if (gst_spout_src_use_zero_copy (self_, state_)) {
+      gst_clear_buffer (&buffer);
+      ret = gst_spout_src_wrap_shared_texture (self_, state_, &buffer);
+    } else {
+      ret = gst_spout_src_copy_texture_to_buffer (self_, state_, buffer);
+    }
+    if (ret == GST_FLOW_OK && priv->spout) {
+      frame_counted = priv->spout->GetSenderFrame () > 0;
+      is_new = priv->spout->IsFrameNew ();
+    }
+    gst_d3d11_device_unlock (priv->device);
+    priv->stats.copy_time.record (gst_util_get_timestamp () - start);
+
+    /* The sender is busy with the texture, it's still there */
+    if (ret == GST_SPOUT_SRC_FLOW_BUSY)
+      return GstSpoutReceiveResult::NO_FRAME;
+    if (ret != GST_FLOW_OK)
+      return GstSpoutReceiveResult::ERROR;
+
+    if (!frame_counted) {
+      next_receive_ = std::chrono::steady_clock::now () +
+          std::chrono::nanoseconds (gst_spout_src_frame_duration (*state_));
+    }
+
+    return is_new ? GstSpoutReceiveResult::FRAME : GstSpoutReceiveResult::NO_FRAME;
+  }
+
+  void release (GstBuffer *& buffer) override
+  {
+    gst_clear_buffer (&buffer);
+  }
+
+  /* Sleep until the sender's next frame is due instead of polling */
+  Duration idle (Duration poll_interval) override
+  {
+    GstClockTime delay =
+        self_->priv->cadence.next_poll (gst_util_get_timestamp ());
+
+    return Duration (GST_TIME_AS_USECONDS (delay));
+  }
+
+private:
+  GstSpoutSrc *self_;
+  GstSpoutStateView state_;   /* the capture thread's, refreshed per frame */
+  std::chrono::steady_clock::time_point next_receive_;
+  bool starved_ = false;    /* the last acquire found no free buffer */
+};
+
+static void
+gst_spout_src_start_capture (GstSpoutSrc * self)
+{
+  GstSpoutSrcPrivate *priv = self->priv;
+  guint retry_ms = MAX (priv->wait_timeout, 1);
+
+  GST_DEBUG_OBJECT (self, "Starting capture thread");
+
+  priv->capture_source = new GstSpoutD3D11FrameSource (self);
+  priv->capture_dropped = 0;
+  priv->capture.start (priv->capture_source,
+      std::chrono::milliseconds (NEW_FRAME_POLL_INTERVAL),
+      std::chrono::milliseconds (retry_ms));
+}
+
+static void
+gst_spout_src_stop_capture (GstSpoutSrc * self)
+{
+  GstSpoutSrcPrivate *priv = self->priv;
+
+  if (!priv->capture.running ())
+    return;
+
+  priv->capture.stop ();
+
+  GST_INFO_OBJECT (self, "Capture thread stopped: %" G_GUINT64_FORMAT
+      " frames received, %" G_GUINT64_FORMAT " pushed, %" G_GUINT64_FORMAT
+      " dropped", priv->capture.frames_received (),
+      priv->capture.frames_consumed (), priv->capture.frames_dropped ());
+
+  delete priv->capture_source;
+  priv->capture_source = nullptr;
+}
+
+/* Wait for the newest frame from the capture thread. Returns with a NULL
+ * buffer if the sender went away, so the caller can fall back to standby */
+static GstFlowReturn
+gst_spout_src_pop_captured (GstSpoutSrc * self, GstSpoutStateView & state,
+    GstBuffer ** buffer)
+{
+  GstSpoutSrcPrivate *priv = self->priv;
+  guint64 dropped;
+
+  GST_SPOUT_TRACE ("capture-wait");
+
+  *buffer = NULL;
+
+  while (!priv->capture.pop_latest (*buffer,
+          std::chrono::milliseconds (priv->wait_timeout))) {
+    if (priv->flushing)
+      return GST_FLOW_FLUSHING;
+    priv->state.refresh (state);
+    if (!state->connected)
+      return GST_FLOW_OK;
+  }
+
+  dropped = priv->capture.frames_dropped ();
+  if (dropped != priv->capture_dropped) {
+    GST_LOG_OBJECT (self, "Dropped %" G_GUINT64_FORMAT " stale frames",
+        dropped - priv->capture_dropped);
+    priv->stats.dropped.add (dropped - priv->capture_dropped);
+    priv->capture_dropped = dropped;
+  }
+
+  return GST_FLOW_OK;
+}
+
+/* Get the next frame, either from the capture thread or by receiving into a
+ * pool buffer right here. Returns GST_SPOUT_SRC_FLOW_BUSY without a buffer
+ * while the sender holds the shared texture, and a NULL buffer if no frame
+ * could be received for other reasons */
+static GstFlowReturn
+gst_spout_src_receive_frame (GstSpoutSrc * self, GstSpoutStateView & state,
+    GstBuffer ** buffer)
+{
+  GstSpoutSrcPrivate *priv = self->priv;
+  GstFlowReturn ret;
+  
+  *buffer = NULL;
+  
+  if (priv->capture.running ()) {
+    /* Take the newest frame the capture thread completed */
+    return gst_spout_src_pop_captured (self, state, buffer);
+  }
+  
+  /* Converting and cropping already read the shared texture */
+  if (gst_spout_src_use_zero_copy (self, state)) {
+    GstClockTime start = gst_util_get_timestamp ();
+    
+    ret = gst_spout_src_wrap_shared_texture (self, state, buffer);
+    priv->stats.copy_time.record (gst_util_get_timestamp () - start);
+    if (ret == GST_SPOUT_SRC_FLOW_BUSY)
+      return ret;
+    if (ret != GST_FLOW_OK)
+      GST_WARNING_OBJECT (self, "Failed to wrap shared texture");
+    
+    return GST_FLOW_OK;
+  }
+  
+  /* We may have been parked before downstream negotiated a pool */
+  if (!priv->pool && !gst_base_src_negotiate (GST_BASE_SRC (self))) {
+    GST_ERROR_OBJECT (self, "Failed to negotiate with downstream");
+    return GST_FLOW_NOT_NEGOTIATED;
+  }
+  
+  /* Get a buffer from our pool, noting whether downstream made us wait */
+  GstBufferPoolAcquireParams params = { };
+  gboolean waited = FALSE;
+  GstClockTime start = gst_util_get_timestamp ();
+  GstSpoutTraceScope acquire_trace ("pool-acquire");
+  
+  params.flags = GST_BUFFER_POOL_ACQUIRE_FLAG_DONTWAIT;
+  ret = gst_buffer_pool_acquire_buffer(priv->pool, buffer, &params);
+  if (ret == GST_FLOW_EOS) {
+    waited = TRUE;
+    ret = gst_buffer_pool_acquire_buffer(priv->pool, buffer, NULL);
+  }
+  acquire_trace.end ();
+  priv->stats.acquire_time.record (gst_util_get_timestamp () - start);
+  if (ret != GST_FLOW_OK) {
+    GST_ERROR_OBJECT (self, "Failed to acquire buffer from pool: %s",
+        gst_flow_get_name (ret));
+    return ret;
+  }
+  
+  gst_spout_src_track_buffer (priv->pool_tracker, *buffer, waited);
+  
+  /* Receive texture from Spout */
+  start = gst_util_get_timestamp ();
+  ret = gst_spout_src_copy_texture_to_buffer (self, state, *buffer);
+  priv->stats.copy_time.record (gst_util_get_timestamp () - start);
+  if (ret == GST_SPOUT_SRC_FLOW_BUSY) {
+    gst_clear_buffer(buffer);
+    return ret;
+  }
+  if (ret != GST_FLOW_OK) {
+    gst_clear_buffer(buffer);
+    GST_WARNING_OBJECT (self, "Failed to copy texture to buffer");
+    
+    /* Not a fatal error - we'll retry on the next frame */
+  }
+  
+  return GST_FLOW_OK;
+}
+
+/* Content fingerprint for senders without frame counting. Copies a sparse
+ * grid of pixels into a tiny staging texture and hashes them, so the map only
+ * waits for a few pixels instead of a full readback. Changes that fall
+ * between the sample points go unnoticed */
+static gboolean
+gst_spout_src_fingerprint (GstSpoutSrc * self, GstBuffer * buffer,
+    guint64 * fingerprint)
+{
+  GstSpoutSrcPrivate *priv = self->priv;
+  GstMemory *mem = gst_buffer_peek_memory (buffer, 0);
+  GstD3D11Memory *dmem;
+  ID3D11Texture2D *texture;
+  ID3D11Device *device;
+  ID3D11DeviceContext *context;
+  D3D11_TEXTURE2D_DESC desc;
+  D3D11_MAPPED_SUBRESOURCE map;
+  guint subresource;
+  HRESULT hr;
+  
+  if (!gst_is_d3d11_memory (mem))
+    return FALSE;
+  
+  dmem = GST_D3D11_MEMORY_CAST (mem);
+  texture = (ID3D11Texture2D *) gst_d3d11_memory_get_resource_handle (dmem);
+  subresource = gst_d3d11_memory_get_subresource_index (dmem);
+  texture->GetDesc (&desc);
+  
+  /* Converted YUV frames can't be sampled one texel at a time */
+  if (desc.Format == DXGI_FORMAT_NV12 || desc.Format == DXGI_FORMAT_P010)
+    return FALSE;
+  
+  device = gst_d3d11_device_get_device_handle (priv->device);
+  context = gst_d3d11_device_get_device_context_handle (priv->device);
+  
+  if (priv->fingerprint_staging) {
+    D3D11_TEXTURE2D_DESC staging_desc;
+    priv->fingerprint_staging->GetDesc (&staging_desc);
+    
+    if (staging_desc.Format != desc.Format) {
+      priv->fingerprint_staging->Release ();
+      priv->fingerprint_staging = nullptr;
+    }
+  }
+  
+  if (!priv->fingerprint_staging) {
+    D3D11_TEXTURE2D_DESC staging_desc = { };
+    
+    staging_desc.Width = FINGERPRINT_GRID * FINGERPRINT_GRID;
+    staging_desc.Height = 1;
+    staging_desc.MipLevels = 1;
+    staging_desc.ArraySize = 1;
+    staging_desc.Format = desc.Format;
+    staging_desc.SampleDesc.Count = 1;
+    staging_desc.Usage = D3D11_USAGE_STAGING;
+    staging_desc.CPUAccessFlags = D3D11_CPU_ACCESS_READ;
+    
+    hr = device->CreateTexture2D (&staging_desc, nullptr,
+        &priv->fingerprint_staging);
+    if (FAILED (hr)) {
+      GST_WARNING_OBJECT (self, "Failed to create fingerprint texture, hr 0x%x",
+          (guint) hr);
+      return FALSE;
+    }
+  }
+  
+  gst_d3d11_device_lock (priv->device);
+  
+  for (guint y = 0; y < FINGERPRINT_GRID; y++) {
+    for (guint x = 0; x < FINGERPRINT_GRID; x++) {
+      D3D11_BOX box;
+      
+      box.left = (2 * x + 1) * desc.Width / (2 * FINGERPRINT_GRID);
+      box.top = (2 * y + 1) * desc.Height / (2 * FINGERPRINT_GRID);
+      box.front = 0;
+      box.right = box.left + 1;
+      box.bottom = box.top + 1;
+      box.back = 1;
+      
+      context->CopySubresourceRegion (priv->fingerprint_staging, 0,
+          y * FINGERPRINT_GRID + x, 0, 0, texture, subresource, &box);
+    }
+  }
+  
+  /* All supported formats are 4 bytes per pixel */
+  hr = context->Map (priv->fingerprint_staging, 0, D3D11_MAP_READ, 0, &map);
+  if (SUCCEEDED (hr)) {
+    *fingerprint = gst_spout_fingerprint_bytes ((const guint8 *) map.pData,
+        FINGERPRINT_GRID * FINGERPRINT_GRID * 4);
+    context->Unmap (priv->fingerprint_staging, 0);
+  }
+  
+  gst_d3d11_device_unlock (priv->device);
+  
+  return SUCCEEDED (hr);
+}
+
+/* Apply duplicate-policy to a received frame */
+static GstSpoutFrameAction
+gst_spout_src_check_duplicate (GstSpoutSrc * self, GstBuffer * buffer)
+{
+  GstSpoutSrcPrivate *priv = self->priv;
+  GstSpoutDuplicatePolicy policy = priv->duplicate_policy;
+  GstSpoutFrameAction action;
+  gint64 sender_frame = (gint64) GST_BUFFER_OFFSET (buffer);
+  guint64 fingerprint = 0;
+  
+  /* Today's behaviour, don't pay for detection */
+  if (policy == GST_SPOUT_DUPLICATE_POLICY_REPEAT)
+    return GST_SPOUT_FRAME_ACTION_PUSH;
+  
+  if (sender_frame <= 0 && !gst_spout_src_fingerprint (self, buffer, &fingerprint))
+    return GST_SPOUT_FRAME_ACTION_PUSH;
+  
+  action = priv->dedup.process (policy, sender_frame, fingerprint);
+  if (action != GST_SPOUT_FRAME_ACTION_PUSH) {
+    priv->stats.duplicated.add ();
+    GST_LOG_OBJECT (self, "Repeated frame (sender frame %" G_GINT64_FORMAT
+        ", %" G_GUINT64_FORMAT " duplicates so far)", sender_frame,
+        priv->dedup.duplicates ());
+  }
+  
+  return action;
+}
+
+/* Stand in for a repeated frame with a GAP event, at most one per frame
+ * duration */
+static void
+gst_spout_src_push_gap (GstSpoutSrc * self, const GstSpoutStateView & state)
+{
+  GstSpoutSrcPrivate *priv = self->priv;
+  GstClock *clock;
+  GstClockTime clock_time, base_time, timestamp, duration;
+  
+  clock = gst_element_get_clock (GST_ELEMENT_CAST (self));
+  if (!clock)
+    return;
+  
+  clock_time = gst_clock_get_time (clock);
+  base_time = GST_ELEMENT_CAST (self)->base_time;
+  gst_object_unref (clock);
+  
+  timestamp = clock_time > base_time ? clock_time - base_time : 0;
+  
+  if (GST_CLOCK_TIME_IS_VALID (priv->gap_end) && timestamp < priv->gap_end)
+    return;
+  
+  duration = gst_spout_src_frame_duration (*state);
+  priv->gap_end = timestamp + duration;
+  
+  GST_LOG_OBJECT (self, "Pushing GAP at %" GST_TIME_FORMAT,
+      GST_TIME_ARGS (timestamp));
+  gst_pad_push_event (GST_BASE_SRC_PAD (self),
+      gst_event_new_gap (timestamp, duration));
+}
+
+bool
+GstSpoutD3D11ReadbackEngine::copy (unsigned int slot, GstBuffer * const & source)
+{
+  ID3D11Device *device_handle = gst_d3d11_device_get_device_handle (device);
+  ID3D11DeviceContext *context = gst_d3d11_device_get_device_context_handle (device);
+  GstMemory *mem = gst_buffer_peek_memory (source, 0);
+  D3D11_TEXTURE2D_DESC desc, staging_desc;
+  ID3D11Texture2D *texture;
+  GstD3D11Memory *dmem;
+  
+  if (!gst_is_d3d11_memory (mem))
+    return false;
+  
+  dmem = GST_D3D11_MEMORY_CAST (mem);
+  texture = (ID3D11Texture2D *) gst_d3d11_memory_get_resource_handle (dmem);
+  texture->GetDesc (&desc);
+  
+  if (slot >= staging.size ())
+    staging.resize (slot + 1, nullptr);
+  
+  /* Slots follow the frame format, a change costs one texture per slot */
+  if (staging[slot]) {
+    staging[slot]->GetDesc (&staging_desc);
+    if (staging_desc.Width != desc.Width || staging_desc.Height != desc.Height ||
+        staging_desc.Format != desc.Format) {
+      staging[slot]->Release ();
+      staging[slot] = nullptr;
+    }
+  }
+  
+  if (!staging[slot]) {
+    staging_desc = { };
+    staging_desc.Width = desc.Width;
+    staging_desc.Height = desc.Height;
+    staging_desc.MipLevels = 1;
+    staging_desc.ArraySize = 1;
+    staging_desc.Format = desc.Format;
+    staging_desc.SampleDesc.Count = 1;
+    staging_desc.Usage = D3D11_USAGE_STAGING;
+    staging_desc.CPUAccessFlags = D3D11_CPU_ACCESS_READ;
+    
+    if (FAILED (device_handle->CreateTexture2D (&staging_desc, nullptr,
+                &staging[slot]))) {
+      GST_WARNING_OBJECT (device, "Failed to create staging texture");
+      staging[slot] = nullptr;
+      return false;
+    }
+  }
+  
+  gst_d3d11_device_lock (device);
+  context->CopySubresourceRegion (staging[slot], 0, 0, 0, 0, texture,
+      gst_d3d11_memory_get_subresource_index (dmem), nullptr);
+  gst_d3d11_device_unlock (device);
+  
+  return true;
+}
+
+GstSpoutMapResult
+GstSpoutD3D11ReadbackEngine::map (unsigned int slot, bool wait,
+    GstSpoutMapping & mapping)
+{
+  ID3D11DeviceContext *context = gst_d3d11_device_get_device_context_handle (device);
+  D3D11_MAPPED_SUBRESOURCE map;
+  HRESULT hr;
+  
+  gst_d3d11_device_lock (device);
+  hr = context->Map (staging[slot], 0, D3D11_MAP_READ,
+      wait ? 0 : D3D11_MAP_FLAG_DO_NOT_WAIT, &map);
+  gst_d3d11_device_unlock (device);
+  
+  if (hr == DXGI_ERROR_WAS_STILL_DRAWING)
+    return GstSpoutMapResult::WOULD_BLOCK;
+  
+  if (FAILED (hr)) {
+    GST_WARNING_OBJECT (device, "Failed to map staging texture, hr 0x%x",
+        (guint) hr);
+    return GstSpoutMapResult::ERROR;
+  }
+  
+  mapping.data = (const uint8_t *) map.pData;
+  mapping.stride = map.RowPitch;
+  
+  return GstSpoutMapResult::DONE;
+}
+
+void
+GstSpoutD3D11ReadbackEngine::unmap (unsigned int slot)
+{
+  ID3D11DeviceContext *context = gst_d3d11_device_get_device_context_handle (device);
+  
+  gst_d3d11_device_lock (device);
+  context->Unmap (staging[slot], 0);
+  gst_d3d11_device_unlock (device);
+}
+
+void
+GstSpoutD3D11ReadbackEngine::clear ()
+{
+  for (auto texture : staging) {
+    if (texture)
+      texture->Release ();
+  }
+  staging.clear ();
+}
+
+/* Run @func over @height rows split into bands starting on even rows, on
+ * the shared worker pool and the calling thread */
+static void
+gst_spout_src_process_bands (GstSpoutSrc * self, guint height,
+    const std::function<void (guint, guint)> & func)
+{
+  GstSpoutSrcPrivate *priv = self->priv;
+  guint threads = priv->readback_threads;
+  guint bands, rows;
+  
+  /* A couple of bands per thread gives stealing something to balance */
+  bands = MIN (threads * 2, MAX (height / MIN_BAND_ROWS, 1u));
+  if (threads <= 1 || bands <= 1) {
+    func (0, height);
+    return;
+  }
+  
+  rows = GST_ROUND_UP_2 ((height + bands - 1) / bands);
+  
+  gst_spout_src_worker_pool ().run (bands, [&] (unsigned int band) {
+    guint y_begin = band * rows;
+    guint y_end = MIN (y_begin + rows, height);
+    
+    if (y_begin < y_end)
+      func (y_begin, y_end);
+  }, threads - 1);
+}
+
+/* Hand out the oldest frame in the readback ring once it is due, *buf stays
+ * NULL if none is */
+static GstFlowReturn
+gst_spout_src_collect_readback (GstSpoutSrc * self, GstBuffer ** buf)
+{
+  GstSpoutSrcPrivate *priv = self->priv;
+  GstFlowReturn ret = GST_FLOW_OK;
+  GstSpoutReadbackResult result;
+  GstBuffer *buffer = NULL;
+  
+  GST_SPOUT_TRACE ("readback-collect");
+  
+  auto sink = [&] (const GstSpoutMapping & mapping,
+      const GstSpoutReadbackTag & tag) -> bool {
+    GstVideoFrame frame;
+    
+    /* Frames of an old format may still be in flight right after a change */
+    if (tag.width != (guint) GST_VIDEO_INFO_WIDTH (&priv->output_info) ||
+        tag.height != (guint) GST_VIDEO_INFO_HEIGHT (&priv->output_info)) {
+      GST_DEBUG_OBJECT (self, "Dropping %ux%u frame read back for %dx%d caps",
+          tag.width, tag.height, GST_VIDEO_INFO_WIDTH (&priv->output_info),
+          GST_VIDEO_INFO_HEIGHT (&priv->output_info));
+      return false;
+    }
+    
+    ret = gst_buffer_pool_acquire_buffer (priv->output_pool, &buffer, NULL);
+    if (ret != GST_FLOW_OK)
+      return false;
+    
+    /* Maps with the strides of downstream's video meta, if any */
+    if (!gst_video_frame_map (&frame, &priv->output_info, buffer, GST_MAP_WRITE)) {
+      GST_ERROR_OBJECT (self, "Failed to map output buffer");
+      gst_clear_buffer (&buffer);
+      ret = GST_FLOW_ERROR;
+      return false;
+    }
+    
+    GstSpoutPlanes planes;
+    GstSpoutPixelFormat in_format = gst_spout_src_pixel_format (tag.format);
+    GstSpoutPixelFormat out_format =
+        gst_spout_src_pixel_format (GST_VIDEO_FRAME_FORMAT (&frame));
+    
+    for (guint i = 0; i < GST_VIDEO_FRAME_N_PLANES (&frame); i++) {
+      planes.data[i] = (uint8_t *) GST_VIDEO_FRAME_PLANE_DATA (&frame, i);
+      planes.stride[i] = GST_VIDEO_FRAME_PLANE_STRIDE (&frame, i);
+    }
+    
+    /* Copy, or convert while the data is coming out of the map anyway */
+    gst_spout_src_process_bands (self, tag.height,
+        [&] (guint y_begin, guint y_end) {
+      if (in_format == out_format) {
+        gst_spout_copy_rows (planes.data[0] + y_begin * planes.stride[0],
+            planes.stride[0], mapping.data + y_begin * mapping.stride,
+            mapping.stride, (size_t) tag.width * 4, y_end - y_begin);
+      } else {
+        gst_spout_convert (in_format, mapping.data, mapping.stride, out_format,
+            planes, tag.width, tag.height, y_begin, y_end, gst_spout_cpu_level ());
+      }
+    });
+    gst_video_frame_unmap (&frame);
+    
+    GST_BUFFER_PTS (buffer) = tag.pts;
+    GST_BUFFER_DURATION (buffer) = tag.duration;
+    GST_BUFFER_OFFSET (buffer) = tag.offset;
+    
+    return true;
+  };
+  
+  result = priv->readback.collect (sink);
+  
+  if (result == GstSpoutReadbackResult::ERROR && ret == GST_FLOW_OK)
+    GST_WARNING_OBJECT (self, "Lost a frame in readback");
+  
+  *buf = buffer;
+  return ret;
+}
+
+#endif
+
+/* dump-trace action signal */
+static gboolean
+gst_spout_src_dump_trace (GstSpoutSrc * self, const gchar * filename)
+{
+  if (!filename || !gst_spout_tracer_get ().dump (filename)) {
+    GST_WARNING_OBJECT (self, "Failed to write trace to %s",
+        GST_STR_NULL (filename));
+    return FALSE;
+  }
+  
+  GST_INFO_OBJECT (self, "Wrote trace to %s", filename);
+  return TRUE;
+}
+
+/* Label the calling thread in traces after the element and its @role */
+static void
+gst_spout_src_name_trace_thread (GstSpoutSrc * self, const gchar * role)
+{
+  GstSpoutTracer & tracer = gst_spout_tracer_get ();
+  
+  if (!tracer.enabled () || tracer.thread_named ())
+    return;
+  
+  gchar *name = g_strdup_printf ("%s %s", GST_OBJECT_NAME (self), role);
+  tracer.name_thread (name);
+  g_free (name);
+}
+
+static GstStructure *
+gst_spout_src_histogram (const GstSpoutHistogram & histogram)
+{
+  GstSpoutHistogram::Snapshot snapshot = histogram.snapshot ();
+  GstStructure *s;
+  GValue buckets = G_VALUE_INIT;
+  
+  s = gst_structure_new ("histogram",
+      "count", G_TYPE_UINT64, snapshot.count,
+      "mean", G_TYPE_UINT64, snapshot.mean (),
+      "max", G_TYPE_UINT64, snapshot.max,
+      "p50", G_TYPE_UINT64, snapshot.percentile (50),
+      "p99", G_TYPE_UINT64, snapshot.percentile (99), NULL);
+  
+  /* Power-of-two buckets of microseconds, see GstSpoutHistogram */
+  g_value_init (&buckets, GST_TYPE_ARRAY);
+  for (guint i = 0; i < GstSpoutHistogram::BUCKETS; i++) {
+    GValue count = G_VALUE_INIT;
+    
+    g_value_init (&count, G_TYPE_UINT64);
+    g_value_set_uint64 (&count, snapshot.buckets[i]);
+    gst_value_array_append_and_take_value (&buckets, &count);
+  }
+  gst_structure_take_value (s, "buckets", &buckets);
+  
+  return s;
+}
+
+/* Snapshot of the statistics. Counters are read one by one without a lock,
+ * so they may be a frame apart from each other */
+static GstStructure *
+gst_spout_src_stats (GstSpoutSrc * self)
+{
+  GstSpoutSrcPrivate *priv = self->priv;
+  GstClockTime last = priv->last_receive_time.load ();
+  GstClockTime since_last = GST_CLOCK_TIME_NONE;
+  guint64 connects = priv->stats.connects.get ();
+  GstStructure *s, *receive, *copy, *acquire;
+  
+  if (GST_CLOCK_TIME_IS_VALID (last)) {
+    GstClockTime now = gst_util_get_timestamp ();
+    
+    since_last = now > last ? now - last : 0;
+  }
+  
+  receive = gst_spout_src_histogram (priv->stats.receive_time);
+  copy = gst_spout_src_histogram (priv->stats.copy_time);
+  acquire = gst_spout_src_histogram (priv->stats.acquire_time);
+  
+  s = gst_structure_new ("GstSpoutSrcStats",
+      "frames-received", G_TYPE_UINT64, priv->stats.received.get (),
+      "frames-pushed", G_TYPE_UINT64, priv->stats.pushed.get (),
+      "frames-duplicated", G_TYPE_UINT64, priv->stats.duplicated.get (),
+      "frames-dropped", G_TYPE_UINT64, priv->stats.dropped.get (),
+      "standby-frames", G_TYPE_UINT64, priv->stats.standby.get (),
+      "reconnects", G_TYPE_UINT64, connects > 0 ? connects - 1 : 0,
+      "time-since-last-frame", G_TYPE_UINT64, since_last,
+      "pool-size", G_TYPE_UINT, priv->pool_size.load (),
+      "receive-time", GST_TYPE_STRUCTURE, receive,
+      "copy-time", GST_TYPE_STRUCTURE, copy,
+      "acquire-time", GST_TYPE_STRUCTURE, acquire, NULL);
+  
+  gst_structure_free (receive);
+  gst_structure_free (copy);
+  gst_structure_free (acquire);
+  
+  return s;
+}
+
+/* stats-interval: post the stats as an element message once it passed */
+static void
+gst_spout_src_post_stats (GstSpoutSrc * self)
+{
+  GstSpoutSrcPrivate *priv = self->priv;
+  guint interval = priv->stats_interval.load ();
+  GstClockTime now;
+  
+  if (interval == 0)
+    return;
+  
+  now = gst_util_get_timestamp ();
+  if (GST_CLOCK_TIME_IS_VALID (priv->stats_posted) &&
+      now < priv->stats_posted + interval * GST_MSECOND)
+    return;
+  
+  priv->stats_posted = now;
+  gst_element_post_message (GST_ELEMENT_CAST (self),
+      gst_message_new_element (GST_OBJECT_CAST (self),
+          gst_spout_src_stats (self)));
+}
+
+/* Measure how far behind the clock @buffer's timestamp is as it leaves us,
+ * and have the pipeline ask for our latency again once that drifted */
+static void
+gst_spout_src_record_latency (GstSpoutSrc * self,
+    const GstSpoutStateView & state, GstBuffer * buffer)
+{
+  GstSpoutSrcPrivate *priv = self->priv;
+  GstClockTime pts = GST_BUFFER_PTS (buffer);
+  GstClockTime base_time, now;
+  GstClock *clock;
+  
+  /* Standby frames are stamped as they go out, they say nothing */
+  if (!GST_CLOCK_TIME_IS_VALID (pts) || !state->connected)
+    return;
+  
+  clock = gst_element_get_clock (GST_ELEMENT_CAST (self));
+  if (!clock)
+    return;
+  
+  now = gst_clock_get_time (clock);
+  base_time = GST_ELEMENT_CAST (self)->base_time;
+  gst_object_unref (clock);
+  
+  now = now > base_time ? now - base_time : 0;
+  if (priv->latency.record (now > pts ? now - pts : 0)) {
+    GST_DEBUG_OBJECT (self, "Measured latency drifted to %" GST_TIME_FORMAT,
+        GST_TIME_ARGS (priv->latency.estimate ()));
+    gst_element_post_message (GST_ELEMENT_CAST (self),
+        gst_message_new_latency (GST_OBJECT_CAST (self)));
+  }
+}
+
+static GstFlowReturn
+gst_spout_src_create (GstBaseSrc * src, guint64 offset, guint size,
+    GstBuffer ** buf)
+{
+  GstSpoutSrc *self = GST_SPOUT_SRC (src);
+  GstFlowReturn ret;
+  
+  gst_spout_src_name_trace_thread (self, "streaming");
+  GST_SPOUT_TRACE_FRAME ("create", self->priv->frame_number);
+  
+  /* The only full load of the state per frame, the rest only refresh it */
+  GstSpoutStateView state = self->priv->state.view ();
+  
+  if (self->priv->receiver)
+    ret = gst_spout_src_create_received (self, state, buf);
+#ifdef HAVE_SPOUT
+  else if (self->priv->sysmem_output)
+    ret = gst_spout_src_create_readback (self, state, buf);
+  else
+    ret = gst_spout_src_create_frame (self, state, buf);
+#else
+  else
+    ret = GST_FLOW_FLUSHING;
+#endif
   
-  /* Update last receive time */
-  {
-    std::lock_guard<std::mutex> lock(priv->lock);
-    priv->last_receive_time = gst_util_get_timestamp();
+  if (ret == GST_FLOW_OK && *buf) {
+    self->priv->stats.pushed.add ();
+    gst_spout_src_record_latency (self, state, *buf);
+    gst_spout_src_post_stats (self);
   }
   
-  GST_LOG_OBJECT (self, "Successfully received texture from Spout");
+  return ret;
+}
+
+#ifdef HAVE_SPOUT
+/* Downstream wants system memory: receive on the GPU as usual, then read
+ * back through the staging ring. Frames come out readback-latency frames
+ * later with the timestamps they were received with */
+static GstFlowReturn
+gst_spout_src_create_readback (GstSpoutSrc * self, GstSpoutStateView & state,
+    GstBuffer ** buf)
+{
+  GstSpoutSrcPrivate *priv = self->priv;
+  GstBuffer *frame, *buffer = NULL;
+  GstFlowReturn ret;
   
-  /* Set or update caps based on the sender if needed */
-  if (priv->spout->IsUpdated() || priv->first_frame) {
-    std::unique_lock<std::mutex> lock(priv->lock);
-    
-    unsigned int width = priv->spout->GetSenderWidth();
-    unsigned int height = priv->spout->GetSenderHeight();
-    DXGI_FORMAT format = priv->spout->GetSenderFormat();
-    
-    /* Update connected sender name */
-    sender_name = priv->spout->GetSenderName();
-    if (sender_name) {
-      priv->connected_sender_name = sender_name;
+  for (;;) {
+    ret = gst_spout_src_collect_readback (self, &buffer);
+    if (ret != GST_FLOW_OK || buffer) {
+      *buf = buffer;
+      return ret;
     }
     
-    GST_DEBUG_OBJECT (self, "Updating caps from sender '%s': %dx%d format=%d", 
-                      priv->connected_sender_name.c_str(), width, height, format);
+    frame = NULL;
+    ret = gst_spout_src_create_frame (self, state, &frame);
+    if (ret != GST_FLOW_OK || !frame) {
+      *buf = frame;
+      return ret;
+    }
     
-    /* Get the sender frame rate if available */
-    double fps = priv->spout->GetSenderFps();
-    if (fps <= 0.0 || fps > 1000.0) {
-      /* If the sender doesn't provide a valid framerate, use our default */
-      fps = DEFAULT_FRAMERATE;
+    /* Renegotiating for the frame may have switched to D3D11 output */
+    if (!priv->sysmem_output) {
+      *buf = frame;
+      return GST_FLOW_OK;
     }
-    priv->current_fps = fps;
     
-    GST_DEBUG_OBJECT (self, "Using sender framerate: %.2f fps", fps);
+    GstSpoutReadbackTag tag;
+    GstVideoMeta *meta = gst_buffer_get_video_meta (frame);
     
-    /* Update our caps */
-    GstVideoFormat video_format = gst_spout_src_dxgi_format_to_gst(format);
-    if (video_format == GST_VIDEO_FORMAT_UNKNOWN) {
-      GST_WARNING_OBJECT (self, "Unsupported DXGI format %d, falling back to BGRA", format);
-      video_format = GST_VIDEO_FORMAT_BGRA;
+    tag.pts = GST_BUFFER_PTS (frame);
+    tag.duration = GST_BUFFER_DURATION (frame);
+    tag.offset = GST_BUFFER_OFFSET (frame);
+    if (meta) {
+      tag.format = meta->format;
+      tag.width = meta->width;
+      tag.height = meta->height;
+    } else {
+      tag.format = GST_VIDEO_INFO_FORMAT (&priv->output_info);
+      tag.width = GST_VIDEO_INFO_WIDTH (&priv->output_info);
+      tag.height = GST_VIDEO_INFO_HEIGHT (&priv->output_info);
     }
     
-    /* Set up the video info with framerate */
-    gst_video_info_set_format(&priv->video_info, video_format, width, height);
-    priv->video_info.fps_n = (int)(fps * 1000);
-    priv->video_info.fps_d = 1000; /* Using 1000 as denominator for better precision */
+    if (!gst_spout_convert_supported (gst_spout_src_pixel_format (tag.format),
+            gst_spout_src_pixel_format (GST_VIDEO_INFO_FORMAT (&priv->output_info)))) {
+      GST_ERROR_OBJECT (self, "Can't read back %s frames as %s",
+          gst_video_format_to_string (tag.format),
+          gst_video_format_to_string (GST_VIDEO_INFO_FORMAT (&priv->output_info)));
+      gst_buffer_unref (frame);
+      return GST_FLOW_NOT_NEGOTIATED;
+    }
     
-    /* Create caps from video info and make them writable */
-    GstCaps *new_caps = gst_video_info_to_caps(&priv->video_info);
-    new_caps = gst_caps_make_writable(new_caps);
+    /* The ring never fills up here, collecting above waits for the GPU
+     * rather than letting it. Once the copy is queued the texture may go
+     * back to the pool, later receives are ordered after the copy */
+    GstSpoutTraceScope submit_trace ("readback-submit");
+    if (!priv->readback.submit (frame, tag))
+      GST_WARNING_OBJECT (self, "Failed to copy frame for readback");
+    submit_trace.end ();
     
-    /* Add D3D11 memory feature to the writable caps */
-    GstCapsFeatures *features = gst_caps_features_new(GST_CAPS_FEATURE_MEMORY_D3D11_MEMORY, NULL);
-    gst_caps_set_features(new_caps, 0, features);
+    gst_buffer_unref (frame);
+  }
+}
+
+#endif
+
+/* Bookkeeping for a new frame about to go out: remember it for
+ * standby-mode=last-frame and push caps if the sender format changed */
+static GstFlowReturn
+gst_spout_src_accept_frame (GstSpoutSrc * self, GstSpoutStateView & state,
+    GstBuffer * buffer)
+{
+  GstBaseSrc *src = GST_BASE_SRC (self);
+  GstSpoutSrcPrivate *priv = self->priv;
+  
+  GST_SPOUT_TRACE ("caps");
+  
+  /* @buffer may come with a new sender format */
+  priv->state.refresh (state);
+  
+#ifdef HAVE_SPOUT
+  /* Keep a reference for standby-mode=last-frame. Zero-copy buffers may hold
+   * the sender's keyed mutex and received ones a slot of the sender, those
+   * can't be kept around. Converted ones aren't in the sender's format */
+  priv->standby.configure (priv->standby_mode, priv->standby_color);
+  if (priv->standby.mode () == GST_SPOUT_STANDBY_LAST_FRAME &&
+      !priv->receiver && !gst_spout_src_use_zero_copy (self, state) &&
+      !priv->converting) {
+    GstSpoutSenderFormat format;
     
-    /* Replace the existing caps with the new one */
-    gst_caps_replace(&priv->caps, new_caps);
-    gst_caps_unref(new_caps);
+    if (gst_spout_src_output_format (self, state, &format))
+      priv->standby.remember (buffer, format);
+  }
+#endif
+  
+  /* Renegotiate only when the sender format actually changed, steady state
+   * frames neither build caps nor take any lock */
+  if (state->caps && state->caps_generation != priv->pushed_caps_generation) {
+    GST_DEBUG_OBJECT (self, "Setting caps for sender '%s': %" GST_PTR_FORMAT,
+                      state->sender_name.c_str(), state->caps);
     
-    GST_DEBUG_OBJECT (self, "Updated caps: %" GST_PTR_FORMAT, priv->caps);
+    /* Read back, converted and reshaped output need their pools and
+     * converter set up again too, so negotiate from scratch. get_caps()
+     * offers the new caps in every format and memory type. Received frames
+     * keep the memory type they were negotiated in */
+    if (priv->sysmem_output || priv->converting || state->reshape ||
+        priv->receiver) {
+      if (!gst_base_src_negotiate(src)) {
+        GST_WARNING_OBJECT (self, "Failed to renegotiate for %" GST_PTR_FORMAT,
+                            state->caps);
+        return GST_FLOW_NOT_NEGOTIATED;
+      }
+    } else if (!gst_base_src_set_caps(src, state->caps)) {
+      GST_WARNING_OBJECT (self, "Downstream refused caps %" GST_PTR_FORMAT,
+                          state->caps);
+      return GST_FLOW_NOT_NEGOTIATED;
+    }
     
-    /* Set the caps on the source pad */
-    GstCaps *current_caps = gst_caps_ref(priv->caps);
-    lock.unlock();
+    priv->pushed_caps_generation = state->caps_generation;
+  }
+  
+  return GST_FLOW_OK;
+}
+
+#ifdef HAVE_SPOUT
+/* Downstream holds @buffer from here on */
+static void
+gst_spout_src_mark_pushed (GstSpoutSrc * self, GstBuffer * buffer)
+{
+  GstSpoutSrcPrivate *priv = self->priv;
+  GstSpoutHoldMeta *meta;
+  
+  if (!priv->pool_tracker)
+    return;
+  
+  meta = (GstSpoutHoldMeta *) gst_buffer_get_meta (buffer,
+      gst_spout_hold_meta_api_get_type ());
+  if (meta)
+    meta->pushed = gst_util_get_timestamp ();
+  
+  gst_spout_src_adapt_pool (self);
+}
+
+/* The newest frame without waiting for one, NULL if the sender has nothing
+ * new. @stale counts frames the capture thread replaced with newer ones */
+static GstFlowReturn
+gst_spout_src_poll_frame (GstSpoutSrc * self, GstSpoutStateView & state,
+    GstBuffer ** buffer, guint64 * stale)
+{
+  GstSpoutSrcPrivate *priv = self->priv;
+  GstFlowReturn ret = GST_FLOW_OK;
+  
+  GST_SPOUT_TRACE ("poll");
+  
+  *buffer = NULL;
+  *stale = 0;
+  
+  if (priv->capture.running ()) {
+    guint64 dropped;
     
-    gst_base_src_set_caps(GST_BASE_SRC(self), current_caps);
-    gst_caps_unref(current_caps);
+    priv->capture.pop_latest (*buffer, std::chrono::microseconds (0));
     
-    /* Note: we've released the lock before calling set_caps to avoid deadlocks */
-    lock.lock();
-    priv->first_frame = FALSE;
-    priv->connected = TRUE;
+    dropped = priv->capture.frames_dropped ();
+    *stale = dropped - priv->capture_dropped;
+    priv->capture_dropped = dropped;
+  } else {
+    /* A busy sender has nothing new for this tick, the last frame repeats */
+    ret = gst_spout_src_receive_frame (self, state, buffer);
+    if (ret == GST_SPOUT_SRC_FLOW_BUSY)
+      return GST_FLOW_OK;
+    if (ret != GST_FLOW_OK)
+      return ret;
   }
   
-  /* Release device context */
-  if (context) {
-    context->Release();
+  if (!*buffer)
+    return GST_FLOW_OK;
+  
+  /* Receiving in place copies the shared texture whether or not the sender
+   * updated it */
+  if (priv->pacer.repeats ((gint64) GST_BUFFER_OFFSET (*buffer))) {
+    priv->stats.duplicated.add ();
+    gst_clear_buffer (buffer);
+  } else if (gst_spout_src_check_duplicate (self, *buffer) !=
+      GST_SPOUT_FRAME_ACTION_PUSH) {
+    gst_clear_buffer (buffer);
   }
   
   return GST_FLOW_OK;
 }
 
+/* cfr=true: wait for the next tick of the negotiated frame rate and put the
+ * newest frame on it, the previous one again if the sender has nothing new.
+ * Ticks come from the element clock, so a test clock steps through them */
 static GstFlowReturn
-gst_spout_src_create (GstBaseSrc * src, guint64 offset, guint size,
+gst_spout_src_create_cfr (GstSpoutSrc * self, GstSpoutStateView & state,
     GstBuffer ** buf)
 {
-  GstSpoutSrc *self = GST_SPOUT_SRC (src);
   GstSpoutSrcPrivate *priv = self->priv;
-  GstFlowReturn ret;
   GstClock *clock;
-  GstClockTime base_time, clock_time, timestamp;
-  gboolean connected = FALSE;
+  GstClockID id;
+  GstClockReturn clock_ret;
+  GstClockTime base_time, now, tick, duration;
+  GstClockTimeDiff jitter = 0;
   GstBuffer *buffer = NULL;
+  GstFlowReturn ret;
+  gboolean have_clock, new_frame = FALSE;
+  guint64 stale = 0, lost;
+  gint fps_n, fps_d;
+  
+  /* Without a pipeline clock pace against the system clock, timestamps
+   * are meaningless then */
+  clock = gst_element_get_clock (GST_ELEMENT_CAST (self));
+  have_clock = clock != NULL;
+  if (!clock)
+    clock = gst_system_clock_obtain ();
+  base_time = have_clock ? GST_ELEMENT_CAST (self)->base_time : 0;
+  
+  gst_spout_src_frame_rate (*state, &fps_n, &fps_d);
+  priv->pacer.set_rate (fps_n, fps_d);
+  
+  now = gst_clock_get_time (clock);
+  now = now > base_time ? now - base_time : 0;
+  tick = priv->pacer.next_tick (now);
+  duration = priv->pacer.duration ();
+  
+  id = gst_clock_new_single_shot_id (clock, base_time + tick);
+  gst_object_unref (clock);
   
-  /* Check if we're flushing */
   {
     std::lock_guard<std::mutex> lock(priv->lock);
     if (priv->flushing) {
-      GST_DEBUG_OBJECT (self, "Flushing, returning FLUSHING");
+      gst_clock_id_unref (id);
       return GST_FLOW_FLUSHING;
     }
+    priv->cfr_clock_id = id;
   }
   
-  /* Ensure we're connected to a Spout sender */
   {
-    std::unique_lock<std::mutex> lock(priv->lock);
-    connected = priv->connected && priv->spout;
-    
-    GST_LOG_OBJECT (self, "Connection status check: connected=%d spout=%p", 
-                    priv->connected, priv->spout);
+    GST_SPOUT_TRACE ("cfr-wait");
+    clock_ret = gst_clock_id_wait (id, &jitter);
+  }
+  
+  {
+    std::lock_guard<std::mutex> lock(priv->lock);
+    priv->cfr_clock_id = nullptr;
+  }
+  gst_clock_id_unref (id);
+  
+  if (clock_ret == GST_CLOCK_UNSCHEDULED)
+    return GST_FLOW_FLUSHING;
+  
+  /* Start receiving in the background once we have buffers to receive into */
+  if (priv->capture_thread && !priv->capture.running () && priv->pool)
+    gst_spout_src_start_capture (self);
+  
+  /* The tick may have been a while */
+  priv->state.refresh (state);
+  if (state->connected) {
+    ret = gst_spout_src_poll_frame (self, state, &buffer, &stale);
+    if (ret != GST_FLOW_OK)
+      return ret;
+  } else {
+    if (priv->reconnect_given_up) {
+      GST_ELEMENT_ERROR (self, RESOURCE, NOT_FOUND,
+          ("Spout sender is gone and reconnecting gave up"), (NULL));
+      return GST_FLOW_ERROR;
+    }
     
-    /* If we just connected, update downstream with the new caps */
-    if (connected && priv->caps) {
-      const char* sender_name = priv->connected_sender_name.c_str();
-      GstCaps *current_caps = gst_caps_ref(priv->caps);
-      lock.unlock();
-      
-      GST_DEBUG_OBJECT (self, "Connected to sender '%s', setting caps: %" GST_PTR_FORMAT,
-                        sender_name, current_caps);
-      
-      gst_base_src_set_caps(src, current_caps);
-      gst_caps_unref(current_caps);
+    /* The next sender starts over */
+    gst_clear_buffer (&priv->cfr_last);
+    priv->pacer.forget_frame ();
+  }
+  
+  if (buffer) {
+    ret = gst_spout_src_accept_frame (self, state, buffer);
+    if (ret != GST_FLOW_OK) {
+      gst_buffer_unref (buffer);
+      return ret;
     }
-    else {
-      lock.unlock();
+    
+    guint64 dropped = priv->pacer.dropped ();
+    
+    priv->pacer.emit ((gint64) GST_BUFFER_OFFSET (buffer), stale);
+    priv->stats.dropped.add (priv->pacer.dropped () - dropped);
+    new_frame = TRUE;
+  } else if (priv->cfr_last) {
+    /* Shares the texture, only the metadata is our own */
+    buffer = gst_buffer_copy (priv->cfr_last);
+    priv->pacer.repeat ();
+  } else {
+    /* Disconnected, or nothing received yet */
+    ret = gst_spout_src_create_standby (self, state, &buffer);
+    if (ret != GST_FLOW_OK || !buffer) {
+      *buf = buffer;
+      return ret;
     }
   }
   
-  if (!connected) {
-    /* Try to connect or reconnect */
-    gboolean result = gst_spout_src_connect (self);
+  GST_BUFFER_PTS (buffer) = have_clock ? tick : GST_CLOCK_TIME_NONE;
+  GST_BUFFER_DURATION (buffer) = duration;
+  GST_BUFFER_OFFSET (buffer) = priv->pacer.ticks ();
+  
+  if (new_frame) {
+    gst_spout_src_mark_pushed (self, buffer);
+    gst_buffer_replace (&priv->cfr_last, buffer);
+  }
+  
+  lost = priv->pacer.dropped () + priv->pacer.missed ();
+  if (lost != priv->cfr_lost) {
+    GstMessage *qos;
     
-    /* Re-check connection state after connection attempt */
-    {
-      std::lock_guard<std::mutex> lock(priv->lock);
-      connected = priv->connected && priv->spout;
-      
-      GST_LOG_OBJECT (self, "Connection after connect attempt: connected=%d spout=%p", 
-                     priv->connected, priv->spout);
-    }
+    GST_LOG_OBJECT (self, "%" G_GUINT64_FORMAT " frames dropped, %"
+        G_GUINT64_FORMAT " ticks missed, %" G_GUINT64_FORMAT " repeated",
+        priv->pacer.dropped (), priv->pacer.missed (), priv->pacer.repeated ());
+    
+    qos = gst_message_new_qos (GST_OBJECT_CAST (self), TRUE, tick, tick, tick,
+        duration);
+    gst_message_set_qos_values (qos, jitter, 1.0, 1000000);
+    gst_message_set_qos_stats (qos, GST_FORMAT_BUFFERS,
+        priv->pacer.output (), lost);
+    gst_element_post_message (GST_ELEMENT_CAST (self), qos);
     
-    if (!result && priv->reconnect_attempts >= 5) {
-      GST_ERROR_OBJECT (self, "Failed to connect to Spout after multiple attempts");
+    priv->cfr_lost = lost;
+  }
+  
+  *buf = buffer;
+  return GST_FLOW_OK;
+}
+
+/* Produce the next frame in D3D11 memory */
+static GstFlowReturn
+gst_spout_src_create_frame (GstSpoutSrc * self, GstSpoutStateView & state,
+    GstBuffer ** buf)
+{
+  GstSpoutSrcPrivate *priv = self->priv;
+  GstFlowReturn ret;
+  gboolean connected = FALSE;
+  GstBuffer *buffer = NULL;
+  
+  /* Check if we're flushing */
+  if (priv->flushing) {
+    GST_DEBUG_OBJECT (self, "Flushing, returning FLUSHING");
+    return GST_FLOW_FLUSHING;
+  }
+  
+  if (priv->cfr)
+    return gst_spout_src_create_cfr (self, state, buf);
+  
+  /* Start receiving in the background once we have buffers to receive into */
+  if (priv->capture_thread && !priv->capture.running () && priv->pool)
+    gst_spout_src_start_capture (self);
+  
+  /* Ensure we're connected to a Spout sender */
+  GstSpoutTraceScope connection_trace ("connection");
+  connected = state->connected;
+  GST_LOG_OBJECT (self, "Connection status check: connected=%d", connected);
+  
+  while (!connected) {
+    if (priv->reconnect_given_up) {
+      GST_ELEMENT_ERROR (self, RESOURCE, NOT_FOUND,
+          ("Spout sender is gone and reconnecting gave up"), (NULL));
       return GST_FLOW_ERROR;
     }
     
-    /* Check if connection succeeded */
-    if (!connected) {
-      /* Wait a short time and provide a dummy black frame instead of returning empty-handed */
-      GST_INFO_OBJECT (self, "No Spout sender available, waiting...");
-      g_usleep(priv->wait_timeout * 1000); // Convert ms to µs
+    if (priv->pool) {
+      /* Keep downstream fed with standby frames at the current rate while the
+       * reconnect thread is at it */
+      GstSpoutStandbyTimer::Slot slot;
+      GstClockTime now = gst_util_get_timestamp ();
+      GstClockTime running_time = gst_spout_src_running_time (self);
+      gint fps_n, fps_d;
       
-      if (!priv->pool) {
-        GST_DEBUG_OBJECT (self, "No buffer pool available yet, deferring");
-        return GST_FLOW_OK;  // Try again next time
-      }
+      gst_spout_src_frame_rate (*state, &fps_n, &fps_d);
+      if (!priv->standby_timer.next (fps_n, fps_d, now,
+              GST_CLOCK_TIME_IS_VALID (running_time) ? running_time : now,
+              slot))
+        return GST_FLOW_ERROR;
       
-      /* Acquire a buffer from the pool */
-      ret = gst_buffer_pool_acquire_buffer(priv->pool, &buffer, NULL);
-      if (ret != GST_FLOW_OK) {
-        GST_WARNING_OBJECT(self, "Failed to acquire buffer: %s", gst_flow_get_name(ret));
-        return GST_FLOW_OK;  // Try again next time
-      }
+      GST_LOG_OBJECT (self, "No Spout sender connected, standby frame");
+      if (slot.due > now && !gst_spout_src_wait_for (self, state,
+              std::chrono::microseconds ((slot.due - now) / GST_USECOND)))
+        return GST_FLOW_FLUSHING;
       
-      /* Initialize buffer to black */
-      GstMapInfo map;
-      if (gst_buffer_map(buffer, &map, GST_MAP_WRITE)) {
-        memset(map.data, 0, map.size);
-        gst_buffer_unmap(buffer, &map);
+      priv->state.refresh (state);
+      connected = state->connected;
+      if (connected) {
+        priv->standby_timer.reset ();
+        break;
       }
       
-      /* Set timestamps for the dummy buffer */
-      clock = gst_element_get_clock(GST_ELEMENT_CAST(self));
-      if (clock) {
-        clock_time = gst_clock_get_time(clock);
-        base_time = GST_ELEMENT_CAST(self)->base_time;
-        gst_object_unref(clock);
-        
-        if (clock_time > base_time)
-          timestamp = clock_time - base_time;
-        else
-          timestamp = 0;
-          
-        GST_BUFFER_TIMESTAMP(buffer) = timestamp;
-        
-        /* Calculate duration based on current fps */
-        double fps = DEFAULT_FRAMERATE;
-        {
-          std::lock_guard<std::mutex> lock(priv->lock);
-          fps = priv->current_fps > 0 ? priv->current_fps : DEFAULT_FRAMERATE;
-        }
-        
-        GST_BUFFER_DURATION(buffer) = gst_util_uint64_scale_int(1, GST_SECOND, (int)fps);
-      }
+      ret = gst_spout_src_create_standby (self, state, buf);
       
-      *buf = buffer;
-      return GST_FLOW_OK;
+      /* On the timer's grid rather than whenever we woke up */
+      if (ret == GST_FLOW_OK && *buf &&
+          GST_CLOCK_TIME_IS_VALID (running_time)) {
+        GST_BUFFER_PTS (*buf) = slot.pts;
+        GST_BUFFER_DURATION (*buf) = slot.duration;
+      }
+      return ret;
     }
+    
+    /* Nothing to output yet, stay parked until we connect or flush */
+    GST_DEBUG_OBJECT (self, "No Spout sender and no buffer pool, parking");
+    if (!gst_spout_src_wait (self, state, SENDER_PARK_TIMEOUT))
+      return GST_FLOW_FLUSHING;
+    
+    priv->state.refresh (state);
+    connected = state->connected;
   }
   
-  /* Set caps if we haven't done so yet */
-  {
-    std::unique_lock<std::mutex> lock(priv->lock);
-    if (priv->caps) {
-      const char* sender_name = priv->connected_sender_name.c_str();
-      GST_LOG_OBJECT (self, "Setting caps for sender '%s'", sender_name);
-      
-      GstCaps *current_caps = gst_caps_ref(priv->caps);
-      lock.unlock();
-      
-      gst_base_src_set_caps(src, current_caps);
-      gst_caps_unref(current_caps);
+  connection_trace.end ();
+  
+  GstClockTime wait_start = gst_util_get_timestamp ();
+  GstSpoutTraceScope receive_trace ("receive");
+  
+  for (;;) {
+    GstSpoutFrameAction action;
+    
+    ret = gst_spout_src_receive_frame (self, state, &buffer);
+    if (ret == GST_SPOUT_SRC_FLOW_BUSY) {
+      /* Still connected, the sender is only writing: no new frame yet */
+      action = GST_SPOUT_FRAME_ACTION_SKIP;
+    } else if (ret != GST_FLOW_OK) {
+      return ret;
+    } else if (!buffer) {
+      /* Standby frames are for a sender that went away, anything else is
+       * worth another try */
+      priv->state.refresh (state);
+      if (!state->connected)
+        return gst_spout_src_create_standby (self, state, buf);
+      action = GST_SPOUT_FRAME_ACTION_SKIP;
+    } else {
+      action = gst_spout_src_check_duplicate (self, buffer);
     }
-    else {
-      lock.unlock();
+    
+    if (action == GST_SPOUT_FRAME_ACTION_PUSH) {
+      priv->stats.receive_time.record (gst_util_get_timestamp () - wait_start);
+      break;
     }
+    
+    gst_clear_buffer (&buffer);
+    
+    if (action == GST_SPOUT_FRAME_ACTION_GAP)
+      gst_spout_src_push_gap (self, state);
+    
+    /* The capture thread paces itself, otherwise sleep until the sender's
+     * next frame is due. Receiving may have published a new format, wait on
+     * the state as it is now */
+    priv->state.refresh (state);
+    if (!priv->capture.running () && !gst_spout_src_wait_for_frame (self, state))
+      return GST_FLOW_FLUSHING;
   }
   
-  /* Get a buffer from our pool */
-  ret = gst_buffer_pool_acquire_buffer(priv->pool, &buffer, NULL);
+  receive_trace.end ();
+  
+  ret = gst_spout_src_accept_frame (self, state, buffer);
   if (ret != GST_FLOW_OK) {
-    GST_ERROR_OBJECT (self, "Failed to acquire buffer from pool: %s",
-        gst_flow_get_name (ret));
+    gst_buffer_unref (buffer);
     return ret;
   }
   
-  /* Receive texture from Spout */
-  ret = gst_spout_src_copy_texture_to_buffer(self, buffer);
-  if (ret != GST_FLOW_OK) {
-    gst_buffer_unref(buffer);
-    GST_WARNING_OBJECT (self, "Failed to copy texture to buffer");
-    
-    /* Not a fatal error - we'll retry on the next frame */
-    return GST_FLOW_OK;  // Try again next time
-  }
+  gst_spout_src_stamp_frame (self, state, buffer);
+  
+  gst_spout_src_mark_pushed (self, buffer);
+  
+  *buf = buffer;
+  return GST_FLOW_OK;
+}
+
+#endif
+
+/* Set running time, duration and our frame count on @buffer. Until then its
+ * PTS carries the time it was received and its offset the sender frame
+ * number */
+static void
+gst_spout_src_stamp_frame (GstSpoutSrc * self,
+    const GstSpoutStateView & state, GstBuffer * buffer)
+{
+  GstSpoutSrcPrivate *priv = self->priv;
+  GstClock *clock;
+  GstClockTime base_time, clock_time, timestamp, received;
   
-  /* Set buffer timestamp */
+  GstSpoutTraceScope timestamp_trace ("timestamp");
   clock = gst_element_get_clock(GST_ELEMENT_CAST(self));
   if (clock) {
     clock_time = gst_clock_get_time(clock);
@@ -1296,17 +5130,31 @@ gst_spout_src_create (GstBaseSrc * src, guint64 offset, guint size,
     else
       timestamp = 0;
     
-    GST_BUFFER_TIMESTAMP(buffer) = timestamp;
+    /* The frame arrived when it was received, possibly a while ago on the
+     * capture thread, not now */
+    received = GST_BUFFER_PTS (buffer);
+    if (GST_CLOCK_TIME_IS_VALID (received)) {
+      GstClockTime now = gst_util_get_timestamp ();
+      GstClockTime age = now > received ? now - received : 0;
+      
+      timestamp = timestamp > age ? timestamp - age : 0;
+    }
     
-    /* Calculate duration if we have a previous timestamp */
+    /* Calculate duration if we have a previous timestamp, prev_pts and
+     * frame_number are only touched by the streaming thread */
     {
-      std::lock_guard<std::mutex> lock(priv->lock);
+      /* Exact duration at the negotiated rate */
+      GstClockTime frame_duration = gst_spout_src_frame_duration (*state);
       
-      /* Get current fps for duration calculation */
-      double fps = priv->current_fps > 0 ? priv->current_fps : DEFAULT_FRAMERATE;
-      GstClockTime frame_duration = gst_util_uint64_scale_int(1, GST_SECOND, (int)fps);
+      /* GST_BUFFER_OFFSET still carries the sender frame number */
+      priv->timestamper.set_frame_duration (frame_duration);
+      timestamp = priv->timestamper.timestamp (priv->timestamp_mode, timestamp,
+          (gint64) GST_BUFFER_OFFSET (buffer));
+      GST_BUFFER_TIMESTAMP(buffer) = timestamp;
       
-      if (GST_CLOCK_TIME_IS_VALID(priv->prev_pts)) {
+      if (priv->timestamp_mode != GST_SPOUT_TIMESTAMP_ARRIVAL) {
+        GST_BUFFER_DURATION(buffer) = priv->timestamper.period ();
+      } else if (GST_CLOCK_TIME_IS_VALID(priv->prev_pts)) {
         /* Avoid potential underflow if timestamps are irregular */
         if (timestamp > priv->prev_pts) {
           GST_BUFFER_DURATION(buffer) = timestamp - priv->prev_pts;
@@ -1324,8 +5172,185 @@ gst_spout_src_create (GstBaseSrc * src, guint64 offset, guint size,
       /* Set frame count */
       GST_BUFFER_OFFSET(buffer) = priv->frame_number++;
     }
+  } else {
+    /* Drop the receive time, it isn't running time */
+    GST_BUFFER_PTS(buffer) = GST_CLOCK_TIME_NONE;
+  }
+  timestamp_trace.end ();
+}
+
+/* Destroy notify of received memory, hands the slot back to the sender */
+static void
+gst_spout_src_release_lease (gpointer user_data)
+{
+  delete (GstSpoutFrameLease *) user_data;
+}
+
+/* Weak ref notify of received fd memory, see above */
+static void
+gst_spout_src_fd_memory_freed (gpointer user_data, GstMiniObject * memory)
+{
+  gst_spout_src_release_lease (user_data);
+}
+
+/* @size bytes of the frame in @lease as memory that holds on to the lease
+ * until it is freed, so the sender leaves the slot alone until then */
+static GstMemory *
+gst_spout_src_wrap_lease (GstSpoutSrc * self, GstSpoutFrameLease && lease,
+    gsize size)
+{
+  GstSpoutSrcPrivate *priv = self->priv;
+  GstMemory *mem;
+  
+  if (!priv->fd_output) {
+    GstSpoutFrameLease *held = new GstSpoutFrameLease (std::move (lease));
+    
+    return gst_memory_new_wrapped (GST_MEMORY_FLAG_READONLY,
+        (gpointer) held->data, held->size, 0, size, held,
+        gst_spout_src_release_lease);
+  }
+  
+  if (lease.fd < 0 || !priv->fd_allocator) {
+    GST_ELEMENT_ERROR (self, STREAM, FORMAT,
+        ("Sender doesn't share frames by fd"),
+        ("memory:FdMemory was negotiated"));
+    return NULL;
+  }
+  
+  /* Memory of its own for every frame rather than a share of one for the
+   * whole ring: a share of a share has the root as its parent, which
+   * wouldn't keep the lease. The lease keeps the fd open, the memory maps
+   * it itself if anybody maps the frame */
+  mem = gst_fd_allocator_alloc (priv->fd_allocator, lease.fd,
+      lease.offset + lease.size, (GstFdMemoryFlags)
+      (GST_FD_MEMORY_FLAG_KEEP_MAPPED | GST_FD_MEMORY_FLAG_DONT_CLOSE));
+  if (!mem) {
+    GST_ERROR_OBJECT (self, "Failed to wrap fd %d", lease.fd);
+    return NULL;
+  }
+  
+  gst_memory_resize (mem, lease.offset, size);
+  GST_MINI_OBJECT_FLAG_SET (mem, GST_MEMORY_FLAG_READONLY);
+  gst_mini_object_weak_ref (GST_MINI_OBJECT_CAST (mem),
+      gst_spout_src_fd_memory_freed, new GstSpoutFrameLease (std::move (lease)));
+  
+  return mem;
+}
+
+/* backend != spout: wait for the receiver's next frame and push it in place.
+ * No GPU to render standby frames on, so we just wait while disconnected */
+static GstFlowReturn
+gst_spout_src_create_received (GstSpoutSrc * self, GstSpoutStateView & state,
+    GstBuffer ** buf)
+{
+  GstSpoutSrcPrivate *priv = self->priv;
+  GstSpoutFrameLease lease;
+  GstBuffer *buffer;
+  GstFlowReturn ret;
+  
+  GstClockTime wait_start = gst_util_get_timestamp ();
+  GstSpoutTraceScope receive_trace ("receive");
+  
+  for (;;) {
+    GstSpoutReceiveResult result;
+    
+    if (priv->flushing)
+      return GST_FLOW_FLUSHING;
+    
+    priv->state.refresh (state);
+    if (!state->connected) {
+      if (priv->receiver->finished ()) {
+        GST_INFO_OBJECT (self, "No sender will come back, end of stream");
+        return GST_FLOW_EOS;
+      }
+      
+      if (priv->reconnect_given_up) {
+        GST_ELEMENT_ERROR (self, RESOURCE, NOT_FOUND,
+            ("Sender is gone and reconnecting gave up"), (NULL));
+        return GST_FLOW_ERROR;
+      }
+      
+      GST_DEBUG_OBJECT (self, "No sender, parking");
+      if (!gst_spout_src_wait (self, state, SENDER_PARK_TIMEOUT))
+        return GST_FLOW_FLUSHING;
+      continue;
+    }
+    
+    /* unlock() wakes the receiver up */
+    result = priv->receiver->receive (lease,
+        std::chrono::milliseconds (MAX (priv->wait_timeout, 1)));
+    if (result == GstSpoutReceiveResult::FRAME)
+      break;
+    
+    if (result == GstSpoutReceiveResult::ERROR)
+      gst_spout_src_receive_failed (self);
+  }
+  
+  receive_trace.end ();
+  
+  GstClockTime now = gst_util_get_timestamp ();
+  priv->last_receive_time = now;
+  priv->stats.received.add ();
+  priv->stats.receive_time.record (now - wait_start);
+  
+  /* The format may change between frames, as replayed senders' do.
+   * accept_frame() renegotiates */
+  GstSpoutFrameFormat format = priv->receiver->format ();
+  if (format != priv->received_format) {
+    std::lock_guard<std::mutex> lock(priv->lock);
+    
+    GST_INFO_OBJECT (self, "Sender format changed: %ux%u, format %u, "
+        "stride %u", format.width, format.height, format.format,
+        format.stride);
+    gst_spout_src_apply_received_format (self, format);
+    gst_spout_src_publish_state (self);
+  }
+  
+  priv->state.refresh (state);
+  const GstVideoInfo *info = &state->video_info;
+  
+  if (lease.size < GST_VIDEO_INFO_SIZE (info)) {
+    GST_ELEMENT_ERROR (self, STREAM, FORMAT,
+        ("Sender frame is smaller than its format"),
+        ("Frame of %" G_GSIZE_FORMAT " bytes is too small for %"
+            G_GSIZE_FORMAT, lease.size, GST_VIDEO_INFO_SIZE (info)));
+    return GST_FLOW_ERROR;
+  }
+  
+  gst_spout_src_record_frame (self, now, lease.frame, lease.timestamp,
+      lease.data, info);
+  
+  /* The sender's timestamp is on the same monotonic clock as ours, it tells
+   * when the frame was made rather than when we got to it. Unless it's in
+   * the future or too old to be true */
+  GstClockTime made = (GstClockTime) lease.timestamp;
+  GstClockTime received =
+      made && made <= now && now - made < GST_SECOND ? made : now;
+  guint64 frame = lease.frame;
+  GstMemory *mem = gst_spout_src_wrap_lease (self, std::move (lease),
+      GST_VIDEO_INFO_SIZE (info));
+  
+  if (!mem)
+    return GST_FLOW_ERROR;
+  
+  buffer = gst_buffer_new ();
+  gst_buffer_append_memory (buffer, mem);
+  gst_buffer_add_video_meta_full (buffer, GST_VIDEO_FRAME_FLAG_NONE,
+      GST_VIDEO_INFO_FORMAT (info), GST_VIDEO_INFO_WIDTH (info),
+      GST_VIDEO_INFO_HEIGHT (info), GST_VIDEO_INFO_N_PLANES (info),
+      info->offset, info->stride);
+  
+  GST_BUFFER_OFFSET (buffer) = frame;
+  GST_BUFFER_PTS (buffer) = received;
+  
+  ret = gst_spout_src_accept_frame (self, state, buffer);
+  if (ret != GST_FLOW_OK) {
+    gst_buffer_unref (buffer);
+    return ret;
   }
   
+  gst_spout_src_stamp_frame (self, state, buffer);
+  
   *buf = buffer;
   return GST_FLOW_OK;
 }
@@ -1334,8 +5359,16 @@ gst_spout_src_create (GstBaseSrc * src, guint64 offset, guint size,
 static gboolean
 plugin_init (GstPlugin * plugin)
 {
-  return gst_element_register (plugin, "spoutsrc", GST_RANK_NONE,
-      GST_TYPE_SPOUT_SRC);
+  if (!gst_element_register (plugin, "spoutsrc", GST_RANK_NONE,
+      GST_TYPE_SPOUT_SRC))
+    return FALSE;
+  
+#ifdef HAVE_SPOUT
+  return gst_device_provider_register (plugin, "spoutdeviceprovider",
+      GST_RANK_SECONDARY, GST_TYPE_SPOUT_DEVICE_PROVIDER);
+#else
+  return TRUE;
+#endif
 }
 
 /* Register the plugin with GStreamer. */
@@ -25,7 +25,6 @@
 #include <gst/gst.h>
 #include <gst/base/gstbasesrc.h>
 #include <gst/video/video.h>
-#include <gst/d3d11/gstd3d11.h>
 #include <mutex>
 #include <string>
 
@@ -38,4 +37,14 @@ G_DECLARE_FINAL_TYPE (GstSpoutSrc, gst_spout_src,
 /* Define available format strings for templates and cap negotiation */
 #define GST_SPOUT_SRC_FORMATS "{ BGRA, RGBA, RGBx, BGRx }"
 
+/* D3D11 output additionally converts to these on the GPU */
+#define GST_SPOUT_SRC_D3D11_FORMATS "{ BGRA, RGBA, RGBx, BGRx, NV12, P010_10LE }"
+
+/* System memory output additionally converts to these while reading back */
+#define GST_SPOUT_SRC_SYSMEM_FORMATS "{ BGRA, RGBA, RGBx, BGRx, NV12, I420 }"
+
+/* Buffers are GstFdMemory, a slot of the sender's shared memory at an offset
+ * of its fd. Offered by system memory backends that share frames by fd */
+#define GST_SPOUT_SRC_CAPS_FEATURE_MEMORY_FD "memory:FdMemory"
+
 G_END_DECLS
\ No newline at end of file
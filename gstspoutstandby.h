@@ -0,0 +1,242 @@
+/* GStreamer
+ * Copyright (C) 2023 Your Name <your.email@example.com>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+#pragma once
+
+/* Standby frames for spoutsrc while no sender is connected.
+ *
+ * A standby frame is rendered once per format and mode and then handed out
+ * again and again, so an outage costs nothing per frame. Free of GStreamer,
+ * D3D11 and Spout: the element plugs in a backend that renders on the GPU,
+ * a system-memory backend can drive the same logic on any platform. */
+
+#include <cstdint>
+
+#include "gstspoutcaps.h"
+#include "gstspoutpacer.h"
+
+typedef enum
+{
+  GST_SPOUT_STANDBY_BLACK,        /* opaque black */
+  GST_SPOUT_STANDBY_LAST_FRAME,   /* hold the last received frame */
+  GST_SPOUT_STANDBY_COLOR,        /* solid standby-color */
+  GST_SPOUT_STANDBY_PATTERN,      /* colour bars */
+} GstSpoutStandbyMode;
+
+#define GST_SPOUT_STANDBY_BARS 8
+
+/* 75% colour bars, ARGB */
+static inline uint32_t
+gst_spout_standby_bar_color (unsigned int bar)
+{
+  static const uint32_t colors[GST_SPOUT_STANDBY_BARS] = {
+    0xffbfbfbf, 0xffbfbf00, 0xff00bfbf, 0xff00bf00,
+    0xffbf00bf, 0xffbf0000, 0xff0000bf, 0xff000000,
+  };
+
+  return colors[bar % GST_SPOUT_STANDBY_BARS];
+}
+
+/* Horizontal extent of @bar in a frame @width pixels wide */
+static inline void
+gst_spout_standby_bar_bounds (uint32_t width, unsigned int bar,
+    uint32_t * left, uint32_t * right)
+{
+  *left = (uint32_t) ((uint64_t) width * bar / GST_SPOUT_STANDBY_BARS);
+  *right = (uint32_t) ((uint64_t) width * (bar + 1) / GST_SPOUT_STANDBY_BARS);
+}
+
+/* Backend requirements:
+ *   Frame      nullable, refcounted handle, e.g. GstBuffer *
+ *   Frame render (const GstSpoutSenderFormat &, GstSpoutStandbyMode, uint32_t argb)
+ *              fill a new frame for BLACK, COLOR or PATTERN
+ *   Frame copy (Frame, const GstSpoutSenderFormat &)
+ *              duplicate a received frame into one we own
+ *   void ref (Frame), void unref (Frame)
+ */
+template <typename Backend>
+class GstSpoutStandby
+{
+public:
+  using Frame = typename Backend::Frame;
+
+  GstSpoutStandby () = default;
+  ~GstSpoutStandby () { clear (); }
+
+  GstSpoutStandby (const GstSpoutStandby &) = delete;
+  GstSpoutStandby & operator= (const GstSpoutStandby &) = delete;
+
+  void configure (GstSpoutStandbyMode mode, uint32_t argb)
+  {
+    if (mode == mode_ && argb == argb_)
+      return;
+
+    mode_ = mode;
+    argb_ = argb;
+    drop (cached_);
+    if (mode_ != GST_SPOUT_STANDBY_LAST_FRAME)
+      drop (last_);
+  }
+
+  GstSpoutStandbyMode mode () const { return mode_; }
+
+  /* A real frame went out. Only kept (a ref, no copy) in last-frame mode */
+  void remember (Frame frame, const GstSpoutSenderFormat & format)
+  {
+    if (mode_ != GST_SPOUT_STANDBY_LAST_FRAME || !frame)
+      return;
+
+    backend_.ref (frame);
+    drop (last_);
+    last_ = frame;
+    last_format_ = format;
+
+    /* The next outage should hold this frame, not the one before */
+    if (cached_is_last_)
+      drop (cached_);
+  }
+
+  /* A new reference to the standby frame for @format, or a null Frame if
+   * the backend failed */
+  Frame get (const GstSpoutSenderFormat & format)
+  {
+    if (mode_ == GST_SPOUT_STANDBY_LAST_FRAME && last_ &&
+        same_geometry (last_format_, format)) {
+      /* Copied once, after that the received frame can go back where it
+       * came from */
+      Frame copy = backend_.copy (last_, format);
+      drop (last_);
+
+      if (copy) {
+        drop (cached_);
+        cached_ = copy;
+        cached_format_ = format;
+        cached_is_last_ = true;
+        copies_++;
+      }
+    }
+
+    if (cached_ && same_geometry (cached_format_, format)) {
+      backend_.ref (cached_);
+      return cached_;
+    }
+
+    /* Nothing held in last-frame mode yet, stand in with black */
+    GstSpoutStandbyMode render_mode = mode_ == GST_SPOUT_STANDBY_LAST_FRAME ?
+        GST_SPOUT_STANDBY_BLACK : mode_;
+
+    drop (cached_);
+    cached_ = backend_.render (format, render_mode, argb_);
+    if (!cached_)
+      return cached_;
+
+    cached_format_ = format;
+    cached_is_last_ = false;
+    renders_++;
+
+    backend_.ref (cached_);
+    return cached_;
+  }
+
+  void clear ()
+  {
+    drop (cached_);
+    drop (last_);
+  }
+
+  uint64_t renders () const { return renders_; }
+  uint64_t copies () const { return copies_; }
+  Backend & backend () { return backend_; }
+
+private:
+  static bool same_geometry (const GstSpoutSenderFormat & a,
+      const GstSpoutSenderFormat & b)
+  {
+    return a.width == b.width && a.height == b.height && a.format == b.format;
+  }
+
+  void drop (Frame & frame)
+  {
+    if (frame)
+      backend_.unref (frame);
+    frame = Frame ();
+    if (&frame == &cached_)
+      cached_is_last_ = false;
+  }
+
+  Backend backend_;
+  GstSpoutStandbyMode mode_ = GST_SPOUT_STANDBY_BLACK;
+  uint32_t argb_ = 0xff000000;
+
+  Frame cached_ = Frame ();
+  GstSpoutSenderFormat cached_format_;
+  bool cached_is_last_ = false;
+
+  Frame last_ = Frame ();
+  GstSpoutSenderFormat last_format_;
+
+  uint64_t renders_ = 0;
+  uint64_t copies_ = 0;
+};
+
+/* When standby frames go out and what they are stamped with. They sit on
+ * an exact grid at the output rate from the first one of an outage on, so
+ * timestamps advance by exactly one frame duration however late each frame
+ * is made; frames we were too late for are skipped, not bunched up. Times
+ * are in nanoseconds */
+class GstSpoutStandbyTimer
+{
+public:
+  struct Slot
+  {
+    uint64_t due = 0;           /* monotonic time to push the frame at */
+    uint64_t pts = 0;           /* running time to stamp it with */
+    uint64_t duration = 0;      /* up to the next slot's pts */
+  };
+
+  /* The outage is over, the next one starts a new grid */
+  void reset () { pacer_.reset (); started_ = false; }
+
+  /* The next frame at @num/@den fps for a caller at monotonic @now, when
+   * the running time is @running_time. False without a valid rate */
+  bool next (int num, int den, uint64_t now, uint64_t running_time,
+      Slot & slot)
+  {
+    pacer_.set_rate (num, den);
+    if (!pacer_.configured ())
+      return false;
+
+    slot.due = pacer_.next_tick (now);
+    if (!started_) {
+      started_ = true;
+      offset_ = (int64_t) (running_time - now);
+    }
+    slot.pts = (uint64_t) ((int64_t) slot.due + offset_);
+    slot.duration = pacer_.duration ();
+
+    return true;
+  }
+
+  /* Frames we were too late for since the outage began */
+  uint64_t missed () const { return pacer_.missed (); }
+
+private:
+  GstSpoutCfrPacer pacer_;
+  bool started_ = false;
+  int64_t offset_ = 0;          /* running time minus monotonic time */
+};
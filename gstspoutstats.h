@@ -0,0 +1,162 @@
+/* GStreamer
+ * Copyright (C) 2023 Your Name <your.email@example.com>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+#pragma once
+
+/* Always-on statistics for spoutsrc.
+ *
+ * Counters and duration histograms kept in relaxed atomics, so the frame
+ * path pays a few uncontended atomic adds and readers on any thread get a
+ * consistent enough snapshot without a lock. Free of GStreamer so a
+ * synthetic source can drive it on any platform. Durations are in
+ * nanoseconds. */
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+
+/* Durations in power-of-two buckets of microseconds: bucket 0 is under
+ * 2 us, bucket i covers [2^i, 2^(i+1)) us and the last one everything from
+ * 2^(BUCKETS-1) us (about 33 ms) up */
+class GstSpoutHistogram
+{
+public:
+  static constexpr unsigned BUCKETS = 16;
+
+  struct Snapshot
+  {
+    uint64_t count = 0;
+    uint64_t sum = 0;
+    uint64_t max = 0;
+    uint64_t buckets[BUCKETS] = { };
+
+    uint64_t mean () const { return count ? sum / count : 0; }
+
+    /* Upper bound of the bucket holding the @percent percentile, at most
+     * the largest duration seen */
+    uint64_t percentile (unsigned percent) const
+    {
+      uint64_t rank = (count * percent + 99) / 100;
+      uint64_t seen = 0;
+
+      for (unsigned i = 0; i < BUCKETS; i++) {
+        seen += buckets[i];
+        if (seen >= rank && seen > 0)
+          return i + 1 < BUCKETS ? std::min (upper_bound (i), max) : max;
+      }
+
+      return 0;
+    }
+  };
+
+  /* Smallest duration that no longer falls into bucket @i */
+  static uint64_t upper_bound (unsigned i) { return (uint64_t) 2000 << i; }
+
+  static unsigned bucket (uint64_t duration)
+  {
+    uint64_t us = duration / 1000;
+    unsigned i = 0;
+
+    while (us >= 2 && i + 1 < BUCKETS) {
+      us >>= 1;
+      i++;
+    }
+
+    return i;
+  }
+
+  void record (uint64_t duration)
+  {
+    uint64_t max = max_.load (std::memory_order_relaxed);
+
+    buckets_[bucket (duration)].fetch_add (1, std::memory_order_relaxed);
+    sum_.fetch_add (duration, std::memory_order_relaxed);
+    count_.fetch_add (1, std::memory_order_relaxed);
+
+    while (duration > max &&
+        !max_.compare_exchange_weak (max, duration, std::memory_order_relaxed))
+      ;
+  }
+
+  void reset ()
+  {
+    for (auto & bucket : buckets_)
+      bucket.store (0, std::memory_order_relaxed);
+    sum_.store (0, std::memory_order_relaxed);
+    count_.store (0, std::memory_order_relaxed);
+    max_.store (0, std::memory_order_relaxed);
+  }
+
+  Snapshot snapshot () const
+  {
+    Snapshot snapshot;
+
+    for (unsigned i = 0; i < BUCKETS; i++)
+      snapshot.buckets[i] = buckets_[i].load (std::memory_order_relaxed);
+    snapshot.sum = sum_.load (std::memory_order_relaxed);
+    snapshot.count = count_.load (std::memory_order_relaxed);
+    snapshot.max = max_.load (std::memory_order_relaxed);
+
+    return snapshot;
+  }
+
+private:
+  std::atomic<uint64_t> buckets_[BUCKETS] = { };
+  std::atomic<uint64_t> sum_ { 0 };
+  std::atomic<uint64_t> count_ { 0 };
+  std::atomic<uint64_t> max_ { 0 };
+};
+
+/* A counter only ever bumped, read from anywhere */
+class GstSpoutCounter
+{
+public:
+  void add (uint64_t n = 1) { value_.fetch_add (n, std::memory_order_relaxed); }
+  void reset () { value_.store (0, std::memory_order_relaxed); }
+  uint64_t get () const { return value_.load (std::memory_order_relaxed); }
+
+private:
+  std::atomic<uint64_t> value_ { 0 };
+};
+
+struct GstSpoutStats
+{
+  GstSpoutCounter received;     /* frames received from the sender */
+  GstSpoutCounter pushed;       /* buffers that left the element */
+  GstSpoutCounter duplicated;   /* received frames the sender had already sent */
+  GstSpoutCounter dropped;      /* frames replaced by newer ones before going out */
+  GstSpoutCounter standby;      /* standby frames pushed */
+  GstSpoutCounter connects;     /* connections made to a sender */
+
+  GstSpoutHistogram receive_time;   /* waiting for a new frame */
+  GstSpoutHistogram copy_time;      /* taking a frame off the sender */
+  GstSpoutHistogram acquire_time;   /* getting a buffer to receive into */
+
+  void reset ()
+  {
+    received.reset ();
+    pushed.reset ();
+    duplicated.reset ();
+    dropped.reset ();
+    standby.reset ();
+    connects.reset ();
+    receive_time.reset ();
+    copy_time.reset ();
+    acquire_time.reset ();
+  }
+};
@@ -0,0 +1,116 @@
+/* GStreamer
+ * Copyright (C) 2023 Your Name <your.email@example.com>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#pragma once
+
+/* Cache of opened sender textures for spoutsrc's zero-copy mode.
+ *
+ * Opening a shared handle is comparatively expensive, so each handle is
+ * opened once and kept until it falls out of the cache. The texture API is
+ * abstracted by a backend, which lets a mock backend check the lifetime
+ * rules without a GPU:
+ *
+ * - the cache owns one reference per entry
+ * - acquire() hands out an extra reference the caller must unref
+ * - evicting or clearing an entry only drops the cache's reference, so
+ *   textures still held by buffers downstream stay valid
+ *
+ * A backend provides Handle and Texture types plus:
+ *   Texture open (Handle)   - new texture with one reference, or nullptr
+ *   void ref (Texture)
+ *   void unref (Texture)
+ */
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+template <typename Backend>
+class GstSpoutTextureCache
+{
+public:
+  using Handle = typename Backend::Handle;
+  using Texture = typename Backend::Texture;
+
+  explicit GstSpoutTextureCache (Backend backend = Backend (),
+      size_t capacity = 2) : backend_ (std::move (backend)),
+      capacity_ (capacity ? capacity : 1)
+  {
+  }
+
+  ~GstSpoutTextureCache () { clear (); }
+
+  GstSpoutTextureCache (const GstSpoutTextureCache &) = delete;
+  GstSpoutTextureCache & operator= (const GstSpoutTextureCache &) = delete;
+
+  Backend & backend () { return backend_; }
+
+  /* Texture for @handle with a reference owned by the caller, opened on
+   * first use. Returns nullptr if the handle can't be opened */
+  Texture acquire (Handle handle)
+  {
+    for (size_t i = 0; i < entries_.size (); i++) {
+      if (entries_[i].first != handle)
+        continue;
+
+      /* Keep entries in order of use, most recent first */
+      if (i != 0)
+        std::rotate (entries_.begin (), entries_.begin () + i,
+            entries_.begin () + i + 1);
+
+      backend_.ref (entries_[0].second);
+      return entries_[0].second;
+    }
+
+    Texture texture = backend_.open (handle);
+    if (!texture)
+      return nullptr;
+
+    opened_++;
+
+    if (entries_.size () >= capacity_) {
+      backend_.unref (entries_.back ().second);
+      entries_.pop_back ();
+    }
+
+    entries_.insert (entries_.begin (), std::make_pair (handle, texture));
+    backend_.ref (texture);
+
+    return texture;
+  }
+
+  /* Drop every entry, e.g. when the device goes away */
+  void clear ()
+  {
+    for (auto & entry : entries_)
+      backend_.unref (entry.second);
+    entries_.clear ();
+  }
+
+  size_t size () const { return entries_.size (); }
+  uint64_t opened () const { return opened_; }
+
+private:
+  Backend backend_;
+  size_t capacity_;
+  std::vector<std::pair<Handle, Texture>> entries_;
+  uint64_t opened_ = 0;
+};
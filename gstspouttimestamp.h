@@ -0,0 +1,360 @@
+/* GStreamer
+ * Copyright (C) 2023 Your Name <your.email@example.com>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+#pragma once
+
+/* Timestamping and frame rates for spoutsrc.
+ *
+ * Turns frame arrival times, which carry our own scheduling jitter, into
+ * evenly spaced timestamps, and reported frame rates into the exact
+ * fractions downstream expects. Free of GStreamer and Spout so recorded
+ * arrival traces can drive it on any platform. Not thread-safe, only the
+ * streaming thread timestamps. Times are in nanoseconds. */
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <numeric>
+
+typedef enum
+{
+  GST_SPOUT_TIMESTAMP_ARRIVAL,        /* when the frame was received */
+  GST_SPOUT_TIMESTAMP_SMOOTHED,       /* arrival times fitted to a cadence */
+  GST_SPOUT_TIMESTAMP_SENDER_FRAME,   /* sender frame number at the frame rate */
+} GstSpoutTimestampMode;
+
+/* Snap a measured or advertised rate to the nearest broadcast or display
+ * rate within @tolerance (relative), otherwise keep it to 1/1000 fps.
+ * Returns TRUE if it snapped */
+static inline bool
+gst_spout_snap_framerate (double fps, int * num, int * den,
+    double tolerance = 0.005)
+{
+  static const int rates[][2] = {
+    { 24000, 1001 }, { 24, 1 }, { 25, 1 }, { 30000, 1001 }, { 30, 1 },
+    { 48, 1 }, { 50, 1 }, { 60000, 1001 }, { 60, 1 }, { 72, 1 }, { 75, 1 },
+    { 90, 1 }, { 100, 1 }, { 120000, 1001 }, { 120, 1 }, { 144, 1 },
+    { 165, 1 }, { 240, 1 },
+  };
+  double best_error = tolerance;
+  int best = -1;
+
+  if (!(fps > 0.0)) {
+    *num = 0;
+    *den = 1;
+    return false;
+  }
+
+  for (int i = 0; i < (int) (sizeof (rates) / sizeof (rates[0])); i++) {
+    double rate = (double) rates[i][0] / rates[i][1];
+    double error = std::fabs (fps - rate) / rate;
+
+    if (error <= best_error) {
+      best_error = error;
+      best = i;
+    }
+  }
+
+  if (best >= 0) {
+    *num = rates[best][0];
+    *den = rates[best][1];
+    return true;
+  }
+
+  long long n = std::llround (fps * 1000);
+  long long g = std::gcd (n, 1000LL);
+
+  *num = (int) (n / g);
+  *den = (int) (1000 / g);
+
+  return false;
+}
+
+/* Nanoseconds per frame at @num/@den fps, as gst_spout_snap_framerate()
+ * gives it. 0 without a rate */
+static inline uint64_t
+gst_spout_frame_duration (int num, int den)
+{
+  if (num <= 0 || den <= 0)
+    return 0;
+
+  return (uint64_t) 1000000000 * (uint64_t) den / (uint64_t) num;
+}
+
+/* Produces the timestamp of each frame from its arrival time.
+ *
+ * Scheduling only ever delays arrivals, so smoothed mode fits a line through
+ * the recent (frame position, arrival) pairs and runs it along their lower
+ * envelope: timestamps are evenly spaced and never later than the arrival.
+ * Positions come from the sender frame number when the sender counts frames,
+ * otherwise from the arrival gap in periods, so skipped frames leave a gap
+ * instead of stretching the cadence. Sender frame mode counts exact periods
+ * from an anchor that only moves when arrivals drift too far from it */
+class GstSpoutTimestamper
+{
+public:
+  static constexpr unsigned WINDOW = 64;
+  static constexpr unsigned MIN_SAMPLES = 8;
+  /* Periods an arrival may stray from the cadence before resyncing */
+  static constexpr double RESYNC_PERIODS = 2.0;
+  /* Frames landing on the previous position per window before the cadence
+   * is taken to have sped up */
+  static constexpr unsigned MAX_COLLISIONS = WINDOW / 8;
+
+  void reset ()
+  {
+    count_ = 0;
+    next_ = 0;
+    slope_ = 0.0;
+    have_last_ = false;
+    have_anchor_ = false;
+  }
+
+  /* Nominal period, from the negotiated frame rate */
+  void set_frame_duration (uint64_t duration) { frame_duration_ = duration; }
+
+  /* Timestamp of a frame that arrived at @arrival. @sender_frame is the
+   * sender's frame number, <= 0 if it doesn't count frames */
+  uint64_t timestamp (GstSpoutTimestampMode mode, uint64_t arrival,
+      int64_t sender_frame)
+  {
+    uint64_t pts;
+
+    switch (mode) {
+      case GST_SPOUT_TIMESTAMP_SMOOTHED:
+        pts = smoothed (arrival, sender_frame);
+        break;
+      case GST_SPOUT_TIMESTAMP_SENDER_FRAME:
+        pts = sender_frame > 0 && frame_duration_ > 0 ?
+            counted (arrival, sender_frame) : smoothed (arrival, sender_frame);
+        break;
+      default:
+        pts = arrival;
+        break;
+    }
+
+    /* Resyncing must not go backwards */
+    if (have_last_ && pts <= last_pts_)
+      pts = last_pts_ + 1;
+
+    last_pts_ = pts;
+    last_arrival_ = arrival;
+    last_frame_ = sender_frame;
+    have_last_ = true;
+
+    return pts;
+  }
+
+  /* Current period estimate, the nominal one until the fit has settled */
+  uint64_t period () const
+  {
+    return slope_ > 0.0 ? (uint64_t) std::llround (slope_) : frame_duration_;
+  }
+
+  uint64_t resyncs () const { return resyncs_; }
+
+private:
+  struct Sample
+  {
+    double x;     /* frame position relative to origin */
+    double y;     /* arrival relative to origin */
+  };
+
+  /* Frame position of the current arrival */
+  int64_t position (uint64_t arrival, int64_t sender_frame)
+  {
+    if (!have_last_)
+      return 0;
+
+    if (sender_frame > 0 && last_frame_ > 0 && sender_frame > last_frame_)
+      return last_position_ + (sender_frame - last_frame_);
+
+    /* Arrivals are only ever late, so the position is the last period
+     * starting at or before the arrival on the envelope. A little slack
+     * absorbs the envelope's own error */
+    if (count_ >= MIN_SAMPLES && slope_ > 0.0) {
+      double y = (double) ((int64_t) (arrival - origin_arrival_));
+      return origin_position_ +
+          (int64_t) std::floor ((y - intercept_ - shift_) / slope_ + 0.1);
+    }
+
+    double period = (double) this->period ();
+    int64_t step = 1;
+    if (period > 0.0 && arrival > last_arrival_)
+      step = std::max<int64_t> (1, std::llround ((arrival - last_arrival_) / period));
+
+    return last_position_ + step;
+  }
+
+  void restart (int64_t position, uint64_t arrival)
+  {
+    count_ = 0;
+    next_ = 0;
+    origin_position_ = position;
+    origin_arrival_ = arrival;
+    slope_ = 0.0;
+    window_frames_ = collisions_ = 0;
+  }
+
+  uint64_t smoothed (uint64_t arrival, int64_t sender_frame)
+  {
+    int64_t pos = position (arrival, sender_frame);
+
+    if (++window_frames_ >= WINDOW)
+      window_frames_ = collisions_ = 0;
+
+    /* Landing on the previous frame's position means that one was late by
+     * more than a period, move it back rather than this one forward. Too
+     * often and the sender runs faster than the fit */
+    if (count_ > 0 && pos == last_position_) {
+      if (++collisions_ > MAX_COLLISIONS) {
+        resyncs_++;
+        count_ = 0;
+        slope_ = 0.0;
+        pos = last_position_ + 1;
+      } else {
+        samples_[(next_ + WINDOW - 1) % WINDOW].x -= 1.0;
+      }
+    } else if (have_last_ && pos < last_position_) {
+      pos = last_position_ + 1;
+    }
+
+    if (count_ == 0 || pos < origin_position_)
+      restart (pos, arrival);
+    last_position_ = pos;
+
+    /* Far off the fitted cadence: the sender stalled or changed rate */
+    if (count_ >= MIN_SAMPLES) {
+      double predicted = fit (pos - origin_position_);
+      double residual = (double) ((int64_t) (arrival - origin_arrival_)) - predicted;
+
+      if (std::fabs (residual) > RESYNC_PERIODS * period ()) {
+        resyncs_++;
+        restart (pos, arrival);
+      }
+    }
+
+    Sample & sample = samples_[next_];
+    sample.x = (double) (pos - origin_position_);
+    sample.y = (double) ((int64_t) (arrival - origin_arrival_));
+    next_ = (next_ + 1) % WINDOW;
+    count_ = std::min (count_ + 1, WINDOW);
+
+    if (count_ < MIN_SAMPLES)
+      return arrival;
+
+    regress ();
+
+    /* Lower envelope: the earliest arrival relative to the line */
+    shift_ = 0.0;
+    for (unsigned i = 0; i < count_; i++)
+      shift_ = std::min (shift_, samples_[i].y - fit (samples_[i].x));
+    if (!std::isfinite (shift_))
+      shift_ = 0.0;
+
+    double pts = (double) origin_arrival_ + fit (sample.x) + shift_;
+
+    return pts <= 0.0 ? 0 : std::min ((uint64_t) std::llround (pts), arrival);
+  }
+
+  uint64_t counted (uint64_t arrival, int64_t sender_frame)
+  {
+    last_position_ = sender_frame;
+
+    /* Sender restarted or went backwards, or arrivals drifted away */
+    if (!have_anchor_ || sender_frame < anchor_frame_) {
+      if (have_anchor_)
+        resyncs_++;
+      anchor (arrival, sender_frame);
+      return arrival;
+    }
+
+    uint64_t pts = anchor_pts_ + (uint64_t) (sender_frame - anchor_frame_) *
+        frame_duration_;
+
+    if (pts > arrival) {
+      /* Arrived earlier than ever, the anchor was late */
+      anchor (arrival, sender_frame);
+      return arrival;
+    }
+
+    if (arrival - pts > RESYNC_PERIODS * frame_duration_) {
+      resyncs_++;
+      anchor (arrival, sender_frame);
+      return arrival;
+    }
+
+    return pts;
+  }
+
+  void anchor (uint64_t arrival, int64_t sender_frame)
+  {
+    anchor_pts_ = arrival;
+    anchor_frame_ = sender_frame;
+    have_anchor_ = true;
+  }
+
+  double fit (double x) const { return intercept_ + slope_ * x; }
+
+  void regress ()
+  {
+    double mx = 0.0, my = 0.0, sxx = 0.0, sxy = 0.0;
+
+    for (unsigned i = 0; i < count_; i++) {
+      mx += samples_[i].x;
+      my += samples_[i].y;
+    }
+    mx /= count_;
+    my /= count_;
+
+    for (unsigned i = 0; i < count_; i++) {
+      double dx = samples_[i].x - mx;
+      sxx += dx * dx;
+      sxy += dx * (samples_[i].y - my);
+    }
+
+    slope_ = sxx > 0.0 ? sxy / sxx : (double) frame_duration_;
+    intercept_ = my - slope_ * mx;
+  }
+
+  uint64_t frame_duration_ = 0;
+
+  Sample samples_[WINDOW] = { };
+  unsigned count_ = 0;
+  unsigned next_ = 0;
+  int64_t origin_position_ = 0;
+  uint64_t origin_arrival_ = 0;
+  double slope_ = 0.0;
+  double intercept_ = 0.0;
+  double shift_ = 0.0;
+  unsigned window_frames_ = 0;
+  unsigned collisions_ = 0;
+
+  bool have_anchor_ = false;
+  uint64_t anchor_pts_ = 0;
+  int64_t anchor_frame_ = 0;
+
+  bool have_last_ = false;
+  uint64_t last_pts_ = 0;
+  uint64_t last_arrival_ = 0;
+  int64_t last_frame_ = 0;
+  int64_t last_position_ = 0;
+
+  uint64_t resyncs_ = 0;
+};
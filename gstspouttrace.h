@@ -0,0 +1,347 @@
+/* GStreamer
+ * Copyright (C) 2023 Your Name <your.email@example.com>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+#pragma once
+
+/* Stage tracing for spoutsrc.
+ *
+ * Tracepoints record how long each stage of producing a frame took into a
+ * ring preallocated per thread on its first event, and the rings can be
+ * written out as Chrome trace JSON for chrome://tracing or Perfetto. A
+ * thread's ring is retired when it exits and handed to the next new thread,
+ * so there are only ever as many rings as threads traced at once. While
+ * tracing is off a tracepoint costs one relaxed load and a branch. Process
+ * wide, as threads are shared between elements. Free of GStreamer so it can
+ * be exercised on any platform. */
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+class GstSpoutTracer
+{
+public:
+  /* Events kept per thread, older ones are overwritten */
+  static constexpr uint64_t RING_SIZE = 8192;
+
+  bool enabled () const { return enabled_.load (std::memory_order_relaxed); }
+  void set_enabled (bool enabled) { enabled_.store (enabled); }
+
+  static uint64_t now ()
+  {
+    return (uint64_t) std::chrono::duration_cast<std::chrono::nanoseconds> (
+        std::chrono::steady_clock::now ().time_since_epoch ()).count ();
+  }
+
+  /* @name must be a string literal, or at least outlive the tracer */
+  void record (const char * name, uint64_t start, uint64_t end, uint64_t arg)
+  {
+    Ring & ring = this->ring ();
+    uint64_t index = ring.written.load (std::memory_order_relaxed);
+    Event & event = ring.events[index % RING_SIZE];
+
+    /* Odd while the slot is being written, see snapshot() */
+    event.seq.store (2 * index + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence (std::memory_order_release);
+    event.name.store (name, std::memory_order_relaxed);
+    event.start.store (start, std::memory_order_relaxed);
+    event.duration.store (end - start, std::memory_order_relaxed);
+    event.arg.store (arg, std::memory_order_relaxed);
+    event.seq.store (2 * index + 2, std::memory_order_release);
+    ring.written.store (index + 1, std::memory_order_release);
+  }
+
+  bool thread_named () { return ring ().named.load (std::memory_order_relaxed); }
+
+  /* Label the calling thread's track, the first name sticks */
+  void name_thread (const std::string & name)
+  {
+    Ring & ring = this->ring ();
+    std::lock_guard<std::mutex> lock (lock_);
+
+    if (!ring.named.load (std::memory_order_relaxed)) {
+      ring.thread_name = name;
+      ring.named.store (true, std::memory_order_relaxed);
+    }
+  }
+
+  /* Every thread's events as Chrome trace JSON */
+  std::string to_json ()
+  {
+    std::lock_guard<std::mutex> lock (lock_);
+    std::string json = "{\"traceEvents\":[";
+    bool first = true;
+
+    for (const auto & ring : rings_) {
+      if (!ring->thread_name.empty ()) {
+        json += first ? "\n" : ",\n";
+        json += "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":";
+        json += std::to_string (ring->tid);
+        json += ",\"args\":{\"name\":\"";
+        append_escaped (json, ring->thread_name.c_str ());
+        json += "\"}}";
+        first = false;
+      }
+
+      for (const Snapshot & event : snapshot (*ring)) {
+        char times[64];
+
+        std::snprintf (times, sizeof (times), "%.3f,\"dur\":%.3f",
+            event.start / 1000.0, event.duration / 1000.0);
+
+        json += first ? "\n" : ",\n";
+        json += "{\"name\":\"";
+        append_escaped (json, event.name);
+        json += "\",\"cat\":\"spoutsrc\",\"ph\":\"X\",\"ts\":";
+        json += times;
+        json += ",\"pid\":1,\"tid\":";
+        json += std::to_string (ring->tid);
+        json += ",\"args\":{\"frame\":";
+        json += std::to_string (event.arg);
+        json += "}}";
+        first = false;
+      }
+    }
+
+    json += "\n],\"displayTimeUnit\":\"ms\"}\n";
+
+    return json;
+  }
+
+  /* Rings allocated so far, live or retired */
+  size_t rings ()
+  {
+    std::lock_guard<std::mutex> lock (lock_);
+
+    return rings_.size ();
+  }
+
+  bool dump (const char * path)
+  {
+    std::string json = to_json ();
+    FILE *file = std::fopen (path, "wb");
+
+    if (!file)
+      return false;
+
+    bool ok = std::fwrite (json.data (), 1, json.size (), file) == json.size ();
+
+    return std::fclose (file) == 0 && ok;
+  }
+
+private:
+  struct Event
+  {
+    std::atomic<uint64_t> seq { 0 };
+    std::atomic<const char *> name { nullptr };
+    std::atomic<uint64_t> start { 0 };
+    std::atomic<uint64_t> duration { 0 };
+    std::atomic<uint64_t> arg { 0 };
+  };
+
+  struct Snapshot
+  {
+    const char *name;
+    uint64_t start;
+    uint64_t duration;
+    uint64_t arg;
+  };
+
+  struct Ring
+  {
+    unsigned tid = 0;
+    std::string thread_name;    /* guarded by the tracer lock */
+    bool retired = false;       /* guarded by the tracer lock */
+    std::atomic<bool> named { false };
+    std::atomic<uint64_t> written { 0 };
+    Event events[RING_SIZE];
+  };
+
+  /* Retires the thread's ring as the thread exits */
+  struct RingOwner
+  {
+    GstSpoutTracer *tracer = nullptr;
+    Ring *ring = nullptr;
+
+    ~RingOwner ()
+    {
+      if (ring)
+        tracer->retire (ring);
+    }
+  };
+
+  /* The calling thread's ring, taken on its first event. A retired ring is
+   * reused if there is one, its events are dumped until then */
+  Ring & ring ()
+  {
+    static thread_local RingOwner owner;
+
+    if (!owner.ring) {
+      std::lock_guard<std::mutex> lock (lock_);
+      Ring *ring = nullptr;
+
+      for (const auto & candidate : rings_) {
+        if (candidate->retired) {
+          ring = candidate.get ();
+          break;
+        }
+      }
+
+      if (ring) {
+        /* Stale events sit past written, where snapshot() doesn't look, and
+         * are overwritten slot by slot with odd sequence numbers first */
+        ring->thread_name.clear ();
+        ring->retired = false;
+        ring->named.store (false, std::memory_order_relaxed);
+        ring->written.store (0, std::memory_order_release);
+      } else {
+        rings_.push_back (std::make_unique<Ring> ());
+        ring = rings_.back ().get ();
+      }
+
+      /* A new track, Chrome would mix it up with the previous thread's */
+      ring->tid = ++next_tid_;
+      owner.tracer = this;
+      owner.ring = ring;
+    }
+
+    return *owner.ring;
+  }
+
+  void retire (Ring * ring)
+  {
+    std::lock_guard<std::mutex> lock (lock_);
+
+    ring->retired = true;
+  }
+
+  /* Events of @ring in order, skipping any the thread overwrites while we
+   * copy them */
+  static std::vector<Snapshot> snapshot (const Ring & ring)
+  {
+    uint64_t written = ring.written.load (std::memory_order_acquire);
+    uint64_t first = written > RING_SIZE ? written - RING_SIZE : 0;
+    std::vector<Snapshot> events;
+
+    events.reserve (written - first);
+    for (uint64_t index = first; index < written; index++) {
+      const Event & event = ring.events[index % RING_SIZE];
+      Snapshot snapshot;
+
+      if (event.seq.load (std::memory_order_acquire) != 2 * index + 2)
+        continue;
+
+      snapshot.name = event.name.load (std::memory_order_relaxed);
+      snapshot.start = event.start.load (std::memory_order_relaxed);
+      snapshot.duration = event.duration.load (std::memory_order_relaxed);
+      snapshot.arg = event.arg.load (std::memory_order_relaxed);
+
+      std::atomic_thread_fence (std::memory_order_acquire);
+      if (event.seq.load (std::memory_order_relaxed) != 2 * index + 2)
+        continue;
+
+      events.push_back (snapshot);
+    }
+
+    return events;
+  }
+
+  /* @text as the inside of a JSON string */
+  static void append_escaped (std::string & json, const char * text)
+  {
+    for (; text && *text; text++) {
+      unsigned char c = (unsigned char) *text;
+
+      if (c == '"' || c == '\\') {
+        json += '\\';
+        json += (char) c;
+      } else if (c < 0x20) {
+        char escaped[8];
+
+        std::snprintf (escaped, sizeof (escaped), "\\u%04x", c);
+        json += escaped;
+      } else {
+        json += (char) c;
+      }
+    }
+  }
+
+  std::atomic<bool> enabled_ { false };
+  std::mutex lock_;
+  std::vector<std::unique_ptr<Ring>> rings_;
+  unsigned next_tid_ = 0;     /* guarded by lock_ */
+};
+
+/* Not static, every translation unit shares the one tracer */
+inline GstSpoutTracer &
+gst_spout_tracer_get (void)
+{
+  /* Threads may still trace at exit, never destroy it */
+  static GstSpoutTracer *tracer = new GstSpoutTracer ();
+
+  return *tracer;
+}
+
+/* Times the enclosing scope while tracing is on */
+class GstSpoutTraceScope
+{
+public:
+  explicit GstSpoutTraceScope (const char * name, uint64_t arg = 0)
+  {
+    if (gst_spout_tracer_get ().enabled ()) {
+      name_ = name;
+      arg_ = arg;
+      start_ = GstSpoutTracer::now ();
+    }
+  }
+
+  ~GstSpoutTraceScope () { end (); }
+
+  /* Stage is over before the scope is */
+  void end ()
+  {
+    if (name_)
+      gst_spout_tracer_get ().record (name_, start_, GstSpoutTracer::now (), arg_);
+    name_ = nullptr;
+  }
+
+  GstSpoutTraceScope (const GstSpoutTraceScope &) = delete;
+  GstSpoutTraceScope & operator= (const GstSpoutTraceScope &) = delete;
+
+private:
+  const char *name_ = nullptr;
+  uint64_t arg_ = 0;
+  uint64_t start_ = 0;
+};
+
+#define GST_SPOUT_TRACE_PASTE_(a, b) a ## b
+#define GST_SPOUT_TRACE_PASTE(a, b) GST_SPOUT_TRACE_PASTE_ (a, b)
+
+/* Trace the rest of the enclosing block as stage @name */
+#define GST_SPOUT_TRACE(name) \
+    GstSpoutTraceScope GST_SPOUT_TRACE_PASTE (gst_spout_trace_, __LINE__) (name)
+
+/* Same, tagged with the number of the frame being produced */
+#define GST_SPOUT_TRACE_FRAME(name, frame) \
+    GstSpoutTraceScope GST_SPOUT_TRACE_PASTE (gst_spout_trace_, __LINE__) \
+        (name, frame)
@@ -0,0 +1,277 @@
+/* GStreamer
+ * Copyright (C) 2023 Your Name <your.email@example.com>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#pragma once
+
+/* Process-wide worker pool for spoutsrc's system memory path.
+ *
+ * Frames are split into row bands which a persistent set of threads works
+ * through, every spoutsrc in the process sharing the same threads rather
+ * than each spawning its own. Bands are dealt round-robin into per-worker
+ * queues; a worker takes from the front of its own queue and steals from
+ * the back of the others once it runs dry, so one slow band doesn't leave
+ * the rest of the pool idle. The submitting thread works along instead of
+ * just waiting. Free of GStreamer. */
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#ifdef _WIN32
+#include <windows.h>
+#elif defined(__linux__)
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+#define GST_SPOUT_MAX_WORKERS 64
+
+/* Pin the calling thread to the CPUs in @mask, 0 lets it run anywhere */
+static inline void
+gst_spout_set_thread_affinity (uint64_t mask)
+{
+#ifdef _WIN32
+  SetThreadAffinityMask (GetCurrentThread (),
+      mask ? (DWORD_PTR) mask : (DWORD_PTR) -1);
+#elif defined(__linux__)
+  cpu_set_t set;
+
+  CPU_ZERO (&set);
+  for (int cpu = 0; cpu < 64 && cpu < CPU_SETSIZE; cpu++) {
+    if (!mask || (mask & ((uint64_t) 1 << cpu)))
+      CPU_SET (cpu, &set);
+  }
+  pthread_setaffinity_np (pthread_self (), sizeof (set), &set);
+#else
+  (void) mask;
+#endif
+}
+
+class GstSpoutWorkerPool
+{
+public:
+  using Func = std::function<void (unsigned int)>;
+
+  GstSpoutWorkerPool () = default;
+  ~GstSpoutWorkerPool () { stop (); }
+
+  GstSpoutWorkerPool (const GstSpoutWorkerPool &) = delete;
+  GstSpoutWorkerPool & operator= (const GstSpoutWorkerPool &) = delete;
+
+  /* Have at least @threads workers. Never shrinks, other users may still
+   * count on them */
+  void ensure (unsigned int threads)
+  {
+    std::lock_guard<std::mutex> lock (lock_);
+
+    threads = std::min (threads, (unsigned int) GST_SPOUT_MAX_WORKERS);
+    while (threads_.size () < threads) {
+      unsigned int index = (unsigned int) threads_.size ();
+
+      threads_.emplace_back (&GstSpoutWorkerPool::loop, this, index);
+      n_workers_.store (index + 1, std::memory_order_release);
+    }
+  }
+
+  unsigned int workers () const
+  {
+    return n_workers_.load (std::memory_order_acquire);
+  }
+
+  /* CPUs the workers may run on, 0 for any. Applied before their next band */
+  void set_affinity (uint64_t mask)
+  {
+    affinity_.store (mask, std::memory_order_relaxed);
+    affinity_generation_.fetch_add (1, std::memory_order_release);
+  }
+
+  /* Run @func for every index in [0, @count) on at most @parallel workers
+   * and the calling thread, returning once all are done */
+  void run (unsigned int count, const Func & func, unsigned int parallel)
+  {
+    unsigned int queues = std::min ({ parallel, workers (), count });
+
+    if (count == 0)
+      return;
+
+    if (queues == 0 || count == 1) {
+      for (unsigned int i = 0; i < count; i++)
+        func (i);
+      return;
+    }
+
+    Job job;
+    job.func = &func;
+    job.remaining = count;
+
+    /* Spread over the queues starting at a rotating offset so concurrent
+     * users don't all pile onto the first workers */
+    unsigned int first = next_queue_.fetch_add (1, std::memory_order_relaxed);
+    for (unsigned int i = 0; i < count; i++) {
+      Queue & queue = queues_[(first + i) % queues];
+      std::lock_guard<std::mutex> lock (queue.lock);
+      queue.tasks.push_back (Task { &job, i });
+    }
+
+    {
+      std::lock_guard<std::mutex> lock (lock_);
+      pending_ += count;
+    }
+    wake_.notify_all ();
+
+    /* Help out, then wait for bands still running elsewhere */
+    Task task;
+    while (job.remaining.load (std::memory_order_acquire) > 0 &&
+        steal (first % queues, task))
+      execute (task);
+
+    std::unique_lock<std::mutex> lock (job.lock);
+    job.done.wait (lock, [&job] {
+      return job.remaining.load (std::memory_order_acquire) == 0;
+    });
+  }
+
+  /* Join all workers, only for tearing down */
+  void stop ()
+  {
+    {
+      std::lock_guard<std::mutex> lock (lock_);
+      stopping_ = true;
+    }
+    wake_.notify_all ();
+
+    for (auto & thread : threads_)
+      thread.join ();
+    threads_.clear ();
+    n_workers_ = 0;
+  }
+
+  uint64_t executed () const { return executed_.load (std::memory_order_relaxed); }
+  uint64_t stolen () const { return stolen_.load (std::memory_order_relaxed); }
+
+private:
+  struct Job
+  {
+    const Func *func = nullptr;
+    std::atomic<unsigned int> remaining { 0 };
+    std::mutex lock;
+    std::condition_variable done;
+  };
+
+  struct Task
+  {
+    Job *job = nullptr;
+    unsigned int index = 0;
+  };
+
+  struct Queue
+  {
+    std::mutex lock;
+    std::deque<Task> tasks;
+  };
+
+  /* Own queue's front first, then the back of everybody else's */
+  bool steal (unsigned int own, Task & task)
+  {
+    unsigned int n = std::max (workers (), 1u);
+
+    for (unsigned int i = 0; i < n; i++) {
+      Queue & queue = queues_[(own + i) % n];
+      std::lock_guard<std::mutex> lock (queue.lock);
+
+      if (queue.tasks.empty ())
+        continue;
+
+      if (i == 0) {
+        task = queue.tasks.front ();
+        queue.tasks.pop_front ();
+      } else {
+        task = queue.tasks.back ();
+        queue.tasks.pop_back ();
+        stolen_.fetch_add (1, std::memory_order_relaxed);
+      }
+
+      std::lock_guard<std::mutex> pending_lock (lock_);
+      pending_--;
+      return true;
+    }
+
+    return false;
+  }
+
+  void execute (const Task & task)
+  {
+    Job *job = task.job;
+
+    (*job->func) (task.index);
+    executed_.fetch_add (1, std::memory_order_relaxed);
+
+    /* The submitter destroys the job as soon as it sees zero under the
+     * lock, so the count only drops while holding it */
+    std::lock_guard<std::mutex> lock (job->lock);
+    if (job->remaining.fetch_sub (1, std::memory_order_acq_rel) == 1)
+      job->done.notify_all ();
+  }
+
+  void loop (unsigned int index)
+  {
+    uint64_t generation = 0;
+    Task task;
+
+    for (;;) {
+      uint64_t current = affinity_generation_.load (std::memory_order_acquire);
+      if (current != generation) {
+        gst_spout_set_thread_affinity (affinity_.load (std::memory_order_relaxed));
+        generation = current;
+      }
+
+      if (steal (index, task)) {
+        execute (task);
+        continue;
+      }
+
+      std::unique_lock<std::mutex> lock (lock_);
+      wake_.wait (lock, [this] { return stopping_ || pending_ > 0; });
+      if (stopping_)
+        return;
+    }
+  }
+
+  Queue queues_[GST_SPOUT_MAX_WORKERS];
+  std::atomic<unsigned int> n_workers_ { 0 };
+  std::atomic<unsigned int> next_queue_ { 0 };
+
+  std::mutex lock_;                 /* threads_, pending_, stopping_ */
+  std::condition_variable wake_;
+  std::vector<std::thread> threads_;
+  uint64_t pending_ = 0;            /* tasks queued, not yet taken */
+  bool stopping_ = false;
+
+  std::atomic<uint64_t> affinity_ { 0 };
+  std::atomic<uint64_t> affinity_generation_ { 0 };
+
+  std::atomic<uint64_t> executed_ { 0 };
+  std::atomic<uint64_t> stolen_ { 0 };
+};
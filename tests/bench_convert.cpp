@@ -0,0 +1,93 @@
+/* GStreamer
+ * Copyright (C) 2023 Your Name <your.email@example.com>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+/* Throughput of gst_spout_convert() for every format pair and kernel at
+ * 1080p, 4K and 8K, in GB/s of source frame read. Frames are converted
+ * whole on one thread, as with readback-threads=1.
+ *
+ *   bench_convert [seconds per case] */
+
+#include "gstspoutconverttest.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+
+using Clock = std::chrono::steady_clock;
+
+static const struct
+{
+  const char *name;
+  uint32_t width, height;
+} bench_sizes[] = {
+  { "1080p", 1920, 1080 },
+  { "4K", 3840, 2160 },
+  { "8K", 7680, 4320 },
+};
+
+int
+main (int argc, char ** argv)
+{
+  double seconds = argc > 1 ? atof (argv[1]) : 0.1;
+  GstSpoutCpuLevel best = gst_spout_cpu_level ();
+  std::mt19937 rng (1);
+
+  printf ("%-6s %-5s %-5s", "size", "in", "out");
+  for (int level = GST_SPOUT_CPU_SCALAR; level <= best; level++)
+    printf (" %9s", gst_spout_cpu_level_name ((GstSpoutCpuLevel) level));
+  printf ("   GB/s\n");
+
+  for (const auto & size : bench_sizes) {
+    for (GstSpoutPixelFormat in : test_packed_formats) {
+      TestFrame src (in, size.width, size.height);
+
+      src.fill (rng);
+
+      for (GstSpoutPixelFormat out : test_output_formats) {
+        TestFrame dest (out, size.width, size.height);
+
+        printf ("%-6s %-5s %-5s", size.name, test_format_name (in),
+            test_format_name (out));
+
+        for (int level = GST_SPOUT_CPU_SCALAR; level <= best; level++) {
+          int frames = 0;
+          auto start = Clock::now ();
+          std::chrono::duration<double> elapsed;
+
+          /* The first pass faults the destination in, don't time it */
+          src.convert_to (dest, (GstSpoutCpuLevel) level);
+
+          start = Clock::now ();
+          do {
+            src.convert_to (dest, (GstSpoutCpuLevel) level);
+            frames++;
+            elapsed = Clock::now () - start;
+          } while (elapsed.count () < seconds || frames < 2);
+
+          printf (" %9.2f", (double) src.data.size () * frames /
+              elapsed.count () / 1e9);
+        }
+        printf ("\n");
+        fflush (stdout);
+      }
+    }
+  }
+
+  return 0;
+}
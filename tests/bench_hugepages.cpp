@@ -0,0 +1,166 @@
+/* GStreamer
+ * Copyright (C) 2023 Your Name <your.email@example.com>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+/* Copy throughput of frame buffers from gst_spout_pages_alloc() on
+ * ordinary and on huge pages, at 1080p, 4K and 8K BGRA:
+ *   fault   first copy into fresh pages, in GB/s, without and with
+ *           gst_spout_pages_prefault() beforehand (prefault time included)
+ *   copy    whole frame memcpy once faulted in
+ *   column  a walk down 16-byte columns, one row pitch apart, the access
+ *           pattern of a vertical flip or tile conversion that touches a
+ *           new page every row
+ * Huge pages fall back to transparent ones, or to ordinary ones, where the
+ * system has none reserved; the kind column says which were used.
+ *
+ *   bench_hugepages [seconds per case] [numa node] */
+
+#include "gstspouthugepages.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+using Clock = std::chrono::steady_clock;
+
+static const struct
+{
+  const char *name;
+  size_t width, height;
+} bench_sizes[] = {
+  { "1080p", 1920, 1080 },
+  { "4K", 3840, 2160 },
+  { "8K", 7680, 4320 },
+};
+
+static volatile uint64_t sink;
+
+static double
+seconds_since (Clock::time_point start)
+{
+  return std::chrono::duration<double> (Clock::now () - start).count ();
+}
+
+/* Fresh pages for every run, so each one pays for its faults */
+static double
+bench_fault (size_t size, bool huge_pages, int numa_node, bool prefault,
+    const std::vector<uint8_t> & src, double seconds)
+{
+  double elapsed = 0.0;
+  int frames = 0;
+
+  do {
+    GstSpoutPages pages = gst_spout_pages_alloc (size, huge_pages, numa_node);
+    auto start = Clock::now ();
+
+    if (prefault)
+      gst_spout_pages_prefault (pages);
+    memcpy (pages.data, src.data (), size);
+    elapsed += seconds_since (start);
+    frames++;
+
+    gst_spout_pages_free (pages);
+  } while (elapsed < seconds || frames < 2);
+
+  return (double) size * frames / elapsed / 1e9;
+}
+
+static double
+bench_copy (const GstSpoutPages & pages, size_t size,
+    const std::vector<uint8_t> & src, double seconds)
+{
+  int frames = 0;
+  auto start = Clock::now ();
+
+  do {
+    memcpy (pages.data, src.data (), size);
+    frames++;
+  } while (seconds_since (start) < seconds || frames < 2);
+
+  return (double) size * frames / seconds_since (start) / 1e9;
+}
+
+static double
+bench_column (const GstSpoutPages & pages, size_t pitch, size_t height,
+    double seconds)
+{
+  const uint8_t *data = (const uint8_t *) pages.data;
+  uint64_t sum = 0;
+  int frames = 0;
+  auto start = Clock::now ();
+
+  do {
+    for (size_t x = 0; x < pitch; x += 16) {
+      for (size_t y = 0; y < height; y++) {
+        const uint64_t *chunk = (const uint64_t *) (data + y * pitch + x);
+
+        sum += chunk[0] ^ chunk[1];
+      }
+    }
+    frames++;
+  } while (seconds_since (start) < seconds || frames < 2);
+
+  sink = sum;
+
+  return (double) pitch * height * frames / seconds_since (start) / 1e9;
+}
+
+int
+main (int argc, char ** argv)
+{
+  double seconds = argc > 1 ? atof (argv[1]) : 0.2;
+  int numa_node = argc > 2 ? atoi (argv[2]) : -1;
+
+  printf ("huge page size %zu KiB\n\n", gst_spout_huge_page_size () / 1024);
+  printf ("%-6s %-17s %9s %9s %9s %9s   GB/s\n", "size", "kind", "fault",
+      "prefault", "copy", "column");
+
+  for (const auto & size : bench_sizes) {
+    size_t pitch = size.width * 4;
+    size_t bytes = pitch * size.height;
+    std::vector<uint8_t> src (bytes);
+
+    for (size_t i = 0; i < bytes; i++)
+      src[i] = (uint8_t) (i * 2654435761u >> 24);
+
+    for (bool huge_pages : { false, true }) {
+      GstSpoutPages pages = gst_spout_pages_alloc (bytes, huge_pages,
+          numa_node);
+
+      if (!pages.data) {
+        printf ("%-6s out of memory\n", size.name);
+        continue;
+      }
+      gst_spout_pages_prefault (pages);
+
+      printf ("%-6s %-17s", size.name, gst_spout_page_kind_name (pages.kind));
+      printf (" %9.2f", bench_fault (bytes, huge_pages, numa_node, false, src,
+              seconds));
+      printf (" %9.2f", bench_fault (bytes, huge_pages, numa_node, true, src,
+              seconds));
+      printf (" %9.2f", bench_copy (pages, bytes, src, seconds));
+      printf (" %9.2f\n", bench_column (pages, pitch, size.height, seconds));
+      fflush (stdout);
+
+      gst_spout_pages_free (pages);
+    }
+  }
+
+  return 0;
+}
@@ -0,0 +1,102 @@
+/* GStreamer
+ * Copyright (C) 2023 Your Name <your.email@example.com>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+/* Cost of reading spoutsrc's connection state on the per-frame path while
+ * properties are being set. Compares a load() at each of the seven places
+ * create() used to read the state against one view() per frame refreshed
+ * at the same places, with 0, 1 and 3 threads publishing flat out.
+ *
+ *   bench_snapshot [frames] */
+
+#include "gstspoutsnapshot.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <thread>
+#include <vector>
+
+struct BenchState
+{
+  bool connected = true;
+  std::string sender_name = "sender";
+  double fps = 60.0;
+  bool reshape = false;
+};
+
+using Clock = std::chrono::steady_clock;
+
+static const int READS_PER_FRAME = 7;
+
+static double
+run (GstSpoutSnapshot<BenchState> & snapshot, bool use_view, long frames)
+{
+  volatile double sink = 0;
+  auto start = Clock::now ();
+
+  for (long i = 0; i < frames; i++) {
+    if (use_view) {
+      auto state = snapshot.view ();
+
+      for (int j = 0; j < READS_PER_FRAME; j++) {
+        snapshot.refresh (state);
+        sink = sink + state->fps;
+      }
+    } else {
+      for (int j = 0; j < READS_PER_FRAME; j++)
+        sink = sink + snapshot.load ()->fps;
+    }
+  }
+
+  std::chrono::duration<double, std::nano> elapsed = Clock::now () - start;
+  return elapsed.count () / frames;
+}
+
+int
+main (int argc, char ** argv)
+{
+  long frames = argc > 1 ? atol (argv[1]) : 2000000;
+
+  printf ("%-8s %14s %14s\n", "writers", "load() ns/frame", "view ns/frame");
+
+  for (int writers : { 0, 1, 3 }) {
+    GstSpoutSnapshot<BenchState> snapshot;
+    std::atomic<bool> stop { false };
+    std::vector<std::thread> threads;
+
+    for (int i = 0; i < writers; i++) {
+      threads.emplace_back ([&] {
+        while (!stop)
+          snapshot.publish (std::make_shared<const BenchState> ());
+      });
+    }
+
+    double load_ns = run (snapshot, false, frames);
+    double view_ns = run (snapshot, true, frames);
+
+    stop = true;
+    for (auto & thread : threads)
+      thread.join ();
+
+    printf ("%-8d %14.1f %14.1f\n", writers, load_ns, view_ns);
+  }
+
+  return 0;
+}
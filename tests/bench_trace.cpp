@@ -0,0 +1,112 @@
+/* GStreamer
+ * Copyright (C) 2023 Your Name <your.email@example.com>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+/* What spoutsrc's tracepoints cost per frame with tracing off, the default,
+ * and on. A frame passes about a dozen tracepoints, each stage here does a
+ * little work so the loop isn't optimized away.
+ *
+ *   bench_trace [frames] */
+
+#include "gstspouttrace.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+
+using Clock = std::chrono::steady_clock;
+
+#ifdef _MSC_VER
+#define BENCH_NOINLINE __declspec(noinline)
+#else
+#define BENCH_NOINLINE __attribute__ ((noinline))
+#endif
+
+static const int STAGES = 12;
+
+static volatile uint64_t sink;
+
+static inline void
+stage_work (uint64_t frame, int stage)
+{
+  uint64_t x = frame * 2654435761u + (uint64_t) stage;
+
+  for (int i = 0; i < 8; i++)
+    x ^= x >> 13, x *= 0x9e3779b97f4a7c15ull;
+  sink = sink + x;
+}
+
+BENCH_NOINLINE static void
+frame_plain (uint64_t frame)
+{
+  for (int stage = 0; stage < STAGES; stage++)
+    stage_work (frame, stage);
+}
+
+BENCH_NOINLINE static void
+frame_traced (uint64_t frame)
+{
+  GST_SPOUT_TRACE_FRAME ("create", frame);
+
+  for (int stage = 0; stage < STAGES - 1; stage++) {
+    GST_SPOUT_TRACE ("stage");
+    stage_work (frame, stage);
+  }
+  stage_work (frame, STAGES - 1);
+}
+
+template <typename Func>
+static double
+ns_per_frame (Func func, long frames)
+{
+  auto start = Clock::now ();
+
+  for (long i = 0; i < frames; i++)
+    func ((uint64_t) i);
+
+  std::chrono::duration<double, std::nano> elapsed = Clock::now () - start;
+  return elapsed.count () / frames;
+}
+
+int
+main (int argc, char ** argv)
+{
+  long frames = argc > 1 ? atol (argv[1]) : 2000000;
+  GstSpoutTracer & tracer = gst_spout_tracer_get ();
+
+  /* Warm up, and take the best of a few runs against scheduling noise */
+  double plain = 1e30, off = 1e30, on = 1e30;
+
+  for (int run = 0; run < 5; run++) {
+    plain = std::min (plain, ns_per_frame (frame_plain, frames));
+    tracer.set_enabled (false);
+    off = std::min (off, ns_per_frame (frame_traced, frames));
+    tracer.set_enabled (true);
+    on = std::min (on, ns_per_frame (frame_traced, frames));
+    tracer.set_enabled (false);
+  }
+
+  printf ("%d tracepoints per frame\n", STAGES);
+  printf ("no tracepoints: %8.1f ns/frame\n", plain);
+  printf ("tracing off:    %8.1f ns/frame, %+.2f ns per tracepoint\n", off,
+      (off - plain) / STAGES);
+  printf ("tracing on:     %8.1f ns/frame, %+.2f ns per tracepoint\n", on,
+      (on - plain) / STAGES);
+
+  return 0;
+}
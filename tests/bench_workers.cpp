@@ -0,0 +1,125 @@
+/* GStreamer
+ * Copyright (C) 2023 Your Name <your.email@example.com>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+/* Scaling of GstSpoutWorkerPool from one core to all of them, on a 4K BGRA
+ * frame split into row bands like the readback path splits it: a copy,
+ * bound by memory bandwidth, and a luma conversion, bound by arithmetic.
+ * Each line runs on N cores, the submitting thread and N - 1 workers.
+ *
+ *   bench_workers [seconds per case] [max cores] */
+
+#include "gstspoutworkers.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+using Clock = std::chrono::steady_clock;
+
+static const unsigned int WIDTH = 3840;
+static const unsigned int HEIGHT = 2160;
+static const unsigned int BAND_ROWS = 64;     /* MIN_BAND_ROWS in spoutsrc */
+
+static void
+copy_rows (const uint8_t * src, uint8_t * dest, unsigned int first,
+    unsigned int rows)
+{
+  memcpy (dest + (size_t) first * WIDTH * 4, src + (size_t) first * WIDTH * 4,
+      (size_t) rows * WIDTH * 4);
+}
+
+/* BT.709 luma of every BGRA pixel */
+static void
+luma_rows (const uint8_t * src, uint8_t * dest, unsigned int first,
+    unsigned int rows)
+{
+  for (unsigned int y = first; y < first + rows; y++) {
+    const uint8_t *in = src + (size_t) y * WIDTH * 4;
+    uint8_t *out = dest + (size_t) y * WIDTH;
+
+    for (unsigned int x = 0; x < WIDTH; x++, in += 4)
+      out[x] = (uint8_t) ((47 * in[2] + 157 * in[1] + 16 * in[0] + 4096 +
+              128) >> 8);
+  }
+}
+
+int
+main (int argc, char ** argv)
+{
+  double seconds = argc > 1 ? atof (argv[1]) : 0.3;
+  unsigned int max_cores = argc > 2 ? (unsigned int) atoi (argv[2]) :
+      std::thread::hardware_concurrency ();
+  unsigned int bands = (HEIGHT + BAND_ROWS - 1) / BAND_ROWS;
+  std::vector<uint8_t> src ((size_t) WIDTH * HEIGHT * 4);
+  std::vector<uint8_t> dest ((size_t) WIDTH * HEIGHT * 4);
+  GstSpoutWorkerPool pool;
+
+  max_cores = std::clamp (max_cores, 1u, (unsigned int) GST_SPOUT_MAX_WORKERS);
+  for (size_t i = 0; i < src.size (); i++)
+    src[i] = (uint8_t) (i * 2654435761u >> 24);
+
+  printf ("%u cores, %u bands of %u rows\n\n", max_cores, bands, BAND_ROWS);
+  printf ("%-6s %10s %8s %10s %8s\n", "cores", "copy fps", "speedup",
+      "luma fps", "speedup");
+
+  double base[2] = { 0.0, 0.0 };
+
+  for (unsigned int cores = 1; cores <= max_cores;
+      cores = cores < max_cores ? std::min (cores * 2, max_cores) : cores + 1) {
+    pool.ensure (cores - 1);
+    printf ("%-6u", cores);
+
+    for (int work = 0; work < 2; work++) {
+      auto band = [&] (unsigned int index) {
+        unsigned int first = index * BAND_ROWS;
+        unsigned int rows = std::min (BAND_ROWS, HEIGHT - first);
+
+        if (work == 0)
+          copy_rows (src.data (), dest.data (), first, rows);
+        else
+          luma_rows (src.data (), dest.data (), first, rows);
+      };
+      int frames = 0;
+      double elapsed;
+
+      /* Warm up the workers and fault the destination in */
+      pool.run (bands, band, cores - 1);
+
+      auto start = Clock::now ();
+      do {
+        pool.run (bands, band, cores - 1);
+        frames++;
+        elapsed = std::chrono::duration<double> (Clock::now () - start).count ();
+      } while (elapsed < seconds || frames < 2);
+
+      double fps = frames / elapsed;
+      if (cores == 1)
+        base[work] = fps;
+      printf (" %10.1f %7.2fx", fps, fps / base[work]);
+    }
+    printf ("\n");
+    fflush (stdout);
+  }
+
+  printf ("\nbands stolen: %llu of %llu\n", (unsigned long long) pool.stolen (),
+      (unsigned long long) pool.executed ());
+
+  return 0;
+}
@@ -0,0 +1,139 @@
+/* GStreamer
+ * Copyright (C) 2023 Your Name <your.email@example.com>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+/* Shared by the convert test and benchmark: frames in any
+ * GstSpoutPixelFormat with their planes laid out like GstVideoInfo does */
+
+#pragma once
+
+#include "gstspoutconvert.h"
+
+#include <cstring>
+#include <random>
+#include <vector>
+
+static const GstSpoutPixelFormat test_packed_formats[] = {
+  GST_SPOUT_PIXEL_FORMAT_BGRA, GST_SPOUT_PIXEL_FORMAT_RGBA,
+  GST_SPOUT_PIXEL_FORMAT_BGRX, GST_SPOUT_PIXEL_FORMAT_RGBX,
+};
+
+static const GstSpoutPixelFormat test_output_formats[] = {
+  GST_SPOUT_PIXEL_FORMAT_BGRA, GST_SPOUT_PIXEL_FORMAT_RGBA,
+  GST_SPOUT_PIXEL_FORMAT_BGRX, GST_SPOUT_PIXEL_FORMAT_RGBX,
+  GST_SPOUT_PIXEL_FORMAT_NV12, GST_SPOUT_PIXEL_FORMAT_I420,
+};
+
+static inline const char *
+test_format_name (GstSpoutPixelFormat format)
+{
+  switch (format) {
+    case GST_SPOUT_PIXEL_FORMAT_BGRA: return "BGRA";
+    case GST_SPOUT_PIXEL_FORMAT_RGBA: return "RGBA";
+    case GST_SPOUT_PIXEL_FORMAT_BGRX: return "BGRx";
+    case GST_SPOUT_PIXEL_FORMAT_RGBX: return "RGBx";
+    case GST_SPOUT_PIXEL_FORMAT_NV12: return "NV12";
+    case GST_SPOUT_PIXEL_FORMAT_I420: return "I420";
+    default: return "unknown";
+  }
+}
+
+/* A frame with @padding bytes after each row, which conversions must leave
+ * alone */
+struct TestFrame
+{
+  GstSpoutPixelFormat format;
+  uint32_t width, height;
+  std::vector<uint8_t> data;
+  GstSpoutPlanes planes;
+  size_t offset[3] = { };
+  size_t row_bytes[3] = { };
+  uint32_t rows[3] = { };
+  int n_planes = 1;
+
+  TestFrame (GstSpoutPixelFormat format_, uint32_t width_, uint32_t height_,
+      size_t padding = 0)
+      : format (format_), width (width_), height (height_)
+  {
+    uint32_t chroma_width = (width + 1) / 2, chroma_height = (height + 1) / 2;
+    size_t size = 0;
+
+    switch (format) {
+      case GST_SPOUT_PIXEL_FORMAT_NV12:
+        n_planes = 2;
+        row_bytes[0] = width;
+        row_bytes[1] = chroma_width * 2;
+        rows[0] = height;
+        rows[1] = chroma_height;
+        break;
+      case GST_SPOUT_PIXEL_FORMAT_I420:
+        n_planes = 3;
+        row_bytes[0] = width;
+        row_bytes[1] = row_bytes[2] = chroma_width;
+        rows[0] = height;
+        rows[1] = rows[2] = chroma_height;
+        break;
+      default:
+        row_bytes[0] = (size_t) width * 4;
+        rows[0] = height;
+        break;
+    }
+
+    for (int i = 0; i < n_planes; i++) {
+      planes.stride[i] = row_bytes[i] + padding;
+      offset[i] = size;
+      size += planes.stride[i] * rows[i];
+    }
+
+    data.assign (size, 0xa5);
+    for (int i = 0; i < n_planes; i++)
+      planes.data[i] = data.data () + offset[i];
+  }
+
+  const uint8_t * src () const { return planes.data[0]; }
+  size_t src_stride () const { return planes.stride[0]; }
+
+  /* Random pixels, with runs of black, white and saturated colours that
+   * push the fixed point maths to its limits */
+  void fill (std::mt19937 & rng)
+  {
+    static const uint32_t extremes[] = {
+      0x00000000, 0xffffffff, 0xff0000ff, 0xff00ff00, 0xffff0000,
+      0x00ffff00, 0x00ff00ff, 0x0000ffff, 0x01fe01fe, 0xfe01fe01,
+    };
+
+    for (uint32_t y = 0; y < height; y++) {
+      uint8_t *row = planes.data[0] + y * planes.stride[0];
+
+      for (uint32_t x = 0; x < width; x++) {
+        uint32_t pixel = rng ();
+
+        if ((rng () & 3) == 0)
+          pixel = extremes[rng () % (sizeof (extremes) / sizeof (extremes[0]))];
+        memcpy (row + x * 4, &pixel, 4);
+      }
+    }
+  }
+
+  void convert_to (TestFrame & dest, GstSpoutCpuLevel level,
+      uint32_t y_begin = 0, uint32_t y_end = UINT32_MAX) const
+  {
+    gst_spout_convert (format, src (), src_stride (), dest.format, dest.planes,
+        width, height, y_begin, y_end, level);
+  }
+};
@@ -0,0 +1,66 @@
+/* GStreamer
+ * Copyright (C) 2023 Your Name <your.email@example.com>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#pragma once
+
+/* Checks for the tests of spoutsrc's GStreamer-free helpers. A failed check
+ * reports where and what, and the test carries on; main() returns
+ * gst_spout_test_result () so meson sees the failure */
+
+#include <cstdio>
+#include <sstream>
+#include <string>
+
+static int gst_spout_test_failures = 0;
+
+template <typename A, typename B>
+static inline void
+gst_spout_test_check_eq (const A & a, const B & b, const char * expr_a,
+    const char * expr_b, const char * file, int line)
+{
+  if (a == b)
+    return;
+
+  std::ostringstream values;
+  values << a << " != " << b;
+  fprintf (stderr, "%s:%d: CHECK_EQ (%s, %s) failed: %s\n", file, line,
+      expr_a, expr_b, values.str ().c_str ());
+  gst_spout_test_failures++;
+}
+
+#define CHECK(cond) \
+  do { \
+    if (!(cond)) { \
+      fprintf (stderr, "%s:%d: CHECK (%s) failed\n", __FILE__, __LINE__, \
+          #cond); \
+      gst_spout_test_failures++; \
+    } \
+  } while (0)
+
+#define CHECK_EQ(a, b) \
+  gst_spout_test_check_eq ((a), (b), #a, #b, __FILE__, __LINE__)
+
+static inline int
+gst_spout_test_result ()
+{
+  if (gst_spout_test_failures)
+    fprintf (stderr, "%d checks failed\n", gst_spout_test_failures);
+
+  return gst_spout_test_failures ? 1 : 0;
+}
@@ -0,0 +1,195 @@
+/* GStreamer
+ * Copyright (C) 2023 Your Name <your.email@example.com>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+/* GstSpoutBackoff on a simulated clock: delays grow by the factor up to the
+ * cap within the jitter, and each give-up policy stops when it should */
+
+#include "gstspoutbackoff.h"
+#include "gstspouttest.h"
+
+#include <set>
+#include <vector>
+
+using Backoff = GstSpoutBackoff;
+using Ms = Backoff::Duration;
+
+static int64_t
+ms (Backoff::TimePoint::duration duration)
+{
+  return std::chrono::duration_cast<Ms> (duration).count ();
+}
+
+/* Fail every attempt as soon as it is due, returning the delays */
+static std::vector<int64_t>
+fail_until_given_up (Backoff & backoff, Backoff::TimePoint & now,
+    unsigned limit = 1000)
+{
+  std::vector<int64_t> delays;
+
+  while (delays.size () < limit && backoff.failed (now)) {
+    delays.push_back (ms (backoff.next_attempt () - now));
+    now = backoff.next_attempt ();
+  }
+
+  return delays;
+}
+
+static void
+test_growth ()
+{
+  Backoff backoff;
+  Backoff::Config config;
+  Backoff::TimePoint now;
+
+  config.jitter = 0.0;
+  backoff.configure (config);
+
+  std::vector<int64_t> delays = fail_until_given_up (backoff, now, 10);
+  CHECK (delays == std::vector<int64_t> ({ 50, 100, 200, 400, 800, 1600,
+              3200, 5000, 5000, 5000 }));
+  CHECK_EQ (backoff.attempts (), 10u);
+  CHECK (!backoff.given_up ());
+}
+
+static void
+test_jitter ()
+{
+  Backoff backoff;
+  Backoff::Config config;
+  Backoff::TimePoint now;
+  unsigned out_of_range = 0;
+  double nominal = 50.0;
+  int64_t low = INT64_MAX, high = 0;
+
+  backoff.configure (config);
+  backoff.seed (1);
+
+  for (int64_t delay : fail_until_given_up (backoff, now, 200)) {
+    out_of_range += delay < nominal * 0.75 - 1 || delay > nominal * 1.25;
+    if (nominal == 5000.0) {
+      low = std::min (low, delay);
+      high = std::max (high, delay);
+    }
+    nominal = std::min (nominal * 2, 5000.0);
+  }
+
+  CHECK_EQ (out_of_range, 0u);
+  /* Spread over most of the +-25% */
+  CHECK (low < 4000 && high > 6000);
+
+  /* Receivers that lost the same sender don't all come back at once */
+  std::set<int64_t> first_retries;
+  for (uint64_t seed = 1; seed <= 100; seed++) {
+    Backoff receiver;
+    receiver.configure (config);
+    receiver.seed (seed);
+    receiver.failed (Backoff::TimePoint ());
+    first_retries.insert (ms (receiver.next_attempt ().time_since_epoch ()));
+  }
+  CHECK (first_retries.size () > 15);
+
+  /* The same seed gives the same delays */
+  Backoff a, b;
+  Backoff::TimePoint ta, tb;
+  a.configure (config);
+  b.configure (config);
+  a.seed (99);
+  b.seed (99);
+  CHECK (fail_until_given_up (a, ta, 20) == fail_until_given_up (b, tb, 20));
+}
+
+static void
+test_give_up_attempts ()
+{
+  Backoff backoff;
+  Backoff::Config config;
+  Backoff::TimePoint now;
+
+  config.policy = GST_SPOUT_GIVE_UP_ATTEMPTS;
+  config.max_attempts = 3;
+  backoff.configure (config);
+
+  CHECK_EQ (fail_until_given_up (backoff, now).size (), 2u);
+  CHECK (backoff.given_up ());
+  CHECK_EQ (backoff.attempts (), 3u);
+  CHECK (!backoff.due (now + Ms (100000)));
+  CHECK (!backoff.failed (now));
+
+  /* Connecting again starts over */
+  backoff.reset ();
+  CHECK (!backoff.given_up ());
+  CHECK_EQ (fail_until_given_up (backoff, now).size (), 2u);
+}
+
+static void
+test_give_up_duration ()
+{
+  Backoff backoff;
+  Backoff::Config config;
+  Backoff::TimePoint start;
+  Backoff::TimePoint now = start;
+
+  config.policy = GST_SPOUT_GIVE_UP_DURATION;
+  config.max_duration = Ms (10000);
+  backoff.configure (config);
+  backoff.seed (42);
+
+  std::vector<int64_t> delays = fail_until_given_up (backoff, now);
+
+  /* The last attempt lands right on the deadline, not past it */
+  CHECK (backoff.given_up ());
+  CHECK_EQ (ms (now - start), 10000);
+  CHECK (delays.size () > 5);
+  CHECK (delays.back () <= 5000 * 1.25);
+}
+
+static void
+test_expedite ()
+{
+  Backoff backoff;
+  Backoff::Config config;
+  Backoff::TimePoint now;
+
+  config.jitter = 0.0;
+  backoff.configure (config);
+
+  for (int i = 0; i < 5; i++)
+    backoff.failed (now);
+  CHECK (!backoff.due (now));
+  CHECK (backoff.due (now + Ms (800)));
+
+  /* The sender showed up: try now, but keep counting */
+  backoff.expedite (now);
+  CHECK (backoff.due (now));
+  CHECK_EQ (backoff.attempts (), 5u);
+  backoff.failed (now);
+  CHECK_EQ (ms (backoff.next_attempt () - now), 1600);
+}
+
+int
+main ()
+{
+  test_growth ();
+  test_jitter ();
+  test_give_up_attempts ();
+  test_give_up_duration ();
+  test_expedite ();
+
+  return gst_spout_test_result ();
+}
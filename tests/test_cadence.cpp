@@ -0,0 +1,201 @@
+/* GStreamer
+ * Copyright (C) 2023 Your Name <your.email@example.com>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+/* GstSpoutCadencePredictor driven by sender cadence traces, polled the way
+ * spoutsrc's receiving thread polls: sleep for next_poll(), look, and on a
+ * new frame call frame() with the time it was seen. The nominal period
+ * comes from the snapped rational rate, as the element sets it */
+
+#include "gstspoutcadence.h"
+#include "gstspouttimestamp.h"
+#include "gstspouttest.h"
+
+#include <algorithm>
+#include <random>
+#include <vector>
+
+static const uint64_t MS = 1000000;
+static const uint64_t POLL_INTERVAL = 1 * MS;   /* NEW_FRAME_POLL_INTERVAL */
+static const unsigned POLL_BUDGET = 8;
+
+/* When each of a sender's frames became available */
+struct Trace
+{
+  double fps;
+  std::vector<uint64_t> arrivals;
+};
+
+/* A sender at @fps presenting with up to @jitter of scheduling delay,
+ * leaving out every @skip_every th frame if set */
+static Trace
+make_trace (double fps, unsigned frames, uint64_t jitter,
+    unsigned skip_every = 0, uint32_t seed = 1)
+{
+  std::mt19937 rng (seed);
+  Trace trace;
+
+  trace.fps = fps;
+  for (unsigned i = 0; i < frames; i++) {
+    if (skip_every && i % skip_every == skip_every - 1)
+      continue;
+
+    uint64_t ideal = (uint64_t) (i * 1e9 / fps) + 100 * MS;
+    trace.arrivals.push_back (ideal + (jitter ? rng () % jitter : 0));
+  }
+
+  return trace;
+}
+
+struct Replay
+{
+  uint64_t frames = 0;
+  uint64_t polls = 0;
+  uint64_t early_polls = 0;         /* until the period was learnt */
+  std::vector<uint64_t> delays;     /* arrival to being seen */
+
+  uint64_t percentile (unsigned p) const
+  {
+    std::vector<uint64_t> sorted = delays;
+
+    std::sort (sorted.begin (), sorted.end ());
+    return sorted[(sorted.size () - 1) * p / 100];
+  }
+};
+
+static Replay
+replay (const Trace & trace, uint64_t nominal_period)
+{
+  GstSpoutCadencePredictor cadence;
+  Replay result;
+  uint64_t now = 0;
+  size_t next = 0;
+
+  cadence.configure (POLL_INTERVAL, POLL_BUDGET);
+
+  while (next < trace.arrivals.size ()) {
+    now += cadence.next_poll (now);
+    result.polls++;
+    if (result.frames > 0 &&
+        result.frames <= GstSpoutCadencePredictor::MIN_SAMPLES)
+      result.early_polls++;
+
+    if (trace.arrivals[next] > now)
+      continue;
+
+    /* Spout only has the newest frame */
+    while (next + 1 < trace.arrivals.size () && trace.arrivals[next + 1] <= now)
+      next++;
+
+    result.delays.push_back (now - trace.arrivals[next]);
+    result.frames++;
+    next++;
+
+    cadence.set_nominal_period (nominal_period);
+    cadence.frame (now);
+  }
+
+  return result;
+}
+
+static uint64_t
+snapped_period (double fps)
+{
+  int num, den;
+
+  gst_spout_snap_framerate (fps, &num, &den);
+  return gst_spout_frame_duration (num, den);
+}
+
+static void
+test_rational_period ()
+{
+  CHECK_EQ (snapped_period (59.94), 16683333u);
+  CHECK_EQ (snapped_period (60.0), 16666666u);
+  CHECK_EQ (snapped_period (29.97), 33366666u);
+  CHECK_EQ (snapped_period (0.5), 2000000000u);
+  CHECK_EQ (snapped_period (0.0), 0u);
+}
+
+/* Steady senders are seen within a poll interval of presenting, at a
+ * handful of polls per frame */
+static void
+test_steady ()
+{
+  for (double fps : { 23.976, 29.97, 59.94, 144.0 }) {
+    Trace trace = make_trace (fps, 2000, 300000);
+    Replay result = replay (trace, snapped_period (fps));
+
+    CHECK_EQ (result.frames, 2000u);
+    CHECK (result.percentile (99) <= POLL_INTERVAL);
+    CHECK (result.polls <= result.frames * (POLL_BUDGET + 3));
+  }
+}
+
+/* Frames the sender never presented don't throw the period off */
+static void
+test_skipping ()
+{
+  Trace trace = make_trace (59.94, 3000, 1 * MS, 7);
+  Replay result = replay (trace, snapped_period (59.94));
+
+  CHECK_EQ (result.frames, trace.arrivals.size ());
+  CHECK (result.percentile (99) <= 2 * POLL_INTERVAL);
+}
+
+/* Slideshows below 1 fps used to get no nominal period at all, (int) 0.5
+ * is 0, and polled every millisecond until the period was learnt */
+static void
+test_slow_sender ()
+{
+  Trace trace = make_trace (0.5, 40, 0);
+  Replay rational = replay (trace, snapped_period (0.5));
+  Replay truncated = replay (trace, 0);
+
+  CHECK_EQ (rational.frames, 40u);
+  CHECK (rational.early_polls < 50);
+  CHECK (truncated.early_polls > 5000);
+}
+
+/* A film sender reports 23.976 and runs at 24000/1001. Taken as 23 fps
+ * each frame is expected 1.8 ms late until enough intervals are in, so the
+ * receiving thread sleeps through it. The rational period is awake for it */
+static void
+test_film_nominal ()
+{
+  Trace trace = make_trace (24000.0 / 1001, 8, 0);
+  Replay rational = replay (trace, snapped_period (23.976));
+  Replay truncated = replay (trace, 1000000000 / 23);
+
+  for (unsigned i = 1; i < GstSpoutCadencePredictor::MIN_SAMPLES; i++) {
+    CHECK (rational.delays[i] < POLL_INTERVAL / 2);
+    CHECK (truncated.delays[i] > POLL_INTERVAL);
+  }
+}
+
+int
+main ()
+{
+  test_rational_period ();
+  test_steady ();
+  test_skipping ();
+  test_slow_sender ();
+  test_film_nominal ();
+
+  return gst_spout_test_result ();
+}
@@ -0,0 +1,175 @@
+/* GStreamer
+ * Copyright (C) 2023 Your Name <your.email@example.com>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+/* GstSpoutCapsState: a steady sender negotiates once, only real format
+ * changes renegotiate */
+
+#include "gstspoutcaps.h"
+#include "gstspouttest.h"
+
+#include <algorithm>
+#include <set>
+
+static GstSpoutSenderFormat
+sender_format (uint32_t width, uint32_t height, uint32_t format, double fps)
+{
+  GstSpoutSenderFormat sender;
+
+  sender.width = width;
+  sender.height = height;
+  sender.format = format;
+  sender.fps = fps;
+
+  return sender;
+}
+
+/* Senders report a measured rate, it wobbles from frame to frame */
+static void
+test_steady_sender ()
+{
+  GstSpoutCapsState state;
+  uint64_t changes = 0;
+
+  CHECK_EQ (state.generation (), 0u);
+
+  for (int i = 0; i < 10000; i++) {
+    double fps = 60.0 + ((i % 7) - 3) * 0.1;
+
+    if (state.update (sender_format (1920, 1080, 87, fps)))
+      changes++;
+  }
+
+  CHECK_EQ (changes, 1u);
+  CHECK_EQ (state.generation (), 1u);
+  CHECK (state.has_format ());
+  CHECK_EQ (state.current ().width, 1920u);
+}
+
+static void
+test_real_changes ()
+{
+  GstSpoutCapsState state;
+
+  CHECK (state.update (sender_format (1920, 1080, 87, 60.0)));
+  CHECK (state.update (sender_format (1280, 1080, 87, 60.0)));
+  CHECK_EQ (state.generation (), 2u);
+  CHECK (state.update (sender_format (1280, 720, 87, 60.0)));
+  CHECK_EQ (state.generation (), 3u);
+  CHECK (state.update (sender_format (1280, 720, 28, 60.0)));
+  CHECK_EQ (state.generation (), 4u);
+  CHECK (state.update (sender_format (1280, 720, 28, 30.0)));
+  CHECK_EQ (state.generation (), 5u);
+
+  /* Within 1% of the current rate is the same rate, beyond it isn't */
+  CHECK (!state.update (sender_format (1280, 720, 28, 30.29)));
+  CHECK (state.update (sender_format (1280, 720, 28, 30.31)));
+  CHECK_EQ (state.generation (), 6u);
+
+  for (int i = 0; i < 10000; i++)
+    state.update (sender_format (1280, 720, 28, 30.31));
+  CHECK_EQ (state.generation (), 6u);
+}
+
+/* Reconnecting to the same sender renegotiates, the generation goes on */
+static void
+test_reset ()
+{
+  GstSpoutCapsState state;
+
+  state.update (sender_format (640, 480, 87, 30.0));
+  state.reset ();
+  CHECK (!state.has_format ());
+  CHECK (state.update (sender_format (640, 480, 87, 30.0)));
+  CHECK_EQ (state.generation (), 2u);
+}
+
+static void
+test_output_path ()
+{
+  CHECK_EQ (gst_spout_caps_output_path ("BGRA", "BGRA"),
+      GST_SPOUT_OUTPUT_NATIVE);
+  CHECK_EQ (gst_spout_caps_output_path ("BGRA", "NV12"),
+      GST_SPOUT_OUTPUT_CONVERT);
+  CHECK_EQ (gst_spout_caps_output_path ("BGRA", "I420"),
+      GST_SPOUT_OUTPUT_UNSUPPORTED);
+  CHECK_EQ (gst_spout_caps_d3d11_formats ("NV12").size (), 2u);
+  CHECK_EQ (gst_spout_caps_d3d11_formats ("BGRA").front (), "BGRA");
+}
+
+/* Every format offered in D3D11 memory has a way to get there, native
+ * first so fixation keeps it, and everything else is refused */
+static void
+test_convert_paths ()
+{
+  const std::vector<std::string> & convert = gst_spout_caps_convert_formats ();
+  const char *natives[] = { "BGRA", "RGBA", "RGB10A2_LE", "RGBA64_LE" };
+  const char *refused[] = { "I420", "YUY2", "BGRx", "GRAY8", "" };
+
+  CHECK (std::find (convert.begin (), convert.end (), "NV12") != convert.end ());
+  CHECK (std::find (convert.begin (), convert.end (), "P010_10LE") !=
+      convert.end ());
+
+  for (const char *native : natives) {
+    std::vector<std::string> offered = gst_spout_caps_d3d11_formats (native);
+    std::set<std::string> unique (offered.begin (), offered.end ());
+
+    CHECK_EQ (offered.front (), std::string (native));
+    CHECK_EQ (unique.size (), offered.size ());
+    CHECK_EQ (offered.size (), convert.size () + 1);
+
+    CHECK_EQ (gst_spout_caps_output_path (native, native),
+        GST_SPOUT_OUTPUT_NATIVE);
+    for (size_t i = 1; i < offered.size (); i++)
+      CHECK_EQ (gst_spout_caps_output_path (native, offered[i]),
+          GST_SPOUT_OUTPUT_CONVERT);
+
+    for (const char *format : refused)
+      CHECK_EQ (gst_spout_caps_output_path (native, format),
+          GST_SPOUT_OUTPUT_UNSUPPORTED);
+
+    /* Another RGB sender format is not a conversion we do */
+    for (const char *other : natives) {
+      if (std::string (other) != native)
+        CHECK_EQ (gst_spout_caps_output_path (native, other),
+            GST_SPOUT_OUTPUT_UNSUPPORTED);
+    }
+  }
+
+  /* A sender already in a convert format isn't offered it twice, and
+   * delivering it is no conversion */
+  std::vector<std::string> nv12 = gst_spout_caps_d3d11_formats ("NV12");
+  CHECK_EQ (nv12.size (), convert.size ());
+  CHECK_EQ (nv12.front (), std::string ("NV12"));
+  CHECK_EQ (gst_spout_caps_output_path ("NV12", "NV12"),
+      GST_SPOUT_OUTPUT_NATIVE);
+  CHECK_EQ (gst_spout_caps_output_path ("NV12", "P010_10LE"),
+      GST_SPOUT_OUTPUT_CONVERT);
+}
+
+int
+main ()
+{
+  test_steady_sender ();
+  test_real_changes ();
+  test_reset ();
+  test_output_path ();
+  test_convert_paths ();
+
+  return gst_spout_test_result ();
+}
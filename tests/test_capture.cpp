@@ -0,0 +1,244 @@
+/* GStreamer
+ * Copyright (C) 2023 Your Name <your.email@example.com>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+/* GstSpoutFrameRing and GstSpoutCaptureThread with a synthetic frame
+ * source: consumers only ever get the newest frame, whole and in order,
+ * and every frame the source handed out comes back */
+
+#include "gstspoutcapture.h"
+#include "gstspouttest.h"
+
+#include <vector>
+
+/* Written field by field, a frame with a != b was torn */
+struct Frame
+{
+  uint64_t a = 0;
+  uint64_t b = 0;
+};
+
+using Micros = std::chrono::microseconds;
+
+static void
+test_ring_latest ()
+{
+  GstSpoutFrameRing<Frame> ring;
+  Frame frame;
+
+  CHECK (!ring.has_frame ());
+  CHECK (!ring.pop (frame));
+
+  ring.back () = { 1, 1 };
+  CHECK (!ring.publish ());
+  CHECK (ring.has_frame ());
+
+  /* Publishing over an unseen frame hands that one back for reuse */
+  ring.back () = { 2, 2 };
+  CHECK (ring.publish ());
+  CHECK_EQ (ring.back ().a, 1u);
+
+  CHECK (ring.pop (frame));
+  CHECK_EQ (frame.a, 2u);
+  CHECK (!ring.has_frame ());
+  CHECK (!ring.pop (frame));
+
+  ring.back () = { 3, 3 };
+  CHECK (!ring.publish ());
+  CHECK (ring.pop (frame));
+  CHECK_EQ (frame.a, 3u);
+
+  CHECK_EQ (ring.published (), 3u);
+  CHECK_EQ (ring.dropped (), 1u);
+  CHECK_EQ (ring.consumed (), 2u);
+}
+
+/* Producer and consumer on their own threads */
+static void
+test_ring_threads ()
+{
+  const uint64_t frames = 1000000;
+  GstSpoutFrameRing<Frame> ring;
+  std::atomic<bool> done { false };
+  uint64_t last = 0, popped = 0, torn = 0, reordered = 0;
+
+  std::thread producer ([&] {
+    for (uint64_t i = 1; i <= frames; i++) {
+      Frame & back = ring.back ();
+      back.a = i;
+      back.b = i;
+      ring.publish ();
+    }
+    done = true;
+  });
+
+  for (;;) {
+    bool finished = done.load ();
+    Frame frame;
+
+    while (ring.pop (frame)) {
+      torn += frame.a != frame.b;
+      reordered += frame.a <= last;
+      last = frame.a;
+      popped++;
+    }
+    if (finished)
+      break;
+  }
+  producer.join ();
+
+  CHECK_EQ (torn, 0u);
+  CHECK_EQ (reordered, 0u);
+  CHECK_EQ (last, frames);
+  CHECK_EQ (ring.published (), frames);
+  CHECK_EQ (ring.consumed (), popped);
+  CHECK_EQ (ring.consumed () + ring.dropped (), frames);
+}
+
+/* Frames from the heap, like buffers from a pool */
+class SyntheticSource : public GstSpoutFrameSource<Frame *>
+{
+public:
+  bool acquire (Frame *& frame) override
+  {
+    if (fail_acquire && acquired % 5 == 0 && failed++ % 2 == 0)
+      return false;
+    frame = new Frame ();
+    acquired++;
+    return true;
+  }
+
+  GstSpoutReceiveResult receive (Frame *& frame) override
+  {
+    receives++;
+    if (error_every && receives % error_every == 0)
+      return GstSpoutReceiveResult::ERROR;
+    if (idle_every && receives % idle_every == 0)
+      return GstSpoutReceiveResult::NO_FRAME;
+
+    sent++;
+    frame->a = sent;
+    frame->b = sent;
+    return GstSpoutReceiveResult::FRAME;
+  }
+
+  void release (Frame *& frame) override
+  {
+    delete frame;
+    frame = nullptr;
+    released++;
+  }
+
+  Duration idle (Duration poll_interval) override
+  {
+    idles++;
+    return poll_interval;
+  }
+
+  bool fail_acquire = false;
+  unsigned error_every = 0;
+  unsigned idle_every = 0;
+
+  std::atomic<uint64_t> acquired { 0 };
+  std::atomic<uint64_t> released { 0 };
+  std::atomic<uint64_t> idles { 0 };
+  uint64_t failed = 0;
+  uint64_t receives = 0;
+  uint64_t sent = 0;
+};
+
+static void
+test_capture_thread ()
+{
+  SyntheticSource source;
+  GstSpoutCaptureThread<Frame *> capture;
+  uint64_t last = 0, popped = 0, torn = 0, reordered = 0;
+
+  source.fail_acquire = true;
+  source.error_every = 13;
+  source.idle_every = 7;
+  capture.start (&source, Micros (10), Micros (10));
+  CHECK (capture.running ());
+
+  for (int i = 0; i < 20000; i++) {
+    Frame *frame = nullptr;
+
+    if (!capture.pop_latest (frame, Micros (1000)))
+      continue;
+
+    torn += frame->a != frame->b;
+    reordered += frame->a <= last;
+    last = frame->a;
+    popped++;
+    source.release (frame);
+  }
+
+  capture.stop ();
+  CHECK (!capture.running ());
+
+  CHECK (popped > 1000);
+  CHECK_EQ (torn, 0u);
+  CHECK_EQ (reordered, 0u);
+  CHECK (source.idles > 0);
+  CHECK_EQ (capture.frames_received (), source.sent);
+
+  /* stop() pops a frame nobody took yet */
+  CHECK (capture.frames_consumed () - popped <= 1);
+  CHECK_EQ (capture.frames_consumed () + capture.frames_dropped (),
+      capture.frames_received ());
+
+  /* Everything the thread still held went back to the source */
+  CHECK_EQ (source.acquired.load (), source.released.load ());
+}
+
+/* Flushing and stopping don't wait out timeouts or intervals */
+static void
+test_flushing ()
+{
+  SyntheticSource source;
+  GstSpoutCaptureThread<Frame *> capture;
+  Frame *frame = nullptr;
+
+  source.idle_every = 1;
+  capture.start (&source, Micros (10000000), Micros (10000000));
+
+  auto start = std::chrono::steady_clock::now ();
+  CHECK (!capture.pop_latest (frame, Micros (20000)));
+  CHECK (std::chrono::steady_clock::now () - start >= Micros (20000));
+
+  capture.set_flushing (true);
+  start = std::chrono::steady_clock::now ();
+  CHECK (!capture.pop_latest (frame, Micros (10000000)));
+  CHECK (std::chrono::steady_clock::now () - start < std::chrono::seconds (1));
+
+  start = std::chrono::steady_clock::now ();
+  capture.stop ();
+  CHECK (std::chrono::steady_clock::now () - start < std::chrono::seconds (1));
+  CHECK_EQ (source.acquired.load (), source.released.load ());
+}
+
+int
+main ()
+{
+  test_ring_latest ();
+  test_ring_threads ();
+  test_capture_thread ();
+  test_flushing ();
+
+  return gst_spout_test_result ();
+}
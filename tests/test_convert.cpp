@@ -0,0 +1,180 @@
+/* GStreamer
+ * Copyright (C) 2023 Your Name <your.email@example.com>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+/* gst_spout_convert(): the SSE4.1 and AVX2 kernels are bit-exact against
+ * the scalar one for every format pair, at widths around each kernel's
+ * block size, odd sizes and padded strides included */
+
+#include "gstspoutconverttest.h"
+#include "gstspouttest.h"
+
+#include <cstdio>
+
+static const uint32_t test_sizes[][2] = {
+  { 1, 1 }, { 2, 2 }, { 3, 3 }, { 7, 5 }, { 8, 2 }, { 15, 7 }, { 16, 16 },
+  { 17, 9 }, { 31, 4 }, { 32, 3 }, { 33, 6 }, { 63, 2 }, { 64, 5 },
+  { 65, 3 }, { 127, 4 }, { 1920, 9 },
+};
+
+/* Bytes of @a and @b differ, padding included */
+static bool
+frames_differ (const TestFrame & a, const TestFrame & b, int * plane,
+    uint32_t * x, uint32_t * y)
+{
+  for (int i = 0; i < a.n_planes; i++) {
+    for (uint32_t row = 0; row < a.rows[i]; row++) {
+      const uint8_t *pa = a.planes.data[i] + row * a.planes.stride[i];
+      const uint8_t *pb = b.planes.data[i] + row * b.planes.stride[i];
+
+      for (size_t col = 0; col < a.planes.stride[i]; col++) {
+        if (pa[col] != pb[col]) {
+          *plane = i;
+          *x = (uint32_t) col;
+          *y = row;
+          return true;
+        }
+      }
+    }
+  }
+
+  return false;
+}
+
+/* Padding after each row is still the fill pattern */
+static bool
+padding_intact (const TestFrame & frame)
+{
+  for (int i = 0; i < frame.n_planes; i++) {
+    for (uint32_t row = 0; row < frame.rows[i]; row++) {
+      const uint8_t *p = frame.planes.data[i] + row * frame.planes.stride[i];
+
+      for (size_t col = frame.row_bytes[i]; col < frame.planes.stride[i]; col++) {
+        if (p[col] != 0xa5)
+          return false;
+      }
+    }
+  }
+
+  return true;
+}
+
+static void
+test_bit_exact ()
+{
+  GstSpoutCpuLevel best = gst_spout_cpu_level ();
+  std::mt19937 rng (1234);
+
+  printf ("CPU level: %s\n", gst_spout_cpu_level_name (best));
+  if (best == GST_SPOUT_CPU_SCALAR)
+    printf ("No SIMD kernels on this CPU, only checking the scalar one\n");
+
+  for (GstSpoutPixelFormat in : test_packed_formats) {
+    for (GstSpoutPixelFormat out : test_output_formats) {
+      CHECK (gst_spout_convert_supported (in, out));
+
+      for (const auto & size : test_sizes) {
+        TestFrame src (in, size[0], size[1], 12);
+        TestFrame reference (out, size[0], size[1], 5);
+
+        src.fill (rng);
+        src.convert_to (reference, GST_SPOUT_CPU_SCALAR);
+        CHECK (padding_intact (reference));
+
+        for (int level = GST_SPOUT_CPU_SSE41; level <= best; level++) {
+          TestFrame simd (out, size[0], size[1], 5);
+          int plane;
+          uint32_t x, y;
+
+          src.convert_to (simd, (GstSpoutCpuLevel) level);
+          if (frames_differ (reference, simd, &plane, &x, &y)) {
+            fprintf (stderr, "%s -> %s %ux%u %s: plane %d byte %u row %u "
+                "differs\n", test_format_name (in), test_format_name (out),
+                size[0], size[1],
+                gst_spout_cpu_level_name ((GstSpoutCpuLevel) level),
+                plane, x, y);
+            gst_spout_test_failures++;
+          }
+        }
+      }
+    }
+  }
+}
+
+/* Converting in bands, as the readback threads do, gives the whole frame */
+static void
+test_bands ()
+{
+  std::mt19937 rng (42);
+
+  for (GstSpoutPixelFormat out : test_output_formats) {
+    TestFrame src (GST_SPOUT_PIXEL_FORMAT_BGRA, 99, 37, 8);
+    TestFrame whole (out, 99, 37), banded (out, 99, 37);
+    int plane;
+    uint32_t x, y;
+
+    src.fill (rng);
+    src.convert_to (whole, gst_spout_cpu_level ());
+    for (uint32_t y_begin = 0; y_begin < 37; y_begin += 6)
+      src.convert_to (banded, gst_spout_cpu_level (), y_begin, y_begin + 6);
+
+    CHECK (!frames_differ (whole, banded, &plane, &x, &y));
+  }
+}
+
+/* BT.709 limited range end points, in every kernel */
+static void
+test_levels ()
+{
+  for (int level = GST_SPOUT_CPU_SCALAR; level <= gst_spout_cpu_level ();
+      level++) {
+    TestFrame white (GST_SPOUT_PIXEL_FORMAT_BGRX, 40, 2);
+    TestFrame black (GST_SPOUT_PIXEL_FORMAT_BGRX, 40, 2);
+    TestFrame white_nv12 (GST_SPOUT_PIXEL_FORMAT_NV12, 40, 2);
+    TestFrame black_i420 (GST_SPOUT_PIXEL_FORMAT_I420, 40, 2);
+    TestFrame opaque (GST_SPOUT_PIXEL_FORMAT_RGBA, 40, 2);
+
+    memset (white.data.data (), 0xff, white.data.size ());
+    memset (black.data.data (), 0x00, black.data.size ());
+
+    white.convert_to (white_nv12, (GstSpoutCpuLevel) level);
+    black.convert_to (black_i420, (GstSpoutCpuLevel) level);
+    black.convert_to (opaque, (GstSpoutCpuLevel) level);
+
+    CHECK_EQ (white_nv12.planes.data[0][39], 235);
+    CHECK_EQ (white_nv12.planes.data[1][0], 128);
+    CHECK_EQ (white_nv12.planes.data[1][1], 128);
+    CHECK_EQ (black_i420.planes.data[0][40], 16);
+    CHECK_EQ (black_i420.planes.data[1][19], 128);
+    CHECK_EQ (black_i420.planes.data[2][0], 128);
+
+    /* Padding bytes become opaque alpha */
+    CHECK_EQ (opaque.planes.data[0][3], 0xff);
+    CHECK_EQ (opaque.planes.data[0][0], 0);
+  }
+}
+
+int
+main ()
+{
+  test_bit_exact ();
+  test_bands ();
+  test_levels ();
+
+  return gst_spout_test_result ();
+}
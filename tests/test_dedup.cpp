@@ -0,0 +1,146 @@
+/* GStreamer
+ * Copyright (C) 2023 Your Name <your.email@example.com>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+/* GstSpoutDuplicateFilter over scripted sequences of sender frame numbers
+ * and content fingerprints, under each duplicate-policy */
+
+#include "gstspoutdedup.h"
+#include "gstspouttest.h"
+
+#include <cstring>
+#include <vector>
+
+struct Received
+{
+  int64_t sender_frame;
+  uint64_t fingerprint;
+};
+
+static std::vector<GstSpoutFrameAction>
+run (GstSpoutDuplicateFilter & filter, GstSpoutDuplicatePolicy policy,
+    const std::vector<Received> & frames)
+{
+  std::vector<GstSpoutFrameAction> actions;
+
+  for (const Received & frame : frames)
+    actions.push_back (filter.process (policy, frame.sender_frame,
+            frame.fingerprint));
+
+  return actions;
+}
+
+static void
+test_fingerprint ()
+{
+  const char *foobar = "foobar";
+
+  /* FNV-1a reference values */
+  CHECK_EQ (gst_spout_fingerprint_bytes (nullptr, 0), 0xcbf29ce484222325ull);
+  CHECK_EQ (gst_spout_fingerprint_bytes ((const uint8_t *) "a", 1),
+      0xaf63dc4c8601ec8cull);
+  CHECK_EQ (gst_spout_fingerprint_bytes ((const uint8_t *) foobar,
+          strlen (foobar)), 0x85944171f73967e8ull);
+
+  /* Chaining hashes piecewise like one pass */
+  uint64_t hash = gst_spout_fingerprint_bytes ((const uint8_t *) foobar, 3);
+  CHECK_EQ (gst_spout_fingerprint_bytes ((const uint8_t *) foobar + 3, 3, hash),
+      0x85944171f73967e8ull);
+
+  /* A single changed pixel changes it */
+  uint8_t pixels[64] = { };
+  uint64_t before = gst_spout_fingerprint_bytes (pixels, sizeof (pixels));
+  pixels[37] = 1;
+  CHECK (gst_spout_fingerprint_bytes (pixels, sizeof (pixels)) != before);
+}
+
+/* A sender counting frames, polled faster than it sends */
+static const std::vector<Received> counted = {
+  { 1, 0 }, { 1, 0 }, { 2, 0 }, { 3, 0 }, { 3, 0 }, { 3, 0 }, { 5, 0 },
+};
+
+static void
+test_policies ()
+{
+  const GstSpoutFrameAction P = GST_SPOUT_FRAME_ACTION_PUSH;
+  const GstSpoutFrameAction G = GST_SPOUT_FRAME_ACTION_GAP;
+  const GstSpoutFrameAction S = GST_SPOUT_FRAME_ACTION_SKIP;
+  GstSpoutDuplicateFilter repeat, gap, wait;
+
+  CHECK (run (repeat, GST_SPOUT_DUPLICATE_POLICY_REPEAT, counted) ==
+      std::vector<GstSpoutFrameAction> ({ P, P, P, P, P, P, P }));
+  CHECK (run (gap, GST_SPOUT_DUPLICATE_POLICY_GAP, counted) ==
+      std::vector<GstSpoutFrameAction> ({ P, G, P, P, G, G, P }));
+  CHECK (run (wait, GST_SPOUT_DUPLICATE_POLICY_WAIT, counted) ==
+      std::vector<GstSpoutFrameAction> ({ P, S, P, P, S, S, P }));
+
+  /* Repeat still counts what it lets through */
+  CHECK_EQ (repeat.duplicates (), 3u);
+  CHECK_EQ (gap.duplicates (), 3u);
+  CHECK_EQ (wait.duplicates (), 3u);
+}
+
+/* Senders without frame counting are compared by content, and a frame
+ * number never matches a fingerprint that happens to be equal */
+static void
+test_fingerprinted ()
+{
+  const GstSpoutFrameAction P = GST_SPOUT_FRAME_ACTION_PUSH;
+  const GstSpoutFrameAction S = GST_SPOUT_FRAME_ACTION_SKIP;
+  GstSpoutDuplicateFilter filter;
+
+  CHECK (run (filter, GST_SPOUT_DUPLICATE_POLICY_WAIT, {
+        { 0, 0xaa }, { 0, 0xaa }, { -1, 0xaa }, { 0, 0xbb }, { 0, 0xaa },
+        /* The sender turned frame counting on, frame 0xaa isn't content */
+        { 0xaa, 0 }, { 0xaa, 0 }, { 0, 0xaa }, { 0, 0xaa },
+      }) == std::vector<GstSpoutFrameAction> ({ P, S, S, P, P, P, S, P, S }));
+  CHECK_EQ (filter.duplicates (), 4u);
+}
+
+/* After a reset (reconnect, flush) the first frame is always new */
+static void
+test_reset ()
+{
+  GstSpoutDuplicateFilter filter;
+
+  CHECK_EQ (filter.process (GST_SPOUT_DUPLICATE_POLICY_WAIT, 7, 0),
+      GST_SPOUT_FRAME_ACTION_PUSH);
+  filter.reset ();
+  CHECK_EQ (filter.process (GST_SPOUT_DUPLICATE_POLICY_WAIT, 7, 0),
+      GST_SPOUT_FRAME_ACTION_PUSH);
+  CHECK_EQ (filter.process (GST_SPOUT_DUPLICATE_POLICY_WAIT, 7, 0),
+      GST_SPOUT_FRAME_ACTION_SKIP);
+
+  /* Fingerprint 0 right after a reset isn't taken for "nothing seen" */
+  filter.reset ();
+  CHECK_EQ (filter.process (GST_SPOUT_DUPLICATE_POLICY_GAP, 0, 0),
+      GST_SPOUT_FRAME_ACTION_PUSH);
+  CHECK_EQ (filter.process (GST_SPOUT_DUPLICATE_POLICY_GAP, 0, 0),
+      GST_SPOUT_FRAME_ACTION_GAP);
+}
+
+int
+main ()
+{
+  test_fingerprint ();
+  test_policies ();
+  test_fingerprinted ();
+  test_reset ();
+
+  return gst_spout_test_result ();
+}
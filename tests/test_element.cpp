@@ -0,0 +1,320 @@
+/* GStreamer
+ * Copyright (C) 2023 Your Name <your.email@example.com>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+/* spoutsrc itself in a pipeline, with the backends that need no GPU:
+ * frames from a GstSpoutShmSender in this process and from a recording
+ * come out as buffers of the sender's format. Takes the path of the built
+ * plugin as its argument */
+
+#include <gst/gst.h>
+#include <gst/video/video.h>
+
+#include "gstspoutrecording.h"
+#include "gstspoutshm.h"
+#include "gstspouttest.h"
+
+#include <atomic>
+#include <cstring>
+#include <filesystem>
+#include <random>
+#include <thread>
+#include <vector>
+
+using namespace std::chrono_literals;
+
+static const uint32_t WIDTH = 64;
+static const uint32_t HEIGHT = 16;
+
+static GstSpoutFrameFormat
+make_format ()
+{
+  GstSpoutFrameFormat format;
+
+  format.width = WIDTH;
+  format.height = HEIGHT;
+  format.format = 87;           /* DXGI_FORMAT_B8G8R8A8_UNORM */
+  format.stride = WIDTH * 4;
+  format.fps = 60.0;
+  return format;
+}
+
+static std::string
+sender_name (const char * what)
+{
+  return std::string ("test-element-") + what + "-" +
+      std::to_string (gst_spout_shm_current_pid ());
+}
+
+static std::string
+recording_path (const char * what)
+{
+  std::filesystem::path path = std::filesystem::temp_directory_path () /
+      (std::string ("test-element-") + what + "-" +
+      std::to_string (std::random_device () ()) + ".gspr");
+
+  return path.string ();
+}
+
+/* Publishes frames at about 100 fps until destroyed */
+class Publisher
+{
+public:
+  explicit Publisher (GstSpoutShmSender & sender)
+    : thread_ ([this, &sender] {
+        while (!stop_.load ()) {
+          uint8_t *data = sender.begin ();
+
+          if (data) {
+            memset (data, (int) ((sender.frames () + 1) & 0xff),
+                (size_t) WIDTH * 4 * HEIGHT);
+            sender.publish ();
+          }
+          std::this_thread::sleep_for (10ms);
+        }
+      })
+  {
+  }
+
+  ~Publisher ()
+  {
+    stop_.store (true);
+    thread_.join ();
+  }
+
+private:
+  std::atomic<bool> stop_ { false };
+  std::thread thread_;
+};
+
+static GstElement *
+make_pipeline (const std::string & description)
+{
+  GError *error = NULL;
+  GstElement *pipeline = gst_parse_launch (description.c_str (), &error);
+
+  if (error) {
+    fprintf (stderr, "%s: %s\n", description.c_str (), error->message);
+    g_clear_error (&error);
+  }
+  return pipeline;
+}
+
+/* Run @pipeline until EOS or an error, returns the type of the message
+ * that ended it, GST_MESSAGE_UNKNOWN on timeout */
+static GstMessageType
+run (GstElement * pipeline)
+{
+  GstBus *bus = gst_element_get_bus (pipeline);
+  GstMessage *message;
+  GstMessageType type = GST_MESSAGE_UNKNOWN;
+
+  gst_element_set_state (pipeline, GST_STATE_PLAYING);
+  message = gst_bus_timed_pop_filtered (bus, 10 * GST_SECOND,
+      (GstMessageType) (GST_MESSAGE_EOS | GST_MESSAGE_ERROR));
+  if (message) {
+    type = GST_MESSAGE_TYPE (message);
+    if (type == GST_MESSAGE_ERROR) {
+      GError *error = NULL;
+
+      gst_message_parse_error (message, &error, NULL);
+      fprintf (stderr, "error: %s\n", error->message);
+      g_clear_error (&error);
+    }
+    gst_message_unref (message);
+  }
+  gst_object_unref (bus);
+  return type;
+}
+
+static guint64
+stats_field (GstElement * pipeline, const char * field)
+{
+  GstElement *src = gst_bin_get_by_name (GST_BIN (pipeline), "src");
+  GstStructure *stats = NULL;
+  guint64 value = G_MAXUINT64;
+
+  g_object_get (src, "stats", &stats, NULL);
+  if (stats) {
+    gst_structure_get_uint64 (stats, field, &value);
+    gst_structure_free (stats);
+  }
+  gst_object_unref (src);
+  return value;
+}
+
+/* The caps that went out, as video info */
+static bool
+negotiated (GstElement * pipeline, GstVideoInfo * info)
+{
+  GstElement *sink = gst_bin_get_by_name (GST_BIN (pipeline), "sink");
+  GstPad *pad = gst_element_get_static_pad (sink, "sink");
+  GstCaps *caps = gst_pad_get_current_caps (pad);
+  bool ok = caps && gst_video_info_from_caps (info, caps);
+
+  if (caps)
+    gst_caps_unref (caps);
+  gst_object_unref (pad);
+  gst_object_unref (sink);
+  return ok;
+}
+
+/* backend=shm pushes the sender's frames in its format */
+static void
+test_shm ()
+{
+  std::string name = sender_name ("shm");
+  GstSpoutShmSender sender;
+  GstVideoInfo info;
+
+  CHECK (sender.create (name, make_format ()));
+  Publisher publisher (sender);
+
+  GstElement *pipeline = make_pipeline ("spoutsrc name=src backend=shm "
+      "sender-name=" + name + " num-buffers=10 ! fakesink name=sink");
+  CHECK (pipeline);
+  if (!pipeline)
+    return;
+
+  CHECK_EQ (run (pipeline), GST_MESSAGE_EOS);
+  CHECK (negotiated (pipeline, &info));
+  CHECK_EQ (GST_VIDEO_INFO_WIDTH (&info), (gint) WIDTH);
+  CHECK_EQ (GST_VIDEO_INFO_HEIGHT (&info), (gint) HEIGHT);
+  CHECK_EQ (GST_VIDEO_INFO_FORMAT (&info), GST_VIDEO_FORMAT_BGRA);
+  CHECK_EQ (stats_field (pipeline, "frames-pushed"), 10u);
+
+  gst_element_set_state (pipeline, GST_STATE_NULL);
+  gst_object_unref (pipeline);
+}
+
+/* Started before the sender exists, spoutsrc connects once it appears and
+ * counts that as its first connect, not a reconnect */
+static void
+test_shm_late_sender ()
+{
+  std::string name = sender_name ("late");
+  GstSpoutShmSender sender;
+
+  GstElement *pipeline = make_pipeline ("spoutsrc name=src backend=shm "
+      "sender-name=" + name + " num-buffers=5 ! fakesink name=sink");
+  CHECK (pipeline);
+  if (!pipeline)
+    return;
+
+  CHECK (gst_element_set_state (pipeline, GST_STATE_PAUSED) !=
+      GST_STATE_CHANGE_FAILURE);
+  std::this_thread::sleep_for (200ms);
+
+  CHECK (sender.create (name, make_format ()));
+  Publisher publisher (sender);
+
+  CHECK_EQ (run (pipeline), GST_MESSAGE_EOS);
+  CHECK_EQ (stats_field (pipeline, "frames-pushed"), 5u);
+  CHECK_EQ (stats_field (pipeline, "reconnects"), 0u);
+
+  gst_element_set_state (pipeline, GST_STATE_NULL);
+  gst_object_unref (pipeline);
+}
+
+/* backend=replay plays every recorded frame and ends with EOS */
+static void
+test_replay ()
+{
+  std::string path = recording_path ("replay");
+  GstSpoutFrameFormat format = make_format ();
+  std::vector<uint8_t> data ((size_t) format.stride * format.height);
+  GstSpoutRecorder recorder;
+  uint64_t time = 0;
+  GstVideoInfo info;
+
+  CHECK (recorder.open (path));
+  recorder.state (time, true, "recorded", format);
+  for (uint64_t n = 1; n <= 5; n++) {
+    time += 16 * GST_MSECOND;
+    memset (data.data (), (int) n, data.size ());
+    recorder.frame (time, n, time, 0, data.data (), data.size ());
+  }
+  recorder.close ();
+
+  GstElement *pipeline = make_pipeline ("spoutsrc name=src backend=replay "
+      "replay-location=" + path + " replay-timing=fast ! fakesink name=sink");
+  CHECK (pipeline);
+  if (pipeline) {
+    CHECK_EQ (run (pipeline), GST_MESSAGE_EOS);
+    CHECK (negotiated (pipeline, &info));
+    CHECK_EQ (GST_VIDEO_INFO_WIDTH (&info), (gint) WIDTH);
+    CHECK_EQ (stats_field (pipeline, "frames-pushed"), 5u);
+
+    gst_element_set_state (pipeline, GST_STATE_NULL);
+    gst_object_unref (pipeline);
+  }
+
+  std::filesystem::remove (path);
+}
+
+/* A start that fails after record-location was opened, here on a missing
+ * replay-location, leaves no recording behind */
+static void
+test_failed_start_records_nothing ()
+{
+  std::string path = recording_path ("failed-start");
+  std::string missing = recording_path ("missing");
+
+  GstElement *pipeline = make_pipeline ("spoutsrc name=src backend=replay "
+      "replay-location=" + missing + " record-location=" + path +
+      " ! fakesink name=sink");
+  CHECK (pipeline);
+  if (!pipeline)
+    return;
+
+  CHECK_EQ (gst_element_set_state (pipeline, GST_STATE_PAUSED),
+      GST_STATE_CHANGE_FAILURE);
+  CHECK (!std::filesystem::exists (path));
+
+  gst_element_set_state (pipeline, GST_STATE_NULL);
+  gst_object_unref (pipeline);
+  std::filesystem::remove (path);
+}
+
+int
+main (int argc, char **argv)
+{
+  GError *error = NULL;
+  GstPlugin *plugin;
+
+  gst_init (NULL, NULL);
+  if (argc < 2) {
+    fprintf (stderr, "usage: %s PLUGIN\n", argv[0]);
+    return 1;
+  }
+
+  plugin = gst_plugin_load_file (argv[1], &error);
+  if (!plugin) {
+    fprintf (stderr, "%s: %s\n", argv[1], error->message);
+    g_clear_error (&error);
+    return 1;
+  }
+  gst_object_unref (plugin);
+
+  test_shm ();
+  test_shm_late_sender ();
+  test_replay ();
+  test_failed_start_records_nothing ();
+
+  return gst_spout_test_result ();
+}
@@ -0,0 +1,163 @@
+/* GStreamer
+ * Copyright (C) 2023 Your Name <your.email@example.com>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+/* crop-* and output-* mapped onto senders of various sizes by
+ * gst_spout_geometry_compute(), including requests that don't fit */
+
+#include "gstspoutgeometry.h"
+#include "gstspouttest.h"
+
+#include <random>
+
+static GstSpoutGeometryRequest
+make_request (uint32_t left, uint32_t right, uint32_t top, uint32_t bottom,
+    uint32_t width = 0, uint32_t height = 0)
+{
+  GstSpoutGeometryRequest request;
+
+  request.crop_left = left;
+  request.crop_right = right;
+  request.crop_top = top;
+  request.crop_bottom = bottom;
+  request.width = width;
+  request.height = height;
+  return request;
+}
+
+static void
+test_default ()
+{
+  GstSpoutGeometryRequest request;
+  GstSpoutGeometry geometry = gst_spout_geometry_compute (1920, 1080, request);
+
+  CHECK (request.is_default ());
+  CHECK (geometry.identity ());
+  CHECK_EQ (geometry.width, 1920u);
+  CHECK_EQ (geometry.height, 1080u);
+  CHECK_EQ (geometry.crop.width, 1920u);
+  CHECK_EQ (geometry.crop.height, 1080u);
+}
+
+static void
+test_crop ()
+{
+  /* 16:9 letterboxed 4:3 content */
+  GstSpoutGeometry geometry = gst_spout_geometry_compute (1920, 1080,
+      make_request (240, 240, 0, 0));
+
+  CHECK (!make_request (240, 240, 0, 0).is_default ());
+  CHECK (geometry.cropped ());
+  CHECK (!geometry.scaled ());
+  CHECK_EQ (geometry.crop.x, 240u);
+  CHECK_EQ (geometry.crop.y, 0u);
+  CHECK_EQ (geometry.crop.width, 1440u);
+  CHECK_EQ (geometry.crop.height, 1080u);
+  CHECK_EQ (geometry.width, 1440u);
+  CHECK_EQ (geometry.height, 1080u);
+
+  /* Cropping everything away keeps a pixel, the leading side wins */
+  geometry = gst_spout_geometry_compute (100, 50,
+      make_request (300, 300, 10, 45));
+  CHECK_EQ (geometry.crop.x, 99u);
+  CHECK_EQ (geometry.crop.width, 1u);
+  CHECK_EQ (geometry.crop.y, 10u);
+  CHECK_EQ (geometry.crop.height, 1u);
+
+  uint32_t offset, length;
+  gst_spout_geometry_crop_side (0, 5, 5, &offset, &length);
+  CHECK_EQ (offset, 0u);
+  CHECK_EQ (length, 0u);
+}
+
+static void
+test_scale ()
+{
+  /* Both sides set: exactly that, aspect ratio or not */
+  GstSpoutGeometry geometry = gst_spout_geometry_compute (1920, 1080,
+      make_request (0, 0, 0, 0, 1280, 1024));
+  CHECK (geometry.scaled ());
+  CHECK (!geometry.cropped ());
+  CHECK_EQ (geometry.width, 1280u);
+  CHECK_EQ (geometry.height, 1024u);
+
+  /* One side set follows the crop's aspect ratio */
+  geometry = gst_spout_geometry_compute (1920, 1080,
+      make_request (0, 0, 0, 0, 1280, 0));
+  CHECK_EQ (geometry.height, 720u);
+  geometry = gst_spout_geometry_compute (1920, 1080,
+      make_request (0, 0, 0, 0, 0, 480));
+  CHECK_EQ (geometry.width, 853u);       /* 853.33 */
+  geometry = gst_spout_geometry_compute (1920, 1080,
+      make_request (240, 240, 0, 0, 0, 720));
+  CHECK_EQ (geometry.width, 960u);
+
+  /* Same size as the crop is no scaling */
+  geometry = gst_spout_geometry_compute (1920, 1080,
+      make_request (0, 0, 0, 0, 1920, 0));
+  CHECK (geometry.identity ());
+
+  CHECK_EQ (gst_spout_geometry_scale (1080, 2, 3), 720u);
+  CHECK_EQ (gst_spout_geometry_scale (5, 1, 2), 3u);        /* 2.5 rounds up */
+  CHECK_EQ (gst_spout_geometry_scale (1, 1, 1000), 1u);     /* at least 1 */
+  CHECK_EQ (gst_spout_geometry_scale (77, 3, 0), 77u);
+  CHECK_EQ (gst_spout_geometry_scale (UINT32_MAX, UINT32_MAX, 1), UINT32_MAX);
+}
+
+/* Whatever is asked for, the crop stays inside the sender and frames have
+ * a size */
+static void
+test_random_requests ()
+{
+  std::mt19937 rng (3);
+  unsigned outside = 0, empty = 0, wrong_flags = 0;
+
+  for (int i = 0; i < 100000; i++) {
+    uint32_t source_width = 1 + rng () % 4096;
+    uint32_t source_height = 1 + rng () % 4096;
+    GstSpoutGeometryRequest request = make_request (rng () % 5000,
+        rng () % 5000, rng () % 5000, rng () % 5000,
+        rng () % 3 ? 0 : rng () % 8000, rng () % 3 ? 0 : rng () % 8000);
+    GstSpoutGeometry geometry = gst_spout_geometry_compute (source_width,
+        source_height, request);
+
+    outside += geometry.crop.x + geometry.crop.width > source_width ||
+        geometry.crop.y + geometry.crop.height > source_height;
+    empty += !geometry.crop.width || !geometry.crop.height ||
+        !geometry.width || !geometry.height;
+    wrong_flags += geometry.identity () !=
+        (geometry.crop.width == source_width &&
+        geometry.crop.height == source_height &&
+        geometry.width == source_width && geometry.height == source_height);
+  }
+
+  CHECK_EQ (outside, 0u);
+  CHECK_EQ (empty, 0u);
+  CHECK_EQ (wrong_flags, 0u);
+}
+
+int
+main ()
+{
+  test_default ();
+  test_crop ();
+  test_scale ();
+  test_random_requests ();
+
+  return gst_spout_test_result ();
+}
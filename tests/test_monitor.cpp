@@ -0,0 +1,199 @@
+/* GStreamer
+ * Copyright (C) 2023 Your Name <your.email@example.com>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+/* GstSpoutSenderMonitor over a fake sender registry: what subscribers are
+ * told, and that one scan thread serves all of them however many there are */
+
+#include "gstspoutmonitor.h"
+#include "gstspouttest.h"
+
+#include <atomic>
+
+class FakeRegistry : public GstSpoutSenderRegistry
+{
+public:
+  std::vector<GstSpoutSenderDesc> list () override
+  {
+    std::lock_guard<std::mutex> lock (lock_);
+
+    calls++;
+    return senders_;
+  }
+
+  void set (std::vector<GstSpoutSenderDesc> senders)
+  {
+    std::lock_guard<std::mutex> lock (lock_);
+
+    senders_ = std::move (senders);
+  }
+
+  std::atomic<uint64_t> calls { 0 };
+
+private:
+  std::mutex lock_;
+  std::vector<GstSpoutSenderDesc> senders_;
+};
+
+/* Everything a subscriber was told, applied to a sender list */
+struct Listener
+{
+  std::vector<GstSpoutSenderDesc> senders;
+  std::vector<std::string> events;
+
+  GstSpoutSenderMonitor::Callback callback ()
+  {
+    return [this] (const GstSpoutSenderDiff & diff) {
+      for (const auto & sender : diff.removed) {
+        events.push_back ("-" + sender.name);
+        std::erase (senders, sender);
+      }
+      for (const auto & sender : diff.added) {
+        events.push_back ("+" + sender.name);
+        senders.push_back (sender);
+      }
+    };
+  }
+};
+
+static const GstSpoutSenderDesc resolume = { "Resolume", 1920, 1080, 87 };
+static const GstSpoutSenderDesc td = { "TouchDesigner", 1280, 720, 28 };
+
+static void
+test_diff ()
+{
+  GstSpoutSenderDesc resized = resolume;
+  resized.width = 3840;
+
+  GstSpoutSenderDiff diff = gst_spout_diff_senders ({ resolume, td },
+      { td, resolume });
+  CHECK (diff.empty ());
+
+  /* A changed sender goes and comes back, whoever built something from it
+   * rebuilds */
+  diff = gst_spout_diff_senders ({ resolume, td }, { resized, td });
+  CHECK_EQ (diff.removed.size (), 1u);
+  CHECK_EQ (diff.added.size (), 1u);
+  CHECK (diff.removed[0] == resolume);
+  CHECK (diff.added[0] == resized);
+
+  diff = gst_spout_diff_senders ({ }, { resolume });
+  CHECK_EQ (diff.added.size (), 1u);
+  CHECK (diff.removed.empty ());
+}
+
+/* Driven by poll(), as with a zero interval */
+static void
+test_polled ()
+{
+  FakeRegistry registry;
+  GstSpoutSenderMonitor monitor (&registry, GstSpoutSenderMonitor::Duration (0));
+  Listener first, second;
+
+  registry.set ({ resolume });
+  uint64_t first_id = monitor.subscribe (first.callback ());
+  CHECK (first.senders == std::vector<GstSpoutSenderDesc> { resolume });
+  CHECK (monitor.has_sender ("Resolume"));
+  CHECK (monitor.has_sender (""));
+  CHECK (!monitor.has_sender ("TouchDesigner"));
+
+  CHECK (!monitor.poll ());
+
+  registry.set ({ resolume, td });
+  CHECK (monitor.poll ());
+  CHECK_EQ (first.senders.size (), 2u);
+
+  /* Late subscribers get the current list up front */
+  uint64_t second_id = monitor.subscribe (second.callback ());
+  CHECK_EQ (second.senders.size (), 2u);
+
+  registry.set ({ td });
+  CHECK (monitor.poll ());
+  CHECK (first.senders == std::vector<GstSpoutSenderDesc> { td });
+  CHECK (second.senders == std::vector<GstSpoutSenderDesc> { td });
+
+  /* Unsubscribed means not told anymore */
+  monitor.unsubscribe (first_id);
+  registry.set ({ });
+  CHECK (monitor.poll ());
+  CHECK_EQ (first.senders.size (), 1u);
+  CHECK (second.senders.empty ());
+  CHECK (!monitor.has_sender (""));
+
+  monitor.unsubscribe (second_id);
+}
+
+/* However many elements and providers subscribe, the registry is scanned
+ * once per interval and each of them hears about every change */
+static void
+test_shared_thread ()
+{
+  FakeRegistry registry;
+  GstSpoutSenderMonitor monitor (&registry, GstSpoutSenderMonitor::Duration (1));
+  std::vector<Listener> listeners (64);
+  std::vector<uint64_t> ids;
+
+  for (auto & listener : listeners)
+    ids.push_back (monitor.subscribe (listener.callback ()));
+
+  auto start = std::chrono::steady_clock::now ();
+  for (int i = 0; i < 20; i++) {
+    uint64_t scans = monitor.scans ();
+
+    registry.set ({ { "sender " + std::to_string (i), 640, 480, 87 } });
+    while (monitor.scans () < scans + 2)
+      std::this_thread::sleep_for (std::chrono::milliseconds (1));
+  }
+  double elapsed_ms = std::chrono::duration<double, std::milli> (
+      std::chrono::steady_clock::now () - start).count ();
+
+  for (uint64_t id : ids)
+    monitor.unsubscribe (id);
+
+  /* One scan per interval, not one per subscriber. subscribe() scans for
+   * the first one */
+  CHECK (registry.calls <= elapsed_ms + 2);
+
+  for (auto & listener : listeners) {
+    CHECK_EQ (listener.events.size (), 39u);
+    CHECK_EQ (listener.senders.size (), 1u);
+    CHECK_EQ (listener.senders[0].name, std::string ("sender 19"));
+  }
+
+  /* No subscribers, no scanning */
+  uint64_t calls = registry.calls;
+  std::this_thread::sleep_for (std::chrono::milliseconds (20));
+  CHECK_EQ (registry.calls.load (), calls);
+
+  /* Coming back rescans what changed meanwhile */
+  Listener late;
+  registry.set ({ resolume, td });
+  uint64_t id = monitor.subscribe (late.callback ());
+  CHECK_EQ (late.senders.size (), 2u);
+  monitor.unsubscribe (id);
+}
+
+int
+main ()
+{
+  test_diff ();
+  test_polled ();
+  test_shared_thread ();
+
+  return gst_spout_test_result ();
+}
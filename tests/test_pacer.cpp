@@ -0,0 +1,277 @@
+/* GStreamer
+ * Copyright (C) 2023 Your Name <your.email@example.com>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+/* GstSpoutCfrPacer driven by a test clock the way create() drives it in
+ * cfr mode: wait for the tick, then emit the newest sender frame or repeat
+ * the last one. Ticks must be exact, and the counters must add up */
+
+#include "gstspoutpacer.h"
+#include "gstspouttest.h"
+
+#include <random>
+#include <vector>
+
+static const uint64_t SECOND = GstSpoutCfrPacer::SECOND;
+static const uint64_t MS = 1000000;
+
+/* Sender frames (numbered from 1) and when they became available */
+struct Sender
+{
+  std::vector<uint64_t> arrivals;
+
+  /* Newest frame available at @now, 0 for none */
+  int64_t newest (uint64_t now) const
+  {
+    int64_t frame = 0;
+
+    while ((size_t) frame < arrivals.size () && arrivals[frame] <= now)
+      frame++;
+    return frame;
+  }
+};
+
+static Sender
+make_sender (int num, int den, uint64_t duration, uint64_t jitter,
+    uint64_t start = 0)
+{
+  std::mt19937 rng (5);
+  Sender sender;
+
+  for (uint64_t i = 0;; i++) {
+    uint64_t time = start + i * SECOND * den / num;
+
+    if (time >= duration)
+      break;
+    sender.arrivals.push_back (time + (jitter ? rng () % jitter : 0));
+  }
+  return sender;
+}
+
+struct Output
+{
+  std::vector<uint64_t> pts;
+  std::vector<int64_t> frames;
+};
+
+/* The streaming thread on a test clock: wakes @wake_delay after each tick,
+ * and stalls for @stall once at @stall_at */
+static Output
+pace (GstSpoutCfrPacer & pacer, const Sender & sender, bool counts_frames,
+    uint64_t duration, uint64_t wake_delay = 0, uint64_t stall_at = 0,
+    uint64_t stall = 0)
+{
+  Output output;
+  uint64_t now = 0;
+  int64_t last = 0;
+
+  while (now < duration) {
+    uint64_t tick = pacer.next_tick (now);
+    int64_t newest;
+
+    now = std::max (now, tick) + wake_delay;
+    if (stall && now >= stall_at) {
+      now += stall;
+      stall = 0;
+    }
+
+    newest = sender.newest (now);
+    if (newest > last) {
+      /* Without frame numbers only our own count of replaced frames */
+      pacer.emit (counts_frames ? newest : 0,
+          counts_frames || !last ? 0 : (uint64_t) (newest - last - 1));
+      last = newest;
+    } else if (pacer.have_frame ()) {
+      pacer.repeat ();
+    } else {
+      continue;
+    }
+
+    output.pts.push_back (tick);
+    output.frames.push_back (last);
+  }
+
+  return output;
+}
+
+/* Tick times are integer maths on the fraction: no drift however long */
+static void
+test_exact_grid ()
+{
+  GstSpoutCfrPacer pacer;
+  uint64_t origin = 5, tick = 0;
+
+  pacer.set_rate (30000, 1001);
+  CHECK (pacer.configured ());
+  CHECK_EQ (pacer.next_tick (origin), origin);
+
+  uint64_t durations = 0;
+  for (int i = 1; i <= 300000; i++) {
+    durations += pacer.duration ();
+    tick = pacer.next_tick (tick);
+  }
+
+  /* 300000 frames at 30000/1001 are 10010 s to the nanosecond */
+  CHECK_EQ (tick - origin, 10010 * SECOND);
+  CHECK_EQ (durations, 10010 * SECOND);
+  CHECK_EQ (pacer.missed (), 0u);
+  CHECK_EQ (pacer.ticks (), 300000u);
+
+  /* Each tick is the period rounded either way, never more */
+  uint64_t duration = pacer.duration ();
+  CHECK (duration == 33366666 || duration == 33366667);
+}
+
+/* A 30 fps sender paced at 60: every frame goes out, on every other tick */
+static void
+test_upsample ()
+{
+  GstSpoutCfrPacer pacer;
+  Sender sender = make_sender (30, 1, 10 * SECOND, 2 * MS, 1 * MS);
+
+  pacer.set_rate (60, 1);
+  Output output = pace (pacer, sender, true, 10 * SECOND, 100000);
+
+  CHECK_EQ (pacer.dropped (), 0u);
+  CHECK_EQ (pacer.missed (), 0u);
+  CHECK (pacer.emitted () >= sender.arrivals.size () - 1);
+  CHECK (pacer.repeated () + 5 >= pacer.emitted ());
+  CHECK_EQ (pacer.emitted () + pacer.repeated (), output.pts.size ());
+  CHECK_EQ (pacer.output (), pacer.ticks () + 1);
+
+  unsigned uneven = 0;
+  for (size_t i = 1; i < output.pts.size (); i++)
+    uneven += output.pts[i] - output.pts[i - 1] != 16666666 &&
+        output.pts[i] - output.pts[i - 1] != 16666667;
+  CHECK_EQ (uneven, 0u);
+}
+
+/* A 60 fps sender paced at 30: half its frames are dropped, counted by
+ * sender frame number or by what our receive path replaced */
+static void
+test_downsample ()
+{
+  for (bool counts_frames : { true, false }) {
+    GstSpoutCfrPacer pacer;
+    Sender sender = make_sender (60, 1, 10 * SECOND, 1 * MS, 2 * MS);
+
+    pacer.set_rate (30, 1);
+    Output output = pace (pacer, sender, counts_frames, 10 * SECOND, 100000);
+
+    CHECK_EQ (pacer.repeated (), 0u);
+    CHECK_EQ (pacer.emitted (), output.pts.size ());
+    CHECK_EQ (pacer.emitted () + pacer.dropped (),
+        (uint64_t) (output.frames.back () - output.frames.front () + 1));
+    CHECK (pacer.dropped () + 5 >= pacer.emitted ());
+  }
+}
+
+/* A streaming thread that stalls misses ticks instead of bunching them
+ * up afterwards */
+static void
+test_missed_ticks ()
+{
+  GstSpoutCfrPacer pacer;
+  Sender sender = make_sender (60, 1, 5 * SECOND, 0);
+
+  pacer.set_rate (60, 1);
+  Output output = pace (pacer, sender, true, 5 * SECOND, 1000, 2 * SECOND,
+      100 * MS);
+
+  CHECK (pacer.missed () >= 5 && pacer.missed () <= 7);
+  CHECK_EQ (pacer.output (), output.pts.size ());
+  CHECK_EQ (pacer.output () + pacer.missed (), pacer.ticks () + 1);
+
+  /* Still on the grid after the stall: tick k starts at k/60 s, rounded
+   * down to the nanosecond */
+  unsigned off_grid = 0;
+  for (uint64_t pts : output.pts)
+    off_grid += (pts * 60 / SECOND + 1) * SECOND / 60 != pts &&
+        pts * 60 / SECOND * SECOND / 60 != pts;
+  CHECK_EQ (off_grid, 0u);
+}
+
+/* A new rate carries on from the next tick of the old one */
+static void
+test_rate_change ()
+{
+  GstSpoutCfrPacer pacer;
+  uint64_t tick;
+
+  pacer.set_rate (25, 1);
+  tick = pacer.next_tick (0);
+  for (int i = 0; i < 10; i++)
+    tick = pacer.next_tick (tick);
+  CHECK_EQ (tick, 400 * MS);
+
+  pacer.set_rate (50, 1);
+  tick = pacer.next_tick (tick);
+  CHECK_EQ (tick, 440 * MS);
+  tick = pacer.next_tick (tick);
+  CHECK_EQ (tick, 460 * MS);
+  CHECK_EQ (pacer.duration (), 20 * MS);
+
+  /* Invalid or unchanged rates are ignored */
+  pacer.set_rate (0, 1);
+  pacer.set_rate (50, 1);
+  CHECK_EQ (pacer.next_tick (tick), 480 * MS);
+
+  /* A reset starts a new grid */
+  pacer.reset ();
+  CHECK_EQ (pacer.next_tick (1234), 1234u);
+  CHECK_EQ (pacer.next_tick (1234), 1234 + 20 * MS);
+  CHECK_EQ (pacer.ticks (), 1u);
+}
+
+static void
+test_repeats ()
+{
+  GstSpoutCfrPacer pacer;
+
+  pacer.set_rate (60, 1);
+  CHECK (!pacer.have_frame ());
+  CHECK (!pacer.repeats (1));
+
+  pacer.emit (7, 0);
+  CHECK (pacer.repeats (7));
+  CHECK (!pacer.repeats (8));
+  CHECK (!pacer.repeats (0));
+
+  /* Senders restarting their count don't count as dropping frames */
+  pacer.emit (3, 0);
+  CHECK_EQ (pacer.dropped (), 0u);
+  pacer.emit (6, 0);
+  CHECK_EQ (pacer.dropped (), 2u);
+
+  pacer.forget_frame ();
+  CHECK (!pacer.have_frame ());
+  CHECK (!pacer.repeats (6));
+}
+
+int
+main ()
+{
+  test_exact_grid ();
+  test_upsample ();
+  test_downsample ();
+  test_missed_ticks ();
+  test_rate_change ();
+  test_repeats ();
+
+  return gst_spout_test_result ();
+}
@@ -0,0 +1,222 @@
+/* GStreamer
+ * Copyright (C) 2023 Your Name <your.email@example.com>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+/* GstSpoutPoolSizer against a fake consumer with scripted hold times. A
+ * simulated fixed-size pool, as spoutsrc configures its own, makes acquiring
+ * wait whenever every buffer is out, and the element may keep its last
+ * pushed frame until the next one replaces it, as cfr and
+ * standby-mode=last-frame do */
+
+#include "gstspoutpoolsizer.h"
+#include "gstspouttest.h"
+
+#include <algorithm>
+#include <functional>
+#include <vector>
+
+static const uint64_t MS = 1000000;
+static const uint64_t FRAME = 16666667;   /* 60 fps */
+
+struct SimResult
+{
+  uint64_t waits = 0;         /* over the whole run */
+  uint64_t late_waits = 0;    /* over the last quarter */
+  unsigned min_target = ~0u;
+  unsigned max_target = 0;
+  unsigned final_target = 0;
+};
+
+/* Push @frames frames at 60 fps into a pool of sizer.target() buffers.
+ * @hold gives how long downstream keeps frame i, with @held the element
+ * keeps each frame until it pushed the next */
+static SimResult
+simulate (GstSpoutPoolSizer & sizer, unsigned frames, unsigned held,
+    const std::function<uint64_t (unsigned)> & hold)
+{
+  struct Out
+  {
+    unsigned frame;
+    uint64_t pushed;
+    uint64_t returned;    /* UINT64_MAX while we still hold it */
+  };
+  std::vector<Out> out;
+  SimResult result;
+  uint64_t now = 0;
+
+  for (unsigned i = 0; i < frames; i++) {
+    bool waited = false;
+
+    now = std::max (now, (uint64_t) i * FRAME);
+
+    /* Buffers back in the pool report their hold times */
+    auto give_back = [&] {
+      for (auto it = out.begin (); it != out.end ();) {
+        if (it->returned <= now) {
+          sizer.record_hold (it->returned - it->pushed);
+          it = out.erase (it);
+        } else {
+          it++;
+        }
+      }
+    };
+
+    give_back ();
+
+    /* The buffer to receive into */
+    while (out.size () + 1 > sizer.target ()) {
+      uint64_t next = UINT64_MAX;
+
+      for (const auto & o : out)
+        next = std::min (next, o.returned);
+      if (next == UINT64_MAX)
+        break;    /* only what we hold is out, a pool that small can't be */
+
+      waited = true;
+      now = next;
+      give_back ();
+    }
+
+    sizer.record_acquire (waited);
+    if (waited) {
+      result.waits++;
+      if (i >= frames * 3 / 4)
+        result.late_waits++;
+    }
+
+    /* Pushing replaces the frame we held */
+    for (auto & o : out) {
+      if (o.returned == UINT64_MAX)
+        o.returned = std::max (now, o.pushed + hold (o.frame));
+    }
+    out.push_back ({ i, now, held ? UINT64_MAX : now + hold (i) });
+
+    sizer.update ();
+    result.min_target = std::min (result.min_target, sizer.target ());
+    result.max_target = std::max (result.max_target, sizer.target ());
+  }
+
+  result.final_target = sizer.target ();
+  return result;
+}
+
+/* Downstream done within the frame: nothing grows, nothing waits */
+static void
+test_fast_consumer ()
+{
+  for (unsigned held : { 0u, 1u }) {
+    GstSpoutPoolSizer sizer;
+
+    sizer.configure (2, 32, 1, held, FRAME);
+    CHECK_EQ (sizer.target (), 2u + held);
+
+    SimResult result = simulate (sizer, 2000, held,
+        [] (unsigned) { return 5 * MS; });
+
+    CHECK_EQ (result.waits, 0u);
+    CHECK (result.max_target <= 2u + held);
+  }
+}
+
+/* The held frame takes a buffer of its own from the start. Without counting
+ * it a consumer keeping two frames and a bit starves right away */
+static void
+test_held_frame_reserved ()
+{
+  auto hold = [] (unsigned) { return 40 * MS; };
+  GstSpoutPoolSizer counted, uncounted;
+
+  counted.configure (2, 32, 1, 1, FRAME);
+  uncounted.configure (2, 32, 1, 0, FRAME);
+
+  SimResult with = simulate (counted, 200, 1, hold);
+  SimResult without = simulate (uncounted, 200, 1, hold);
+
+  CHECK_EQ (with.waits, 0u);
+  CHECK (without.waits > 0);
+
+  /* Hold times include ours, shrinking never takes the held buffer */
+  CHECK (with.min_target >= 3u);
+}
+
+/* A slow consumer (a queue before a filesink, say): grows until acquiring
+ * no longer waits, not beyond what the hold times ask for */
+static void
+test_slow_consumer ()
+{
+  for (unsigned held : { 0u, 1u }) {
+    GstSpoutPoolSizer sizer;
+
+    sizer.configure (2, 32, 1, held, FRAME);
+    SimResult result = simulate (sizer, 3000, held,
+        [] (unsigned) { return 70 * MS; });
+
+    CHECK (result.waits > 0);
+    CHECK_EQ (result.late_waits, 0u);
+    /* 70 ms is 4.2 frames, plus the buffer being received into */
+    CHECK (result.final_target >= 6u);
+    CHECK (result.final_target <= 7u);
+  }
+}
+
+/* Downstream stalls for a while every few seconds, then is quick again:
+ * the pool grows for the stall and shrinks slowly afterwards */
+static void
+test_bursty_consumer ()
+{
+  GstSpoutPoolSizer sizer;
+
+  sizer.configure (2, 32, 1, 1, FRAME);
+
+  SimResult burst = simulate (sizer, 600, 1, [] (unsigned i) {
+    return i >= 300 && i < 360 ? 100 * MS : 4 * MS;
+  });
+  CHECK (burst.max_target >= 7u);
+
+  SimResult calm = simulate (sizer, 3000, 1,
+      [] (unsigned) { return 4 * MS; });
+  /* Down to the held frame and the one being received into */
+  CHECK_EQ (calm.waits, 0u);
+  CHECK_EQ (calm.final_target, 2u);
+}
+
+/* pool-budget caps the pool, however slow downstream is */
+static void
+test_budget ()
+{
+  GstSpoutPoolSizer sizer;
+
+  sizer.configure (2, 5, 1, 1, FRAME);
+  SimResult result = simulate (sizer, 1000, 1,
+      [] (unsigned) { return 200 * MS; });
+
+  CHECK_EQ (result.max_target, 5u);
+  CHECK (sizer.waits () > 0);
+}
+
+int
+main ()
+{
+  test_fast_consumer ();
+  test_held_frame_reserved ();
+  test_slow_consumer ();
+  test_bursty_consumer ();
+  test_budget ();
+
+  return gst_spout_test_result ();
+}
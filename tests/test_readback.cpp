@@ -0,0 +1,318 @@
+/* GStreamer
+ * Copyright (C) 2023 Your Name <your.email@example.com>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+/* GstSpoutReadbackRing with a mock copy engine whose copies complete a set
+ * time after they were issued: frames come back in order, whole, and only
+ * wait for the "GPU" when the ring runs full */
+
+#include "gstspoutreadback.h"
+#include "gstspouttest.h"
+
+#include <deque>
+
+/* Frames are numbered, staging slots hold the number in every byte */
+struct MockEngine
+{
+  using Source = uint64_t;
+
+  static const size_t SIZE = 64;
+
+  uint64_t now = 0;               /* in frames */
+  uint64_t copy_time = 1;         /* frames until a copy completes */
+  uint64_t waited = 0;            /* frames spent waiting in map() */
+  int fail_copy = -1;             /* frame whose copy fails */
+  int fail_map = -1;              /* frame whose mapping fails */
+  bool mapped[8] = { };
+  int overlapping = 0;
+
+  struct Slot
+  {
+    uint8_t data[SIZE];
+    uint64_t done = 0;
+    uint64_t frame = 0;
+  } slots[8];
+
+  bool copy (unsigned int slot, const Source & frame)
+  {
+    if ((int) frame == fail_copy)
+      return false;
+    overlapping += mapped[slot];
+
+    /* Lands in the staging memory now, visible once done */
+    memset (slots[slot].data, (int) (frame & 0xff), SIZE);
+    slots[slot].done = now + copy_time;
+    slots[slot].frame = frame;
+    return true;
+  }
+
+  GstSpoutMapResult map (unsigned int slot, bool wait,
+      GstSpoutMapping & mapping)
+  {
+    if ((int) slots[slot].frame == fail_map)
+      return GstSpoutMapResult::ERROR;
+
+    if (now < slots[slot].done) {
+      if (!wait)
+        return GstSpoutMapResult::WOULD_BLOCK;
+      waited += slots[slot].done - now;
+      now = slots[slot].done;
+    }
+
+    mapped[slot] = true;
+    mapping.data = slots[slot].data;
+    mapping.stride = SIZE;
+    return GstSpoutMapResult::DONE;
+  }
+
+  void unmap (unsigned int slot) { mapped[slot] = false; }
+};
+
+/* What the sink got */
+struct Collected
+{
+  uint64_t frame;
+  uint64_t submitted_at;
+  uint64_t collected_at;
+};
+
+using Ring = GstSpoutReadbackRing<MockEngine, Collected>;
+
+struct Run
+{
+  std::vector<Collected> out;
+  unsigned torn = 0;
+
+  /* While streaming, draining at the end waits for the tail */
+  uint64_t late = 0;
+  uint64_t stalls = 0;
+  uint64_t waited = 0;
+};
+
+/* One frame per tick, then drain. @copy_times gives each frame's copy
+ * time, cycling */
+static Run
+stream (Ring & ring, uint64_t frames, std::vector<uint64_t> copy_times)
+{
+  MockEngine & engine = ring.engine ();
+  Run run;
+  auto sink = [&] (const GstSpoutMapping & mapping, const Collected & tag) {
+    for (size_t i = 0; i < MockEngine::SIZE; i++)
+      run.torn += mapping.data[i] != (uint8_t) (tag.frame & 0xff);
+    run.out.push_back ({ tag.frame, tag.submitted_at, engine.now });
+    return true;
+  };
+
+  for (uint64_t frame = 1; frame <= frames; frame++, engine.now++) {
+    engine.copy_time = copy_times[frame % copy_times.size ()];
+
+    /* Make room first, like the element does */
+    while (ring.full () &&
+        ring.collect (sink) != GstSpoutReadbackResult::PENDING) {
+    }
+    ring.submit (frame, { frame, engine.now, 0 });
+
+    while (ring.collect (sink) == GstSpoutReadbackResult::READY) {
+    }
+  }
+
+  run.late = ring.late ();
+  run.stalls = ring.stalls ();
+  run.waited = engine.waited;
+
+  while (ring.collect (sink, true) != GstSpoutReadbackResult::EMPTY) {
+  }
+
+  return run;
+}
+
+static bool
+in_order (const std::vector<Collected> & out, uint64_t frames)
+{
+  if (out.size () != frames)
+    return false;
+  for (size_t i = 0; i < out.size (); i++) {
+    if (out[i].frame != i + 1)
+      return false;
+  }
+  return true;
+}
+
+/* Latency 0 reads back right after the copy and waits for it every time */
+static void
+test_synchronous ()
+{
+  Ring ring;
+
+  ring.configure (0);
+  CHECK_EQ (ring.slots (), 2u);
+
+  Run run = stream (ring, 100, { 1 });
+  CHECK (in_order (run.out, 100));
+  CHECK_EQ (run.torn, 0u);
+  CHECK_EQ (run.stalls, 100u);
+  CHECK_EQ (run.waited, 100u);
+}
+
+/* With a latency covering the copy time nothing ever waits, and frames
+ * come out exactly that many frames later */
+static void
+test_pipelined ()
+{
+  for (unsigned int latency = 1; latency <= 4; latency++) {
+    Ring ring;
+
+    ring.configure (latency);
+    Run run = stream (ring, 1000, { latency });
+
+    CHECK (in_order (run.out, 1000));
+    CHECK_EQ (run.torn, 0u);
+    CHECK_EQ (run.stalls, 0u);
+    CHECK_EQ (run.late, 0u);
+    CHECK_EQ (run.waited, 0u);
+    CHECK_EQ (ring.engine ().overlapping, 0);
+
+    unsigned exact = 0;
+    for (const Collected & c : run.out)
+      exact += c.collected_at - c.submitted_at == latency;
+    CHECK_EQ (exact, 1000u);
+  }
+}
+
+/* A copy running a frame over costs a frame of latency through the spare
+ * slot, not a stall. Only one running further over fills the ring */
+static void
+test_late_copies ()
+{
+  Ring ring;
+
+  ring.configure (2);
+  Run run = stream (ring, 1000, { 2, 2, 2, 2, 2, 2, 2, 2, 2, 3 });
+
+  CHECK (in_order (run.out, 1000));
+  CHECK_EQ (run.torn, 0u);
+  CHECK (run.late >= 90);
+  CHECK_EQ (run.stalls, 0u);
+
+  Ring slow;
+  slow.configure (2);
+  run = stream (slow, 1000, { 2, 2, 2, 2, 2, 2, 2, 2, 2, 6 });
+
+  CHECK (in_order (run.out, 1000));
+  CHECK_EQ (run.torn, 0u);
+  CHECK (run.stalls > 0);
+  CHECK (run.stalls <= 100);
+}
+
+/* Failed copies and mappings drop their frame, the rest carries on */
+static void
+test_errors ()
+{
+  Ring ring;
+
+  ring.configure (2);
+  ring.engine ().fail_copy = 10;
+  ring.engine ().fail_map = 20;
+
+  Run run = stream (ring, 100, { 2 });
+  std::vector<Collected> & out = run.out;
+
+  CHECK_EQ (out.size (), 98u);
+  CHECK_EQ (run.torn, 0u);
+  CHECK_EQ (ring.errors (), 2u);
+  CHECK_EQ (ring.submitted (), 99u);
+  CHECK_EQ (ring.collected (), 98u);
+  for (size_t i = 1; i < out.size (); i++)
+    CHECK (out[i].frame > out[i - 1].frame);
+
+  /* A failing sink counts as an error too */
+  Ring rejecting;
+  rejecting.configure (0);
+  rejecting.engine ().copy_time = 0;
+  CHECK (rejecting.submit (1, { 1, 0, 0 }));
+  CHECK (rejecting.collect ([] (const GstSpoutMapping &, const Collected &) {
+        return false;
+      }) == GstSpoutReadbackResult::ERROR);
+  CHECK_EQ (rejecting.in_flight (), 0u);
+}
+
+static void
+test_full_and_reset ()
+{
+  Ring ring;
+  auto sink = [] (const GstSpoutMapping &, const Collected &) { return true; };
+
+  ring.configure (1);
+  CHECK (ring.collect (sink) == GstSpoutReadbackResult::EMPTY);
+  CHECK (ring.submit (1, { 1, 0, 0 }));
+  CHECK (ring.collect (sink) == GstSpoutReadbackResult::PENDING);
+  CHECK (ring.submit (2, { 2, 0, 0 }));
+  CHECK (ring.submit (3, { 3, 0, 0 }));
+  CHECK (ring.full ());
+  CHECK (!ring.submit (4, { 4, 0, 0 }));
+
+  ring.reset ();
+  CHECK_EQ (ring.in_flight (), 0u);
+  CHECK (ring.collect (sink, true) == GstSpoutReadbackResult::EMPTY);
+  CHECK (ring.submit (5, { 5, 0, 0 }));
+}
+
+static void
+test_copy_rows ()
+{
+  const size_t row_size = 10, rows = 5;
+  uint8_t src[16 * rows], dest[24 * rows];
+
+  for (size_t i = 0; i < sizeof (src); i++)
+    src[i] = (uint8_t) i;
+
+  for (size_t src_stride : { row_size, (size_t) 16 }) {
+    for (size_t dest_stride : { row_size, (size_t) 24 }) {
+      unsigned wrong = 0, touched = 0;
+
+      memset (dest, 0xee, sizeof (dest));
+      gst_spout_copy_rows (dest, dest_stride, src, src_stride, row_size, rows);
+
+      for (size_t row = 0; row < rows; row++) {
+        for (size_t x = 0; x < dest_stride; x++) {
+          uint8_t value = dest[row * dest_stride + x];
+
+          if (x < row_size)
+            wrong += value != src[row * src_stride + x];
+          else
+            touched += value != 0xee;
+        }
+      }
+      CHECK_EQ (wrong, 0u);
+      CHECK_EQ (touched, 0u);
+    }
+  }
+}
+
+int
+main ()
+{
+  test_synchronous ();
+  test_pipelined ();
+  test_late_copies ();
+  test_errors ();
+  test_full_and_reset ();
+  test_copy_rows ();
+
+  return gst_spout_test_result ();
+}
@@ -0,0 +1,379 @@
+/* GStreamer
+ * Copyright (C) 2023 Your Name <your.email@example.com>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+/* Recordings played back by the replay backend: what was recorded comes
+ * back in order with its content, formats and connections, as fast as it
+ * is taken or at the recorded pace, and a recording still being written
+ * plays up to its last complete record */
+
+#include "gstspoutrecording.h"
+#include "gstspouttest.h"
+
+#include <cstdio>
+#include <filesystem>
+#include <random>
+#include <thread>
+
+using namespace std::chrono_literals;
+
+static const uint64_t MS = 1000000;
+
+static std::string
+recording_path (const char * what)
+{
+  std::filesystem::path path = std::filesystem::temp_directory_path () /
+      (std::string ("test-recording-") + what + "-" +
+      std::to_string (std::random_device () ()) + ".gspr");
+
+  return path.string ();
+}
+
+static GstSpoutFrameFormat
+make_format (uint32_t width, uint32_t height, double fps)
+{
+  GstSpoutFrameFormat format;
+
+  format.width = width;
+  format.height = height;
+  format.format = 87;           /* DXGI_FORMAT_B8G8R8A8_UNORM */
+  format.stride = width * 4;
+  format.fps = fps;
+  return format;
+}
+
+/* Frame @number's content, different in every byte position and frame */
+static std::vector<uint8_t>
+content (const GstSpoutFrameFormat & format, uint64_t number)
+{
+  std::vector<uint8_t> data ((size_t) format.stride * format.height);
+
+  for (size_t i = 0; i < data.size (); i++)
+    data[i] = (uint8_t) (i * 7 + number * 13);
+  return data;
+}
+
+static bool
+matches (const GstSpoutFrameLease & lease, const std::vector<uint8_t> & data)
+{
+  return lease.size == data.size () &&
+      memcmp (lease.data, data.data (), data.size ()) == 0;
+}
+
+static bool
+blank (const GstSpoutFrameLease & lease)
+{
+  for (size_t i = 0; i < lease.size; i++) {
+    if (lease.data[i])
+      return false;
+  }
+  return lease.size > 0;
+}
+
+/* Two senders one after the other, a format change, frames with and
+ * without content: all of it comes back as it went in */
+static void
+test_round_trip ()
+{
+  std::string path = recording_path ("round-trip");
+  GstSpoutFrameFormat small = make_format (32, 8, 60.0);
+  GstSpoutFrameFormat large = make_format (64, 16, 30.0);
+  GstSpoutRecorder recorder;
+  uint64_t time = 1000 * MS;
+
+  CHECK (recorder.open (path));
+  CHECK (recorder.is_open ());
+
+  recorder.state (time, true, "first", small);
+  for (uint64_t n = 1; n <= 10; n++) {
+    auto data = content (small, n);
+
+    /* Every third one only by fingerprint, like GPU frames */
+    time += 16 * MS;
+    recorder.frame (time, n, time, n * 3,
+        n % 3 ? data.data () : nullptr, data.size ());
+  }
+  recorder.state (time, true, "first", large);
+  for (uint64_t n = 11; n <= 15; n++) {
+    auto data = content (large, n);
+
+    time += 33 * MS;
+    recorder.frame (time, n, time, 0, data.data (), data.size ());
+  }
+  recorder.state (time += MS, false, "", GstSpoutFrameFormat ());
+  recorder.state (time += MS, true, "second", small);
+  for (uint64_t n = 1; n <= 5; n++) {
+    auto data = content (small, n + 100);
+
+    time += 16 * MS;
+    recorder.frame (time, n, time, 0, data.data (), data.size ());
+  }
+  CHECK_EQ (recorder.frames (), 20u);
+  CHECK (!recorder.lost ());
+  recorder.close ();
+  CHECK (!recorder.is_open ());
+
+  GstSpoutReplayReceiver replay;
+  GstSpoutFrameLease lease;
+
+  CHECK (replay.open (path, GST_SPOUT_REPLAY_TIMING_FAST));
+  CHECK (replay.available (""));
+  CHECK (replay.available ("first"));
+  CHECK (!replay.finished ());
+
+  CHECK (replay.connect ("first"));
+  CHECK_EQ (replay.sender_name (), std::string ("first"));
+  CHECK (replay.format () == small);
+
+  for (uint64_t n = 1; n <= 10; n++) {
+    CHECK (replay.receive (lease, 0us) == GstSpoutReceiveResult::FRAME);
+    CHECK_EQ (lease.frame, n);
+    CHECK (n % 3 ? matches (lease, content (small, n)) : blank (lease));
+    CHECK_EQ (lease.timestamp, 0u);
+  }
+  for (uint64_t n = 11; n <= 15; n++) {
+    CHECK (replay.receive (lease, 0us) == GstSpoutReceiveResult::FRAME);
+    CHECK (replay.format () == large);
+    CHECK_EQ (lease.frame, n);
+    CHECK (matches (lease, content (large, n)));
+  }
+
+  /* The disconnect, then the second sender */
+  CHECK (replay.receive (lease, 0us) == GstSpoutReceiveResult::ERROR);
+  CHECK (!replay.finished ());
+  CHECK (replay.available ("second"));
+  CHECK (replay.connect (""));
+  CHECK_EQ (replay.sender_name (), std::string ("second"));
+  CHECK (replay.format () == small);
+
+  for (uint64_t n = 1; n <= 5; n++) {
+    CHECK (replay.receive (lease, 0us) == GstSpoutReceiveResult::FRAME);
+    CHECK_EQ (lease.frame, n);
+    CHECK (matches (lease, content (small, n + 100)));
+  }
+
+  /* The end of the recording is the sender going away for good, while the
+   * frame last received stays valid */
+  GstSpoutFrameLease end;
+  CHECK (replay.receive (end, 0us) == GstSpoutReceiveResult::ERROR);
+  CHECK (replay.finished ());
+  CHECK (!replay.connect (""));
+  CHECK (matches (lease, content (small, 105)));
+
+  lease.release ();
+  std::filesystem::remove (path);
+}
+
+/* Frames come at their recorded pace with their timestamps moved along
+ * to now, and a receiver that can't keep up misses frames like it would
+ * with a live sender rather than falling behind */
+static void
+test_original_timing ()
+{
+  std::string path = recording_path ("timing");
+  GstSpoutFrameFormat format = make_format (16, 4, 50.0);
+  GstSpoutRecorder recorder;
+  const uint64_t FRAMES = 25, PERIOD = 20 * MS, START = 5000 * MS;
+
+  CHECK (recorder.open (path));
+  recorder.state (START, true, "paced", format);
+  for (uint64_t n = 1; n <= FRAMES; n++) {
+    auto data = content (format, n);
+    uint64_t time = START + n * PERIOD;
+
+    recorder.frame (time, n, time, 0, data.data (), data.size ());
+  }
+  recorder.close ();
+
+  /* Keeping up: every frame, each one period after the last */
+  GstSpoutReplayReceiver replay;
+  GstSpoutFrameLease lease;
+  uint64_t received = 0, first = 0, last = 0;
+
+  CHECK (replay.open (path, GST_SPOUT_REPLAY_TIMING_ORIGINAL));
+  auto start = std::chrono::steady_clock::now ();
+
+  CHECK (replay.connect ("paced"));
+  while (replay.receive (lease, 1s) == GstSpoutReceiveResult::FRAME) {
+    uint64_t now = (uint64_t) std::chrono::duration_cast<
+        std::chrono::nanoseconds> (std::chrono::steady_clock::now ()
+        .time_since_epoch ()).count ();
+
+    received++;
+    CHECK_EQ (lease.frame, received);
+    CHECK (matches (lease, content (format, received)));
+
+    /* Not handed out before the sender made it */
+    CHECK (lease.timestamp <= now);
+    if (received == 1)
+      first = lease.timestamp;
+    else
+      CHECK_EQ (lease.timestamp - last, PERIOD);
+    last = lease.timestamp;
+  }
+  auto elapsed = std::chrono::steady_clock::now () - start;
+
+  CHECK_EQ (received, FRAMES);
+  CHECK_EQ (last - first, (FRAMES - 1) * PERIOD);
+  CHECK (replay.finished ());
+  CHECK (elapsed >= std::chrono::nanoseconds (FRAMES * PERIOD));
+  CHECK (elapsed < std::chrono::nanoseconds (FRAMES * PERIOD) + 2s);
+
+  /* Busy for two and a half periods after every frame */
+  uint64_t previous = 0, skipped = 0;
+
+  received = 0;
+  CHECK (replay.open (path, GST_SPOUT_REPLAY_TIMING_ORIGINAL));
+  CHECK (replay.connect ("paced"));
+  while (replay.receive (lease, 1s) == GstSpoutReceiveResult::FRAME) {
+    received++;
+    CHECK (lease.frame > previous);
+    skipped += lease.frame - previous - 1;
+    previous = lease.frame;
+    CHECK (matches (lease, content (format, lease.frame)));
+    std::this_thread::sleep_for (std::chrono::nanoseconds (PERIOD * 5 / 2));
+  }
+
+  CHECK (skipped >= FRAMES / 2);
+  CHECK_EQ (received + skipped, previous);
+  CHECK (previous >= FRAMES - 1);
+
+  lease.release ();
+  std::filesystem::remove (path);
+}
+
+/* A replay of a recording that is still being written, or was cut short
+ * by a crash, plays every complete record and nothing after */
+static void
+test_unfinished ()
+{
+  std::string path = recording_path ("unfinished");
+  GstSpoutFrameFormat format = make_format (16, 4, 30.0);
+  GstSpoutRecorder recorder;
+
+  CHECK (recorder.open (path));
+  recorder.state (MS, true, "live", format);
+  for (uint64_t n = 1; n <= 3; n++) {
+    auto data = content (format, n);
+
+    recorder.frame (n * 33 * MS, n, 0, 0, data.data (), data.size ());
+  }
+
+  GstSpoutReplayReceiver replay;
+  GstSpoutFrameLease lease;
+
+  CHECK (replay.open (path, GST_SPOUT_REPLAY_TIMING_FAST));
+  CHECK (replay.connect ("live"));
+  for (uint64_t n = 1; n <= 3; n++) {
+    CHECK (replay.receive (lease, 0us) == GstSpoutReceiveResult::FRAME);
+    CHECK_EQ (lease.frame, n);
+    CHECK (matches (lease, content (format, n)));
+  }
+  CHECK (replay.receive (lease, 0us) == GstSpoutReceiveResult::ERROR);
+  CHECK (replay.finished ());
+
+  /* Frames recorded since don't show up in a replay opened before */
+  auto data = content (format, 4);
+  recorder.frame (4 * 33 * MS, 4, 0, 0, data.data (), data.size ());
+  CHECK (!replay.connect ("live"));
+  recorder.close ();
+
+  /* Anything but a recording is refused */
+  std::string junk = recording_path ("junk");
+  FILE *file = fopen (junk.c_str (), "wb");
+
+  CHECK (file != nullptr);
+  if (file) {
+    fputs ("not a recording, just some text that is long enough", file);
+    fclose (file);
+  }
+  CHECK (!replay.open (junk, GST_SPOUT_REPLAY_TIMING_FAST));
+  CHECK (!replay.open (recording_path ("missing"),
+          GST_SPOUT_REPLAY_TIMING_FAST));
+
+  lease.release ();
+  std::filesystem::remove (junk);
+  std::filesystem::remove (path);
+}
+
+/* wake() gets a receive() waiting for a far off frame out early */
+static void
+test_wake ()
+{
+  std::string path = recording_path ("wake");
+  GstSpoutFrameFormat format = make_format (16, 4, 1.0);
+  GstSpoutRecorder recorder;
+
+  CHECK (recorder.open (path));
+  recorder.state (0, true, "slow", format);
+  recorder.frame (60000 * MS, 1, 0, 0, nullptr, 0);
+  recorder.close ();
+
+  GstSpoutReplayReceiver replay;
+  GstSpoutFrameLease lease;
+
+  CHECK (replay.open (path, GST_SPOUT_REPLAY_TIMING_ORIGINAL));
+  CHECK (replay.connect ("slow"));
+
+  auto start = std::chrono::steady_clock::now ();
+  std::thread waker ([&replay] {
+    std::this_thread::sleep_for (50ms);
+    replay.wake ();
+  });
+
+  CHECK (replay.receive (lease, 10s) == GstSpoutReceiveResult::NO_FRAME);
+  CHECK (std::chrono::steady_clock::now () - start < 5s);
+  CHECK (!lease.held ());
+  waker.join ();
+
+  std::filesystem::remove (path);
+}
+
+/* A discarded recording leaves no file behind, a closed one stays */
+static void
+test_discard ()
+{
+  std::string path = recording_path ("discard");
+  GstSpoutRecorder recorder;
+
+  CHECK (recorder.open (path));
+  CHECK (std::filesystem::exists (path));
+  recorder.state (MS, true, "sender", make_format (32, 8, 60.0));
+  recorder.discard ();
+  CHECK (!recorder.is_open ());
+  CHECK (!std::filesystem::exists (path));
+
+  CHECK (recorder.open (path));
+  recorder.close ();
+  recorder.discard ();
+  CHECK (std::filesystem::exists (path));
+
+  std::filesystem::remove (path);
+}
+
+int
+main ()
+{
+  test_round_trip ();
+  test_original_timing ();
+  test_unfinished ();
+  test_wake ();
+  test_discard ();
+
+  return gst_spout_test_result ();
+}
@@ -0,0 +1,235 @@
+/* GStreamer
+ * Copyright (C) 2023 Your Name <your.email@example.com>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+/* Leases from the shm receive backend as downstream gets them under
+ * memory:FdMemory: the fd maps to the same bytes as the lease, a leased
+ * slot is never written while held, a sender with every slot leased drops
+ * frames rather than waiting, and releasing a lease frees its slot */
+
+#include "gstspoutshm.h"
+#include "gstspouttest.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+static const uint32_t WIDTH = 64;
+static const uint32_t HEIGHT = 16;
+static const unsigned SLOTS = GST_SPOUT_SHM_MIN_SLOTS;
+
+static std::string
+sender_name (const char * what)
+{
+  return std::string ("test-shm-") + what + "-" +
+      std::to_string (gst_spout_shm_current_pid ());
+}
+
+static bool
+create_sender (GstSpoutShmSender & sender, const std::string & name)
+{
+  GstSpoutFrameFormat format;
+
+  format.width = WIDTH;
+  format.height = HEIGHT;
+  format.format = 87;           /* DXGI_FORMAT_B8G8R8A8_UNORM */
+  format.fps = 60.0;
+  return sender.create (name, format, SLOTS);
+}
+
+/* Publish the next frame, every byte of it its number */
+static bool
+publish (GstSpoutShmSender & sender)
+{
+  uint8_t *data = sender.begin ();
+
+  if (!data)
+    return false;
+  memset (data, (int) ((sender.frames () + 1) & 0xff),
+      (size_t) WIDTH * 4 * HEIGHT);
+  sender.publish ();
+  return true;
+}
+
+static bool
+filled (const uint8_t * data, size_t size, uint64_t frame)
+{
+  for (size_t i = 0; i < size; i++) {
+    if (data[i] != (uint8_t) frame)
+      return false;
+  }
+  return true;
+}
+
+static GstSpoutReceiveResult
+receive (GstSpoutShmReceiver & receiver, GstSpoutFrameLease & lease)
+{
+  return receiver.receive (lease, std::chrono::milliseconds (100));
+}
+
+/* The bytes at the lease's fd and offset are the lease's bytes, both the
+ * way GstFdMemory maps them (the whole fd up to the frame's end) and as a
+ * mapping of just the frame */
+static void
+test_fd_matches_data ()
+{
+  std::string name = sender_name ("fd");
+  GstSpoutShmSender sender;
+  GstSpoutShmReceiver receiver;
+  GstSpoutFrameLease lease;
+
+  CHECK (receiver.shares_fd ());
+  CHECK (create_sender (sender, name));
+  CHECK (receiver.connect (name));
+  CHECK (receiver.shares_fd ());
+
+  CHECK (publish (sender));
+  CHECK (publish (sender));
+  CHECK (receive (receiver, lease) == GstSpoutReceiveResult::FRAME);
+  CHECK_EQ (lease.frame, 2u);
+  CHECK_EQ (lease.size, (size_t) WIDTH * 4 * HEIGHT);
+  CHECK (lease.fd >= 0);
+  CHECK (filled (lease.data, lease.size, 2));
+
+  /* Frames start on a page, so they can be mapped on their own */
+  CHECK_EQ (lease.offset % GST_SPOUT_SHM_ALIGN, 0u);
+
+  struct stat st;
+  CHECK (fstat (lease.fd, &st) == 0);
+  CHECK ((size_t) st.st_size >= lease.offset + lease.size);
+
+  size_t whole_size = lease.offset + lease.size;
+  void *whole = mmap (nullptr, whole_size, PROT_READ, MAP_SHARED, lease.fd, 0);
+  void *frame = mmap (nullptr, lease.size, PROT_READ, MAP_SHARED, lease.fd,
+      (off_t) lease.offset);
+
+  CHECK (whole != MAP_FAILED);
+  CHECK (frame != MAP_FAILED);
+  if (whole != MAP_FAILED && frame != MAP_FAILED) {
+    CHECK (memcmp ((uint8_t *) whole + lease.offset, lease.data,
+            lease.size) == 0);
+    CHECK (memcmp (frame, lease.data, lease.size) == 0);
+
+    /* Still the same frame after the sender has moved on */
+    CHECK (publish (sender));
+    CHECK (filled ((const uint8_t *) frame, lease.size, 2));
+  }
+  if (whole != MAP_FAILED)
+    munmap (whole, whole_size);
+  if (frame != MAP_FAILED)
+    munmap (frame, lease.size);
+
+  /* The fd outlives the receiver's connection and the sender for as long
+   * as the lease is held, that's what keeps GstFdMemory valid */
+  int fd = lease.fd;
+  receiver.disconnect ();
+  sender.close ();
+  CHECK (fcntl (fd, F_GETFD) >= 0);
+  CHECK (filled (lease.data, lease.size, 2));
+
+  lease.release ();
+  CHECK_EQ (lease.fd, -1);
+  CHECK (!lease.held ());
+}
+
+/* Held slots are never overwritten; with every slot the sender could write
+ * leased it drops the frame, and a release frees the slot again */
+static void
+test_leases_hold_slots ()
+{
+  std::string name = sender_name ("slots");
+  GstSpoutShmSender sender;
+  GstSpoutShmReceiver receiver;
+  GstSpoutFrameLease held[SLOTS];
+
+  CHECK (create_sender (sender, name));
+  CHECK (receiver.connect (name));
+
+  for (unsigned i = 0; i < SLOTS; i++) {
+    CHECK (publish (sender));
+    CHECK (receive (receiver, held[i]) == GstSpoutReceiveResult::FRAME);
+    CHECK_EQ (held[i].frame, (uint64_t) i + 1);
+  }
+
+  /* Every slot leased: nothing to write to, and nothing new to receive */
+  for (int i = 0; i < 10; i++)
+    CHECK (sender.begin () == nullptr);
+  CHECK_EQ (sender.dropped (), 10u);
+  CHECK_EQ (sender.frames (), (uint64_t) SLOTS);
+
+  GstSpoutFrameLease none;
+  CHECK (receive (receiver, none) == GstSpoutReceiveResult::NO_FRAME);
+  CHECK (!none.held ());
+
+  for (unsigned i = 0; i < SLOTS; i++)
+    CHECK (filled (held[i].data, held[i].size, i + 1));
+
+  /* Releasing the oldest frees exactly its slot: the sender writes there
+   * and the other leases are left alone */
+  size_t freed = held[0].offset;
+
+  held[0].release ();
+  CHECK (publish (sender));
+  CHECK (sender.begin () == nullptr);
+  CHECK_EQ (sender.dropped (), 11u);
+
+  GstSpoutFrameLease next;
+  CHECK (receive (receiver, next) == GstSpoutReceiveResult::FRAME);
+  CHECK_EQ (next.frame, (uint64_t) SLOTS + 1);
+  CHECK_EQ (next.offset, freed);
+  CHECK (filled (next.data, next.size, SLOTS + 1));
+  for (unsigned i = 1; i < SLOTS; i++)
+    CHECK (filled (held[i].data, held[i].size, i + 1));
+
+  /* With one receiver holding a single frame the sender cycles through the
+   * other slots for as long as it likes, never touching the held one */
+  for (unsigned i = 1; i < SLOTS; i++)
+    held[i].release ();
+  unsigned published = 0;
+  while (published < 1000 && publish (sender))
+    published++;
+  CHECK_EQ (published, 1000u);
+  CHECK_EQ (sender.dropped (), 11u);
+  CHECK (filled (next.data, next.size, SLOTS + 1));
+
+  /* The receiver skips straight to the newest */
+  GstSpoutFrameLease newest;
+  CHECK (receive (receiver, newest) == GstSpoutReceiveResult::FRAME);
+  CHECK_EQ (newest.frame, sender.frames ());
+  CHECK (filled (newest.data, newest.size, sender.frames ()));
+
+  /* All released, every slot is writable again */
+  next.release ();
+  newest.release ();
+  for (unsigned i = 0; i < SLOTS; i++)
+    CHECK (publish (sender));
+  CHECK_EQ (sender.dropped (), 11u);
+
+  sender.close ();
+  CHECK (receive (receiver, none) == GstSpoutReceiveResult::ERROR);
+}
+
+int
+main ()
+{
+  test_fd_matches_data ();
+  test_leases_hold_slots ();
+
+  return gst_spout_test_result ();
+}
@@ -0,0 +1,219 @@
+/* GStreamer
+ * Copyright (C) 2023 Your Name <your.email@example.com>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+/* The shm receive backend across processes: a forked sender publishes
+ * frames as fast as it can while this process receives them, holding some
+ * for a while. Every frame must arrive whole and in order, and a sender
+ * that closes or dies must be noticed */
+
+#include "gstspoutshm.h"
+#include "gstspouttest.h"
+
+#include <sys/wait.h>
+
+static const uint32_t WIDTH = 256;
+static const uint32_t HEIGHT = 64;
+static const uint64_t FRAMES = 5000;
+
+static std::string
+sender_name (const char * what)
+{
+  return std::string ("test-shm-") + what + "-" +
+      std::to_string (gst_spout_shm_current_pid ());
+}
+
+/* Every word of a frame carries its number, a frame mixing two is torn */
+static void
+fill (uint8_t * data, size_t size, uint64_t frame)
+{
+  uint64_t *words = (uint64_t *) data;
+
+  for (size_t i = 0; i < size / sizeof (uint64_t); i++)
+    words[i] = frame;
+}
+
+static bool
+intact (const uint8_t * data, size_t size, uint64_t frame)
+{
+  const uint64_t *words = (const uint64_t *) data;
+
+  for (size_t i = 0; i < size / sizeof (uint64_t); i++) {
+    if (words[i] != frame)
+      return false;
+  }
+  return true;
+}
+
+/* Publishes @frames frames, then waits to be told to close or is killed */
+static pid_t
+fork_sender (const std::string & name, uint64_t frames, int done_fd)
+{
+  pid_t pid = fork ();
+
+  if (pid != 0)
+    return pid;
+
+  GstSpoutShmSender sender;
+  GstSpoutFrameFormat format;
+  char byte;
+
+  format.width = WIDTH;
+  format.height = HEIGHT;
+  format.format = 87;           /* DXGI_FORMAT_B8G8R8A8_UNORM */
+  format.fps = 60.0;
+  if (!sender.create (name, format, 4))
+    _exit (1);
+
+  while (sender.frames () < frames) {
+    uint8_t *data = sender.begin ();
+
+    if (!data) {
+      sched_yield ();
+      continue;
+    }
+    fill (data, (size_t) WIDTH * 4 * HEIGHT, sender.frames () + 1);
+    sender.publish ();
+  }
+
+  if (read (done_fd, &byte, 1) < 0)
+    _exit (1);
+  sender.close ();
+  _exit (0);
+}
+
+static bool
+connect_to (GstSpoutShmReceiver & receiver, const std::string & name)
+{
+  for (int i = 0; i < 5000; i++) {
+    if (receiver.connect (name))
+      return true;
+    usleep (1000);
+  }
+  return false;
+}
+
+static void
+test_frames_across_processes ()
+{
+  std::string name = sender_name ("frames");
+  GstSpoutShmReceiver receiver;
+  GstSpoutFrameLease held[2];
+  uint64_t last = 0, received = 0, torn = 0, reordered = 0;
+  int done[2];
+  int status;
+
+  CHECK (pipe (done) == 0);
+  pid_t pid = fork_sender (name, FRAMES, done[0]);
+
+  CHECK (connect_to (receiver, name));
+  CHECK (receiver.available (name));
+  CHECK_EQ (receiver.sender_name (), name);
+  CHECK_EQ (receiver.format ().width, WIDTH);
+  CHECK_EQ (receiver.format ().stride, WIDTH * 4);
+
+  while (last < FRAMES) {
+    GstSpoutFrameLease lease;
+    GstSpoutReceiveResult result =
+        receiver.receive (lease, std::chrono::seconds (5));
+
+    if (result != GstSpoutReceiveResult::FRAME) {
+      CHECK (result == GstSpoutReceiveResult::FRAME);
+      break;
+    }
+
+    received++;
+    reordered += lease.frame <= last;
+    torn += !intact (lease.data, lease.size, lease.frame);
+    last = lease.frame;
+
+    /* Held frames must not change under us while the sender goes on */
+    for (auto & frame : held)
+      torn += frame.held () && !intact (frame.data, frame.size, frame.frame);
+    if (received % 10 == 0)
+      held[(received / 10) % 2] = std::move (lease);
+  }
+
+  CHECK (received > 0);
+  CHECK_EQ (torn, 0u);
+  CHECK_EQ (reordered, 0u);
+  CHECK_EQ (last, FRAMES);
+
+  /* Closing is seen right away */
+  CHECK (write (done[1], "x", 1) == 1);
+  GstSpoutFrameLease lease;
+  CHECK (receiver.receive (lease, std::chrono::seconds (5)) ==
+      GstSpoutReceiveResult::ERROR);
+  CHECK (waitpid (pid, &status, 0) == pid);
+  CHECK (WIFEXITED (status) && WEXITSTATUS (status) == 0);
+  CHECK (!receiver.available (name));
+
+  /* What we still hold outlives the sender */
+  for (auto & frame : held)
+    CHECK (frame.held () && intact (frame.data, frame.size, frame.frame));
+
+  close (done[0]);
+  close (done[1]);
+}
+
+/* A sender that crashed never closes its ring, its pid going away has to
+ * tell, and its registry entry is taken over */
+static void
+test_crashed_sender ()
+{
+  std::string name = sender_name ("crash");
+  GstSpoutShmReceiver receiver;
+  GstSpoutFrameLease lease;
+  int done[2];
+
+  CHECK (pipe (done) == 0);
+  pid_t pid = fork_sender (name, 1, done[0]);
+
+  CHECK (connect_to (receiver, name));
+  CHECK (receiver.receive (lease, std::chrono::seconds (5)) ==
+      GstSpoutReceiveResult::FRAME);
+  lease.release ();
+
+  kill (pid, SIGKILL);
+  CHECK (waitpid (pid, nullptr, 0) == pid);
+
+  CHECK (receiver.receive (lease, std::chrono::milliseconds (20)) ==
+      GstSpoutReceiveResult::ERROR);
+  CHECK (!receiver.available (name));
+
+  /* The name is free again */
+  GstSpoutShmSender sender;
+  GstSpoutFrameFormat format;
+  format.width = WIDTH;
+  format.height = HEIGHT;
+  CHECK (sender.create (name, format));
+  CHECK (receiver.connect (name));
+  sender.close ();
+
+  close (done[0]);
+  close (done[1]);
+}
+
+int
+main ()
+{
+  test_frames_across_processes ();
+  test_crashed_sender ();
+
+  return gst_spout_test_result ();
+}
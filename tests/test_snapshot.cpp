@@ -0,0 +1,177 @@
+/* GStreamer
+ * Copyright (C) 2023 Your Name <your.email@example.com>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+/* GstSpoutSnapshot: views follow publications, readers under concurrent
+ * publishing never see a state that was only partly written */
+
+#include "gstspoutsnapshot.h"
+#include "gstspouttest.h"
+
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <string>
+#include <thread>
+
+struct TestState
+{
+  int generation = 0;
+  std::string name = "0";
+  double fps = 0;
+};
+
+static std::shared_ptr<const TestState>
+make_state (int generation)
+{
+  auto state = std::make_shared<TestState> ();
+
+  state->generation = generation;
+  state->name = std::to_string (generation);
+  state->fps = generation * 0.5;
+
+  return state;
+}
+
+static void
+test_refresh ()
+{
+  GstSpoutSnapshot<TestState> snapshot;
+  auto view = snapshot.view ();
+
+  CHECK_EQ (view->generation, 0);
+  CHECK (!snapshot.refresh (view));
+
+  snapshot.publish (make_state (1));
+  CHECK_EQ (view->generation, 0);
+  CHECK (snapshot.refresh (view));
+  CHECK_EQ (view->generation, 1);
+  CHECK (!snapshot.refresh (view));
+
+  /* Only the latest of several publications matters */
+  snapshot.publish (make_state (2));
+  snapshot.publish (make_state (3));
+  CHECK (snapshot.refresh (view));
+  CHECK_EQ (view->generation, 3);
+  CHECK_EQ (snapshot.load ()->generation, 3);
+
+  /* An empty view always loads */
+  GstSpoutSnapshot<TestState>::View empty;
+  CHECK (snapshot.refresh (empty));
+  CHECK_EQ (empty->generation, 3);
+}
+
+static void
+test_concurrent ()
+{
+  GstSpoutSnapshot<TestState> snapshot;
+  std::atomic<bool> done { false };
+  int torn = 0, backwards = 0, last = 0;
+
+  std::thread writer ([&] {
+    for (int i = 1; i <= 20000; i++)
+      snapshot.publish (make_state (i));
+    done = true;
+  });
+
+  auto view = snapshot.view ();
+  while (!done || snapshot.refresh (view)) {
+    snapshot.refresh (view);
+
+    if (view->name != std::to_string (view->generation) ||
+        view->fps != view->generation * 0.5)
+      torn++;
+    if (view->generation < last)
+      backwards++;
+    last = view->generation;
+  }
+
+  writer.join ();
+
+  CHECK_EQ (torn, 0);
+  CHECK_EQ (backwards, 0);
+  CHECK_EQ (view->generation, 20000);
+}
+
+/* The streaming thread decides to wait on the view it has, the way
+ * gst_spout_src_wait_for() does: a publication that lands between that
+ * decision and the wait must still end it right away, and one during the
+ * wait must wake it rather than leave it for the whole timeout */
+static void
+test_wait_for_change ()
+{
+  using namespace std::chrono;
+  GstSpoutSnapshot<TestState> snapshot;
+  std::mutex lock;
+  std::condition_variable cond;
+
+  auto wait = [&] (const GstSpoutSnapshot<TestState>::View & view) {
+    std::unique_lock<std::mutex> guard (lock);
+    auto start = steady_clock::now ();
+
+    cond.wait_for (guard, seconds (10),
+        [&] { return snapshot.changed (view); });
+    return steady_clock::now () - start;
+  };
+
+  auto view = snapshot.view ();
+  CHECK (!snapshot.changed (view));
+
+  /* Connected between the decision and the wait: no wait at all */
+  {
+    std::lock_guard<std::mutex> guard (lock);
+    snapshot.publish (make_state (1));
+    cond.notify_all ();
+  }
+  CHECK (snapshot.changed (view));
+  CHECK (wait (view) < seconds (1));
+  CHECK (snapshot.refresh (view));
+  CHECK (!snapshot.changed (view));
+
+  /* Connected while waiting: woken up */
+  std::thread reconnect ([&] {
+    std::this_thread::sleep_for (milliseconds (50));
+    std::lock_guard<std::mutex> guard (lock);
+    snapshot.publish (make_state (2));
+    cond.notify_all ();
+  });
+  CHECK (wait (view) < seconds (5));
+  reconnect.join ();
+  CHECK (snapshot.refresh (view));
+  CHECK_EQ (view->generation, 2);
+
+  /* Nothing published: the timeout. A view never loaded counts as changed,
+   * so it is loaded before anybody waits on it */
+  {
+    std::unique_lock<std::mutex> guard (lock);
+    CHECK (!cond.wait_for (guard, milliseconds (20),
+            [&] { return snapshot.changed (view); }));
+  }
+  GstSpoutSnapshot<TestState>::View empty;
+  CHECK (snapshot.changed (empty));
+}
+
+int
+main ()
+{
+  test_refresh ();
+  test_concurrent ();
+  test_wait_for_change ();
+
+  return gst_spout_test_result ();
+}
@@ -0,0 +1,330 @@
+/* GStreamer
+ * Copyright (C) 2023 Your Name <your.email@example.com>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+/* GstSpoutStandby over a system memory backend: standby frames are rendered
+ * once per format and mode, last-frame mode copies the held frame once and
+ * gives the received one back, and nothing leaks */
+
+#include "gstspoutstandby.h"
+#include "gstspouttest.h"
+
+#include <vector>
+
+struct SysFrame
+{
+  int refs = 1;
+  uint32_t width = 0;
+  uint32_t height = 0;
+  std::vector<uint32_t> pixels;     /* ARGB */
+};
+
+struct SysBackend
+{
+  using Frame = SysFrame *;
+
+  int live = 0;
+  bool fail = false;
+
+  Frame render (const GstSpoutSenderFormat & format, GstSpoutStandbyMode mode,
+      uint32_t argb)
+  {
+    if (fail)
+      return nullptr;
+
+    Frame frame = make (format);
+
+    for (uint32_t x = 0; x < format.width; x++) {
+      uint32_t color = 0xff000000;
+
+      if (mode == GST_SPOUT_STANDBY_COLOR)
+        color = argb;
+      for (unsigned int bar = 0; mode == GST_SPOUT_STANDBY_PATTERN &&
+          bar < GST_SPOUT_STANDBY_BARS; bar++) {
+        uint32_t left, right;
+
+        gst_spout_standby_bar_bounds (format.width, bar, &left, &right);
+        if (x >= left && x < right)
+          color = gst_spout_standby_bar_color (bar);
+      }
+      for (uint32_t y = 0; y < format.height; y++)
+        frame->pixels[y * format.width + x] = color;
+    }
+    return frame;
+  }
+
+  Frame copy (Frame source, const GstSpoutSenderFormat & format)
+  {
+    if (fail)
+      return nullptr;
+
+    Frame frame = make (format);
+    frame->pixels = source->pixels;
+    return frame;
+  }
+
+  void ref (Frame frame) { frame->refs++; }
+
+  void unref (Frame frame)
+  {
+    if (--frame->refs == 0) {
+      delete frame;
+      live--;
+    }
+  }
+
+  Frame make (const GstSpoutSenderFormat & format)
+  {
+    Frame frame = new SysFrame ();
+
+    frame->width = format.width;
+    frame->height = format.height;
+    frame->pixels.resize ((size_t) format.width * format.height);
+    live++;
+    return frame;
+  }
+};
+
+static GstSpoutSenderFormat
+make_format (uint32_t width, uint32_t height)
+{
+  GstSpoutSenderFormat format;
+
+  format.width = width;
+  format.height = height;
+  format.format = 87;           /* DXGI_FORMAT_B8G8R8A8_UNORM */
+  format.fps = 60.0;
+  return format;
+}
+
+/* Bars tile the width without gaps or overlaps, whatever the width */
+static void
+test_bar_bounds ()
+{
+  for (uint32_t width : { 1u, 7u, 8u, 1366u, 1920u, 4095u }) {
+    uint32_t expected_left = 0;
+
+    for (unsigned int bar = 0; bar < GST_SPOUT_STANDBY_BARS; bar++) {
+      uint32_t left, right;
+
+      gst_spout_standby_bar_bounds (width, bar, &left, &right);
+      CHECK_EQ (left, expected_left);
+      CHECK (right >= left);
+      CHECK (right - left <= width / GST_SPOUT_STANDBY_BARS + 1);
+      expected_left = right;
+    }
+    CHECK_EQ (expected_left, width);
+  }
+
+  CHECK_EQ (gst_spout_standby_bar_color (0), 0xffbfbfbfu);
+  CHECK_EQ (gst_spout_standby_bar_color (7), 0xff000000u);
+  CHECK_EQ (gst_spout_standby_bar_color (8), gst_spout_standby_bar_color (0));
+}
+
+/* An outage renders once, not once per frame */
+static void
+test_rendered_once ()
+{
+  GstSpoutStandby<SysBackend> standby;
+  GstSpoutSenderFormat format = make_format (64, 4);
+
+  standby.configure (GST_SPOUT_STANDBY_PATTERN, 0);
+  for (int i = 0; i < 1000; i++) {
+    SysFrame *frame = standby.get (format);
+
+    CHECK (frame != nullptr);
+    CHECK_EQ (frame->pixels[0], 0xffbfbfbfu);
+    CHECK_EQ (frame->pixels[63], 0xff000000u);
+    standby.backend ().unref (frame);
+  }
+  CHECK_EQ (standby.renders (), 1u);
+
+  /* New geometry, new mode or colour: rendered again */
+  standby.backend ().unref (standby.get (make_format (32, 4)));
+  CHECK_EQ (standby.renders (), 2u);
+
+  standby.configure (GST_SPOUT_STANDBY_COLOR, 0xff336699);
+  SysFrame *frame = standby.get (make_format (32, 4));
+  CHECK_EQ (frame->pixels[5], 0xff336699u);
+  standby.backend ().unref (frame);
+
+  standby.configure (GST_SPOUT_STANDBY_COLOR, 0xff336699);
+  standby.backend ().unref (standby.get (make_format (32, 4)));
+  CHECK_EQ (standby.renders (), 3u);
+
+  standby.configure (GST_SPOUT_STANDBY_COLOR, 0xffffffff);
+  standby.backend ().unref (standby.get (make_format (32, 4)));
+  CHECK_EQ (standby.renders (), 4u);
+
+  standby.clear ();
+  CHECK_EQ (standby.backend ().live, 0);
+}
+
+static void
+test_last_frame ()
+{
+  GstSpoutStandby<SysBackend> standby;
+  SysBackend & backend = standby.backend ();
+  GstSpoutSenderFormat format = make_format (16, 2);
+
+  standby.configure (GST_SPOUT_STANDBY_LAST_FRAME, 0);
+
+  /* Nothing received yet, black */
+  SysFrame *frame = standby.get (format);
+  CHECK_EQ (frame->pixels[0], 0xff000000u);
+  backend.unref (frame);
+
+  /* Received frames are only held, not copied, while they flow */
+  SysFrame *received = backend.render (format, GST_SPOUT_STANDBY_COLOR,
+      0xff123456);
+  for (int i = 0; i < 100; i++)
+    standby.remember (received, format);
+  CHECK_EQ (standby.copies (), 0u);
+  CHECK_EQ (received->refs, 2);
+
+  /* The outage copies it once and lets the received frame go */
+  for (int i = 0; i < 100; i++) {
+    frame = standby.get (format);
+    CHECK_EQ (frame->pixels[3], 0xff123456u);
+    CHECK (frame != received);
+    backend.unref (frame);
+  }
+  CHECK_EQ (standby.copies (), 1u);
+  CHECK_EQ (received->refs, 1);
+  backend.unref (received);
+
+  /* The next outage holds the newer frame */
+  received = backend.render (format, GST_SPOUT_STANDBY_COLOR, 0xff654321);
+  standby.remember (received, format);
+  backend.unref (received);
+  frame = standby.get (format);
+  CHECK_EQ (frame->pixels[3], 0xff654321u);
+  backend.unref (frame);
+  CHECK_EQ (standby.copies (), 2u);
+
+  /* A held frame of another size doesn't fit, black again */
+  frame = standby.get (make_format (8, 2));
+  CHECK_EQ (frame->pixels[0], 0xff000000u);
+  backend.unref (frame);
+
+  /* Leaving last-frame mode drops what it held */
+  received = backend.render (format, GST_SPOUT_STANDBY_COLOR, 0xff00ff00);
+  standby.remember (received, format);
+  backend.unref (received);
+  standby.configure (GST_SPOUT_STANDBY_BLACK, 0);
+  CHECK_EQ (backend.live, 0);
+}
+
+/* A failing backend gives a null frame and is tried again next time */
+static void
+test_backend_failure ()
+{
+  GstSpoutStandby<SysBackend> standby;
+  GstSpoutSenderFormat format = make_format (16, 2);
+
+  standby.configure (GST_SPOUT_STANDBY_PATTERN, 0);
+  standby.backend ().fail = true;
+  CHECK (standby.get (format) == nullptr);
+  CHECK_EQ (standby.renders (), 0u);
+
+  standby.backend ().fail = false;
+  SysFrame *frame = standby.get (format);
+  CHECK (frame != nullptr);
+  standby.backend ().unref (frame);
+  CHECK_EQ (standby.renders (), 1u);
+}
+
+/* Standby timestamps advance by exactly one frame duration and never drift
+ * from the grid, even at NTSC rates */
+static void
+test_timer_grid ()
+{
+  const uint64_t second = GstSpoutCfrPacer::SECOND;
+  GstSpoutStandbyTimer timer;
+  GstSpoutStandbyTimer::Slot slot, prev;
+  uint64_t now = 5 * second;
+  uint64_t running_time = 2 * second;
+
+  CHECK (timer.next (30000, 1001, now, running_time, prev));
+  CHECK_EQ (prev.due, now);
+  CHECK_EQ (prev.pts, running_time);
+
+  for (int i = 1; i < 30000; i++) {
+    /* Woken up a little late every time */
+    now = prev.due + 1000;
+    CHECK (timer.next (30000, 1001, now, running_time, slot));
+    CHECK_EQ (slot.pts, prev.pts + prev.duration);
+    CHECK_EQ (slot.due - prev.due, slot.pts - prev.pts);
+    prev = slot;
+  }
+
+  /* 30000 frames at 30000/1001 are 1001 seconds to the nanosecond */
+  CHECK_EQ (prev.pts + prev.duration, running_time + 1001 * second);
+  CHECK_EQ (timer.missed (), 0u);
+}
+
+/* A caller too late for a frame skips it rather than bunching frames up */
+static void
+test_timer_late ()
+{
+  const uint64_t second = GstSpoutCfrPacer::SECOND;
+  GstSpoutStandbyTimer timer;
+  GstSpoutStandbyTimer::Slot slot;
+
+  CHECK (timer.next (25, 1, 0, 0, slot));
+  CHECK (timer.next (25, 1, 0, 0, slot));
+  CHECK_EQ (slot.pts, second / 25);
+
+  /* Two and a half frames behind */
+  CHECK (timer.next (25, 1, 3 * second / 25 + second / 50, 0, slot));
+  CHECK_EQ (slot.pts, 3 * second / 25);
+  CHECK_EQ (slot.duration, second / 25);
+  CHECK_EQ (timer.missed (), 1u);
+
+  /* A new outage starts a new grid at the current running time */
+  timer.reset ();
+  CHECK (timer.next (25, 1, 10 * second, 7 * second, slot));
+  CHECK_EQ (slot.due, 10 * second);
+  CHECK_EQ (slot.pts, 7 * second);
+}
+
+/* Without a valid rate there's nothing to pace with */
+static void
+test_timer_no_rate ()
+{
+  GstSpoutStandbyTimer timer;
+  GstSpoutStandbyTimer::Slot slot;
+
+  CHECK (!timer.next (0, 1, 0, 0, slot));
+  CHECK (!timer.next (30, 0, 0, 0, slot));
+  CHECK (timer.next (30, 1, 0, 0, slot));
+}
+
+int
+main ()
+{
+  test_bar_bounds ();
+  test_rendered_once ();
+  test_last_frame ();
+  test_backend_failure ();
+  test_timer_grid ();
+  test_timer_late ();
+  test_timer_no_rate ();
+
+  return gst_spout_test_result ();
+}
@@ -0,0 +1,178 @@
+/* GStreamer
+ * Copyright (C) 2023 Your Name <your.email@example.com>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+/* GstSpoutStats: histogram buckets and percentiles against the exact
+ * values, and counts that add up with writers and readers on several
+ * threads */
+
+#include "gstspoutstats.h"
+#include "gstspouttest.h"
+
+#include <algorithm>
+#include <random>
+#include <thread>
+#include <vector>
+
+static void
+test_buckets ()
+{
+  CHECK_EQ (GstSpoutHistogram::bucket (0), 0u);
+  CHECK_EQ (GstSpoutHistogram::bucket (1999), 0u);
+  CHECK_EQ (GstSpoutHistogram::bucket (2000), 1u);
+  CHECK_EQ (GstSpoutHistogram::bucket (3999), 1u);
+  CHECK_EQ (GstSpoutHistogram::bucket (4000), 2u);
+  CHECK_EQ (GstSpoutHistogram::bucket (1ull << 50),
+      GstSpoutHistogram::BUCKETS - 1);
+
+  /* Every bucket ends where the next one starts */
+  for (unsigned i = 0; i + 1 < GstSpoutHistogram::BUCKETS; i++) {
+    uint64_t bound = GstSpoutHistogram::upper_bound (i);
+
+    CHECK_EQ (GstSpoutHistogram::bucket (bound - 1), i);
+    CHECK_EQ (GstSpoutHistogram::bucket (bound), i + 1);
+  }
+}
+
+/* Percentiles are bucket upper bounds: never below the exact value, and
+ * within a factor of two of it once past the first bucket */
+static void
+test_percentiles ()
+{
+  GstSpoutHistogram histogram;
+  std::mt19937_64 rng (20);
+  std::lognormal_distribution<double> frame_time (14.5, 1.0);
+  std::vector<uint64_t> durations;
+
+  CHECK_EQ (histogram.snapshot ().percentile (50), 0u);
+  CHECK_EQ (histogram.snapshot ().mean (), 0u);
+
+  for (int i = 0; i < 100000; i++) {
+    uint64_t duration = (uint64_t) frame_time (rng);
+
+    durations.push_back (duration);
+    histogram.record (duration);
+  }
+  std::sort (durations.begin (), durations.end ());
+
+  GstSpoutHistogram::Snapshot snapshot = histogram.snapshot ();
+  uint64_t sum = 0, total = 0;
+
+  for (uint64_t duration : durations)
+    sum += duration;
+  for (uint64_t count : snapshot.buckets)
+    total += count;
+
+  CHECK_EQ (snapshot.count, durations.size ());
+  CHECK_EQ (total, durations.size ());
+  CHECK_EQ (snapshot.sum, sum);
+  CHECK_EQ (snapshot.max, durations.back ());
+  CHECK_EQ (snapshot.mean (), sum / durations.size ());
+  CHECK_EQ (snapshot.percentile (100), durations.back ());
+
+  for (unsigned percent : { 1u, 10u, 50u, 90u, 99u, 100u }) {
+    uint64_t exact = durations[(durations.size () * percent + 99) / 100 - 1];
+    uint64_t estimate = snapshot.percentile (percent);
+
+    CHECK (estimate >= exact);
+    CHECK (exact < 2000 || estimate <= 2 * exact);
+  }
+
+  histogram.reset ();
+  snapshot = histogram.snapshot ();
+  CHECK_EQ (snapshot.count, 0u);
+  CHECK_EQ (snapshot.max, 0u);
+  CHECK_EQ (snapshot.percentile (99), 0u);
+}
+
+/* The frame path records on one thread while the app polls from others:
+ * nothing lost, the max is the true max, and readers never see a value go
+ * backwards */
+static void
+test_threads ()
+{
+  const int WRITERS = 4, PER_WRITER = 200000;
+  GstSpoutStats stats;
+  std::atomic<bool> done { false };
+  std::atomic<unsigned> backwards { 0 };
+  std::vector<std::thread> threads;
+
+  for (int w = 0; w < WRITERS; w++) {
+    threads.emplace_back ([&, w] {
+      for (int i = 0; i < PER_WRITER; i++) {
+        stats.received.add ();
+        stats.copy_time.record ((uint64_t) (i % 5000) * 1000 + w);
+        if (i % 3 == 0)
+          stats.dropped.add ();
+        else
+          stats.pushed.add ();
+      }
+    });
+  }
+
+  std::vector<std::thread> readers;
+  for (int r = 0; r < 2; r++) {
+    readers.emplace_back ([&] {
+      uint64_t received = 0, count = 0, max = 0;
+
+      while (!done.load ()) {
+        GstSpoutHistogram::Snapshot snapshot = stats.copy_time.snapshot ();
+        uint64_t now = stats.received.get ();
+
+        if (now < received || snapshot.count < count || snapshot.max < max)
+          backwards++;
+        received = now;
+        count = snapshot.count;
+        max = snapshot.max;
+      }
+    });
+  }
+
+  for (auto & thread : threads)
+    thread.join ();
+  done = true;
+  for (auto & thread : readers)
+    thread.join ();
+
+  GstSpoutHistogram::Snapshot snapshot = stats.copy_time.snapshot ();
+  uint64_t total = 0;
+
+  for (uint64_t count : snapshot.buckets)
+    total += count;
+
+  CHECK_EQ (backwards.load (), 0u);
+  CHECK_EQ (stats.received.get (), (uint64_t) WRITERS * PER_WRITER);
+  CHECK_EQ (stats.pushed.get () + stats.dropped.get (), stats.received.get ());
+  CHECK_EQ (snapshot.count, (uint64_t) WRITERS * PER_WRITER);
+  CHECK_EQ (total, snapshot.count);
+  CHECK_EQ (snapshot.max, 4999000u + WRITERS - 1);
+
+  stats.reset ();
+  CHECK_EQ (stats.received.get (), 0u);
+  CHECK_EQ (stats.copy_time.snapshot ().count, 0u);
+}
+
+int
+main ()
+{
+  test_buckets ();
+  test_percentiles ();
+  test_threads ();
+
+  return gst_spout_test_result ();
+}
@@ -0,0 +1,230 @@
+/* GStreamer
+ * Copyright (C) 2023 Your Name <your.email@example.com>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+/* GstSpoutTextureCache over a mock texture backend that counts references
+ * and catches use after free, so the lifetime rules hold without a GPU */
+
+#include "gstspouttexturecache.h"
+#include "gstspouttest.h"
+
+#include <algorithm>
+#include <list>
+#include <memory>
+#include <random>
+
+struct MockTexture
+{
+  int handle;
+  int refs;
+};
+
+/* Shared by copies of the backend, the cache keeps its own */
+struct MockState
+{
+  std::vector<std::unique_ptr<MockTexture>> textures;
+  int live = 0;
+  int freed_twice = 0;
+  uint64_t opens = 0;
+};
+
+struct MockBackend
+{
+  using Handle = int;
+  using Texture = MockTexture *;
+
+  std::shared_ptr<MockState> state = std::make_shared<MockState> ();
+
+  /* Negative handles belong to senders that went away */
+  Texture open (Handle handle)
+  {
+    if (handle < 0)
+      return nullptr;
+
+    state->textures.push_back (std::make_unique<MockTexture> (
+            MockTexture { handle, 1 }));
+    state->live++;
+    state->opens++;
+    return state->textures.back ().get ();
+  }
+
+  void ref (Texture texture) { texture->refs++; }
+
+  void unref (Texture texture)
+  {
+    if (texture->refs <= 0) {
+      state->freed_twice++;
+      return;
+    }
+    if (--texture->refs == 0)
+      state->live--;
+  }
+};
+
+static void
+test_references ()
+{
+  GstSpoutTextureCache<MockBackend> cache (MockBackend (), 2);
+  MockBackend & backend = cache.backend ();
+
+  MockTexture *a = cache.acquire (1);
+  CHECK (a != nullptr);
+  CHECK_EQ (a->refs, 2);          /* cache + caller */
+
+  MockTexture *again = cache.acquire (1);
+  CHECK (again == a);
+  CHECK_EQ (a->refs, 3);
+  CHECK_EQ (cache.opened (), 1u);
+  backend.unref (again);
+
+  /* Failed opens aren't cached and don't evict anything */
+  CHECK (cache.acquire (-1) == nullptr);
+  CHECK_EQ (cache.size (), 1u);
+
+  /* Evicted while the caller still holds it: stays valid */
+  MockTexture *b = cache.acquire (2);
+  MockTexture *c = cache.acquire (3);
+  CHECK_EQ (cache.size (), 2u);
+  CHECK_EQ (a->refs, 1);
+  CHECK_EQ (backend.state->live, 3);
+
+  backend.unref (a);
+  CHECK_EQ (backend.state->live, 2);
+
+  /* Clearing leaves what buffers downstream hold */
+  cache.clear ();
+  CHECK_EQ (cache.size (), 0u);
+  CHECK_EQ (b->refs, 1);
+  CHECK_EQ (c->refs, 1);
+  backend.unref (b);
+  backend.unref (c);
+  CHECK_EQ (backend.state->live, 0);
+  CHECK_EQ (backend.state->freed_twice, 0);
+}
+
+/* Least recently used goes first */
+static void
+test_eviction_order ()
+{
+  GstSpoutTextureCache<MockBackend> cache (MockBackend (), 2);
+  MockBackend & backend = cache.backend ();
+
+  backend.unref (cache.acquire (1));
+  backend.unref (cache.acquire (2));
+  backend.unref (cache.acquire (1));
+  backend.unref (cache.acquire (3));    /* evicts 2 */
+  backend.unref (cache.acquire (1));
+  CHECK_EQ (cache.opened (), 3u);
+
+  backend.unref (cache.acquire (2));
+  CHECK_EQ (cache.opened (), 4u);
+
+  /* A capacity of 0 still caches one */
+  GstSpoutTextureCache<MockBackend> single (MockBackend (), 0);
+  single.backend ().unref (single.acquire (5));
+  single.backend ().unref (single.acquire (5));
+  CHECK_EQ (single.opened (), 1u);
+}
+
+/* The destructor drops the cache's references */
+static void
+test_destructor ()
+{
+  std::shared_ptr<MockState> state;
+  MockTexture *held;
+
+  {
+    GstSpoutTextureCache<MockBackend> cache (MockBackend (), 4);
+    state = cache.backend ().state;
+
+    cache.backend ().unref (cache.acquire (1));
+    cache.backend ().unref (cache.acquire (2));
+    held = cache.acquire (3);
+    CHECK_EQ (state->live, 3);
+  }
+
+  CHECK_EQ (state->live, 1);
+  CHECK_EQ (held->refs, 1);
+}
+
+/* Random senders and downstream holding textures for a while, checked
+ * against a plain LRU list */
+static void
+test_against_model ()
+{
+  const size_t capacity = 3;
+  GstSpoutTextureCache<MockBackend> cache (MockBackend (), capacity);
+  MockBackend & backend = cache.backend ();
+  std::list<int> model;
+  std::vector<MockTexture *> held;
+  std::mt19937 rng (7);
+  uint64_t expected_opens = 0;
+  int wrong = 0;
+
+  for (int i = 0; i < 100000; i++) {
+    int handle = (int) (rng () % 6) - 1;
+    MockTexture *texture = cache.acquire (handle);
+
+    if (handle < 0) {
+      wrong += texture != nullptr;
+    } else {
+      auto it = std::find (model.begin (), model.end (), handle);
+
+      if (it != model.end ()) {
+        model.erase (it);
+      } else {
+        expected_opens++;
+        if (model.size () == capacity)
+          model.pop_back ();
+      }
+      model.push_front (handle);
+
+      wrong += !texture || texture->handle != handle || texture->refs < 2;
+      held.push_back (texture);
+    }
+
+    /* Downstream lets go of buffers in any order */
+    while (held.size () > 8 || (!held.empty () && rng () % 2)) {
+      size_t index = rng () % held.size ();
+      backend.unref (held[index]);
+      held[index] = held.back ();
+      held.pop_back ();
+    }
+  }
+
+  CHECK_EQ (wrong, 0);
+  CHECK_EQ (cache.opened (), expected_opens);
+  CHECK_EQ (cache.size (), model.size ());
+
+  for (MockTexture *texture : held)
+    backend.unref (texture);
+  cache.clear ();
+  CHECK_EQ (backend.state->live, 0);
+  CHECK_EQ (backend.state->freed_twice, 0);
+}
+
+int
+main ()
+{
+  test_references ();
+  test_eviction_order ();
+  test_destructor ();
+  test_against_model ();
+
+  return gst_spout_test_result ();
+}
@@ -0,0 +1,271 @@
+/* GStreamer
+ * Copyright (C) 2023 Your Name <your.email@example.com>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+/* GstSpoutTimestamper fed jittery arrival traces in each timestamp mode,
+ * with the frame duration from the snapped rational rate as spoutsrc
+ * passes it. Checks how evenly the output PTS are spaced */
+
+#include "gstspouttimestamp.h"
+#include "gstspouttest.h"
+
+#include <cmath>
+#include <random>
+#include <vector>
+
+static const uint64_t MS = 1000000;
+
+struct Arrival
+{
+  uint64_t time;
+  int64_t sender_frame;
+};
+
+/* A sender at @num/@den fps whose frames reach us up to @jitter late,
+ * mostly a little and now and then a lot, as a busy scheduler does. 0
+ * @jitter is a quarter period */
+static std::vector<Arrival>
+make_trace (int num, int den, unsigned frames, uint64_t jitter,
+    uint32_t seed = 1)
+{
+  std::mt19937 rng (seed);
+  std::exponential_distribution<double> delay (4.0);
+  std::vector<Arrival> trace;
+
+  if (jitter == 0)
+    jitter = 250000000ull * den / num;
+
+  for (unsigned i = 0; i < frames; i++) {
+    uint64_t ideal = 500 * MS + (uint64_t) i * 1000000000ull * den / num;
+    double late = std::min (delay (rng), 1.0) * jitter;
+
+    trace.push_back ({ ideal + (uint64_t) late, (int64_t) i + 1 });
+  }
+
+  return trace;
+}
+
+struct Stats
+{
+  double mean = 0;
+  double stddev = 0;
+  uint64_t min = UINT64_MAX;
+  uint64_t max = 0;
+};
+
+static Stats
+interval_stats (const std::vector<uint64_t> & pts, size_t skip = 0)
+{
+  Stats stats;
+  std::vector<double> intervals;
+
+  for (size_t i = skip + 1; i < pts.size (); i++) {
+    intervals.push_back ((double) (pts[i] - pts[i - 1]));
+    stats.min = std::min (stats.min, pts[i] - pts[i - 1]);
+    stats.max = std::max (stats.max, pts[i] - pts[i - 1]);
+  }
+
+  for (double interval : intervals)
+    stats.mean += interval;
+  stats.mean /= intervals.size ();
+  for (double interval : intervals)
+    stats.stddev += (interval - stats.mean) * (interval - stats.mean);
+  stats.stddev = std::sqrt (stats.stddev / intervals.size ());
+
+  return stats;
+}
+
+static std::vector<uint64_t>
+run (GstSpoutTimestamper & timestamper, GstSpoutTimestampMode mode,
+    const std::vector<Arrival> & trace, bool count_frames = true)
+{
+  std::vector<uint64_t> pts;
+
+  for (const Arrival & arrival : trace) {
+    pts.push_back (timestamper.timestamp (mode, arrival.time,
+            count_frames ? arrival.sender_frame : 0));
+  }
+
+  return pts;
+}
+
+static uint64_t
+frame_duration (double fps)
+{
+  int num, den;
+
+  gst_spout_snap_framerate (fps, &num, &den);
+  return gst_spout_frame_duration (num, den);
+}
+
+/* PTS never run backwards and are never later than the frame arrived */
+static void
+check_bounds (const std::vector<Arrival> & trace,
+    const std::vector<uint64_t> & pts)
+{
+  unsigned late = 0, backwards = 0;
+
+  for (size_t i = 0; i < pts.size (); i++) {
+    late += pts[i] > trace[i].time;
+    backwards += i > 0 && pts[i] <= pts[i - 1];
+  }
+
+  CHECK_EQ (late, 0u);
+  CHECK_EQ (backwards, 0u);
+}
+
+static void
+test_snapped_duration ()
+{
+  CHECK_EQ (frame_duration (59.94), 16683333u);
+  CHECK_EQ (frame_duration (23.976), 41708333u);
+  CHECK_EQ (frame_duration (25.0), 40000000u);
+  CHECK_EQ (frame_duration (0.5), 2000000000u);
+}
+
+/* Arrival mode passes the jitter through, smoothing takes nearly all of it
+ * out at the right mean period */
+static void
+test_smoothed_variance ()
+{
+  for (double fps : { 23.976, 29.97, 59.94, 144.0 }) {
+    int num, den;
+    gst_spout_snap_framerate (fps, &num, &den);
+
+    std::vector<Arrival> trace = make_trace (num, den, 5000, 0);
+    GstSpoutTimestamper arrival, smoothed;
+    uint64_t duration = gst_spout_frame_duration (num, den);
+
+    arrival.set_frame_duration (duration);
+    smoothed.set_frame_duration (duration);
+
+    Stats raw = interval_stats (run (arrival, GST_SPOUT_TIMESTAMP_ARRIVAL,
+            trace, false));
+    std::vector<uint64_t> pts = run (smoothed, GST_SPOUT_TIMESTAMP_SMOOTHED,
+        trace, false);
+    Stats out = interval_stats (pts, GstSpoutTimestamper::WINDOW);
+
+    check_bounds (trace, pts);
+    CHECK (raw.stddev > duration / 20);
+    CHECK (out.stddev < raw.stddev / 10);
+    CHECK (std::fabs (out.mean - (double) duration) < duration * 0.001);
+    CHECK_EQ (smoothed.resyncs (), 0u);
+  }
+}
+
+/* Sender frame numbers give exactly the negotiated period, but for the odd
+ * step back when an arrival beats the anchor. Taken as 59 fps a 59.94
+ * sender's timestamps run a quarter millisecond a frame ahead of the
+ * arrivals, keep falling back to them and carry their jitter */
+static void
+test_sender_frame ()
+{
+  std::vector<Arrival> trace = make_trace (60000, 1001, 10000, 4 * MS);
+  GstSpoutTimestamper rational, truncated;
+
+  rational.set_frame_duration (frame_duration (59.94));
+  truncated.set_frame_duration (1000000000 / 59);
+
+  std::vector<uint64_t> pts = run (rational,
+      GST_SPOUT_TIMESTAMP_SENDER_FRAME, trace);
+  Stats drifting = interval_stats (run (truncated,
+          GST_SPOUT_TIMESTAMP_SENDER_FRAME, trace));
+  unsigned exact = 0;
+
+  for (size_t i = 1; i < pts.size (); i++)
+    exact += pts[i] - pts[i - 1] == 16683333;
+
+  check_bounds (trace, pts);
+  CHECK (exact > pts.size () * 99 / 100);
+  CHECK_EQ (rational.resyncs (), 0u);
+  CHECK (drifting.stddev > 5 * interval_stats (pts).stddev);
+}
+
+/* Frames the sender skipped leave a gap instead of stretching the cadence,
+ * with or without sender frame numbers */
+static void
+test_skipped_frames ()
+{
+  std::vector<Arrival> trace = make_trace (30000, 1001, 3000, 2 * MS);
+  std::vector<Arrival> kept;
+  uint64_t duration = frame_duration (29.97);
+
+  for (size_t i = 0; i < trace.size (); i++) {
+    if (i % 10 != 9)
+      kept.push_back (trace[i]);
+  }
+
+  for (bool count_frames : { false, true }) {
+    GstSpoutTimestamper timestamper;
+    timestamper.set_frame_duration (duration);
+
+    std::vector<uint64_t> pts = run (timestamper,
+        GST_SPOUT_TIMESTAMP_SMOOTHED, kept, count_frames);
+    unsigned gaps = 0, off = 0;
+
+    check_bounds (kept, pts);
+    for (size_t i = GstSpoutTimestamper::WINDOW; i < pts.size (); i++) {
+      double periods = (double) (pts[i] - pts[i - 1]) / duration;
+
+      gaps += std::fabs (periods - 2.0) < 0.05;
+      off += std::fabs (periods - std::round (periods)) > 0.05;
+    }
+
+    CHECK (gaps > 290);
+    CHECK_EQ (off, 0u);
+  }
+}
+
+/* A stall reads as skipped frames: the timestamps jump a whole number of
+ * periods and carry on at the same cadence */
+static void
+test_stall ()
+{
+  std::vector<Arrival> trace = make_trace (60, 1, 2000, 2 * MS);
+  GstSpoutTimestamper timestamper;
+
+  for (size_t i = 1000; i < trace.size (); i++)
+    trace[i].time += 300 * MS;
+
+  timestamper.set_frame_duration (frame_duration (60.0));
+
+  std::vector<uint64_t> pts = run (timestamper,
+      GST_SPOUT_TIMESTAMP_SMOOTHED, trace, false);
+  std::vector<uint64_t> after (pts.begin () + 1000, pts.end ());
+  Stats out = interval_stats (after, GstSpoutTimestamper::WINDOW);
+
+  double jump = (double) (pts[1000] - pts[999]) / 16666666.0;
+
+  check_bounds (trace, pts);
+  CHECK (jump > 18.0);
+  CHECK (std::fabs (jump - std::round (jump)) < 0.05);
+  CHECK (std::fabs (out.mean - 16666666.0) < 16666.0);
+  CHECK (out.stddev < 200000);
+}
+
+int
+main ()
+{
+  test_snapped_duration ();
+  test_smoothed_variance ();
+  test_sender_frame ();
+  test_skipped_frames ();
+  test_stall ();
+
+  return gst_spout_test_result ();
+}
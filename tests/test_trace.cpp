@@ -0,0 +1,275 @@
+/* GStreamer
+ * Copyright (C) 2023 Your Name <your.email@example.com>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+/* GstSpoutTracer: dumps are valid JSON whatever the names, and threads that
+ * come and go don't pile up rings */
+
+#include "gstspouttrace.h"
+#include "gstspouttest.h"
+
+#include <cstring>
+#include <thread>
+
+/* Just enough of a JSON parser to tell valid from invalid */
+class JsonChecker
+{
+public:
+  explicit JsonChecker (const std::string & text) : p_ (text.c_str ()) {}
+
+  bool valid ()
+  {
+    bool ok = value ();
+
+    space ();
+    return ok && *p_ == '\0';
+  }
+
+private:
+  void space ()
+  {
+    while (*p_ == ' ' || *p_ == '\n' || *p_ == '\r' || *p_ == '\t')
+      p_++;
+  }
+
+  bool literal (const char * word)
+  {
+    size_t n = strlen (word);
+
+    if (strncmp (p_, word, n))
+      return false;
+    p_ += n;
+    return true;
+  }
+
+  bool string ()
+  {
+    if (*p_++ != '"')
+      return false;
+
+    while (*p_ != '"') {
+      unsigned char c = (unsigned char) *p_++;
+
+      if (c < 0x20)
+        return false;
+      if (c == '\\') {
+        c = (unsigned char) *p_++;
+        if (c == 'u') {
+          for (int i = 0; i < 4; i++) {
+            if (!isxdigit ((unsigned char) *p_++))
+              return false;
+          }
+        } else if (!strchr ("\"\\/bfnrt", c) || !c) {
+          return false;
+        }
+      }
+    }
+    p_++;
+
+    return true;
+  }
+
+  bool number ()
+  {
+    char *end;
+
+    strtod (p_, &end);
+    if (end == p_)
+      return false;
+    p_ = end;
+    return true;
+  }
+
+  bool value ()
+  {
+    space ();
+    switch (*p_) {
+      case '{':
+        p_++;
+        space ();
+        if (*p_ == '}')
+          return p_++, true;
+        for (;;) {
+          space ();
+          if (!string ())
+            return false;
+          space ();
+          if (*p_++ != ':' || !value ())
+            return false;
+          space ();
+          if (*p_ == '}')
+            return p_++, true;
+          if (*p_++ != ',')
+            return false;
+        }
+      case '[':
+        p_++;
+        space ();
+        if (*p_ == ']')
+          return p_++, true;
+        for (;;) {
+          if (!value ())
+            return false;
+          space ();
+          if (*p_ == ']')
+            return p_++, true;
+          if (*p_++ != ',')
+            return false;
+        }
+      case '"':
+        return string ();
+      case 't':
+        return literal ("true");
+      case 'f':
+        return literal ("false");
+      case 'n':
+        return literal ("null");
+      default:
+        return number ();
+    }
+  }
+
+  const char *p_;
+};
+
+static size_t
+count (const std::string & text, const std::string & what)
+{
+  size_t n = 0;
+
+  for (size_t pos = text.find (what); pos != std::string::npos;
+      pos = text.find (what, pos + 1))
+    n++;
+
+  return n;
+}
+
+/* Element names are up to the application, anything goes */
+static void
+test_json_names ()
+{
+  GstSpoutTracer & tracer = gst_spout_tracer_get ();
+  std::string name (300, 'x');
+
+  name += " \"quoted\" back\\slash\ttab\nnewline \x01";
+  tracer.set_enabled (true);
+
+  std::thread thread ([&] {
+    tracer.name_thread (name + " streaming");
+    tracer.record ("create", 1000, 2500, 42);
+    tracer.record ("odd \"stage\"", 3000, 3001, 18446744073709551615ull);
+  });
+  thread.join ();
+
+  std::string json = tracer.to_json ();
+
+  CHECK (JsonChecker (json).valid ());
+  CHECK (json.find (std::string (300, 'x')) != std::string::npos);
+  CHECK (json.find ("\\\"quoted\\\" back\\\\slash\\u0009tab\\u000anewline "
+          "\\u0001 streaming") != std::string::npos);
+  CHECK (json.find ("\"frame\":18446744073709551615") != std::string::npos);
+  CHECK (json.find ("\"ts\":1.000,\"dur\":1.500") != std::string::npos);
+
+  /* And the checker does tell */
+  CHECK (!JsonChecker ("{\"a\":\"b\nc\"}").valid ());
+  CHECK (!JsonChecker ("{\"a\":\"b").valid ());
+}
+
+/* Sequential threads share one ring, concurrent ones have a ring each */
+static void
+test_ring_reuse ()
+{
+  GstSpoutTracer & tracer = gst_spout_tracer_get ();
+
+  tracer.set_enabled (true);
+  tracer.record ("main", 0, 1, 0);
+  size_t rings = tracer.rings ();
+
+  for (int i = 0; i < 100; i++) {
+    std::thread thread ([&] {
+      tracer.name_thread ("short-lived " + std::to_string (i));
+      for (int j = 0; j <= i; j++)
+        tracer.record ("work", 10000 + j, 10001 + j, (uint64_t) i);
+    });
+    thread.join ();
+  }
+
+  CHECK (tracer.rings () <= rings + 1);
+
+  /* The last thread's events are still in the dump, older threads' gave
+   * way to it */
+  std::string json = tracer.to_json ();
+
+  CHECK (JsonChecker (json).valid ());
+  CHECK (json.find ("short-lived 99") != std::string::npos);
+  CHECK (json.find ("short-lived 98\"") == std::string::npos);
+  CHECK_EQ (count (json, "\"args\":{\"frame\":99}"), 100u);
+  CHECK_EQ (count (json, "\"args\":{\"frame\":98}"), 0u);
+
+  /* The last short-lived thread's ring is free again, three more are
+   * needed */
+  std::atomic<int> waiting { 4 };
+  std::vector<std::thread> threads;
+
+  rings = tracer.rings ();
+
+  for (int i = 0; i < 4; i++) {
+    threads.emplace_back ([&] {
+      tracer.record ("together", 0, 1, 0);
+      waiting--;
+      while (waiting > 0)
+        std::this_thread::yield ();
+    });
+  }
+  for (auto & thread : threads)
+    thread.join ();
+
+  CHECK_EQ (tracer.rings (), rings + 3);
+}
+
+/* Overwritten events are gone, the newest RING_SIZE stay */
+static void
+test_ring_wrap ()
+{
+  GstSpoutTracer & tracer = gst_spout_tracer_get ();
+
+  tracer.set_enabled (true);
+
+  std::thread thread ([&] {
+    tracer.name_thread ("wrapping");
+    for (uint64_t i = 0; i < GstSpoutTracer::RING_SIZE + 100; i++)
+      tracer.record ("wrap", i, i + 1, 7000000 + i);
+  });
+  thread.join ();
+
+  std::string json = tracer.to_json ();
+
+  CHECK_EQ (count (json, "\"frame\":7000099}"), 0u);
+  CHECK_EQ (count (json, "\"frame\":7000100}"), 1u);
+  CHECK_EQ (count (json, "\"args\":{\"frame\":700"), GstSpoutTracer::RING_SIZE);
+}
+
+int
+main ()
+{
+  test_json_names ();
+  test_ring_reuse ();
+  test_ring_wrap ();
+
+  return gst_spout_test_result ();
+}